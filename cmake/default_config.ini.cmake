@@ -88,6 +88,21 @@ mag_converter_min_fov               = 0.001
 labels_amount                       = 3.0
 init_bortle_scale                   = 2
 
+# Compute the star zones with a pool of worker threads.
+# draw_thread_count = 0 uses one thread per CPU core.
+flag_multithreaded_draw             = false
+draw_thread_count                   = 0
+
+# Reuse the stars computed at the previous frame while the view does not change.
+flag_draw_cache                     = true
+
+# Draw the stars as instanced quads when OpenGL supports instanced arrays.
+flag_instanced_point_sources        = true
+
+# Star catalogs from this one on (stars4, stars5...) are loaded in the background
+# after startup. Use -1 to load all the catalogs at startup.
+background_loading_level            = 4
+
 [custom_selected_info]
 flag_show_absolutemagnitude         = false
 flag_show_altaz                     = false
@@ -242,6 +257,7 @@ flag_planets                        = true
 flag_planets_hints                  = false
 flag_planets_orbits                 = false
 flag_light_travel_time              = true
+flag_parallel_positions             = true
 flag_object_trails                  = false
 flag_nebula                         = true
 flag_nebula_name                    = false
@@ -267,6 +283,10 @@ flag_use_de430                      = false
 flag_use_de431                      = false
 de430_path                          = ""
 de431_path                          = ""
+flag_ephemeris_cache                = true
+ephemeris_cache_start_year          = 1950
+ephemeris_cache_end_year            = 2050
+ephemeris_cache_tolerance           = 1e-9
 
 [init_location]
 location                            = auto
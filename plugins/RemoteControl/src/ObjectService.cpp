@@ -20,10 +20,14 @@
 #include "ObjectService.hpp"
 
 #include "SearchDialog.hpp"
+#include "Planet.hpp"
+#include "SolarSystemEphemeris.hpp"
 #include "StelApp.hpp"
 #include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
 #include "StelObjectMgr.hpp"
 #include "StelTranslator.hpp"
+#include "StelUtils.hpp"
 
 #include <QEventLoop>
 #include <QJsonArray>
@@ -35,6 +39,16 @@
 #include <QRunnable>
 #include <QWaitCondition>
 
+#include <cmath>
+
+namespace
+{
+	//! Maximum number of dates computed by the ephemeris operation
+	const double MaxEphemerisDates = 100000.;
+	//! Maximum number of days predicted by the satellitepasses operation
+	const double MaxPassDays = 31.;
+}
+
 ObjectService::ObjectService(const QByteArray &serviceName, QObject *parent) : AbstractAPIService(serviceName,parent)
 {
 	//this is run in the main thread
@@ -195,10 +209,97 @@ void ObjectService::getImpl(const QByteArray& operation, const APIParameters &pa
 			response.writeRequestError("missing type parameter");
 		}
 	}
+	else if(operation == "ephemeris")
+	{
+		QString name = QString::fromUtf8(parameters.value("name"));
+		if(name.isEmpty())
+		{
+			response.writeRequestError("missing name parameter");
+			return;
+		}
+
+		bool ok = true;
+		double from = core->getJD();
+		if(parameters.contains("from"))
+			from = QString(parameters.value("from")).toDouble(&ok);
+		double to = from;
+		if(ok && parameters.contains("to"))
+			to = QString(parameters.value("to")).toDouble(&ok);
+		double step = 1.;
+		if(ok && parameters.contains("step"))
+			step = QString(parameters.value("step")).toDouble(&ok);
+		if(!ok || !(step>0.) || to<from || (to-from)/step>=MaxEphemerisDates)
+		{
+			response.writeRequestError("invalid from, to or step parameter");
+			return;
+		}
+
+		StelObjectP obj;
+		QMetaObject::invokeMethod(this,"findObject",SERVICE_DEFAULT_INVOKETYPE,
+					  Q_RETURN_ARG(StelObjectP,obj),
+					  Q_ARG(QString,name));
+		if(!qSharedPointerDynamicCast<Planet>(obj))
+		{
+			response.setStatus(404,"not found");
+			response.setData("solar system object name not found");
+			return;
+		}
+
+		QJsonArray arr;
+		QMetaObject::invokeMethod(this,"computeEphemeris",SERVICE_DEFAULT_INVOKETYPE,
+					  Q_RETURN_ARG(QJsonArray,arr),
+					  Q_ARG(QString,name),
+					  Q_ARG(double,from),
+					  Q_ARG(double,to),
+					  Q_ARG(double,step));
+		if(arr.isEmpty())
+		{
+			response.writeRequestError("cannot compute the positions of this object");
+			return;
+		}
+		response.writeJSON(QJsonDocument(arr));
+	}
+	else if(operation == "satellitepasses")
+	{
+		bool ok = true;
+		double from = core->getJD();
+		if(parameters.contains("from"))
+			from = QString(parameters.value("from")).toDouble(&ok);
+		double days = 1.;
+		if(ok && parameters.contains("days"))
+			days = QString(parameters.value("days")).toDouble(&ok);
+		double minAltitude = 0.;
+		if(ok && parameters.contains("minaltitude"))
+			minAltitude = QString(parameters.value("minaltitude")).toDouble(&ok);
+		if(!ok || !(days>0.) || days>MaxPassDays)
+		{
+			response.writeRequestError("invalid from, days or minaltitude parameter");
+			return;
+		}
+
+		//the Satellites plugin may not be loaded
+		StelModule* satellites = StelApp::getInstance().getModuleMgr().getModule("Satellites", true);
+		if(!satellites)
+		{
+			response.setStatus(404,"not found");
+			response.setData("the Satellites plugin is not loaded");
+			return;
+		}
+
+		//getPasses copies the orbits in the main thread, but computes the passes in this one,
+		//so that the main thread is not blocked
+		QVariantList passes;
+		QMetaObject::invokeMethod(satellites,"getPasses",Qt::DirectConnection,
+					  Q_RETURN_ARG(QVariantList,passes),
+					  Q_ARG(double,from),
+					  Q_ARG(double,days),
+					  Q_ARG(double,minAltitude));
+		response.writeJSON(QJsonDocument(QJsonArray::fromVariantList(passes)));
+	}
 	else
 	{
 		//TODO some sort of service description?
-		response.writeRequestError("unsupported operation. GET: find,info,listobjecttypes,listobjectsbytype");
+		response.writeRequestError("unsupported operation. GET: find,info,listobjecttypes,listobjectsbytype,ephemeris,satellitepasses");
 	}
 }
 
@@ -214,3 +315,43 @@ QString ObjectService::getInfoString(const StelObjectP obj)
 {
 	return obj->getInfoString(core);
 }
+
+QJsonArray ObjectService::computeEphemeris(const QString &name, double from, double to, double step)
+{
+	//the object is searched again, as the planets may have been reloaded since the request was checked
+	PlanetP planet = qSharedPointerDynamicCast<Planet>(findObject(name));
+	QJsonArray arr;
+	if(!planet)
+		return arr;
+
+	QVector<double> dates;
+	for(double jd = from; jd<=to; jd+=step)
+		dates.append(jd);
+	const SolarSystemEphemeris ephemeris(core, core->getCurrentLocation());
+	QVector<SolarSystemEphemeris::Position> positions;
+	if(!ephemeris.compute(planet, dates, positions))
+		return arr;
+
+	foreach(const SolarSystemEphemeris::Position& position, positions)
+	{
+		double ra, dec, alt, az;
+		QJsonObject pos;
+		pos.insert("jd", position.JD);
+		StelUtils::rectToSphe(&ra, &dec, position.equinoxEquatorialPos);
+		pos.insert("ra", ra*180./M_PI);
+		pos.insert("dec", dec*180./M_PI);
+		StelUtils::rectToSphe(&ra, &dec, position.j2000EquatorialPos);
+		pos.insert("raJ2000", ra*180./M_PI);
+		pos.insert("decJ2000", dec*180./M_PI);
+		StelUtils::rectToSphe(&az, &alt, position.altAzPos);
+		az = 3.*M_PI - az;
+		if(az > M_PI*2)
+			az -= M_PI*2;
+		pos.insert("altitude", alt*180./M_PI);
+		pos.insert("azimuth", az*180./M_PI);
+		pos.insert("distance", position.distance);
+		pos.insert("vmag", position.vMagnitude);
+		arr.append(pos);
+	}
+	return arr;
+}
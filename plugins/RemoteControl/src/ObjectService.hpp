@@ -23,6 +23,7 @@
 #include "AbstractAPIService.hpp"
 #include "StelObjectType.hpp"
 
+#include <QJsonArray>
 #include <QStringList>
 
 class StelCore;
@@ -56,6 +57,11 @@ private slots:
 
 	//! Wrapper around obj->getInfoString
 	QString getInfoString(const StelObjectP obj);
+
+	//! Compute the ephemeris of the solar system object \p name for the current location with a SolarSystemEphemeris,
+	//! in the main thread so that the planets cannot be reloaded meanwhile.
+	//! @return the positions as the ephemeris operation returns them, or an empty array if they cannot be computed
+	QJsonArray computeEphemeris(const QString& name, double from, double to, double step);
 private:
 	StelCore* core;
 	StelObjectMgr* objMgr;
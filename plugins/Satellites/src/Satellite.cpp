@@ -65,7 +65,6 @@ Vec3f Satellite::invisibleSatelliteColor = Vec3f(0.2,0.2,0.2);
 QString Satellite::myText = "";
 #endif
 double Satellite::sunReflAngle = 180.;
-double Satellite::timeShift = 0.;
 
 Satellite::Satellite(const QString& identifier, const QVariantMap& map)
 	: initialized(false)
@@ -86,6 +85,8 @@ Satellite::Satellite(const QString& identifier, const QVariantMap& map)
 	, phaseAngle(0.)
 	, lastEpochCompForOrbit(0.)
 	, epochTime(0.)
+	, propagationJD(0.)
+	, hiddenInterval(0.)
 {
 	// return initialized if the mandatory fields are not present
 	if (identifier.isEmpty())
@@ -406,172 +407,184 @@ float Satellite::getVMagnitude(const StelCore* core) const
 		{
 			// Calculation of approx. visual magnitude for artificial satellites
 			// described here: http://www.prismnet.com/~mmccants/tles/mccdesc.html
-			double fracil = calculateIlluminatedFraction();
-			if (fracil==0)
-				fracil = 0.000001;
 			if (pSatWrapper && name.startsWith("IRIDIUM"))
 			{
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
 				myText = "";
 #endif
-				Vec3d Sun3d = pSatWrapper->getSunECIPos();
-				QVector3D sun(Sun3d.data()[0],Sun3d.data()[1],Sun3d.data()[2]);
-				QVector3D sunN = sun; sunN.normalize();
+				sunReflAngle = computeIridiumReflectionAngle(*pSatWrapper, position, velocity, elAzPosition,
+									     gSatWrapper::getCurrentObserverContext());
+				vmag = qMin(stdMag, computeIridiumFlareMagnitude(sunReflAngle));
+			}
+			else // not Iridium
+			{
+				sunReflAngle = -1;
+				vmag = stdMag;
+			}
+
+			vmag = computeMagnitude(vmag, range, calculateIlluminatedFraction());
+
+		}
+	}
+	return vmag;
+}
+
+double Satellite::computeIridiumReflectionAngle(gSatWrapper& wrapper, const Vec3d& position, const Vec3d& velocity,
+						const Vec3d& elAzPosition, const gSatWrapper::ObserverContext& context)
+{
+	Vec3d Sun3d = wrapper.getSunECIPos(context);
+	QVector3D sun(Sun3d.data()[0],Sun3d.data()[1],Sun3d.data()[2]);
+	QVector3D sunN = sun; sunN.normalize();
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Sun3d = " + QString("[%1 %2 %3]")
-						.arg(sunN.x())
-						.arg(sunN.y())
-						.arg(sunN.z())
-						+ "<br>\n";
+	myText += "Sun3d = " + QString("[%1 %2 %3]")
+			.arg(sunN.x())
+			.arg(sunN.y())
+			.arg(sunN.z())
+			+ "<br>\n";
 #endif
-				//static double sin1 = sin(40*M_PI/180);
-				//static double cos1 = cos(40*M_PI/180);
-				//static double sin2 = sin(120*M_PI/180);
-				//static double cos2 = cos(120*M_PI/180);
-				// position, velocity are known
-				QVector3D Vx(velocity.data()[0],velocity.data()[1],velocity.data()[2]); Vx.normalize();
+	//static double sin1 = sin(40*M_PI/180);
+	//static double cos1 = cos(40*M_PI/180);
+	//static double sin2 = sin(120*M_PI/180);
+	//static double cos2 = cos(120*M_PI/180);
+	// position, velocity are known
+	QVector3D Vx(velocity.data()[0],velocity.data()[1],velocity.data()[2]); Vx.normalize();
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Vx = " + QString("[%1 %2 %3]")
-						.arg(Vx.x())
-						.arg(Vx.y())
-						.arg(Vx.z())
-						+ "<br>\n";
+	myText += "Vx = " + QString("[%1 %2 %3]")
+			.arg(Vx.x())
+			.arg(Vx.y())
+			.arg(Vx.z())
+			+ "<br>\n";
 #endif
-				QVector3D SatPos(position.data()[0],position.data()[1],position.data()[2]);
-				Vec3d vy = (position^velocity);
-				QVector3D Vy(vy.data()[0],vy.data()[1],vy.data()[2]); Vy.normalize();
+	QVector3D SatPos(position.data()[0],position.data()[1],position.data()[2]);
+	Vec3d vy = (position^velocity);
+	QVector3D Vy(vy.data()[0],vy.data()[1],vy.data()[2]); Vy.normalize();
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Vy = " + QString("[%1 %2 %3]")
-						.arg(Vy.x())
-						.arg(Vy.y())
-						.arg(Vy.z())
-						+ "<br>\n";
+	myText += "Vy = " + QString("[%1 %2 %3]")
+			.arg(Vy.x())
+			.arg(Vy.y())
+			.arg(Vy.z())
+			+ "<br>\n";
 #endif
-				QVector3D Vz = QVector3D::crossProduct(Vx,Vy); Vz.normalize();
+	QVector3D Vz = QVector3D::crossProduct(Vx,Vy); Vz.normalize();
 
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "Vz = " + QString("[%1 %2 %3]")
-						.arg(Vz.x())
-						.arg(Vz.y())
-						.arg(Vz.z())
-						+ "<br>\n";
+	myText += "Vz = " + QString("[%1 %2 %3]")
+			.arg(Vz.x())
+			.arg(Vz.y())
+			.arg(Vz.z())
+			+ "<br>\n";
 #endif
 
-				// move this to constructor for optimizing
-				QMatrix4x4 m0;
-				m0.rotate(40, Vy);
-				QVector3D Vx0 = m0.mapVector(Vx);
+	// move this to constructor for optimizing
+	QMatrix4x4 m0;
+	m0.rotate(40, Vy);
+	QVector3D Vx0 = m0.mapVector(Vx);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-				myText += "mirror0 = " + QString("[%1 %2 %3]")
-						.arg(Vx0.x())
-						.arg(Vx0.y())
-						.arg(Vx0.z())
-						+ "<br>\n";
+	myText += "mirror0 = " + QString("[%1 %2 %3]")
+			.arg(Vx0.x())
+			.arg(Vx0.y())
+			.arg(Vx0.z())
+			+ "<br>\n";
 #endif
 
-				QMatrix4x4 m[3];
-				//m[2] = m[1] = m[0];
-				m[0].rotate(0, Vz);
-				m[1].rotate(120, Vz);
-				m[2].rotate(-120, Vz);
+	QMatrix4x4 m[3];
+	//m[2] = m[1] = m[0];
+	m[0].rotate(0, Vz);
+	m[1].rotate(120, Vz);
+	m[2].rotate(-120, Vz);
 
-				QVector3D mirror;
-				sunReflAngle = 180.;
+	QVector3D mirror;
+	double sunReflAngle = 180.;
 
-				for (int i = 0; i<3; i++)
-				{
-					mirror = m[i].mapVector(Vx0);
-					mirror.normalize();
+	for (int i = 0; i<3; i++)
+	{
+		mirror = m[i].mapVector(Vx0);
+		mirror.normalize();
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "mirror = " + QString("[%1 %2 %3]")
-							.arg(mirror.x())
-							.arg(mirror.y())
-							.arg(mirror.z())
-							+ "<br>\n";
+		myText += "mirror = " + QString("[%1 %2 %3]")
+				.arg(mirror.x())
+				.arg(mirror.y())
+				.arg(mirror.z())
+				+ "<br>\n";
 #endif
-					// reflection R = 2*(V dot N)*N - V
-					QVector3D rsun =  2*QVector3D::dotProduct(sun,mirror)*mirror - sun;
-					rsun = -rsun;
-					Vec3d rSun(rsun.x(),rsun.y(),rsun.z());
+		// reflection R = 2*(V dot N)*N - V
+		QVector3D rsun =  2*QVector3D::dotProduct(sun,mirror)*mirror - sun;
+		rsun = -rsun;
+		Vec3d rSun(rsun.x(),rsun.y(),rsun.z());
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "rSun = " + rSun.toString() + "<br>\n";
+		myText += "rSun = " + rSun.toString() + "<br>\n";
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-					StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
-					Vec3d topoRSunPos;
-					Vec3d observerECIPos;
-					Vec3d observerECIVel;
+		const StelLocation& loc = context.location;
+		Vec3d topoRSunPos;
+		Vec3d observerECIPos;
+		Vec3d observerECIVel;
 
-					double  radLatitude    = loc.latitude * KDEG2RAD;
-					double  theta          = pSatWrapper->getEpoch().toThetaLMST(loc.longitude * KDEG2RAD);
+		double  radLatitude    = loc.latitude * KDEG2RAD;
+		double  theta          = wrapper.getEpoch().toThetaLMST(loc.longitude * KDEG2RAD);
 
-					pSatWrapper->calcObserverECIPosition(observerECIPos, observerECIVel);
+		wrapper.calcObserverECIPosition(loc, observerECIPos, observerECIVel);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "ObsPos = " + observerECIPos.toString() + " (" + observerECIPos.toStringLonLat() + ")<br>\n";
-					myText += "ObsVel = " + observerECIVel.toString() + " (" + observerECIVel.toStringLonLat() + ")<br>\n";
+		myText += "ObsPos = " + observerECIPos.toString() + " (" + observerECIPos.toStringLonLat() + ")<br>\n";
+		myText += "ObsVel = " + observerECIVel.toString() + " (" + observerECIVel.toStringLonLat() + ")<br>\n";
 #endif
 
-					//Vec3d satECIPos  = getTEMEPos();
-					Vec3d slantRange = rSun - observerECIPos;
-
-					//top_s
-					topoRSunPos[0] = (sin(radLatitude) * cos(theta) * slantRange[0]
-							+ sin(radLatitude) * sin(theta) * slantRange[1]
-							- cos(radLatitude) * slantRange[2]);
-					//top_e
-					topoRSunPos[1] = ((-1.0) * sin(theta) * slantRange[0]
-							+ cos(theta) * slantRange[1]);
-
-					//top_z
-					topoRSunPos[2] = (cos(radLatitude) * cos(theta) * slantRange[0]
-							+ cos(radLatitude) * sin(theta) * slantRange[1]
-							+ sin(radLatitude) * slantRange[2]);
+		//Vec3d satECIPos  = getTEMEPos();
+		Vec3d slantRange = rSun - observerECIPos;
+
+		//top_s
+		topoRSunPos[0] = (sin(radLatitude) * cos(theta) * slantRange[0]
+				+ sin(radLatitude) * sin(theta) * slantRange[1]
+				- cos(radLatitude) * slantRange[2]);
+		//top_e
+		topoRSunPos[1] = ((-1.0) * sin(theta) * slantRange[0]
+				+ cos(theta) * slantRange[1]);
+
+		//top_z
+		topoRSunPos[2] = (cos(radLatitude) * cos(theta) * slantRange[0]
+				+ cos(radLatitude) * sin(theta) * slantRange[1]
+				+ sin(radLatitude) * slantRange[2]);
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += "SunRefl = " + topoRSunPos.toString() + " (" + topoRSunPos.toStringLonLat() + ")<br>\n";
+		myText += "SunRefl = " + topoRSunPos.toString() + " (" + topoRSunPos.toStringLonLat() + ")<br>\n";
 #endif
-					sunReflAngle = qMin(elAzPosition.angle(topoRSunPos) * KRAD2DEG, sunReflAngle) ;
+		sunReflAngle = qMin(elAzPosition.angle(topoRSunPos) * KRAD2DEG, sunReflAngle) ;
 #ifdef IRIDIUM_SAT_TEXT_DEBUG
-					myText += QString("Angle = %1").arg(QString::number(sunReflAngle, 'f', 1)) + "<br>";
+		myText += QString("Angle = %1").arg(QString::number(sunReflAngle, 'f', 1)) + "<br>";
 #endif
 ////////////////////////////////////////////////////////////////////////////////////////////////////
+	}
+	return sunReflAngle;
+}
 
-
-				}
-
-				// very simple flare model
-				double iridiumFlare = 100;
-				if (sunReflAngle<0.5)
-				{
-					iridiumFlare = -8.92 + sunReflAngle*6;
-				}
-				else
-				if (sunReflAngle<0.7)
-				{
-					iridiumFlare = -5.92 + (sunReflAngle-0.5)*10;
-				}
-					else
-				{
-					iridiumFlare = -3.92 + (sunReflAngle-0.7)*5;
-				}
-
-
-				 vmag = qMin(stdMag, iridiumFlare);
-			}
-			else // not Iridium
-			{
-				sunReflAngle = -1;
-				vmag = stdMag;
-			}
-
-			vmag = vmag - 15.75 + 2.5 * std::log10(range * range / fracil);
-
-		}
+double Satellite::computeIridiumFlareMagnitude(double sunReflAngle)
+{
+	// very simple flare model
+	double iridiumFlare = 100;
+	if (sunReflAngle<0.5)
+	{
+		iridiumFlare = -8.92 + sunReflAngle*6;
 	}
-	return vmag;
+	else
+	if (sunReflAngle<0.7)
+	{
+		iridiumFlare = -5.92 + (sunReflAngle-0.5)*10;
+	}
+	else
+	{
+		iridiumFlare = -3.92 + (sunReflAngle-0.7)*5;
+	}
+	return iridiumFlare;
+}
+
+double Satellite::computeMagnitude(double standardMagnitude, double range, double illuminatedFraction)
+{
+	if (illuminatedFraction==0)
+		illuminatedFraction = 0.000001;
+	return standardMagnitude - 15.75 + 2.5 * std::log10(range * range / illuminatedFraction);
 }
 
 // Calculate illumination fraction of artifical satellite
@@ -600,6 +613,7 @@ void Satellite::setNewTleElements(const QString& tle1, const QString& tle2)
 	tleElements.second.append(tle2);
 
 	pSatWrapper = new gSatWrapper(id, tle1, tle2);
+	resetSchedule();
 	orbitPoints.clear();
 	visibilityPoints.clear();
 	
@@ -607,11 +621,16 @@ void Satellite::setNewTleElements(const QString& tle1, const QString& tle2)
 }
 
 void Satellite::update(double)
+{
+	if (pSatWrapper && orbitValid)
+		update(StelApp::getInstance().getCore()->getJD(), gSatWrapper::getCurrentObserverContext());
+}
+
+void Satellite::update(double JD, const gSatWrapper::ObserverContext& context)
 {
 	if (pSatWrapper && orbitValid)
 	{
-		StelCore* core = StelApp::getInstance().getCore();
-		epochTime = core->getJD() + timeShift; // We have "true" JD from core, satellites don't need JDE!
+		epochTime = JD; // We have "true" JD from core, satellites don't need JDE!
 
 		pSatWrapper->setEpoch(epochTime);
 		position                 = pSatWrapper->getTEMEPos();
@@ -632,18 +651,41 @@ void Satellite::update(double)
 			return;
 		}
 
-		elAzPosition             = pSatWrapper->getAltAz();
+		elAzPosition             = pSatWrapper->getAltAz(context);
 		elAzPosition.normalize();
 
-		pSatWrapper->getSlantRange(range, rangeRate);
-		visibility = pSatWrapper->getVisibilityPredict();
-		phaseAngle = pSatWrapper->getPhaseAngle();
+		pSatWrapper->getSlantRange(range, rangeRate, context);
+		visibility = pSatWrapper->getVisibilityPredict(context);
+		phaseAngle = pSatWrapper->getPhaseAngle(context);
+
+		propagationJD = epochTime;
+		hiddenInterval = 0.;
+		if (visibility == NOT_VISIBLE)
+		{
+			Vec3d observerECIPos;
+			Vec3d observerECIVel;
+			pSatWrapper->calcObserverECIPosition(context.location, observerECIPos, observerECIVel);
+			double angle = observerECIPos.angle(position) - pSatWrapper->getMaxHorizonAngle();
+			double rate  = pSatWrapper->getMaxAngularRate();
+			// At most a day, as the bounds come from the mean elements of the TLE
+			if (angle > 0 && rate > 0)
+				hiddenInterval = qMin(angle/rate, 1.);
+		}
 
 		// Compute orbit points to draw orbit line.
-		if (orbitDisplayed) computeOrbitPoints();
+		if (orbitDisplayed) computeOrbitPoints(context);
 	}
 }
 
+bool Satellite::updateIfRisen(double JD, const gSatWrapper::ObserverContext& context)
+{
+	// The orbit line is drawn above and below the horizon
+	if (!orbitDisplayed && std::fabs(JD - propagationJD) < hiddenInterval)
+		return false;
+	update(JD, context);
+	return true;
+}
+
 double Satellite::getDoppler(double freq) const
 {
 	double result;
@@ -849,7 +891,7 @@ float Satellite::calculateOrbitSegmentIntensity(int segNum)
 	}
 }
 
-void Satellite::computeOrbitPoints()
+void Satellite::computeOrbitPoints(const gSatWrapper::ObserverContext& context)
 {
 	gTimeSpan computeInterval(0, 0, 0, orbitLineSegmentDuration);
 	gTimeSpan orbitSpan(0, 0, 0, orbitLineSegments*orbitLineSegmentDuration/2);
@@ -867,9 +909,9 @@ void Satellite::computeOrbitPoints()
 		for (int i=0; i<=orbitLineSegments; i++)
 		{
 			pSatWrapper->setEpoch(epochTm.getGmtTm());
-			elAzVector  = pSatWrapper->getAltAz();
+			elAzVector  = pSatWrapper->getAltAz(context);
 			orbitPoints.append(elAzVector);
-			visibilityPoints.append(pSatWrapper->getVisibilityPredict());
+			visibilityPoints.append(pSatWrapper->getVisibilityPredict(context));
 			epochTm    += computeInterval;
 		}
 		lastEpochCompForOrbit = epochTime;
@@ -898,9 +940,9 @@ void Satellite::computeOrbitPoints()
 				orbitPoints.removeFirst();
 				visibilityPoints.removeFirst();
 				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
+				elAzVector  = pSatWrapper->getAltAz(context);
 				orbitPoints.append(elAzVector);
-				visibilityPoints.append(pSatWrapper->getVisibilityPredict());
+				visibilityPoints.append(pSatWrapper->getVisibilityPredict(context));
 				epochTm    += computeInterval;
 			}
 
@@ -928,9 +970,9 @@ void Satellite::computeOrbitPoints()
 				orbitPoints.removeLast();
 				visibilityPoints.removeLast();
 				pSatWrapper->setEpoch(epochTm.getGmtTm());
-				elAzVector  = pSatWrapper->getAltAz();
+				elAzVector  = pSatWrapper->getAltAz(context);
 				orbitPoints.push_front(elAzVector);
-				visibilityPoints.push_front(pSatWrapper->getVisibilityPredict());
+				visibilityPoints.push_front(pSatWrapper->getVisibilityPredict(context));
 				epochTm -= computeInterval;
 
 			}
@@ -140,8 +140,34 @@ public:
 
 	// calculate faders, new position
 	void update(double deltaTime);
+	//! Compute the position at a date (JD, UT), seen by the observer of the context.
+	//! It only reads the context and changes this satellite, so that several
+	//! satellites may be updated by concurrent threads, as Satellites::update() does.
+	void update(double JD, const gSatWrapper::ObserverContext& context);
+	//! Like update(double, const gSatWrapper::ObserverContext&), but the propagation is skipped while the
+	//! satellite cannot have risen since the last one, which was below the horizon (see hiddenInterval).
+	//! The satellite then keeps its last position, below the horizon.
+	//! @return false if the propagation was skipped
+	bool updateIfRisen(double JD, const gSatWrapper::ObserverContext& context);
+	//! Propagate the satellite again at the next update, e.g. after a change of location.
+	void resetSchedule() {hiddenInterval = 0.;}
 
 	double getDoppler(double freq) const;
+
+	//! Approximate visual magnitude, from the standard magnitude (at 1000 km and phase angle 90 degrees).
+	//! @see http://www.prismnet.com/~mmccants/tles/mccdesc.html
+	//! @param range slant range, in km
+	//! @param illuminatedFraction as calculateIlluminatedFraction()
+	static double computeMagnitude(double standardMagnitude, double range, double illuminatedFraction);
+	//! Smallest angle between the direction of the satellite and the reflection of the Sun
+	//! on the three main mission antennas of an Iridium satellite, in degrees.
+	//! @param wrapper the orbit, computed at the date of the positions
+	//! @param position, velocity TEME position and velocity of the satellite
+	//! @param elAzPosition position of the satellite in StelCore::FrameAltAz
+	static double computeIridiumReflectionAngle(gSatWrapper& wrapper, const Vec3d& position, const Vec3d& velocity,
+						    const Vec3d& elAzPosition, const gSatWrapper::ObserverContext& context);
+	//! Standard magnitude of an Iridium flare with a reflection angle (in degrees), by a very simple model.
+	static double computeIridiumFlareMagnitude(double sunReflAngle);
 	static float showLabels;
 	static double roundToDp(float n, int dp);
 
@@ -169,7 +195,7 @@ public:
 
 private:
 	//draw orbits methods
-	void computeOrbitPoints();
+	void computeOrbitPoints(const gSatWrapper::ObserverContext& context);
 	void drawOrbit(StelPainter& painter);
 	//! returns 0 - 1.0 for the DRAWORBIT_FADE_NUMBER segments at
 	//! each end of an orbit, with 1 in the middle.
@@ -249,7 +275,6 @@ private:
 	int	visibility;
 	double	phaseAngle; // phase angle for the satellite
 	static double sunReflAngle; // for Iridium satellites
-	static double timeShift; // for Iridium satellites
 
 	//Satellite Orbit Draw
 	QFont     font;
@@ -258,6 +283,14 @@ private:
 	double    epochTime;  //measured in Julian Days
 	QList<Vec3d> orbitPoints; //orbit points represented by ElAzPos vectors
 	QList<int> visibilityPoints; //orbit visibility points
+
+	//Propagation scheduling
+	double    propagationJD; //date of the last propagation, measured in Julian Days
+	//! The satellite stays below the horizon within this interval from propagationJD (measured in days),
+	//! from the angle between the observer and the satellite seen from the centre of the Earth, which
+	//! changes at most at gSatWrapper::getMaxAngularRate(), and gSatWrapper::getMaxHorizonAngle().
+	//! 0 when the satellite may be above the horizon.
+	double    hiddenInterval;
 };
 
 typedef QSharedPointer<Satellite> SatelliteP;
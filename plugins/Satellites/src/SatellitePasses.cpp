@@ -0,0 +1,449 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SatellitePasses.hpp"
+#include "Satellite.hpp"
+#include "MinimumSearch.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelModuleMgr.hpp"
+
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+	// Interval between the tabulated positions of the Sun, in days
+	const double SunStep = 5./1440.;
+	// Limits of the step of the scan of the altitude, in days
+	const double MinScanStep = 1./1440.;
+	const double MaxScanStep = 20./1440.;
+	// Longest search of the rise and the set of a pass outside the range of dates, in days
+	const double MaxPassExtension = 1.;
+	// Precision of the rise, set and culmination, in days
+	const double Tolerance = 1./86400.;
+	// Step of the walk along a pass, in days, and its smallest value near an Iridium flare
+	const double WalkStep = 20./86400.;
+	const double MinFlareStep = 0.5/86400.;
+	// Precision of the date of a flare, in days
+	const double FlareTolerance = 0.1/86400.;
+	// The flares are the minima of the reflection angle below MaxFlareAngle (in degrees), brighter than
+	// MaxFlareMagnitude and higher than MinFlareAltitude, the limits of Satellites::getIridiumFlaresPrediction()
+	const double MaxFlareAngle = 2.;
+	const double MaxFlareMagnitude = 1.;
+	const double MinFlareAltitude = 5.*M_PI/180.;
+
+	//! The Sun seen by the observer, tabulated over the range of a prediction.
+	struct SunTable
+	{
+		double start;
+		QVector<Vec3d> equinoxEqPos;
+		QVector<Vec3d> altAzPos;
+
+		//! Set the Sun of a context at a date, interpolated linearly.
+		void interpolate(double JD, gSatWrapper::ObserverContext& context) const
+		{
+			const double x = (JD-start)/SunStep;
+			const int i = qBound(0, (int)std::floor(x), equinoxEqPos.size()-2);
+			const double f = x-i;
+			context.sunEquinoxEqPos = equinoxEqPos.at(i)*(1.-f) + equinoxEqPos.at(i+1)*f;
+			context.sunAltAzPos = altAzPos.at(i)*(1.-f) + altAzPos.at(i+1)*f;
+		}
+	};
+
+	//! Azimuth from the north of a position in the frame of gSatWrapper::getAltAz().
+	double northAzimuth(const Vec3d& altAz)
+	{
+		double azimuth = M_PI - std::atan2(altAz[1], altAz[0]);
+		if (azimuth>=2.*M_PI)
+			azimuth -= 2.*M_PI;
+		return azimuth;
+	}
+
+	//! An orbit computed at any date for the observer, as Satellite::update() does.
+	struct OrbitTracker
+	{
+		OrbitTracker(const SatellitePasses::Orbit& orbit, const StelLocation& location, const SunTable& sun, double JD)
+			: wrapper(orbit.id, orbit.tle1, orbit.tle2, JD)
+			, sun(sun)
+		{
+			context.location = location;
+		}
+
+		void setDate(double JD)
+		{
+			wrapper.setEpoch(JD);
+			sun.interpolate(JD, context);
+			altAz = wrapper.getAltAz(context);
+		}
+		//! Whether the orbit is no longer valid, e.g. after the re-entry of the satellite.
+		bool hasDecayed() {return wrapper.getSubPoint()[2] <= 0.;}
+		double getAltitude() const {return std::atan2(altAz[2], std::sqrt(altAz[0]*altAz[0]+altAz[1]*altAz[1]));}
+		double getAzimuth() const {return northAzimuth(altAz);}
+		int getVisibility() {return wrapper.getVisibilityPredict(context);}
+		double getMagnitude(double stdMag)
+		{
+			double range, rangeRate;
+			wrapper.getSlantRange(range, rangeRate, context);
+			return Satellite::computeMagnitude(stdMag, range, (1.+std::cos(wrapper.getPhaseAngle(context)))/2.);
+		}
+		double getReflectionAngle()
+		{
+			Vec3d direction = altAz;
+			direction.normalize();
+			return Satellite::computeIridiumReflectionAngle(wrapper, wrapper.getTEMEPos(), wrapper.getTEMEVel(), direction, context);
+		}
+
+		gSatWrapper wrapper;
+		const SunTable& sun;
+		gSatWrapper::ObserverContext context;
+		Vec3d altAz;
+	};
+
+	//! The opposite of the altitude, whose minimum is the culmination.
+	struct NegativeAltitude
+	{
+		NegativeAltitude(OrbitTracker& tracker) : tracker(tracker) {}
+		double operator()(double JD)
+		{
+			tracker.setDate(JD);
+			return -tracker.getAltitude();
+		}
+		OrbitTracker& tracker;
+	};
+
+	//! The reflection angle of an Iridium satellite while visible, whose minima are the flares.
+	struct ReflectionAngle
+	{
+		ReflectionAngle(OrbitTracker& tracker) : tracker(tracker) {}
+		double operator()(double JD)
+		{
+			tracker.setDate(JD);
+			return tracker.getVisibility()==VISIBLE ? tracker.getReflectionAngle() : 180.;
+		}
+		OrbitTracker& tracker;
+	};
+
+	//! Bisect the crossing of the horizon between a date below it and a date above it.
+	double findHorizon(OrbitTracker& tracker, double below, double above)
+	{
+		while (std::fabs(above-below)>Tolerance)
+		{
+			const double middle = 0.5*(below+above);
+			tracker.setDate(middle);
+			if (tracker.getAltitude()>0.)
+				above = middle;
+			else
+				below = middle;
+		}
+		return 0.5*(below+above);
+	}
+
+	//! Complete a pass from its samples, from the rise, or the start of the range, to the set, or the end of the range.
+	//! @return false if the pass culminates below the smallest altitude
+	bool computePass(OrbitTracker& tracker, const SatellitePasses::Orbit& orbit, QVector<double>& dates,
+			 QVector<double>& altitudes, double minAltitude, SatellitePass& pass)
+	{
+		// A short pass may have been sampled only at its ends
+		if (dates.size()<3)
+		{
+			const double middle = 0.5*(dates.first()+dates.last());
+			tracker.setDate(middle);
+			dates.insert(1, middle);
+			altitudes.insert(1, tracker.getAltitude());
+		}
+
+		// The highest sample and its neighbours bracket the culmination, unless the pass is cut
+		// by the range while the satellite is the highest
+		int highest = 0;
+		for (int i=1; i<dates.size(); ++i)
+		{
+			if (altitudes.at(i)>altitudes.at(highest))
+				highest = i;
+		}
+		if (highest==0 || highest==dates.size()-1)
+		{
+			pass.culminationJD = dates.at(highest);
+			pass.culminationAltitude = altitudes.at(highest);
+		}
+		else
+		{
+			NegativeAltitude negativeAltitude(tracker);
+			double culminationAltitude;
+			pass.culminationJD = MinimumSearch::refine(negativeAltitude, dates.at(highest-1), dates.at(highest), dates.at(highest+1),
+								   -altitudes.at(highest), Tolerance, &culminationAltitude);
+			pass.culminationAltitude = -culminationAltitude;
+		}
+		if (pass.culminationAltitude<minAltitude)
+			return false;
+
+		pass.id = orbit.id;
+		pass.name = orbit.name;
+		pass.riseJD = dates.first();
+		pass.setJD = dates.last();
+		tracker.setDate(pass.culminationJD);
+		pass.culminationAzimuth = tracker.getAzimuth();
+		pass.culminationVisibility = tracker.getVisibility();
+		tracker.setDate(pass.riseJD);
+		pass.riseAzimuth = tracker.getAzimuth();
+		tracker.setDate(pass.setJD);
+		pass.setAzimuth = tracker.getAzimuth();
+
+		// Walk along the pass for the visibility and the magnitude. As in Satellite::getVMagnitude(),
+		// the magnitude and the flares are computed only when the standard magnitude is known.
+		const bool iridium = orbit.stdMag!=99. && orbit.name.startsWith("IRIDIUM");
+		pass.visible = false;
+		pass.peakMagnitude = 99.;
+		pass.flares.clear();
+		// The last three samples of the reflection angle, which bracket a minimum
+		double flareDates[3], flareAngles[3];
+		int flareSamples = 0;
+		double step = WalkStep;
+		for (double JD=pass.riseJD; JD<pass.setJD; JD+=step)
+		{
+			tracker.setDate(JD);
+			step = WalkStep;
+			if (tracker.getVisibility()!=VISIBLE)
+			{
+				flareSamples = 0;
+				continue;
+			}
+			pass.visible = true;
+			if (orbit.stdMag==99.)
+				continue;
+			if (!iridium)
+			{
+				pass.peakMagnitude = qMin(pass.peakMagnitude, tracker.getMagnitude(orbit.stdMag));
+				continue;
+			}
+
+			const double angle = tracker.getReflectionAngle();
+			pass.peakMagnitude = qMin(pass.peakMagnitude, tracker.getMagnitude(qMin(orbit.stdMag, Satellite::computeIridiumFlareMagnitude(angle))));
+			// The reflection angle changes faster when small
+			step = qBound(MinFlareStep, 2e-6*angle*angle, WalkStep);
+			if (flareSamples==3)
+			{
+				flareDates[0] = flareDates[1]; flareAngles[0] = flareAngles[1];
+				flareDates[1] = flareDates[2]; flareAngles[1] = flareAngles[2];
+				--flareSamples;
+			}
+			flareDates[flareSamples] = JD;
+			flareAngles[flareSamples] = angle;
+			++flareSamples;
+			if (flareSamples==3 && flareAngles[1]<flareAngles[0] && flareAngles[1]<=flareAngles[2] && flareAngles[1]<MaxFlareAngle)
+			{
+				ReflectionAngle reflectionAngle(tracker);
+				SatelliteFlare flare;
+				flare.JD = MinimumSearch::refine(reflectionAngle, flareDates[0], flareDates[1], flareDates[2], flareAngles[1],
+								 FlareTolerance, &flare.reflectionAngle);
+				tracker.setDate(flare.JD);
+				flare.azimuth = tracker.getAzimuth();
+				flare.altitude = tracker.getAltitude();
+				flare.magnitude = tracker.getMagnitude(qMin(orbit.stdMag, Satellite::computeIridiumFlareMagnitude(flare.reflectionAngle)));
+				if (flare.magnitude<MaxFlareMagnitude && flare.altitude>MinFlareAltitude)
+				{
+					pass.flares.append(flare);
+					pass.peakMagnitude = qMin(pass.peakMagnitude, flare.magnitude);
+				}
+			}
+		}
+		return true;
+	}
+
+	//! Find the passes of an orbit during a range of dates.
+	void predictOrbit(const SatellitePasses::Orbit& orbit, const StelLocation& location, const SunTable& sun,
+			  double startJD, double endJD, double minAltitude, SatellitePassList& passes)
+	{
+		// The scan starts and ends a period before and after the range, to find the rise and the set of the
+		// passes in progress at its limits
+		OrbitTracker tracker(orbit, location, sun, startJD);
+		// Period in minutes
+		const double period = tracker.wrapper.getPeriod();
+		if (!(period>0.))
+			return;
+		const double step = qBound(MinScanStep, period/(90.*1440.), MaxScanStep);
+		const double extension = qMin(period/1440., MaxPassExtension);
+
+		// Dates and altitudes of the samples of the current pass, from its rise
+		QVector<double> dates;
+		QVector<double> altitudes;
+		bool inPass = false;
+		bool riseFound = true;
+		double lastJD = startJD-extension;
+		tracker.setDate(lastJD);
+		if (tracker.hasDecayed())
+			return;
+		double lastAltitude = tracker.getAltitude();
+		// Whether the satellite is above the horizon since the start of the scan, so that its rise is not known
+		bool upSinceScanStart = lastAltitude>0.;
+		while (lastJD<endJD || (inPass && lastJD<endJD+extension))
+		{
+			const double JD = upSinceScanStart ? qMin(lastJD+step, startJD) : lastJD+step;
+			tracker.setDate(JD);
+			// As in Satellite::update(), the orbit is no longer valid
+			if (tracker.hasDecayed())
+				return;
+			const double altitude = tracker.getAltitude();
+			if (upSinceScanStart)
+			{
+				// Up for longer than a pass lasts, e.g. a geostationary satellite: the pass starts with the range
+				if (altitude>0. && JD>=startJD)
+				{
+					inPass = true;
+					riseFound = false;
+				}
+				upSinceScanStart = altitude>0. && JD<startJD;
+			}
+			else if (lastAltitude<=0. && altitude>0.)
+			{
+				dates.clear();
+				altitudes.clear();
+				dates.append(findHorizon(tracker, lastJD, JD));
+				altitudes.append(0.);
+				inPass = true;
+				riseFound = true;
+			}
+			if (inPass && altitude>0.)
+			{
+				dates.append(JD);
+				altitudes.append(altitude);
+			}
+			else if (inPass)
+			{
+				dates.append(findHorizon(tracker, JD, lastJD));
+				altitudes.append(0.);
+				inPass = false;
+				SatellitePass pass;
+				// Only the passes which are above the horizon during the range
+				if (dates.last()>startJD && dates.first()<endJD && computePass(tracker, orbit, dates, altitudes, minAltitude, pass))
+				{
+					pass.riseFound = riseFound;
+					pass.setFound = true;
+					passes.append(pass);
+				}
+			}
+			lastJD = JD;
+			lastAltitude = altitude;
+		}
+
+		if (inPass && dates.first()<endJD)
+		{
+			// Still up for longer than a pass lasts: the pass ends with the range
+			while (dates.size()>1 && dates.last()>=endJD)
+			{
+				dates.removeLast();
+				altitudes.removeLast();
+			}
+			tracker.setDate(endJD);
+			dates.append(endJD);
+			altitudes.append(tracker.getAltitude());
+			SatellitePass pass;
+			if (computePass(tracker, orbit, dates, altitudes, minAltitude, pass))
+			{
+				pass.riseFound = riseFound;
+				pass.setFound = false;
+				passes.append(pass);
+			}
+		}
+	}
+
+	//! The passes of an orbit, predicted by one thread
+	struct Job
+	{
+		const SatellitePasses::Orbit* orbit;
+		SatellitePassList passes;
+	};
+
+	struct PredictJob
+	{
+		typedef void result_type;
+
+		PredictJob(const StelLocation& location, const SunTable& sun, double startJD, double endJD, double minAltitude)
+			: location(location), sun(sun), startJD(startJD), endJD(endJD), minAltitude(minAltitude) {}
+		void operator()(Job& job) const
+		{
+			predictOrbit(*job.orbit, location, sun, startJD, endJD, minAltitude, job.passes);
+		}
+
+		const StelLocation& location;
+		const SunTable& sun;
+		double startJD;
+		double endJD;
+		double minAltitude;
+	};
+
+	bool riseBefore(const SatellitePass& pass1, const SatellitePass& pass2)
+	{
+		return pass1.riseJD<pass2.riseJD;
+	}
+}
+
+SatellitePasses::SatellitePasses(const StelCore* core, const StelLocation& location)
+	: ephemeris(core, location)
+	, sun(GETSTELMODULE(SolarSystem)->getSun())
+	, minAltitude(0.)
+{
+}
+
+bool SatellitePasses::isValid() const
+{
+	return ephemeris.isValid() && !sun.isNull() && ephemeris.getLocation().planetName=="Earth";
+}
+
+SatellitePassList SatellitePasses::predict(double startJD, double endJD) const
+{
+	SatellitePassList passes;
+	if (!isValid() || orbits.isEmpty() || !(endJD>startJD))
+		return passes;
+
+	// The Sun, over the range extended by the search of the rises and the sets, with a step of margin on both sides
+	SunTable sunTable;
+	sunTable.start = startJD-MaxPassExtension-SunStep;
+	const int sunCount = (int)std::ceil((endJD-startJD+2.*MaxPassExtension)/SunStep)+3;
+	QVector<double> JDs(sunCount);
+	for (int i=0; i<sunCount; ++i)
+		JDs[i] = sunTable.start+i*SunStep;
+	QVector<SolarSystemEphemeris::Position> positions;
+	if (!ephemeris.compute(sun, JDs, positions))
+		return passes;
+	sunTable.equinoxEqPos.resize(sunCount);
+	sunTable.altAzPos.resize(sunCount);
+	for (int i=0; i<sunCount; ++i)
+	{
+		sunTable.equinoxEqPos[i] = positions.at(i).equinoxEquatorialPos;
+		sunTable.altAzPos[i] = positions.at(i).altAzPos;
+	}
+
+	QVector<Job> jobs(orbits.size());
+	for (int i=0; i<orbits.size(); ++i)
+		jobs[i].orbit = &orbits.at(i);
+	QtConcurrent::blockingMap(jobs, PredictJob(ephemeris.getLocation(), sunTable, startJD, endJD, minAltitude));
+
+	foreach (const Job& job, jobs)
+		passes += job.passes;
+	std::sort(passes.begin(), passes.end(), riseBefore);
+	return passes;
+}
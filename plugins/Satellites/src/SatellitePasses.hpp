@@ -0,0 +1,126 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _SATELLITEPASSES_HPP_
+#define _SATELLITEPASSES_HPP_
+
+#include "gSatWrapper.hpp"
+#include "SolarSystemEphemeris.hpp"
+
+#include <QList>
+#include <QMetaType>
+#include <QString>
+
+//! An Iridium flare during a pass.
+//! @ingroup satellites
+struct SatelliteFlare
+{
+	double JD;		//!< Date of the smallest reflection angle, JD (UT)
+	double azimuth;		//!< Azimuth from the north, in radians
+	double altitude;	//!< Altitude, in radians
+	double magnitude;	//!< Approximate visual magnitude
+	double reflectionAngle;	//!< @see Satellite::computeIridiumReflectionAngle(), in degrees
+};
+
+//! A pass of a satellite above the horizon, from its rise to its set.
+//! @ingroup satellites
+struct SatellitePass
+{
+	QString id;			//!< Catalog number of the satellite
+	QString name;
+	double riseJD;			//!< JD (UT)
+	double riseAzimuth;		//!< Azimuth from the north, in radians
+	double culminationJD;
+	double culminationAzimuth;
+	double culminationAltitude;	//!< Altitude, in radians
+	double setJD;
+	double setAzimuth;
+	//! False when the satellite is already above the horizon a period (at most a day) before the start
+	//! of the range, e.g. a geostationary satellite: riseJD and riseAzimuth are then those of the start of the range.
+	bool riseFound;
+	//! False when the satellite is still above the horizon a period (at most a day) after the end
+	//! of the range: setJD and setAzimuth are then those of the end of the range.
+	bool setFound;
+	//! Visibility at the culmination: RADAR_SUN, VISIBLE or RADAR_NIGHT (see gSatWrapper::getVisibilityPredict())
+	int culminationVisibility;
+	//! Whether the satellite is in the sunlight while the observer is in the dark at some time of the pass
+	bool visible;
+	//! Smallest magnitude while visible, 99 when not visible or when the standard magnitude is not known
+	double peakMagnitude;
+	//! Iridium flares during the pass, in order of date
+	QList<SatelliteFlare> flares;
+};
+
+typedef QList<SatellitePass> SatellitePassList;
+
+//! @class SatellitePasses
+//! Prediction of the passes of satellites over an observer, computed without changing StelCore
+//! nor the Satellite objects. Each orbit is propagated by its own gSatWrapper, by the threads of
+//! the global thread pool.
+//!
+//! The altitude of a satellite is scanned at a step of about 1/90 of its period; the rise and the set
+//! are then found by bisection and the culmination by Brent's method (see MinimumSearch), to about a second.
+//! The pass is walked again at a shorter step to find when the satellite is visible, its magnitude and,
+//! for the Iridium satellites, the flares. The Sun is computed by a SolarSystemEphemeris every few minutes
+//! and interpolated. The passes in progress at the start or at the end of the range of dates are returned too,
+//! with their rise and set searched up to a period of the satellite (at most a day) outside the range.
+//! The prediction and its orbits must be set in the main thread, and then it may be computed by any thread.
+//! @ingroup satellites
+class SatellitePasses
+{
+public:
+	//! The orbit and the name of a satellite, copied so that the prediction does not use the Satellite.
+	struct Orbit
+	{
+		QString id;
+		QString name;
+		QString tle1;
+		QString tle2;
+		//! Standard magnitude, 99 when not known
+		double stdMag;
+	};
+
+	//! Create the prediction for an observer on the Earth, with the settings of core.
+	SatellitePasses(const StelCore* core, const StelLocation& location);
+
+	//! Whether the Sun can be computed for the location.
+	bool isValid() const;
+
+	//! Set the smallest culmination altitude of the passes returned, in radians.
+	void setMinAltitude(double altitude) {minAltitude = altitude;}
+	double getMinAltitude() const {return minAltitude;}
+
+	//! Set the orbits of the satellites to predict, copied from the satellites in the main thread.
+	void setOrbits(const QList<Orbit>& newOrbits) {orbits = newOrbits;}
+
+	//! Predict the passes of the satellites.
+	//! @param startJD, endJD the range of dates (JD, UT)
+	//! @return the passes of all the satellites which are above the horizon during the range, in order of rise
+	SatellitePassList predict(double startJD, double endJD) const;
+
+private:
+	SolarSystemEphemeris ephemeris;
+	PlanetP sun;
+	double minAltitude;
+	QList<Orbit> orbits;
+};
+
+Q_DECLARE_METATYPE(SatellitePasses*)
+
+#endif // _SATELLITEPASSES_HPP_
@@ -38,6 +38,7 @@
 #include "StelJsonParser.hpp"
 #include "SatellitesDialog.hpp"
 #include "LabelMgr.hpp"
+#include "LandscapeMgr.hpp"
 #include "StelTranslator.hpp"
 #include "StelProgressController.hpp"
 #include "StelUtils.hpp"
@@ -52,6 +53,38 @@
 #include <QVariantMap>
 #include <QVariant>
 #include <QDir>
+#include <QAtomicInt>
+#include <QtConcurrent>
+#include <QScopedPointer>
+#include <QThread>
+
+namespace
+{
+	// Below this number of displayed satellites, they are updated by the main thread alone
+	const int MinSatellitesPerThread = 32;
+
+	//! Updates a satellite for the date and the observer of a frame, from any thread.
+	//! When scheduled, the satellites known to be below the horizon are not propagated, and counted.
+	struct UpdateSatellite
+	{
+		typedef void result_type;
+
+		UpdateSatellite(double JD, const gSatWrapper::ObserverContext& context, bool scheduled, QAtomicInt* skipped)
+			: JD(JD), context(context), scheduled(scheduled), skipped(skipped) {}
+		void operator()(const SatelliteP& sat) const
+		{
+			if (!scheduled)
+				sat->update(JD, context);
+			else if (!sat->updateIfRisen(JD, context))
+				skipped->ref();
+		}
+
+		double JD;
+		const gSatWrapper::ObserverContext& context;
+		bool scheduled;
+		QAtomicInt* skipped;
+	};
+}
 
 StelModule* SatellitesStelPluginInterface::getStelModule() const
 {
@@ -89,9 +122,12 @@ Satellites::Satellites()
 	, autoRemoveEnabled(false)
 	, updateFrequencyHours(0)
 	, messageTimer(0)
+	, propagationCount(0)
+	, skippedPropagationCount(0)
 {
 	setObjectName("Satellites");
 	configDialog = new SatellitesDialog();
+	qRegisterMetaType<SatellitePasses*>();
 }
 
 void Satellites::deinit()
@@ -752,6 +788,7 @@ void Satellites::setDataMap(const QVariantMap& map)
 		satelliteListModel->beginSatellitesChange();
 	
 	satellites.clear();
+	displayedSatellites.clear();
 	groups.clear();
 	QVariantMap satMap = map.value("satellites").toMap();
 	foreach(const QString& satId, satMap.keys())
@@ -958,6 +995,7 @@ void Satellites::remove(const QStringList& idList)
 	
 	StelObjectMgr* objMgr = GETSTELMODULE(StelObjectMgr);
 	int numRemoved = 0;
+	displayedSatellites.clear(); // Filled again by the next update()
 	for (int i = 0; i < satellites.size(); i++)
 	{
 		const SatelliteP& sat = satellites.at(i);
@@ -1547,11 +1585,42 @@ void Satellites::update(double deltaTime)
 
 	hintFader.update((int)(deltaTime*1000));
 
+	displayedSatellites.resize(0);
 	foreach(const SatelliteP& sat, satellites)
 	{
 		if (sat->initialized && sat->displayed)
-			sat->update(deltaTime);
+			displayedSatellites.append(sat);
+	}
+
+	// The date and the observer are read once for all the satellites, which the threads of the global
+	// thread pool then compute in blocks. Each satellite is computed as by Satellite::update(double).
+	const gSatWrapper::ObserverContext context = gSatWrapper::getCurrentObserverContext();
+
+	// Most satellites are below the horizon. While the ground hides them, the ones which cannot have
+	// risen since their last propagation keep their position. A new location invalidates the bounds,
+	// and the selected satellites are always propagated for their info string.
+	const bool scheduled = GETSTELMODULE(LandscapeMgr)->getFlagLandscape();
+	if (context.location.latitude != scheduleLocation.latitude || context.location.longitude != scheduleLocation.longitude
+	    || context.location.altitude != scheduleLocation.altitude)
+	{
+		scheduleLocation = context.location;
+		foreach(const SatelliteP& sat, satellites)
+			sat->resetSchedule();
 	}
+	foreach(const StelObjectP& obj, GETSTELMODULE(StelObjectMgr)->getSelectedObject("Satellite"))
+		obj.staticCast<Satellite>()->resetSchedule();
+
+	QAtomicInt skipped;
+	const UpdateSatellite updateSatellite(StelApp::getInstance().getCore()->getJD(), context, scheduled, &skipped);
+	if (displayedSatellites.size() >= 2*MinSatellitesPerThread)
+		QtConcurrent::blockingMap(displayedSatellites, updateSatellite);
+	else
+	{
+		foreach(const SatelliteP& sat, displayedSatellites)
+			updateSatellite(sat);
+	}
+	skippedPropagationCount = skipped.load();
+	propagationCount = displayedSatellites.size() - skippedPropagationCount;
 }
 
 void Satellites::draw(StelCore* core)
@@ -1572,9 +1641,10 @@ void Satellites::draw(StelCore* core)
 	glEnable(GL_TEXTURE_2D);
 	Satellite::hintTexture->bind();
 	Satellite::viewportHalfspace = painter.getProjector()->getBoundingCap();
-	foreach (const SatelliteP& sat, satellites)
+	foreach (const SatelliteP& sat, displayedSatellites)
 	{
-		if (sat && sat->initialized && sat->displayed)
+		// The orbit of a satellite may have been found invalid by update()
+		if (sat->displayed)
 			sat->draw(core, painter, 1.0);
 	}
 
@@ -1657,73 +1727,124 @@ bool Satellites::isValidRangeDates() const
 
 IridiumFlaresPredictionList Satellites::getIridiumFlaresPrediction()
 {
-	StelCore* pcore = StelApp::getInstance().getCore();
-	double currentJD = pcore->getJD(); // save current JD
-	bool isTimeNow = pcore->getIsTimeNow();
-	long iJD =currentJD;
-	double JDMidnight = iJD + 0.5 - pcore->getCurrentLocation().longitude / 360.f;
-	double delta = currentJD - JDMidnight;
-
-	pcore->setJD(iJD + 0.5 - pcore->getCurrentLocation().longitude / 360.f);
-	pcore->update(10); // force update to get new coordinates
+	QList<SatelliteP> iridiums;
+	foreach(const SatelliteP& sat, satellites)
+	{
+		if (sat->getEnglishName().startsWith("IRIDIUM"))
+			iridiums.append(sat);
+	}
 
+	const double currentJD = StelApp::getInstance().getCore()->getJD();
 	IridiumFlaresPredictionList predictions;
-	predictions.clear();
-	foreach(const SatelliteP& sat, satellites)
+	foreach(const SatellitePass& pass, predictPasses(iridiums, currentJD, currentJD+1.))
 	{
-		if (sat->initialized && sat.data()->getEnglishName().startsWith("IRIDIUM"))
+		foreach(const SatelliteFlare& flare, pass.flares)
 		{
-			double dt  = 0;
-			double angle0 = 100;
-			double lat0 = -1;
-			while (dt<1)
-			{
-				Satellite::timeShift = dt+delta;
-				sat.data()->update(0);
+			// The passes in progress at the limits of the day may have flares outside of it
+			if (flare.JD<currentJD || flare.JD>currentJD+1.)
+				continue;
+			IridiumFlaresPrediction prediction;
+			prediction.datetime  = StelUtils::julianDayToISO8601String(flare.JD+StelUtils::getGMTShiftFromQT(flare.JD)/24.f);
+			prediction.satellite = pass.name;
+			prediction.azimuth   = flare.azimuth;
+			prediction.altitude  = flare.altitude;
+			prediction.magnitude = flare.magnitude;
+			predictions.append(prediction);
+		}
+	}
+	return predictions;
+}
+
+SatellitePasses* Satellites::createPassPrediction(const QList<SatelliteP>& sats, double minAltitude) const
+{
+	QList<SatellitePasses::Orbit> orbits;
+	foreach(const SatelliteP& sat, sats)
+	{
+		if (!sat->initialized || !sat->orbitValid)
+			continue;
+		SatellitePasses::Orbit orbit;
+		orbit.id     = sat->id;
+		orbit.name   = sat->name;
+		orbit.tle1   = QString(sat->tleElements.first);
+		orbit.tle2   = QString(sat->tleElements.second);
+		orbit.stdMag = sat->stdMag;
+		orbits.append(orbit);
+	}
 
-				Vec3d pos = sat.data()->getAltAzPosApparent(pcore);
-				double lat = pos.latitude();
-				double lon = M_PI - pos.longitude();
-				double v =   sat.data()->getVMagnitude(pcore);
-				double angle =  sat.data()->sunReflAngle;
+	StelCore* core = StelApp::getInstance().getCore();
+	SatellitePasses* prediction = new SatellitePasses(core, core->getCurrentLocation());
+	prediction->setMinAltitude(minAltitude);
+	prediction->setOrbits(orbits);
+	return prediction;
+}
 
-				if (angle>0 && angle<2)
-				{
-					if (angle>angle0 && (v<1) && lat>5*M_PI/180)
-					{
-						IridiumFlaresPrediction flare;
-						flare.datetime = StelUtils::julianDayToISO8601String(currentJD+dt+StelUtils::getGMTShiftFromQT(currentJD+dt)/24.f);
-						flare.satellite = sat.data()->getEnglishName();
-						flare.azimuth   = lon;
-						flare.altitude  = lat;
-						flare.magnitude = v;
-
-						predictions.append(flare);
-
-						dt +=0.005;
-					}
-					angle0 = angle;
-				}
-				if (angle>0)
-					dt+=0.000002*angle*angle;
-				else
-				{
-					if (lat0>0 && lat<0)
-						dt+=0.05;
-					else
-						dt+=0.0002;
-				}
-				lat0 = lat;
-			}
-		}
+SatellitePasses* Satellites::createPassPrediction(double minAltitude) const
+{
+	return createPassPrediction(satellites, minAltitude);
+}
+
+SatellitePassList Satellites::predictPasses(const QList<SatelliteP>& sats, double startJD, double endJD, double minAltitude) const
+{
+	QScopedPointer<SatellitePasses> prediction(createPassPrediction(sats, minAltitude));
+	return prediction->predict(startJD, endJD);
+}
+
+namespace
+{
+	SatellitePassList runPassPrediction(QSharedPointer<SatellitePasses> prediction, double startJD, double endJD)
+	{
+		return prediction->predict(startJD, endJD);
 	}
-	Satellite::timeShift = 0.;
-	if (isTimeNow)
-		pcore->setTimeNow();
-	else
-		pcore->setJD(currentJD);
+}
 
-	return predictions;
+QFuture<SatellitePassList> Satellites::predictPassesAsync(double startJD, double endJD, double minAltitude) const
+{
+	QSharedPointer<SatellitePasses> prediction(createPassPrediction(minAltitude));
+	return QtConcurrent::run(runPassPrediction, prediction, startJD, endJD);
+}
+
+QVariantList Satellites::getPasses(double startJD, double days, double minAltitude)
+{
+	// The orbits are copied in the main thread, and the passes are computed in the calling one
+	SatellitePasses* created = NULL;
+	QMetaObject::invokeMethod(this, "createPassPrediction",
+				  QThread::currentThread()==thread() ? Qt::DirectConnection : Qt::BlockingQueuedConnection,
+				  Q_RETURN_ARG(SatellitePasses*, created),
+				  Q_ARG(double, minAltitude*M_PI/180.));
+	QScopedPointer<SatellitePasses> prediction(created);
+
+	QVariantList result;
+	foreach(const SatellitePass& pass, prediction->predict(startJD, startJD+days))
+	{
+		QVariantMap map;
+		map["id"] = pass.id;
+		map["name"] = pass.name;
+		map["rise"] = pass.riseJD;
+		map["riseAzimuth"] = pass.riseAzimuth*180./M_PI;
+		map["culmination"] = pass.culminationJD;
+		map["culminationAzimuth"] = pass.culminationAzimuth*180./M_PI;
+		map["culminationAltitude"] = pass.culminationAltitude*180./M_PI;
+		map["set"] = pass.setJD;
+		map["setAzimuth"] = pass.setAzimuth*180./M_PI;
+		map["riseFound"] = pass.riseFound;
+		map["setFound"] = pass.setFound;
+		map["visible"] = pass.visible;
+		map["peakMagnitude"] = pass.peakMagnitude;
+		QVariantList flares;
+		foreach(const SatelliteFlare& flare, pass.flares)
+		{
+			QVariantMap flareMap;
+			flareMap["JD"] = flare.JD;
+			flareMap["azimuth"] = flare.azimuth*180./M_PI;
+			flareMap["altitude"] = flare.altitude*180./M_PI;
+			flareMap["magnitude"] = flare.magnitude;
+			flareMap["reflectionAngle"] = flare.reflectionAngle;
+			flares.append(flareMap);
+		}
+		map["flares"] = flares;
+		result.append(map);
+	}
+	return result;
 }
 
 void Satellites::translations()
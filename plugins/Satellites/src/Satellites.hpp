@@ -22,6 +22,7 @@
 
 #include "StelObjectModule.hpp"
 #include "Satellite.hpp"
+#include "SatellitePasses.hpp"
 #include "StelFader.hpp"
 #include "StelGui.hpp"
 #include "StelDialog.hpp"
@@ -29,9 +30,11 @@
 
 #include <QDateTime>
 #include <QFile>
+#include <QFuture>
 #include <QDir>
 #include <QUrl>
 #include <QVariantMap>
+#include <QVector>
 
 class StelButton;
 class Planet;
@@ -368,8 +371,24 @@ public:
 	bool isAutoAddEnabled() const { return autoAddEnabled; }
 	bool isAutoRemoveEnabled() const { return autoRemoveEnabled; }	
 
+	//! Predict the Iridium flares over the current location during the day after the current date.
 	IridiumFlaresPredictionList getIridiumFlaresPrediction();
 
+	//! Create a prediction of the passes of satellites over the current location (see SatellitePasses),
+	//! with a copy of their orbits, owned by the caller. Must be called from the main thread; the
+	//! prediction may then be computed by any thread, without changing the date nor the satellites.
+	//! @param sats the satellites, of which the ones without a valid orbit are ignored
+	//! @param minAltitude the smallest culmination altitude, in radians
+	SatellitePasses* createPassPrediction(const QList<SatelliteP>& sats, double minAltitude=0.) const;
+	//! Create a prediction of the passes of all the satellites with a valid orbit.
+	Q_INVOKABLE SatellitePasses* createPassPrediction(double minAltitude=0.) const;
+	//! Predict the passes of satellites in the calling thread.
+	//! @param startJD, endJD the range of dates (JD, UT)
+	SatellitePassList predictPasses(const QList<SatelliteP>& sats, double startJD, double endJD, double minAltitude=0.) const;
+	//! Start the prediction of the passes of all the satellites with a valid orbit in the global thread pool.
+	//! Must be called from the main thread, which copies the orbits.
+	QFuture<SatellitePassList> predictPassesAsync(double startJD, double endJD, double minAltitude=0.) const;
+
 signals:
 	void hintsVisibleChanged(bool b);
 	void labelsVisibleChanged(bool b);
@@ -461,6 +480,24 @@ public slots:
 	//! Save the current satellite catalog to disk.
 	void saveCatalog(QString path=QString());
 
+	//! Predict the passes of all the satellites with a valid orbit over the current location, e.g. for scripts.
+	//! May be called from any thread: the orbits are copied by the main thread and the passes are computed
+	//! by the calling one, with the threads of the global thread pool.
+	//! @param startJD the start of the prediction (JD, UT)
+	//! @param days the length of the prediction, in days
+	//! @param minAltitude the smallest culmination altitude, in degrees
+	//! @return a map for each pass, in order of rise: id, name, rise, culmination and set (JD, UT),
+	//! riseAzimuth, culminationAzimuth, culminationAltitude and setAzimuth (in degrees, the azimuth
+	//! from the north), riseFound and setFound (see SatellitePass), visible, peakMagnitude (99 when unknown),
+	//! and a list of Iridium flares with JD, azimuth, altitude, magnitude and reflectionAngle
+	QVariantList getPasses(double startJD, double days, double minAltitude=0.);
+
+	//! Number of the displayed satellites propagated by the last frame.
+	int getPropagationCount() const {return propagationCount;}
+	//! Number of the displayed satellites whose propagation was avoided by the last frame,
+	//! as they were known to be hidden by the ground (see Satellite::updateIfRisen()).
+	int getSkippedPropagationCount() const {return skippedPropagationCount;}
+
 private slots:
 
 private:
@@ -529,6 +566,14 @@ private:
 	QDir dataDir;
 	
 	QList<SatelliteP> satellites;
+	//! The displayed satellites, updated together by update() and drawn by draw().
+	QVector<SatelliteP> displayedSatellites;
+	//! Location of the last update(). The propagations skipped by Satellite::updateIfRisen()
+	//! are only valid for this location.
+	StelLocation scheduleLocation;
+	//! Number of the displayed satellites propagated and not propagated by the last update()
+	int propagationCount;
+	int skippedPropagationCount;
 	SatellitesListModel* satelliteListModel;
 
 	QHash<QString, double> qsMagList;
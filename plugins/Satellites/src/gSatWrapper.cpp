@@ -43,7 +43,33 @@
 #include <QByteArray>
 
 
+gSatWrapper::ObserverContext gSatWrapper::getCurrentObserverContext()
+{
+	StelCore* core = StelApp::getInstance().getCore();
+	SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
+	ObserverContext context;
+	context.location        = core->getCurrentLocation();
+	context.sunEquinoxEqPos = solsystem->getSun()->getEquinoxEquatorialPos(core);
+	context.sunAltAzPos     = solsystem->getSun()->getAltAzPosGeometric(core);
+	return context;
+}
+
+
 gSatWrapper::gSatWrapper(QString designation, QString tle1,QString tle2)
+{
+	createSatellite(designation, tle1, tle2);
+	updateEpoch();
+}
+
+
+gSatWrapper::gSatWrapper(QString designation, QString tle1, QString tle2, double ai_julianDaysEpoch)
+{
+	createSatellite(designation, tle1, tle2);
+	setEpoch(ai_julianDaysEpoch);
+}
+
+
+void gSatWrapper::createSatellite(const QString& designation, const QString& tle1, const QString& tle2)
 {
 	// The TLE library actually modifies the TLE strings, which is annoying (because
 	// when we get updates, we want to check if there has been a change by using ==
@@ -59,7 +85,6 @@ gSatWrapper::gSatWrapper(QString designation, QString tle1,QString tle2)
 	pSatellite = new gSatTEME(designation.toLatin1().data(),
 	                          t1.data(),
 	                          t2.data());
-	updateEpoch();
 }
 
 
@@ -139,9 +164,12 @@ void gSatWrapper::setEpoch(double ai_julianDaysEpoch)
 
 void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity)
 {
+	calcObserverECIPosition(StelApp::getInstance().getCore()->getCurrentLocation(), ao_position, ao_velocity);
+}
 
-	StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
 
+void gSatWrapper::calcObserverECIPosition(const StelLocation& loc, Vec3d& ao_position, Vec3d& ao_velocity)
+{
 	double radLatitude = loc.latitude * KDEG2RAD;
         double theta       = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
 	double r;
@@ -166,8 +194,13 @@ void gSatWrapper::calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_velocity
 
 Vec3d gSatWrapper::getAltAz()
 {
+	return getAltAz(getCurrentObserverContext());
+}
+
 
-	StelLocation loc   = StelApp::getInstance().getCore()->getCurrentLocation();
+Vec3d gSatWrapper::getAltAz(const ObserverContext& context)
+{
+	const StelLocation& loc = context.location;
 	Vec3d topoSatPos;
 	Vec3d observerECIPos;
 	Vec3d observerECIVel;
@@ -175,7 +208,7 @@ Vec3d gSatWrapper::getAltAz()
 	double  radLatitude    = loc.latitude * KDEG2RAD;
         double  theta          = epoch.toThetaLMST(loc.longitude * KDEG2RAD);
 
-	calcObserverECIPosition(observerECIPos, observerECIVel);
+	calcObserverECIPosition(loc, observerECIPos, observerECIVel);
 
 	Vec3d satECIPos  = getTEMEPos();
 	Vec3d slantRange = satECIPos - observerECIPos;
@@ -197,12 +230,17 @@ Vec3d gSatWrapper::getAltAz()
 }
 
 void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRate)
+{
+	getSlantRange(ao_slantRange, ao_slantRangeRate, getCurrentObserverContext());
+}
+
+void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRate, const ObserverContext& context)
 {
 
 	Vec3d observerECIPos;
 	Vec3d observerECIVel;
 
-	calcObserverECIPosition(observerECIPos, observerECIVel);
+	calcObserverECIPosition(context.location, observerECIPos, observerECIVel);
 
 
         Vec3d satECIPos            = getTEMEPos();
@@ -215,17 +253,19 @@ void  gSatWrapper::getSlantRange(double &ao_slantRange, double &ao_slantRangeRat
 }
 
 Vec3d gSatWrapper::getSunECIPos()
+{
+	return getSunECIPos(getCurrentObserverContext());
+}
+
+Vec3d gSatWrapper::getSunECIPos(const ObserverContext& context)
 {
 	// All positions in ECI system are positions referenced in a StelCore::EquinoxEq system centered in the earth centre
 	Vec3d observerECIPos;
 	Vec3d observerECIVel;
 	Vec3d sunECIPos;
-	Vec3d sunEquinoxEqPos;
-
-	calcObserverECIPosition(observerECIPos, observerECIVel);
+	const Vec3d& sunEquinoxEqPos = context.sunEquinoxEqPos;
 
-	SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");
-	sunEquinoxEqPos        = solsystem->getSun()->getEquinoxEquatorialPos(StelApp::getInstance().getCore());
+	calcObserverECIPosition(context.location, observerECIPos, observerECIVel);
 
 	//sunEquinoxEqPos is measured in AU. we need meassure it in Km
 	sunECIPos.set(sunEquinoxEqPos[0]*AU, sunEquinoxEqPos[1]*AU, sunEquinoxEqPos[2]*AU);
@@ -237,6 +277,11 @@ Vec3d gSatWrapper::getSunECIPos()
 // Operation getVisibilityPredict
 // @brief This operation predicts the satellite visibility contidions.
 int gSatWrapper::getVisibilityPredict()
+{
+	return getVisibilityPredict(getCurrentObserverContext());
+}
+
+int gSatWrapper::getVisibilityPredict(const ObserverContext& context)
 {
 	Vec3d satECIPos;
 	Vec3d satAltAzPos;
@@ -246,15 +291,14 @@ int gSatWrapper::getVisibilityPredict()
 	double sunSatAngle, Dist;
 	int   visibility;
 
-	satAltAzPos = getAltAz();
+	satAltAzPos = getAltAz(context);
 
 	if (satAltAzPos[2] > 0)
 	{
 		satECIPos = getTEMEPos();
-		SolarSystem *solsystem = (SolarSystem*)StelApp::getInstance().getModuleMgr().getModule("SolarSystem");		
-		sunAltAzPos        = solsystem->getSun()->getAltAzPosGeometric(StelApp::getInstance().getCore());
+		sunAltAzPos        = context.sunAltAzPos;
 
-		sunECIPos = getSunECIPos();
+		sunECIPos = getSunECIPos(context);
 
 		if (sunAltAzPos[2] > 0.0)
 		{
@@ -281,9 +325,45 @@ int gSatWrapper::getVisibilityPredict()
 	return visibility; //TODO: put correct return
 }
 
+double gSatWrapper::getPeriod()
+{
+	return pSatellite ? pSatellite->getPeriod() : 0.;
+}
+
+double gSatWrapper::getMaxHorizonAngle()
+{
+	if (pSatellite == NULL)
+		return M_PI;
+	// Spherical Earth of the polar radius, the smallest one, with 1% on the apogee and a degree
+	// for the difference of the geodetic and geocentric verticals and the perturbations.
+	double apogeeRadius  = (KEARTHRADIUS + pSatellite->getApogee())*1.01;
+	double observerRadius = KEARTHRADIUS*(1 - __f);
+	if (apogeeRadius <= observerRadius)
+		return M_PI;
+	return qMin(std::acos(observerRadius/apogeeRadius) + KDEG2RAD, M_PI);
+}
+
+double gSatWrapper::getMaxAngularRate()
+{
+	double period = getPeriod();
+	if (!(period > 0))
+		return 0;
+	double apogeeRadius  = KEARTHRADIUS + pSatellite->getApogee();
+	double perigeeRadius = KEARTHRADIUS + pSatellite->getPerigee();
+	double e = (apogeeRadius - perigeeRadius)/(apogeeRadius + perigeeRadius);
+	// Rate at the perigee from the conservation of the angular momentum, with 10% for the perturbations
+	double perigeeRate = (K2PI/period)*Sqr(1 + e)/std::pow(1 - e*e, 1.5)*1.1; // radians/minute
+	return (perigeeRate + KMFACTOR*60)*1440;
+}
+
 double gSatWrapper::getPhaseAngle()
 {
-	Vec3d sunECIPos = getSunECIPos();
+	return getPhaseAngle(getCurrentObserverContext());
+}
+
+double gSatWrapper::getPhaseAngle(const ObserverContext& context)
+{
+	Vec3d sunECIPos = getSunECIPos(context);
 	return sunECIPos.angle(getTEMEPos());
 }
 
@@ -32,6 +32,7 @@
 #include <QString>
 
 #include "VecMath.hpp"
+#include "StelLocation.hpp"
 
 #include "gsatellite/gSatTEME.hpp"
 #include "gsatellite/gTime.hpp"
@@ -48,7 +49,25 @@ class gSatWrapper
 {
 
 public:
+	//! @brief The observer and the Sun, as read from StelCore and SolarSystem by the
+	//! methods without this parameter.
+	//! Reading them once for all the satellites lets the satellites be computed by
+	//! several threads, as the methods taking a context only read it and their own satellite.
+	struct ObserverContext
+	{
+		StelLocation location;
+		//! Position of the Sun in StelCore::FrameEquinoxEqu, in AU
+		Vec3d sunEquinoxEqPos;
+		//! Geometric position of the Sun in StelCore::FrameAltAz
+		Vec3d sunAltAzPos;
+	};
+	//! Read the observer and the Sun at the current time of StelCore. Must be called from the main thread.
+	static ObserverContext getCurrentObserverContext();
+
         gSatWrapper(QString designation, QString tle1,QString tle2);
+	//! Create the wrapper computed at a date instead of the date of StelCore, so that it
+	//! can be created and used in any thread.
+	gSatWrapper(QString designation, QString tle1, QString tle2, double ai_julianDaysEpoch);
         ~gSatWrapper();
 
 	// Operation updateEpoch
@@ -67,6 +86,7 @@ public:
 	//! @brief Get Sun positions in ECI system.
 	//! @return Vec3d with ECI position.
 	Vec3d getSunECIPos();
+	Vec3d getSunECIPos(const ObserverContext& context);
 
 	// Operation getTEMEVel
 	//! @brief This operation isolate gSatTEME getVel operation.
@@ -89,6 +109,7 @@ public:
 	//!   Dr. T.S. Kelso
 	//!   http://www.celestrak.com/columns/v02n02/
 	Vec3d getAltAz();
+	Vec3d getAltAz(const ObserverContext& context);
 
         // Operation getSlantRange
         //! @brief This operation compute the slant range (distance between the
@@ -97,6 +118,7 @@ public:
         //! @param &ao_slantRangeRate Reference to a output variable where the method store the slant range variation in Km/s
         //! @return void
 	void  getSlantRange(double &ao_slantRange, double &ao_slantRangeRate); //meassured in km and km/s
+	void  getSlantRange(double &ao_slantRange, double &ao_slantRangeRate, const ObserverContext& context);
 
 
         // Operation getVisibilityPredict
@@ -115,8 +137,27 @@ public:
         //!   Fundamentals of Astrodynamis and Applications (Third Edition) pg 898
         //!   David A. Vallado
         int getVisibilityPredict();
+	int getVisibilityPredict(const ObserverContext& context);
+
+	//! @brief Get the orbital period of the satellite, from its TLE.
+	//! @return Period measured in minutes
+	double getPeriod();
+
+	// Operation getMaxHorizonAngle
+	//! @brief Bound of the angle, seen from the centre of the Earth, between the observer and
+	//! the satellite while the satellite is above the horizon of the observer.
+	//! It is the angle at the apogee, with a margin for the ellipsoid and the perturbations.
+	//! @return Angle measured in radians
+	double getMaxHorizonAngle();
+
+	// Operation getMaxAngularRate
+	//! @brief Bound of the rate of the angle, seen from the centre of the Earth, between the
+	//! observer and the satellite: the rate of the satellite at the perigee plus the rotation of the Earth.
+	//! @return Rate measured in radians/day
+	double getMaxAngularRate();
 
 	double getPhaseAngle();
+	double getPhaseAngle(const ObserverContext& context);
 	gTime	getEpoch() { return epoch; }
 
 
@@ -134,9 +175,12 @@ public:
         //! @param[out] ao_position Observer ECI position vector measured in Km
         //! @param[out] ao_vel Observer ECI velocity vector measured in Km/s
         void calcObserverECIPosition(Vec3d& ao_position, Vec3d& ao_vel);
+	void calcObserverECIPosition(const StelLocation& loc, Vec3d& ao_position, Vec3d& ao_vel);
 
 
 private:
+	void createSatellite(const QString& designation, const QString& tle1, const QString& tle2);
+
 	gSatTEME *pSatellite;
         gTime	 epoch;
 
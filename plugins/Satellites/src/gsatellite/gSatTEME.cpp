@@ -125,6 +125,21 @@ void gSatTEME::setMinSinceKepEpoch(double ai_minSinceKepEpoch)
 	m_SubPoint    = computeSubPoint( Epoch);
 }
 
+double gSatTEME::getPeriod()
+{
+	return K2PI/satrec.no;
+}
+
+double gSatTEME::getApogee()
+{
+	return satrec.alta*KEARTHRADIUS;
+}
+
+double gSatTEME::getPerigee()
+{
+	return satrec.altp*KEARTHRADIUS;
+}
+
 gVector gSatTEME::computeSubPoint(gTime ai_Time)
 {
 
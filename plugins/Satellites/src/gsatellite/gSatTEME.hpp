@@ -129,6 +129,21 @@ public:
 		return satrec.error;
 	}
 
+	// Operation: getPeriod()
+	//! @brief Get the orbital period, from the mean motion of the Keplerian data
+	//! @return Period measured in minutes
+	double getPeriod();
+
+	// Operation: getApogee()
+	//! @brief Get the altitude of the apogee, from the Keplerian data
+	//! @return Altitude above the equatorial radius measured in Km
+	double getApogee();
+
+	// Operation: getPerigee()
+	//! @brief Get the altitude of the perigee, from the Keplerian data
+	//! @return Altitude above the equatorial radius measured in Km
+	double getPerigee();
+
 private:
 	// Operation:  computeSubPoint
 	//! @brief Compute the Geographic satellite subpoint Vector
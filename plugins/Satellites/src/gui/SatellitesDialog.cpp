@@ -53,6 +53,7 @@ SatellitesDialog::SatellitesDialog()
 	, importWindow(0)
 	, filterModel(0)
 	, checkStateRole(Qt::UserRole)
+	, passesWatcher(this)
 {
 	ui = new Ui_satellitesDialog;
 	dialogName = "Satellites";
@@ -60,6 +61,8 @@ SatellitesDialog::SatellitesDialog()
 
 SatellitesDialog::~SatellitesDialog()
 {
+	passesWatcher.waitForFinished();
+
 	if (updateTimer)
 	{
 		updateTimer->stop();
@@ -85,6 +88,7 @@ void SatellitesDialog::retranslate()
 		populateAboutPage();
 		populateFilterMenu();
 		initListIridiumFlares();
+		initListPasses();
 	}
 }
 
@@ -227,6 +231,11 @@ void SatellitesDialog::createDialogContent()
 	initListIridiumFlares();
 	connect(ui->pushButtonPredictIridiumFlares, SIGNAL(clicked()), this, SLOT(predictIridiumFlares()));
 	connect(ui->iridiumFlaresTreeWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(selectCurrentIridiumFlare(QModelIndex)));
+
+	initListPasses();
+	connect(ui->pushButtonPredictPasses, SIGNAL(clicked()), this, SLOT(predictPasses()));
+	connect(&passesWatcher, SIGNAL(finished()), this, SLOT(showPasses()));
+	connect(ui->passesTreeWidget, SIGNAL(doubleClicked(QModelIndex)), this, SLOT(selectCurrentPass(QModelIndex)));
 }
 
 void SatellitesDialog::filterListByGroup(int index)
@@ -999,6 +1008,11 @@ void SatellitesDialog::selectCurrentIridiumFlare(const QModelIndex &modelIndex)
 	double JD  = StelUtils::getJulianDayFromISO8601String(date.left(10) + "T" + date.right(8), &ok);
 	JD -= StelUtils::getGMTShiftFromQT(JD)/24.;
 
+	selectSatelliteAt(name, JD);
+}
+
+void SatellitesDialog::selectSatelliteAt(const QString& name, double JD)
+{
 	StelObjectMgr* objectMgr = GETSTELMODULE(StelObjectMgr);
 	if (objectMgr->findAndSelectI18n(name) || objectMgr->findAndSelect(name))
 	{
@@ -1012,3 +1026,86 @@ void SatellitesDialog::selectCurrentIridiumFlare(const QModelIndex &modelIndex)
 		}
 	}
 }
+
+void SatellitesDialog::setPassesHeaderNames()
+{
+	QStringList headerStrings;
+	headerStrings << q_("Rise");
+	headerStrings << q_("Culmination");
+	headerStrings << q_("Set");
+	headerStrings << q_("Altitude");
+	headerStrings << q_("Brightness");
+	headerStrings << q_("Satellite");
+
+	ui->passesTreeWidget->setHeaderLabels(headerStrings);
+
+	// adjust the column width
+	for(int i = 0; i < PassesCount; ++i)
+	{
+	    ui->passesTreeWidget->resizeColumnToContents(i);
+	}
+
+	// sort-by-date
+	ui->passesTreeWidget->sortItems(PassesRise, Qt::AscendingOrder);
+}
+
+void SatellitesDialog::initListPasses()
+{
+	ui->passesTreeWidget->clear();
+	ui->passesTreeWidget->setColumnCount(PassesCount);
+	setPassesHeaderNames();
+	ui->passesTreeWidget->header()->setSectionsMovable(false);
+}
+
+void SatellitesDialog::predictPasses()
+{
+	if (passesWatcher.isRunning())
+		return;
+
+	// The orbits are copied here, and the passes are computed in the global thread pool
+	const double JD = StelApp::getInstance().getCore()->getJD();
+	ui->pushButtonPredictPasses->setEnabled(false);
+	passesWatcher.setFuture(GETSTELMODULE(Satellites)->predictPassesAsync(JD, JD+ui->passesDaysSpinBox->value()));
+}
+
+void SatellitesDialog::showPasses()
+{
+	ui->pushButtonPredictPasses->setEnabled(true);
+	ui->passesTreeWidget->clear();
+	foreach (const SatellitePass& pass, passesWatcher.result())
+	{
+		SatPassTreeWidgetItem *treeItem = new SatPassTreeWidgetItem(ui->passesTreeWidget);
+		QString rise = StelUtils::julianDayToISO8601String(pass.riseJD+StelUtils::getGMTShiftFromQT(pass.riseJD)/24.f);
+		QString culmination = StelUtils::julianDayToISO8601String(pass.culminationJD+StelUtils::getGMTShiftFromQT(pass.culminationJD)/24.f);
+		QString set = StelUtils::julianDayToISO8601String(pass.setJD+StelUtils::getGMTShiftFromQT(pass.setJD)/24.f);
+		// The passes cut by the range, e.g. of geostationary satellites, start or end with it
+		treeItem->setText(PassesRise, QString("%1%2 %3").arg(pass.riseFound ? "" : "< ").arg(rise.left(10)).arg(rise.right(8)));
+		treeItem->setData(PassesRise, Qt::UserRole, pass.riseJD);
+		treeItem->setText(PassesCulmination, culmination.right(8));
+		treeItem->setData(PassesCulmination, Qt::UserRole, pass.culminationJD);
+		treeItem->setText(PassesSet, QString("%1%2").arg(pass.setFound ? "" : "> ").arg(set.right(8)));
+		treeItem->setData(PassesSet, Qt::UserRole, pass.setJD);
+		treeItem->setText(PassesAltitude, StelUtils::radToDmsStr(pass.culminationAltitude));
+		treeItem->setData(PassesAltitude, Qt::UserRole, pass.culminationAltitude);
+		treeItem->setTextAlignment(PassesAltitude, Qt::AlignRight);
+		// Invisible passes, and the satellites without standard magnitude, have no magnitude
+		if (pass.peakMagnitude<99.)
+			treeItem->setText(PassesMagnitude, QString::number(pass.peakMagnitude,'f',1));
+		treeItem->setData(PassesMagnitude, Qt::UserRole, pass.peakMagnitude);
+		treeItem->setTextAlignment(PassesMagnitude, Qt::AlignRight);
+		treeItem->setText(PassesSatellite, pass.name);
+	}
+
+	for(int i = 0; i < PassesCount; ++i)
+	{
+	    ui->passesTreeWidget->resizeColumnToContents(i);
+	}
+}
+
+void SatellitesDialog::selectCurrentPass(const QModelIndex &modelIndex)
+{
+	// Select the satellite at its culmination
+	QString name = modelIndex.sibling(modelIndex.row(), PassesSatellite).data().toString();
+	double JD = modelIndex.sibling(modelIndex.row(), PassesCulmination).data(Qt::UserRole).toDouble();
+	selectSatelliteAt(name, JD);
+}
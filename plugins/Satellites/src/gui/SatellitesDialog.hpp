@@ -23,6 +23,7 @@
 #define _SATELLITESDIALOG_HPP_
 
 #include <QObject>
+#include <QFutureWatcher>
 #include <QModelIndex>
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
@@ -58,6 +59,18 @@ public:
 		IridiumFlaresCount	//! total number of columns
 	};
 
+	//! Defines the number and the order of the columns in the Passes table
+	//! @enum PassesColumns
+	enum PassesColumns {
+		PassesRise,		//! date and time of the rise
+		PassesCulmination,	//! time of the culmination
+		PassesSet,		//! time of the set
+		PassesAltitude,		//! altitude of the culmination
+		PassesMagnitude,	//! smallest magnitude while visible
+		PassesSatellite,	//! satellite name
+		PassesCount		//! total number of columns
+	};
+
 	SatellitesDialog();
 	~SatellitesDialog();
 
@@ -112,6 +125,11 @@ private slots:
 	void predictIridiumFlares();
 	void selectCurrentIridiumFlare(const QModelIndex &modelIndex);
 
+	void predictPasses();
+	//! Fill the list of passes when their prediction is finished.
+	void showPasses();
+	void selectCurrentPass(const QModelIndex &modelIndex);
+
 private:
 	//! @todo find out if this is really necessary... --BM
 	void enableSatelliteDataForm(bool enabled);
@@ -138,6 +156,15 @@ private:
 
 	//! Init header and list of Iridium flares
 	void initListIridiumFlares();
+
+	//! Update header names for passes table
+	void setPassesHeaderNames();
+
+	//! Init header and list of passes
+	void initListPasses();
+
+	//! Set the date, then select and track a satellite.
+	void selectSatelliteAt(const QString& name, double JD);
 	
 	Ui_satellitesDialog* ui;
 	bool satelliteModified;
@@ -150,6 +177,9 @@ private:
 	
 	//! Makes sure that newly added source lines are as checkable as the rest.
 	Qt::ItemDataRole checkStateRole;
+
+	//! The prediction of the passes, computed in the global thread pool
+	QFutureWatcher<SatellitePassList> passesWatcher;
 };
 
 // Reimplements the QTreeWidgetItem class to fix the sorting bug
@@ -177,4 +207,30 @@ private:
 	}
 };
 
+// Sorts the passes by the value kept in the Qt::UserRole data of the columns, else by text
+class SatPassTreeWidgetItem : public QTreeWidgetItem
+{
+public:
+	SatPassTreeWidgetItem(QTreeWidget* parent)
+		: QTreeWidgetItem(parent)
+	{
+	}
+
+private:
+	bool operator < (const QTreeWidgetItem &other) const
+	{
+		int column = treeWidget()->sortColumn();
+		QVariant value = data(column, Qt::UserRole);
+
+		if (value.isValid())
+		{
+			return value.toDouble() < other.data(column, Qt::UserRole).toDouble();
+		}
+		else
+		{
+			return text(column).toLower() < other.text(column).toLower();
+		}
+	}
+};
+
 #endif // _SATELLITESDIALOG_HPP_
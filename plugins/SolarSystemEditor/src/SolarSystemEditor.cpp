@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QFile>
 #include <QSettings>
+#include <QSet>
 #include <QString>
 
 #include <cmath>
@@ -333,7 +334,7 @@ QHash<QString,QString> SolarSystemEditor::listAllLoadedObjectsInFile(QString fil
 		return QHash<QString,QString>();
 
 	QStringList groups = solarSystem.childGroups();
-	QStringList planetNames = solarSystemManager->getAllPlanetEnglishNames();
+	const QSet<QString> planetNames = solarSystemManager->getAllPlanetEnglishNames().toSet();
 	QHash<QString,QString> loadedObjects;
 	foreach (QString group, groups)
 	{
@@ -1194,6 +1195,8 @@ bool SolarSystemEditor::appendToSolarSystemConfigurationFile(QList<SsoElements>
 		qDebug() << "Error opening ssystem.ini:" << QDir::toNativeSeparators(customSolarSystemFilePath);
 		return false;
 	}
+	// Listing the groups is linear in the size of the file: it is done once for the whole list
+	QSet<QString> groups = solarSystemSettings->childGroups().toSet();
 	foreach (SsoElements object, objectList)
 	{
 		QString name = object.value("name").toString();
@@ -1207,12 +1210,14 @@ bool SolarSystemEditor::appendToSolarSystemConfigurationFile(QList<SsoElements>
 		if (loadedObjects.contains(name))
 		{
 			solarSystemSettings->remove(loadedObjects.value(name));
+			groups.remove(loadedObjects.value(name));
 			loadedObjects.remove(name);
 		}
-		else if (solarSystemSettings->childGroups().contains(group))
+		else if (groups.contains(group))
 		{
 			loadedObjects.remove(solarSystemSettings->value(group + "/name").toString());
 			solarSystemSettings->remove(group);
+			groups.remove(group);
 		}
 	}
 	solarSystemSettings->sync();
@@ -1226,7 +1231,7 @@ bool SolarSystemEditor::appendToSolarSystemConfigurationFile(QList<SsoElements>
 	if(solarSystemConfigurationFile.open(QFile::WriteOnly | QFile::Append | QFile::Text))
 	{
 		QTextStream output (&solarSystemConfigurationFile);
-		bool appendedAtLeastOne = false;
+		int appendedCount = 0;
 
 		foreach (SsoElements object, objectList)
 		{
@@ -1242,20 +1247,20 @@ bool SolarSystemEditor::appendToSolarSystemConfigurationFile(QList<SsoElements>
 			if (name.isEmpty())
 				continue;
 
-			output << endl << QString("[%1]").arg(sectionName) << endl;
+			// endl would flush the file for each line
+			output << "\n" << QString("[%1]").arg(sectionName) << "\n";
 			foreach(QString key, object.keys())
 			{
-				output << QString("%1 = %2").arg(key).arg(object.value(key).toString()) << endl;
+				output << QString("%1 = %2").arg(key).arg(object.value(key).toString()) << "\n";
 			}
-			output.flush();
-			qDebug() << "Appended successfully" << sectionName;
-			appendedAtLeastOne = true;
+			appendedCount++;
 		}
 
+		output.flush();
 		solarSystemConfigurationFile.close();
-		qDebug() << "appendToSolarSystemConfigurationFile appended: " << appendedAtLeastOne; // GZ
+		qDebug() << "appendToSolarSystemConfigurationFile appended: " << appendedCount; // GZ
 
-		return appendedAtLeastOne;
+		return appendedCount>0;
 	}
 	else
 	{
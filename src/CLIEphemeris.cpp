@@ -0,0 +1,324 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "CLIEphemeris.hpp"
+#include "CLIProcessor.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelObjectMgr.hpp"
+#include "StelUtils.hpp"
+#include "SolarSystem.hpp"
+#include "SolarSystemEphemeris.hpp"
+#include "EphemWrapper.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+	// Number of dates computed for an object by one task, and number of dates computed before
+	// their rows are written, which bounds the memory used by long ephemerides.
+	const int DatesPerTask = 256;
+	const int DatesPerBlock = 16384;
+
+	struct Target
+	{
+		QString name;
+		//! NULL for the objects out of the solar system, which have a fixed direction
+		PlanetP planet;
+		Vec3d j2000EquatorialPos;
+		float vMagnitude;
+	};
+
+	struct Task
+	{
+		int target;
+		int firstDate;
+		int dateCount;
+	};
+
+	//! Computes the positions of a task in its own context, as the tasks run in several threads.
+	struct ComputeTask
+	{
+		typedef void result_type;
+
+		ComputeTask(const SolarSystemEphemeris* ephemeris, const QVector<Target>* targets, const double* dates,
+			    SolarSystemEphemeris::Position* positions, bool* valid)
+			: ephemeris(ephemeris), targets(targets), dates(dates), positions(positions), valid(valid) {}
+
+		void operator()(const Task& task) const
+		{
+			EphemContext context;
+			const Target& target = targets->at(task.target);
+			for (int i=task.firstDate; i<task.firstDate+task.dateCount; ++i)
+			{
+				const int index = i*targets->size()+task.target;
+				if (target.planet)
+					valid[index] = ephemeris->compute(target.planet, dates[i], positions[index], &context);
+				else
+				{
+					valid[index] = ephemeris->computeDirection(target.j2000EquatorialPos, dates[i], positions[index], &context);
+					positions[index].vMagnitude = target.vMagnitude;
+				}
+			}
+		}
+
+		const SolarSystemEphemeris* ephemeris;
+		const QVector<Target>* targets;
+		const double* dates;
+		SolarSystemEphemeris::Position* positions;
+		bool* valid;
+	};
+
+	//! Parse a date given as a JD or as an ISO 8601 UTC date.
+	bool parseDate(const QString& str, double* JD)
+	{
+		bool ok;
+		*JD = str.toDouble(&ok);
+		if (!ok)
+			*JD = StelUtils::getJulianDayFromISO8601String(str, &ok);
+		return ok;
+	}
+
+	//! Angle in [0, 2 pi[, in degrees.
+	double toDegrees0To360(double angle)
+	{
+		angle = std::fmod(angle, 2.*M_PI);
+		if (angle<0.)
+			angle += 2.*M_PI;
+		return angle*180./M_PI;
+	}
+
+	QString jsonString(const QString& str)
+	{
+		QString escaped = str;
+		escaped.replace('\\', "\\\\").replace('"', "\\\"");
+		return QString("\"%1\"").arg(escaped);
+	}
+
+	//! Quote a CSV field as RFC 4180 does: only when it contains a separator, a quote or a line break,
+	//! and with its quotes doubled.
+	QString csvString(const QString& str)
+	{
+		if (!str.contains(',') && !str.contains('"') && !str.contains('\n') && !str.contains('\r'))
+			return str;
+		QString escaped = str;
+		escaped.replace('"', "\"\"");
+		return QString("\"%1\"").arg(escaped);
+	}
+
+	//! Compute the ephemeris and write its rows, in the order of the dates.
+	//! @return the exit status of the program
+	int writeEphemeris(StelApp* app, const QString& names, double startJD, double endJD, double step, bool json,
+			   QFile& output, qint64 startupTime)
+	{
+		StelCore* core = app->getCore();
+		const SolarSystemEphemeris ephemeris(core, core->getCurrentLocation());
+		QVector<Target> targets;
+		foreach (const QString& name, names.split(',', QString::SkipEmptyParts))
+		{
+			Target target;
+			target.name = name.trimmed();
+			target.planet = GETSTELMODULE(SolarSystem)->searchByEnglishName(target.name);
+			target.vMagnitude = 0.f;
+			if (!target.planet)
+			{
+				StelObjectP obj = app->getStelObjectMgr().searchByName(target.name);
+				if (!obj)
+				{
+					qWarning() << "WARNING: --ephemeris object not found:" << target.name;
+					continue;
+				}
+				target.j2000EquatorialPos = obj->getJ2000EquatorialPos(core);
+				target.vMagnitude = obj->getVMagnitude(core);
+			}
+			targets.append(target);
+		}
+		if (targets.isEmpty() || !ephemeris.isValid())
+		{
+			qCritical() << "ERROR: nothing to compute for --ephemeris";
+			return 1;
+		}
+
+		const double direction = app->getFlagSouthAzimuthUsage() ? 2. : 3.; // N is zero, E is 90 degrees
+		QTextStream out(&output);
+		out << (json ? "[" : "object,jd,date,ra_j2000,dec_j2000,ra,dec,azimuth,altitude,distance,vmag\n");
+
+		QElapsedTimer timer;
+		timer.start();
+		qint64 rowCount = 0;
+		qint64 failedCount = 0;
+		const qint64 dateCount = (qint64)std::floor((endJD-startJD)/step + 1e-9) + 1;
+		QVector<double> dates;
+		QVector<SolarSystemEphemeris::Position> positions;
+		QVector<bool> valid;
+		QVector<Task> tasks;
+		for (qint64 first=0; first<dateCount; first+=DatesPerBlock)
+		{
+			const int blockSize = (int)qMin((qint64)DatesPerBlock, dateCount-first);
+			dates.resize(blockSize);
+			for (int i=0; i<blockSize; ++i)
+				dates[i] = startJD + (first+i)*step;
+			positions.resize(blockSize*targets.size());
+			valid.resize(blockSize*targets.size());
+			tasks.clear();
+			for (int t=0; t<targets.size(); ++t)
+			{
+				for (int i=0; i<blockSize; i+=DatesPerTask)
+				{
+					Task task = {t, i, qMin(DatesPerTask, blockSize-i)};
+					tasks.append(task);
+				}
+			}
+			QtConcurrent::blockingMap(tasks, ComputeTask(&ephemeris, &targets, dates.constData(), positions.data(), valid.data()));
+
+			for (int index=0; index<positions.size(); ++index)
+			{
+				if (!valid.at(index))
+				{
+					++failedCount;
+					continue;
+				}
+				const SolarSystemEphemeris::Position& position = positions.at(index);
+				double raJ2000, decJ2000, ra, dec, az, alt;
+				StelUtils::rectToSphe(&raJ2000, &decJ2000, position.j2000EquatorialPos);
+				StelUtils::rectToSphe(&ra, &dec, position.equinoxEquatorialPos);
+				StelUtils::rectToSphe(&az, &alt, position.altAzPos);
+
+				const QString& name = targets.at(index%targets.size()).name;
+				const QString date = StelUtils::julianDayToISO8601String(position.JD);
+				const QString values[9] = {
+					QString::number(toDegrees0To360(raJ2000), 'f', 6), QString::number(decJ2000*180./M_PI, 'f', 6),
+					QString::number(toDegrees0To360(ra), 'f', 6), QString::number(dec*180./M_PI, 'f', 6),
+					QString::number(toDegrees0To360(direction*M_PI - az), 'f', 6), QString::number(alt*180./M_PI, 'f', 6),
+					QString::number(position.distance, 'g', 12), QString::number(position.vMagnitude, 'f', 2),
+					QString::number(position.JD, 'f', 6)};
+				if (json)
+				{
+					out << (rowCount==0 ? "\n" : ",\n")
+					    << "{\"object\":" << jsonString(name) << ",\"jd\":" << values[8] << ",\"date\":" << jsonString(date)
+					    << ",\"raJ2000\":" << values[0] << ",\"decJ2000\":" << values[1]
+					    << ",\"ra\":" << values[2] << ",\"dec\":" << values[3]
+					    << ",\"azimuth\":" << values[4] << ",\"altitude\":" << values[5]
+					    << ",\"distance\":" << values[6] << ",\"vmag\":" << values[7] << "}";
+				}
+				else
+				{
+					out << csvString(name) << ',' << values[8] << ',' << date;
+					for (int v=0; v<8; ++v)
+						out << ',' << values[v];
+					out << '\n';
+				}
+				++rowCount;
+			}
+			out.flush();
+		}
+		if (json)
+			out << "\n]\n";
+		out.flush();
+		const qint64 computeTime = qMax(timer.elapsed(), (qint64)1);
+
+		std::cerr << qPrintable(QString("Ephemeris: started in %1 ms, %2 rows in %3 ms (%4 rows/s) with %5 threads")
+					.arg(startupTime).arg(rowCount).arg(computeTime).arg(qRound64(rowCount*1000./computeTime))
+					.arg(QThreadPool::globalInstance()->maxThreadCount())) << std::endl;
+		if (failedCount>0)
+			qWarning() << "WARNING:" << failedCount << "positions could not be computed for --ephemeris";
+
+		return 0;
+	}
+}
+
+bool CLIEphemeris::isRequested(const QStringList& argList)
+{
+	return CLIProcessor::argsGetOption(argList, "", "--ephemeris");
+}
+
+int CLIEphemeris::run(const QStringList& argList, QSettings* conf)
+{
+	QString names, startStr, endStr, format, outputName;
+	double step;
+	try
+	{
+		names = CLIProcessor::argsGetOptionWithArg(argList, "", "--ephemeris", "").toString();
+		startStr = CLIProcessor::argsGetOptionWithArg(argList, "", "--ephemeris-start", "").toString();
+		endStr = CLIProcessor::argsGetOptionWithArg(argList, "", "--ephemeris-end", "").toString();
+		step = CLIProcessor::argsGetOptionWithArg(argList, "", "--ephemeris-step", 1./24.).toDouble();
+		format = CLIProcessor::argsGetOptionWithArg(argList, "", "--ephemeris-format", "csv").toString().toLower();
+		outputName = CLIProcessor::argsGetOptionWithArg(argList, "", "--ephemeris-output", "").toString();
+	}
+	catch (std::runtime_error& e)
+	{
+		qCritical() << "ERROR: while processing --ephemeris options: " << e.what();
+		return 1;
+	}
+
+	double startJD = StelUtils::getJDFromSystem();
+	if (!startStr.isEmpty() && !parseDate(startStr, &startJD))
+	{
+		qCritical() << "ERROR: --ephemeris-start argument has unrecognised format (I want a JD or yyyy-mm-ddThh:mm:ss)";
+		return 1;
+	}
+	double endJD = startJD+1.;
+	if (!endStr.isEmpty() && !parseDate(endStr, &endJD))
+	{
+		qCritical() << "ERROR: --ephemeris-end argument has unrecognised format (I want a JD or yyyy-mm-ddThh:mm:ss)";
+		return 1;
+	}
+	if (!(step>0.) || endJD<startJD)
+	{
+		qCritical() << "ERROR: invalid range of dates for --ephemeris";
+		return 1;
+	}
+	if (format!="csv" && format!="json")
+	{
+		qCritical() << "ERROR: --ephemeris-format must be csv or json";
+		return 1;
+	}
+	const bool json = format=="json";
+
+	QFile output(outputName);
+	const bool opened = outputName.isEmpty() ? output.open(stdout, QIODevice::WriteOnly) : output.open(QIODevice::WriteOnly|QIODevice::Text);
+	if (!opened)
+	{
+		qCritical() << "ERROR: cannot write the ephemeris to" << outputName << output.errorString();
+		return 1;
+	}
+
+	// No window and no OpenGL context: the modules do not load their textures
+	QElapsedTimer startupTimer;
+	startupTimer.start();
+	StelApp* app = new StelApp();
+	app->initHeadless(conf);
+	const qint64 startupTime = startupTimer.elapsed();
+
+	const int status = writeEphemeris(app, names, startJD, endJD, step, json, output, startupTime);
+	delete app;
+	return status;
+}
@@ -0,0 +1,55 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef CLIEPHEMERIS_HPP
+#define CLIEPHEMERIS_HPP
+
+#include <QStringList>
+
+class QSettings;
+
+//! @class CLIEphemeris
+//! Batch mode of the command line: compute the ephemeris of a list of objects, write it and exit,
+//! without opening the main window.
+//! Only StelCore and the modules needed to find and compute the objects are started (see StelApp::initHeadless()).
+//! No OpenGL context or display is needed: main() selects the offscreen Qt platform,
+//! unless QT_QPA_PLATFORM is set, and the modules load no textures.
+//! The positions are computed by SolarSystemEphemeris by the threads of the global thread pool,
+//! and the rows are written in the order of the dates as soon as a block of dates is computed.
+//!
+//! The options are:
+//! - --ephemeris: comma separated English names of the objects (bodies of the solar system, stars, deep-sky objects)
+//! - --ephemeris-start, --ephemeris-end: the range of dates, as JD or ISO 8601 UTC dates (default: now, one day after the start)
+//! - --ephemeris-step: the interval between the dates, in days (default: 1/24)
+//! - --ephemeris-format: csv or json (default: csv)
+//! - --ephemeris-output: the output file (default: the standard output)
+//! The location is the one of the configuration, or the one given by --latitude, --longitude, --altitude and --home-planet.
+//! The startup time and the number of rows per second are reported on the standard error.
+class CLIEphemeris
+{
+public:
+	//! Whether the command line asks for an ephemeris.
+	static bool isRequested(const QStringList& argList);
+	//! Start the needed modules, compute and write the ephemeris.
+	//! Must be called from the main thread after the configuration is read and parseCLIArgsPostConfig() is done.
+	//! @return the exit status of the program
+	static int run(const QStringList& argList, QSettings* conf);
+};
+
+#endif // CLIEPHEMERIS_HPP
@@ -86,6 +86,12 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 		          << "--fov                   : Specify the field of view (degrees)\n"
 		          << "--projection-type       : Specify projection type, e.g. stereographic\n"
 		          << "--restore-defaults      : Delete existing config.ini and use defaults\n"
+		          << "--ephemeris             : With comma separated object names, write their ephemeris and exit\n"
+		          << "--ephemeris-start       : Start of the ephemeris, as JD or yyyy-mm-ddThh:mm:ss UTC (default: now)\n"
+		          << "--ephemeris-end         : End of the ephemeris (default: one day after the start)\n"
+		          << "--ephemeris-step        : Interval between the dates of the ephemeris in days (default: 1/24)\n"
+		          << "--ephemeris-format      : csv or json (default: csv)\n"
+		          << "--ephemeris-output      : Output file of the ephemeris (default: standard output)\n"
 		          << "--multires-image        : With filename / URL argument, specify a\n"
 		          << "                          multi-resolution image to load\n";
 		exit(0);
@@ -23,6 +23,10 @@
 #include "StelApp.hpp"
 #include "RefractionExtinction.hpp"
 
+#include <algorithm>
+
+const float Extinction::UndergroundSinAltitude = -0.035f;
+
 Extinction::Extinction() : ext_coeff(50), undergroundExtinctionMode(UndergroundExtinctionMirror)
 {
 }
@@ -30,7 +34,7 @@ Extinction::Extinction() : ext_coeff(50), undergroundExtinctionMode(UndergroundE
 // airmass computation for cosine of zenith angle z
 float Extinction::airmass(float cosZ, const bool apparent_z) const
 {
-	if (cosZ<-0.035f) // about -2 degrees. Here, RozenbergZ>574 and climbs fast!
+	if (cosZ<UndergroundSinAltitude) // about -2 degrees. Here, RozenbergZ>574 and climbs fast!
 	{
 		switch (undergroundExtinctionMode)
 		{
@@ -39,7 +43,7 @@ float Extinction::airmass(float cosZ, const bool apparent_z) const
 			case UndergroundExtinctionMax:
 				return 42.f;
 			case UndergroundExtinctionMirror:
-				cosZ = std::min(1.f, -0.035f - (cosZ+0.035f));
+				cosZ = std::min(1.f, UndergroundSinAltitude - (cosZ-UndergroundSinAltitude));
 		}
 	}
 
@@ -59,6 +63,28 @@ float Extinction::airmass(float cosZ, const bool apparent_z) const
 
 /* ***************************************************************************************************** */
 
+const float ExtinctionTable::scale = ExtinctionTable::TableSize/(1.f-Extinction::UndergroundSinAltitude);
+
+ExtinctionTable::ExtinctionTable() : ext_coeff(-1.f), undergroundExtinctionMode(Extinction::UndergroundExtinctionZero)
+{
+	std::fill(magShift, magShift+TableSize+1, 0.f);
+}
+
+void ExtinctionTable::update(const Extinction& extinction)
+{
+	if (extinction.getExtinctionCoefficient()==ext_coeff && extinction.getUndergroundExtinctionMode()==undergroundExtinctionMode)
+		return;
+	ext_coeff = extinction.getExtinctionCoefficient();
+	undergroundExtinctionMode = extinction.getUndergroundExtinctionMode();
+	for (int i=0;i<=TableSize;++i)
+	{
+		const float sinAlt = qMin(1.f, Extinction::UndergroundSinAltitude + i/scale);
+		const Vec3f altAz(std::sqrt(1.f-sinAlt*sinAlt), 0.f, sinAlt);
+		magShift[i] = 0.f;
+		extinction.forward(altAz, &magShift[i]);
+	}
+}
+
 // The following 4 are to be configured, the rest is derived.
 // Recommendations: -4.9/-4.3/0.1/0.1: sharp but continuous transition, no effects below -5.
 //                  -4.3/-4.3/0.7/0.7: sharp but continuous transition, no effects below -5. Maybe better for picking?
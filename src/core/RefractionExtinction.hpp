@@ -90,7 +90,10 @@ public:
 
 	void setUndergroundExtinctionMode(UndergroundExtinctionMode mode) {undergroundExtinctionMode=mode;}
 	UndergroundExtinctionMode getUndergroundExtinctionMode() const {return undergroundExtinctionMode;}
-	
+
+	//! sin(altitude) below which the underground extinction mode applies, about -2 degrees.
+	static const float UndergroundSinAltitude;
+
 private:
 	//! airmass computation for @param cosZ = cosine of zenith angle z (=sin(altitude)!).
 	//! The default (@param apparent_z = true) is computing airmass from observed altitude, following Rozenberg (1966) [X(90)~40].
@@ -108,6 +111,48 @@ private:
 	UndergroundExtinctionMode undergroundExtinctionMode;
 };
 
+//! @class ExtinctionTable
+//! The extinction of Extinction::forward() tabulated against sin(geometric altitude), for drawing
+//! many objects per frame such as the stars of the catalogs. The table is interpolated linearly
+//! above -2 degrees, where the airmass is continuous, and the underground extinction mode is applied
+//! exactly below. The interpolation error is below 0.015 airmass, i.e. 0.003 mag for k=0.2.
+class ExtinctionTable
+{
+public:
+	ExtinctionTable();
+
+	//! Tabulate the extinction. Does nothing if the coefficient and the underground mode did not change.
+	void update(const Extinction& extinction);
+
+	//! Get the magnitude shift of an object, as added by Extinction::forward().
+	//! @param sinAlt the sine of the geometric altitude of the object, i.e. the z component of its normalized AltAz position.
+	float getMagShift(float sinAlt) const
+	{
+		if (sinAlt<Extinction::UndergroundSinAltitude)
+		{
+			switch (undergroundExtinctionMode)
+			{
+				case Extinction::UndergroundExtinctionZero:
+					return 0.f;
+				case Extinction::UndergroundExtinctionMax:
+					return 42.f*ext_coeff;
+				case Extinction::UndergroundExtinctionMirror:
+					sinAlt = qMin(1.f, 2.f*Extinction::UndergroundSinAltitude - sinAlt);
+			}
+		}
+		const float x = (sinAlt-Extinction::UndergroundSinAltitude)*scale;
+		const int i = qMin((int)x, TableSize-1);
+		return magShift[i] + (x-i)*(magShift[i+1]-magShift[i]);
+	}
+
+private:
+	static const int TableSize = 1024;
+	static const float scale;
+	float magShift[TableSize+1];
+	float ext_coeff;
+	Extinction::UndergroundExtinctionMode undergroundExtinctionMode;
+};
+
 //! @class Refraction
 //! This class performs refraction computations, following literature from atmospheric optics and astronomy.
 //! Refraction solutions can only be approximate, given the turbulent, unpredictable real atmosphere.
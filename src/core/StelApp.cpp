@@ -222,6 +222,7 @@ StelApp::StelApp(QObject* parent)
 	, flagNightVision(false)
 	, confSettings(NULL)
 	, initialized(false)
+	, headless(false)
 	, saveProjW(-1)
 	, saveProjH(-1)
 	, baseFontSize(13)
@@ -524,6 +525,56 @@ void StelApp::init(QSettings* conf)
 	initialized = true;
 }
 
+void StelApp::initHeadless(QSettings* conf)
+{
+	confSettings = conf;
+	headless = true;
+
+	core = new StelCore();
+	textureMgr = new StelTextureMgr();
+	textureMgr->init();
+	// Only used if the location is looked up from the IP address
+	networkAccessManager = new QNetworkAccessManager(this);
+
+	propMgr = new StelPropertyMgr();
+	localeMgr = new StelLocaleMgr();
+	skyCultureMgr = new StelSkyCultureMgr();
+	propMgr->registerObject(skyCultureMgr);
+	planetLocationMgr = new StelLocationMgr();
+	actionMgr = new StelActionMgr();
+
+	stelObjectMgr = new StelObjectMgr();
+	stelObjectMgr->init();
+	getModuleMgr().registerModule(stelObjectMgr);
+
+	localeMgr->init();
+
+	SolarSystem* ssystem = new SolarSystem();
+	ssystem->init();
+	getModuleMgr().registerModule(ssystem);
+
+	StarMgr* hip_stars = new StarMgr();
+	hip_stars->init();
+	getModuleMgr().registerModule(hip_stars);
+
+	core->init();
+
+	NebulaMgr* nebulas = new NebulaMgr();
+	nebulas->init();
+	getModuleMgr().registerModule(nebulas);
+
+	ConstellationMgr* asterisms = new ConstellationMgr(hip_stars);
+	asterisms->init();
+	getModuleMgr().registerModule(asterisms);
+
+	skyCultureMgr->init();
+	updateI18n();
+
+	setFlagSouthAzimuthUsage(confSettings->value("gui/flag_use_azimuth_from_south", false).toBool());
+
+	initialized = true;
+}
+
 // Load and initialize external modules (plugins)
 void StelApp::initPlugIns()
 {
@@ -79,6 +79,14 @@ public:
 
 	//! Initialize core and all the modules.
 	void init(QSettings* conf);
+	//! Initialize only core and the modules needed to compute positions and to find objects by name:
+	//! StelObjectMgr, SolarSystem, StarMgr, NebulaMgr and ConstellationMgr (for the names of the stars).
+	//! Used by the command line modes which do not open a window. No OpenGL context is needed:
+	//! the textures and the shaders are not loaded (see isHeadless()).
+	void initHeadless(QSettings* conf);
+	//! Whether the application was started by initHeadless(), without OpenGL.
+	//! The modules must then not load textures or shaders, nor draw.
+	bool isHeadless() const {return headless;}
 	//! Deinitialize core and all the modules.
 	void deinit();
 
@@ -352,6 +360,8 @@ private:
 
 	// Define whether the StelApp instance has completed initialization
 	bool initialized;
+	// Define whether the StelApp instance was initialized without OpenGL
+	bool headless;
 
 	static qint64 startMSecs;
 	static float animationScale;
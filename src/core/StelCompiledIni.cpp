@@ -0,0 +1,290 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelCompiledIni.hpp"
+#include "StelIniParser.hpp"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMap>
+#include <QPair>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+
+// Layout of the binary file, all integers being little endian quint32:
+// - header: magic, version, SHA-1 hash of the ini file (20 bytes), number of keys, of sections
+//   and of entries, size of the string pool
+// - key table: offset and length of each key name in the string pool
+// - section table: offset and length of the name, first entry and number of entries of each section
+// - entry table: key number, offset and length of the value of each entry
+// - string pool: the names and values in UTF-8
+namespace
+{
+	const quint32 FileMagic = 0x494E4953;	// "SINI"
+	const quint32 FileVersion = 1;
+	const int HashSize = 20;
+	const int HeaderSize = 8+HashSize+16;
+	const int KeySize = 8;
+	const int SectionSize = 16;
+	const int EntrySize = 12;
+
+	inline quint32 readU32(const uchar* p)
+	{
+		return qFromLittleEndian<quint32>(p);
+	}
+
+	void appendU32(QByteArray& out, quint32 value)
+	{
+		uchar buf[4];
+		qToLittleEndian<quint32>(value, buf);
+		out.append(reinterpret_cast<const char*>(buf), 4);
+	}
+
+	// Append a string to the pool, once for all its occurrences
+	void appendString(QByteArray& pool, QHash<QByteArray, quint32>& pooled, const QString& string, QByteArray& table)
+	{
+		const QByteArray utf8 = string.toUtf8();
+		QHash<QByteArray, quint32>::const_iterator it = pooled.constFind(utf8);
+		quint32 offset;
+		if (it!=pooled.constEnd())
+			offset = it.value();
+		else
+		{
+			offset = pool.size();
+			pool.append(utf8);
+			pooled.insert(utf8, offset);
+		}
+		appendU32(table, offset);
+		appendU32(table, utf8.size());
+	}
+}
+
+StelCompiledIni::StelCompiledIni(const QString& iniPath, const QString& cachePath)
+	: valid(false)
+	, loadedFromCache(false)
+	, keyTable(NULL)
+	, sectionTable(NULL)
+	, entryTable(NULL)
+	, stringPool(NULL)
+{
+	QFile iniFile(iniPath);
+	if (!iniFile.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "Cannot read" << QDir::toNativeSeparators(iniPath) << iniFile.errorString();
+		return;
+	}
+	QByteArray content = iniFile.readAll();
+	iniFile.close();
+	const QByteArray hash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+
+	if (!cachePath.isEmpty())
+	{
+		cacheFile.setFileName(cachePath);
+		if (cacheFile.open(QIODevice::ReadOnly))
+		{
+			qint64 size = cacheFile.size();
+			const uchar* mapped = cacheFile.map(0, size);
+			if (!mapped)
+			{
+				bytes = cacheFile.readAll();
+				mapped = reinterpret_cast<const uchar*>(bytes.constData());
+				size = bytes.size();
+			}
+			if (setData(mapped, size, hash))
+			{
+				valid = true;
+				loadedFromCache = true;
+				return;
+			}
+			// Stale or invalid: it will be replaced
+			cacheFile.close();
+			bytes.clear();
+		}
+	}
+
+	QBuffer buffer(&content);
+	buffer.open(QIODevice::ReadOnly);
+	QSettings::SettingsMap map;
+	if (!readStelIniFile(buffer, map))
+	{
+		qWarning() << "ERROR while parsing" << QDir::toNativeSeparators(iniPath);
+		return;
+	}
+	bytes = compile(map, hash);
+	valid = setData(reinterpret_cast<const uchar*>(bytes.constData()), bytes.size(), hash);
+	Q_ASSERT(valid);
+
+	if (!cachePath.isEmpty())
+	{
+		QDir().mkpath(QFileInfo(cachePath).absolutePath());
+		QSaveFile out(cachePath);
+		if (!out.open(QIODevice::WriteOnly) || out.write(bytes)!=bytes.size() || !out.commit())
+			qWarning() << "Cannot write" << QDir::toNativeSeparators(cachePath) << out.errorString();
+	}
+}
+
+QByteArray StelCompiledIni::compile(const QSettings::SettingsMap& map, const QByteArray& sourceHash)
+{
+	Q_ASSERT(sourceHash.size()==HashSize);
+
+	// Group the keys by section, the keys before the first section being in the section ""
+	typedef QList<QPair<QString, QString> > Entries;
+	QMap<QString, Entries> sections;
+	for (QSettings::SettingsMap::const_iterator it=map.constBegin(); it!=map.constEnd(); ++it)
+	{
+		const int slash = it.key().indexOf('/');
+		sections[slash<0 ? QString() : it.key().left(slash)].append(qMakePair(it.key().mid(slash+1), it.value().toString()));
+	}
+
+	QByteArray pool;
+	QHash<QByteArray, quint32> pooled;
+	QHash<QString, quint32> keyIds;
+	QByteArray keys, sectionTable, entries;
+	quint32 entryCount = 0;
+	for (QMap<QString, Entries>::const_iterator s=sections.constBegin(); s!=sections.constEnd(); ++s)
+	{
+		appendString(pool, pooled, s.key(), sectionTable);
+		appendU32(sectionTable, entryCount);
+		appendU32(sectionTable, s.value().size());
+		foreach (const Entries::value_type& entry, s.value())
+		{
+			QHash<QString, quint32>::const_iterator k = keyIds.constFind(entry.first);
+			if (k==keyIds.constEnd())
+			{
+				k = keyIds.insert(entry.first, keyIds.size());
+				appendString(pool, pooled, entry.first, keys);
+			}
+			appendU32(entries, k.value());
+			appendString(pool, pooled, entry.second, entries);
+			++entryCount;
+		}
+	}
+
+	QByteArray out;
+	appendU32(out, FileMagic);
+	appendU32(out, FileVersion);
+	out.append(sourceHash);
+	appendU32(out, keyIds.size());
+	appendU32(out, sections.size());
+	appendU32(out, entryCount);
+	appendU32(out, pool.size());
+	out.append(keys);
+	out.append(sectionTable);
+	out.append(entries);
+	out.append(pool);
+	return out;
+}
+
+bool StelCompiledIni::setData(const uchar* d, qint64 size, const QByteArray& sourceHash)
+{
+	if (size<HeaderSize || readU32(d)!=FileMagic || readU32(d+4)!=FileVersion
+	    || sourceHash.size()!=HashSize || std::memcmp(d+8, sourceHash.constData(), HashSize)!=0)
+		return false;
+	const quint32 keyCount = readU32(d+8+HashSize);
+	const quint32 sectionCount = readU32(d+12+HashSize);
+	const quint32 entryCount = readU32(d+16+HashSize);
+	const quint32 poolSize = readU32(d+20+HashSize);
+	if ((qint64)HeaderSize + (qint64)KeySize*keyCount + (qint64)SectionSize*sectionCount
+	    + (qint64)EntrySize*entryCount + poolSize != size)
+		return false;
+	const uchar* keys = d+HeaderSize;
+	const uchar* sections = keys+KeySize*keyCount;
+	const uchar* entries = sections+SectionSize*sectionCount;
+	const uchar* pool = entries+EntrySize*entryCount;
+
+	// Check all the offsets once, so that value() can trust them
+	for (quint32 i=0;i<keyCount;++i)
+	{
+		const uchar* k = keys+KeySize*i;
+		if ((quint64)readU32(k)+readU32(k+4)>poolSize)
+			return false;
+	}
+	for (quint32 i=0;i<sectionCount;++i)
+	{
+		const uchar* s = sections+SectionSize*i;
+		if ((quint64)readU32(s)+readU32(s+4)>poolSize || (quint64)readU32(s+8)+readU32(s+12)>entryCount)
+			return false;
+	}
+	for (quint32 i=0;i<entryCount;++i)
+	{
+		const uchar* e = entries+EntrySize*i;
+		if (readU32(e)>=keyCount || (quint64)readU32(e+4)+readU32(e+8)>poolSize)
+			return false;
+	}
+
+	keyTable = keys;
+	sectionTable = sections;
+	entryTable = entries;
+	stringPool = pool;
+
+	sectionNames.clear();
+	sectionIndex.clear();
+	keyIds.clear();
+	for (quint32 i=0;i<sectionCount;++i)
+	{
+		const uchar* s = sectionTable+SectionSize*i;
+		const QString name = string(readU32(s), readU32(s+4));
+		sectionIndex.insert(name, i);
+		if (!name.isEmpty())
+			sectionNames << name;
+	}
+	for (quint32 i=0;i<keyCount;++i)
+	{
+		const uchar* k = keyTable+KeySize*i;
+		keyIds.insert(string(readU32(k), readU32(k+4)), i);
+	}
+	return true;
+}
+
+QString StelCompiledIni::string(quint32 offset, quint32 length) const
+{
+	return QString::fromUtf8(reinterpret_cast<const char*>(stringPool+offset), length);
+}
+
+QStringList StelCompiledIni::childGroups() const
+{
+	return sectionNames;
+}
+
+QVariant StelCompiledIni::value(const QString& key, const QVariant& defaultValue) const
+{
+	const int slash = key.indexOf('/');
+	QHash<QString, int>::const_iterator s = sectionIndex.constFind(slash<0 ? QString() : key.left(slash));
+	if (s==sectionIndex.constEnd())
+		return defaultValue;
+	QHash<QString, quint32>::const_iterator k = keyIds.constFind(key.mid(slash+1));
+	if (k==keyIds.constEnd())
+		return defaultValue;
+
+	const uchar* section = sectionTable+SectionSize*s.value();
+	const quint32 first = readU32(section+8);
+	const quint32 end = first+readU32(section+12);
+	for (quint32 i=first;i<end;++i)
+	{
+		const uchar* entry = entryTable+EntrySize*i;
+		if (readU32(entry)==k.value())
+			return QVariant(string(readU32(entry+4), readU32(entry+8)));
+	}
+	return defaultValue;
+}
@@ -0,0 +1,90 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELCOMPILEDINI_HPP_
+#define _STELCOMPILEDINI_HPP_
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QSettings>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+//! @class StelCompiledIni
+//! Read only access to an ini file in StelIniFormat through a compiled binary cache.
+//! Parsing a large ini file with QSettings takes time, so the parsed sections are written to a
+//! binary file which is then used as long as the ini file keeps the same content (checked by its
+//! SHA-1 hash). The binary file is mapped in memory (or read at once when it cannot be mapped),
+//! and the values are only converted to QString when asked for.
+//! When the binary file is missing or stale, the ini file is parsed and the binary file rewritten.
+//!
+//! The values are the ones of a QSettings reading the ini file: value() and childGroups() can
+//! replace the ones of QSettings.
+class StelCompiledIni
+{
+public:
+	//! Open an ini file.
+	//! @param iniPath the ini file
+	//! @param cachePath the binary file. If empty, the ini file is parsed without cache.
+	StelCompiledIni(const QString& iniPath, const QString& cachePath);
+
+	//! Return QSettings::NoError if the ini file could be read, QSettings::AccessError otherwise.
+	QSettings::Status status() const {return valid ? QSettings::NoError : QSettings::AccessError;}
+	//! Return true if the values come from an up to date binary file.
+	bool isLoadedFromCache() const {return loadedFromCache;}
+
+	//! Return the names of the sections, in the order of QSettings::childGroups().
+	QStringList childGroups() const;
+	//! Return the value of a key.
+	//! @param key "section/name", or "name" for the keys before the first section
+	QVariant value(const QString& key, const QVariant& defaultValue=QVariant()) const;
+
+	//! Parse an ini file into the binary format.
+	//! @param sourceHash the SHA-1 hash of the content of the ini file
+	static QByteArray compile(const QSettings::SettingsMap& map, const QByteArray& sourceHash);
+
+private:
+	Q_DISABLE_COPY(StelCompiledIni)
+
+	//! Use a binary file, after checking it: all the offsets must be inside the data.
+	//! @return false if the data is not a valid binary file for the source hash
+	bool setData(const uchar* data, qint64 size, const QByteArray& sourceHash);
+	//! Decode a string of the string pool.
+	QString string(quint32 offset, quint32 length) const;
+
+	bool valid;
+	bool loadedFromCache;
+
+	// The binary file, either mapped from cacheFile or held in bytes
+	QFile cacheFile;
+	QByteArray bytes;
+	const uchar* keyTable;
+	const uchar* sectionTable;
+	const uchar* entryTable;
+	const uchar* stringPool;
+
+	QStringList sectionNames;
+	QHash<QString, int> sectionIndex;
+	QHash<QString, quint32> keyIds;
+};
+
+#endif // _STELCOMPILEDINI_HPP_
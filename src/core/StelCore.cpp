@@ -122,6 +122,7 @@ StelCore::StelCore()
 
 StelCore::~StelCore()
 {
+	EphemWrapper::stop_chebyshev_cache();
 	delete toneReproducer; toneReproducer=NULL;
 	delete geodesicGrid; geodesicGrid=NULL;
 	delete skyDrawer; skyDrawer=NULL;
@@ -782,7 +783,7 @@ StelProjector::ModelViewTranformP StelCore::getObservercentricEclipticJ2000Model
 //! Get the modelview matrix for observer-centric ecliptic-of-date drawing
 StelProjector::ModelViewTranformP StelCore::getObservercentricEclipticOfDateModelViewTransform(RefractionMode refMode) const
 {
-	double eps_A=getPrecessionAngleVondrakCurrentEpsilonA();
+	double eps_A=getPrecessionAngleVondrakEpsilon(getJDE());
 	if (refMode==RefractionOff || skyDrawer==NULL || (refMode==RefractionAuto && skyDrawer->getFlagHasAtmosphere()==false))
 		return StelProjector::ModelViewTranformP(new StelProjector::Mat4dTransform(matAltAzModelView*matEquinoxEquToAltAz* Mat4d::xrotation(eps_A)));
 	Refraction* refr = new Refraction(skyDrawer->getRefraction());
@@ -2117,4 +2118,14 @@ void StelCore::initEphemeridesFunctions()
 		EphemWrapper::init_de431(de431FilePath.toStdString().c_str());
 	}
 	setDe431Active(de431Available && conf->value("astro/flag_use_de431", false).toBool());
+
+	//<-- Chebyshev approximations of VSOP87 and ELP82B -->
+	if (conf->value("astro/flag_ephemeris_cache", true).toBool())
+	{
+		double startJDE, endJDE;
+		StelUtils::getJDFromDate(&startJDE, conf->value("astro/ephemeris_cache_start_year", 1950).toInt(), 1, 1, 0, 0, 0);
+		StelUtils::getJDFromDate(&endJDE, conf->value("astro/ephemeris_cache_end_year", 2050).toInt(), 1, 1, 0, 0, 0);
+		EphemWrapper::init_chebyshev_cache(StelFileMgr::getCacheDir() + "/ephemeris", startJDE, endJDE,
+						   conf->value("astro/ephemeris_cache_tolerance", 1e-9).toDouble());
+	}
 }
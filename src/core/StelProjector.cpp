@@ -25,6 +25,7 @@
 
 #include <QDebug>
 #include <QString>
+#include <typeinfo>
 
 StelProjector::Mat4dTransform::Mat4dTransform(const Mat4d& m)
     : transfoMat(m),
@@ -240,6 +241,27 @@ SphericalRegionP StelProjector::getViewportConvexPolygon(float marginX, float ma
 	return SphericalRegionP(new SphericalCap(hp));
 }
 
+// Return whether this projector and other project any point to the same screen position.
+bool StelProjector::isSameProjection(const StelProjector& other) const
+{
+	if (typeid(*this)!=typeid(other))
+		return false;
+	if (flipHorz!=other.flipHorz || flipVert!=other.flipVert || pixelPerRad!=other.pixelPerRad || maskType!=other.maskType
+	    || zNear!=other.zNear || oneOverZNearMinusZFar!=other.oneOverZNearMinusZFar || viewportXywh!=other.viewportXywh
+	    || viewportCenter!=other.viewportCenter || viewportCenterOffset!=other.viewportCenterOffset
+	    || viewportFovDiameter!=other.viewportFovDiameter || devicePixelsPerPixel!=other.devicePixelsPerPixel
+	    || widthStretch!=other.widthStretch)
+		return false;
+	const Mat4d m1 = modelViewTransform->getApproximateLinearTransfo();
+	const Mat4d m2 = other.modelViewTransform->getApproximateLinearTransfo();
+	for (int i=0;i<16;++i)
+	{
+		if (m1.r[i]!=m2.r[i])
+			return false;
+	}
+	return true;
+}
+
 const SphericalCap& StelProjector::getBoundingCap() const
 {
 	return boundingCap;
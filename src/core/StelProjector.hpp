@@ -276,6 +276,10 @@ public:
 	//! Get the current projection matrix.
 	Mat4f getProjectionMatrix() const;
 
+	//! Return whether this projector and @em other project any point to the same screen position.
+	//! This can be used to reuse projected positions between frames when the view did not change.
+	bool isSameProjection(const StelProjector& other) const;
+
 	///////////////////////////////////////////////////////////////////////////
 	//! Get a string description of a StelProjectorMaskType.
 	static const QString maskTypeToString(StelProjectorMaskType type);
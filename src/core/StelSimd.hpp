@@ -0,0 +1,86 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELSIMD_HPP_
+#define _STELSIMD_HPP_
+
+//! @file StelSimd.hpp
+//! Support for the vectorized kernels (see StarPositionKernel and KeplerBatch).
+//! The kernels are only available for x86 CPUs. They are compiled with function level
+//! target attributes, so that the rest of Stellarium does not require SSE2 or AVX2 to run,
+//! and the best one is chosen at runtime with StelSimd::cpuHasSSE2() and StelSimd::cpuHasAVX2().
+//! STEL_SIMD_X86 is defined when the kernels can be compiled.
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+ #define STEL_SIMD_X86
+ #define STEL_TARGET_SSE2 __attribute__((target("sse2")))
+ #define STEL_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+ #define STEL_SIMD_X86
+ #define STEL_TARGET_SSE2
+ #define STEL_TARGET_AVX2
+ #include <intrin.h>
+#endif
+
+#ifdef STEL_SIMD_X86
+ #include <immintrin.h>
+
+namespace StelSimd
+{
+	//! Whether the CPU and the OS support the AVX2 instructions.
+	inline bool cpuHasAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0]<7)
+			return false;
+		__cpuid(info, 1);
+		// The OS must save the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+		const bool osxsave = (info[2] & (1<<27)) && (info[2] & (1<<28));
+		if (!osxsave || (_xgetbv(0) & 6)!=6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1<<5))!=0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	//! Whether the CPU supports the SSE2 instructions.
+	inline bool cpuHasSSE2()
+	{
+#if defined(_MSC_VER)
+ #if defined(_M_X64)
+		return true;
+ #else
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1<<26))!=0;
+ #endif
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2");
+#endif
+	}
+}
+#endif // STEL_SIMD_X86
+
+#endif // _STELSIMD_HPP_
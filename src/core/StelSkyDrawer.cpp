@@ -36,6 +36,7 @@
 #include "StelMovementMgr.hpp"
 #include "StelPainter.hpp"
 
+#include <QOpenGLBuffer>
 #include <QOpenGLContext>
 #include <QOpenGLShaderProgram>
 #include <QStringList>
@@ -43,13 +44,19 @@
 #include <QDebug>
 #include <QtGlobal>
 
+#include <cstddef>
+
 // The 0.025 corresponds to the maximum eye resolution in degree
 #define EYE_RESOLUTION (0.25f)
 #define MAX_LINEAR_RADIUS 8.f
 
+// Number of batches of point sources held by the instance buffer before it is orphaned
+static const int InstanceBufferBatches = 4;
+
 StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	core(acore),
 	eye(acore->getToneReproducer()),
+	j2000Zenith(0.f, 0.f, 1.f),
 	maxAdaptFov(180.f),
 	minAdaptFov(0.1f),
 	lnfovFactor(0.f),
@@ -60,8 +67,21 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	limitLuminance(0.f),
 	bortleScaleIndex(3),
 	inScale(1.f),
+	vertexArray(NULL),
+	textureCoordArray(NULL),
 	starShaderProgram(NULL),
 	starShaderVars(StarShaderVars()),
+	useInstancing(false),
+	instanceArray(NULL),
+	cornerBuffer(NULL),
+	instanceBuffer(NULL),
+	instanceBufferOffset(0),
+	starInstancedShaderProgram(NULL),
+	starInstancedShaderVars(StarInstancedShaderVars()),
+	vertexAttribDivisorFunc(NULL),
+	drawArraysInstancedFunc(NULL),
+	nbPointSources(0),
+	maxPointSources(0),
 	maxLum(0.f),
 	oldLum(-1.f),
 	big3dModelHaloRadius(150.f)
@@ -117,20 +137,6 @@ StelSkyDrawer::StelSkyDrawer(StelCore* acore) :
 	if (!ok)
 		setAtmospherePressure(1013.0);
 
-	// Initialize buffers for use by gl vertex array
-	nbPointSources = 0;
-	maxPointSources = 1000;
-	
-	
-	vertexArray = new StarVertex[maxPointSources*6];
-	
-	textureCoordArray = new unsigned char[maxPointSources*6*2];
-	for (unsigned int i=0;i<maxPointSources; ++i)
-	{
-		static const unsigned char texElems[] = {0, 0, 255, 0, 255, 255, 0, 0, 255, 255, 0, 255};
-		unsigned char* elem = &textureCoordArray[i*6*2];
-		memcpy(elem, texElems, 12);
-	}
 }
 
 StelSkyDrawer::~StelSkyDrawer()
@@ -139,14 +145,29 @@ StelSkyDrawer::~StelSkyDrawer()
 	vertexArray = NULL;
 	delete[] textureCoordArray;
 	textureCoordArray = NULL;
+	delete[] instanceArray;
+	instanceArray = NULL;
 	
 	delete starShaderProgram;
 	starShaderProgram = NULL;
+	delete starInstancedShaderProgram;
+	starInstancedShaderProgram = NULL;
+	delete cornerBuffer;
+	cornerBuffer = NULL;
+	delete instanceBuffer;
+	instanceBuffer = NULL;
 }
 
 // Init parameters from config file
 void StelSkyDrawer::init()
 {
+	// Nothing is drawn by the command line modes, which have no OpenGL context
+	if (StelApp::getInstance().isHeadless())
+	{
+		update(0);
+		return;
+	}
+
 	// Load star texture no mipmap:
 	texHalo = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/star16x16.png");
 	texBigHalo = StelApp::getInstance().getTextureManager().createTexture(StelFileMgr::getInstallationDir()+"/textures/haloLune.png");
@@ -193,9 +214,129 @@ void StelSkyDrawer::init()
 	starShaderVars.color = starShaderProgram->attributeLocation("color");
 	starShaderVars.texture = starShaderProgram->uniformLocation("tex");
 
+	// Initialize buffers for use by gl vertex array. With instancing, a source is 16 bytes
+	// instead of 6 vertices of 12 bytes plus their texture coordinates, so more fit in a batch.
+	QSettings* conf = StelApp::getInstance().getSettings();
+	useInstancing = conf->value("stars/flag_instanced_point_sources", true).toBool() && initInstancing();
+	nbPointSources = 0;
+	if (useInstancing)
+	{
+		maxPointSources = 65536;
+		instanceArray = new StarInstance[maxPointSources];
+		instanceBuffer->bind();
+		instanceBuffer->allocate(InstanceBufferBatches*maxPointSources*sizeof(StarInstance));
+		instanceBuffer->release();
+		instanceBufferOffset = 0;
+	}
+	else
+	{
+		maxPointSources = 10000;
+		vertexArray = new StarVertex[maxPointSources*6];
+		textureCoordArray = new unsigned char[maxPointSources*6*2];
+		for (unsigned int i=0;i<maxPointSources; ++i)
+		{
+			static const unsigned char texElems[] = {0, 0, 255, 0, 255, 255, 0, 0, 255, 255, 0, 255};
+			unsigned char* elem = &textureCoordArray[i*6*2];
+			memcpy(elem, texElems, 12);
+		}
+	}
+
 	update(0);
 }
 
+bool StelSkyDrawer::initInstancing()
+{
+	QOpenGLContext* context = QOpenGLContext::currentContext();
+	if (!context)
+		return false;
+
+	// Find the entry points: core in OpenGL 3.3 and OpenGL ES 3.0, else from an extension
+	const QSurfaceFormat format = context->format();
+	const char* suffix = NULL;
+	if (context->isOpenGLES())
+	{
+		if (format.majorVersion()>=3)
+			suffix = "";
+		else if (context->hasExtension("GL_EXT_instanced_arrays"))
+			suffix = "EXT";
+		else if (context->hasExtension("GL_ANGLE_instanced_arrays"))
+			suffix = "ANGLE";
+	}
+	else
+	{
+		if (format.version()>=qMakePair(3, 3))
+			suffix = "";
+		else if (context->hasExtension("GL_ARB_instanced_arrays"))
+			suffix = "ARB";
+	}
+	if (!suffix)
+		return false;
+	vertexAttribDivisorFunc = context->getProcAddress(QByteArray("glVertexAttribDivisor")+suffix);
+	drawArraysInstancedFunc = context->getProcAddress(QByteArray("glDrawArraysInstanced")+suffix);
+	if (!vertexAttribDivisorFunc || !drawArraysInstancedFunc)
+		return false;
+
+	// Each instance is a quad whose corners are stretched by the radius of the source
+	QOpenGLShader vshader(QOpenGLShader::Vertex);
+	const char *vsrc =
+		"attribute mediump vec2 corner;\n"
+		"attribute mediump vec3 posRadius;\n"
+		"attribute mediump vec3 color;\n"
+		"uniform mediump mat4 projectionMatrix;\n"
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec3 outColor;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_Position = projectionMatrix * vec4(posRadius.xy + corner*posRadius.z, 0, 1);\n"
+		"    texc = corner*0.5 + 0.5;\n"
+		"    outColor = color;\n"
+		"}\n";
+	vshader.compileSourceCode(vsrc);
+	if (!vshader.log().isEmpty()) { qWarning() << "StelSkyDrawer::initInstancing(): Warnings while compiling vshader: " << vshader.log(); }
+
+	QOpenGLShader fshader(QOpenGLShader::Fragment);
+	const char *fsrc =
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec3 outColor;\n"
+		"uniform sampler2D tex;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_FragColor = texture2D(tex, texc)*vec4(outColor, 1.);\n"
+		"}\n";
+	fshader.compileSourceCode(fsrc);
+	if (!fshader.log().isEmpty()) { qWarning() << "StelSkyDrawer::initInstancing(): Warnings while compiling fshader: " << fshader.log(); }
+
+	starInstancedShaderProgram = new QOpenGLShaderProgram(context);
+	starInstancedShaderProgram->addShader(&vshader);
+	starInstancedShaderProgram->addShader(&fshader);
+	// Some drivers require the generic attribute 0 not to be instanced
+	starInstancedShaderProgram->bindAttributeLocation("corner", 0);
+	if (!StelPainter::linkProg(starInstancedShaderProgram, "starInstancedShader"))
+	{
+		delete starInstancedShaderProgram;
+		starInstancedShaderProgram = NULL;
+		return false;
+	}
+	starInstancedShaderVars.projectionMatrix = starInstancedShaderProgram->uniformLocation("projectionMatrix");
+	starInstancedShaderVars.corner = starInstancedShaderProgram->attributeLocation("corner");
+	starInstancedShaderVars.posRadius = starInstancedShaderProgram->attributeLocation("posRadius");
+	starInstancedShaderVars.color = starInstancedShaderProgram->attributeLocation("color");
+	starInstancedShaderVars.texture = starInstancedShaderProgram->uniformLocation("tex");
+
+	static const GLfloat corners[] = {-1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f};
+	cornerBuffer = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	cornerBuffer->setUsagePattern(QOpenGLBuffer::StaticDraw);
+	cornerBuffer->create();
+	cornerBuffer->bind();
+	cornerBuffer->allocate(corners, sizeof(corners));
+	cornerBuffer->release();
+
+	instanceBuffer = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	instanceBuffer->setUsagePattern(QOpenGLBuffer::StreamDraw);
+	instanceBuffer->create();
+	return true;
+}
+
 void StelSkyDrawer::update(double)
 {
 	float fov = core->getMovementMgr()->getCurrentFov();
@@ -237,6 +378,13 @@ void StelSkyDrawer::update(double)
 
 	// update limit luminance
 	limitLuminance = computeLimitLuminance();
+
+	lastFrameStats = currentStats;
+	currentStats = PointSourceStats();
+
+	// Tabulate the extinction for the objects drawn in this frame
+	extinctionTable.update(extinction);
+	j2000Zenith = core->altAzToJ2000(Vec3d(0.,0.,1.), StelCore::RefractionOff).toVec3f();
 }
 
 // Compute the current limit magnitude by dichotomy
@@ -392,8 +540,61 @@ void StelSkyDrawer::postDrawPointSource(StelPainter* sPainter)
 
 	const Mat4f& m = sPainter->getProjector()->getProjectionMatrix();
 	const QMatrix4x4 qMat(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
+
+	currentStats.pointSources += nbPointSources;
+	++currentStats.drawCalls;
+
+	if (useInstancing)
+	{
+		typedef void (QOPENGLF_APIENTRYP VertexAttribDivisor)(GLuint index, GLuint divisor);
+		typedef void (QOPENGLF_APIENTRYP DrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei primcount);
+		const VertexAttribDivisor vertexAttribDivisor = reinterpret_cast<VertexAttribDivisor>(vertexAttribDivisorFunc);
+		const DrawArraysInstanced drawArraysInstanced = reinterpret_cast<DrawArraysInstanced>(drawArraysInstancedFunc);
+		Q_ASSERT(sizeof(StarInstance)==16);
+
+		// Write the batch after the previous ones, which the driver may still be drawing from. Only when
+		// the buffer is full is it orphaned, with the same size, so that writing does not wait for them.
+		const int size = nbPointSources*sizeof(StarInstance);
+		const int bufferSize = InstanceBufferBatches*maxPointSources*sizeof(StarInstance);
+		instanceBuffer->bind();
+		if (instanceBufferOffset+size>bufferSize)
+		{
+			instanceBuffer->allocate(bufferSize);
+			instanceBufferOffset = 0;
+		}
+		instanceBuffer->write(instanceBufferOffset, instanceArray, size);
+		currentStats.uploadedBytes += size;
+
+		starInstancedShaderProgram->bind();
+		starInstancedShaderProgram->setAttributeBuffer(starInstancedShaderVars.posRadius, GL_FLOAT, instanceBufferOffset, 3, sizeof(StarInstance));
+		starInstancedShaderProgram->enableAttributeArray(starInstancedShaderVars.posRadius);
+		vertexAttribDivisor(starInstancedShaderVars.posRadius, 1);
+		starInstancedShaderProgram->setAttributeBuffer(starInstancedShaderVars.color, GL_UNSIGNED_BYTE, instanceBufferOffset+offsetof(StarInstance, color), 3, sizeof(StarInstance));
+		starInstancedShaderProgram->enableAttributeArray(starInstancedShaderVars.color);
+		vertexAttribDivisor(starInstancedShaderVars.color, 1);
+		cornerBuffer->bind();
+		starInstancedShaderProgram->setAttributeBuffer(starInstancedShaderVars.corner, GL_FLOAT, 0, 2);
+		starInstancedShaderProgram->enableAttributeArray(starInstancedShaderVars.corner);
+		starInstancedShaderProgram->setUniformValue(starInstancedShaderVars.projectionMatrix, qMat);
+
+		drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, nbPointSources);
+
+		// The divisors are not part of the program: reset them for the other users of these attributes
+		vertexAttribDivisor(starInstancedShaderVars.posRadius, 0);
+		vertexAttribDivisor(starInstancedShaderVars.color, 0);
+		starInstancedShaderProgram->disableAttributeArray(starInstancedShaderVars.corner);
+		starInstancedShaderProgram->disableAttributeArray(starInstancedShaderVars.posRadius);
+		starInstancedShaderProgram->disableAttributeArray(starInstancedShaderVars.color);
+		starInstancedShaderProgram->release();
+		cornerBuffer->release();
+
+		instanceBufferOffset += size;
+		nbPointSources = 0;
+		return;
+	}
 	
 	Q_ASSERT(sizeof(StarVertex)==12);
+	currentStats.uploadedBytes += nbPointSources*6*(sizeof(StarVertex)+2);
 	
 	starShaderProgram->bind();
 	starShaderProgram->setAttributeArray(starShaderVars.pos, GL_FLOAT, (GLfloat*)vertexArray, 2, 12);
@@ -419,6 +620,18 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 {
 	Q_ASSERT(sPainter);
 
+	PointSource ps;
+	if (!computePointSource(sPainter->getProjector().data(), v, rcMag, color, checkInScreen, twinkleFactor, ps))
+		return false;
+	drawPointSource(sPainter, ps);
+	return true;
+}
+
+// Project a point source and compute its halo. No OpenGL calls here.
+bool StelSkyDrawer::computePointSource(const StelProjector* prj, const Vec3f& v, const RCMag& rcMag, const Vec3f& color, bool checkInScreen, float twinkleFactor, PointSource& ps) const
+{
+	Q_ASSERT(prj);
+
 	if (rcMag.radius<=0.f)
 		return false;
 
@@ -426,18 +639,31 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 //	Vec3d win;
 //	if (!(checkInScreen ? sPainter->getProjector()->projectCheck(Vec3d(v[0],v[1],v[2]), win) : sPainter->getProjector()->project(Vec3d(v[0],v[1],v[2]), win)))
 //		return false;
-	Vec3f win;
-	if (!(checkInScreen ? sPainter->getProjector()->projectCheck(v, win) : sPainter->getProjector()->project(v, win)))
+	if (!(checkInScreen ? prj->projectCheck(v, ps.win) : prj->project(v, ps.win)))
 		return false;
 
-	const float radius = rcMag.radius;
+	ps.radius = rcMag.radius;
+	ps.luminance = rcMag.luminance;
+	ps.twinkleFactor = twinkleFactor;
+	ps.color = color;
+	return true;
+}
+
+// Store a precomputed point source in the vertex arrays.
+void StelSkyDrawer::drawPointSource(StelPainter* sPainter, const PointSource& ps)
+{
+	Q_ASSERT(sPainter);
+
+	const Vec3f& win = ps.win;
+	const Vec3f& color = ps.color;
+	const float radius = ps.radius;
 	// Random coef for star twinkling. twinkleFactor can introduce height-dependent twinkling.
-	const float tw = (flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle)) ? (1.f-twinkleFactor*twinkleAmount*qrand()/RAND_MAX)*rcMag.luminance : rcMag.luminance;
+	const float tw = (flagStarTwinkle && (flagHasAtmosphere || flagForcedTwinkle)) ? (1.f-ps.twinkleFactor*twinkleAmount*qrand()/RAND_MAX)*ps.luminance : ps.luminance;
 
 	// If the rmag is big, draw a big halo
 	if (radius>MAX_LINEAR_RADIUS+5.f)
 	{
-		float cmag = qMin(rcMag.luminance,(float)(radius-(MAX_LINEAR_RADIUS+5.f))/30.f);
+		float cmag = qMin(ps.luminance,(float)(radius-(MAX_LINEAR_RADIUS+5.f))/30.f);
 		float rmag = 150.f;
 		if (cmag>1.f)
 			cmag = 1.f;
@@ -455,14 +681,24 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 	starColor[1] = (unsigned char)std::min((int)(color[1]*tw*255+0.5f), 255);
 	starColor[2] = (unsigned char)std::min((int)(color[2]*tw*255+0.5f), 255);
 	
-	// Store the drawing instructions in the vertex arrays
-	StarVertex* vx = &(vertexArray[nbPointSources*6]);
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
-	vx->pos.set(win[0]-radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+	if (useInstancing)
+	{
+		// Store the drawing instructions in the instance array
+		StarInstance* instance = &(instanceArray[nbPointSources]);
+		instance->posRadius.set(win[0], win[1], radius);
+		memcpy(instance->color, starColor, 3);
+	}
+	else
+	{
+		// Store the drawing instructions in the vertex arrays
+		StarVertex* vx = &(vertexArray[nbPointSources*6]);
+		vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]+radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]-radius,win[1]-radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]+radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+		vx->pos.set(win[0]-radius,win[1]+radius); memcpy(vx->color, starColor, 3); ++vx;
+	}
 
 	++nbPointSources;
 	if (nbPointSources>=maxPointSources)
@@ -470,7 +706,6 @@ bool StelSkyDrawer::drawPointSource(StelPainter* sPainter, const Vec3f& v, const
 		// Flush the buffer (draw all buffered stars)
 		postDrawPointSource(sPainter);
 	}
-	return true;
 }
 
 // Draw's the Sun's corona during a solar eclipse on Earth.
@@ -104,6 +104,50 @@ public:
 
 	bool drawPointSource(StelPainter* sPainter, const Vec3f& v, const RCMag &rcMag, const Vec3f& bcolor, bool checkInScreen=false, float twinkleFactor=1.0f);
 
+	//! A point source halo which has already been projected and colored, waiting to be stored in the vertex arrays.
+	struct PointSource
+	{
+		Vec3f win;		//!< Position in window coordinates
+		float radius;		//!< Halo radius in pixels
+		float luminance;	//!< Luminance as computed by computeRCMag()
+		float twinkleFactor;	//!< Height-dependent twinkling amount. The random twinkling is applied when drawing.
+		Vec3f color;		//!< RGB color of the source
+	};
+
+	//! Project a point source and compute its on-screen halo without drawing it.
+	//! This method does not touch any OpenGL state and may therefore be called from worker threads.
+	//! @param prj the projector to use.
+	//! @param v the 3d position of the source in J2000 reference frame
+	//! @param rcMag the radius and luminance of the source as computed by computeRCMag()
+	//! @param bV the source B-V index
+	//! @param checkInScreen whether source in screen should be checked to avoid unnecessary drawing.
+	//! @param twinkleFactor allows height-dependent twinkling. Allowed values [0..1]
+	//! @param ps the computed point source.
+	//! @return true if the source is visible and ps was filled.
+	bool computePointSource(const StelProjector* prj, const Vec3f& v, const RCMag &rcMag, unsigned int bV, bool checkInScreen, float twinkleFactor, PointSource& ps) const
+	{
+		return computePointSource(prj, v, rcMag, colorTable[bV], checkInScreen, twinkleFactor, ps);
+	}
+
+	bool computePointSource(const StelProjector* prj, const Vec3f& v, const RCMag &rcMag, const Vec3f& bcolor, bool checkInScreen, float twinkleFactor, PointSource& ps) const;
+
+	//! Draw a point source halo previously computed by computePointSource().
+	//! Must be called between preDrawPointSource() and postDrawPointSource().
+	void drawPointSource(StelPainter* sPainter, const PointSource& ps);
+
+	//! Counters of the point source rendering during one frame.
+	struct PointSourceStats
+	{
+		PointSourceStats() : pointSources(0), drawCalls(0), uploadedBytes(0) {}
+		int pointSources;	//!< Number of point sources drawn
+		int drawCalls;		//!< Number of draw calls used for them
+		qint64 uploadedBytes;	//!< Amount of vertex data sent to OpenGL for them
+	};
+	//! Get the point source rendering counters of the previous frame.
+	const PointSourceStats& getPointSourceStats() const {return lastFrameStats;}
+	//! Get whether point sources are drawn as instanced quads, i.e. with one set of attributes per source.
+	bool getFlagInstancedPointSources() const {return useInstancing;}
+
 	void drawSunCorona(StelPainter* painter, const Vec3f& v, float radius, const Vec3f& color, const float alpha);
 
 	//! Terminate drawing of a 3D model, draw the halo
@@ -261,6 +305,14 @@ public slots:
 
 	//! Get the current valid extinction computation object.
 	const Extinction& getExtinction() const {return extinction;}
+	//! Get the extinction tabulated for the current frame, for drawing many objects.
+	const ExtinctionTable& getExtinctionTable() const {return extinctionTable;}
+	//! Get the zenith of the current frame in J2000 frame, so that the sine of the geometric
+	//! altitude of a normalized J2000 position v is v.dot(getJ2000Zenith()).
+	const Vec3f& getJ2000Zenith() const {return j2000Zenith;}
+	//! Get the height-dependent twinkle factor to pass to computePointSource() or drawPointSource().
+	//! Twinkling is suppressed at higher altitudes, keeping 0.1 twinkle amount at the zenith.
+	static float getTwinkleFactor(float sinAlt) {return qMin(1.0f, 1.0f-0.9f*sinAlt);}
 	//! Get the current valid refraction computation object.
 	const Refraction& getRefraction() const {return refraction;}
 
@@ -351,11 +403,18 @@ private:
 	//! is displayed with a halo of size targetRadius
 	float findWorldLumForMag(float mag, float targetRadius);
 
+	//! Check the OpenGL support for instanced arrays and create the instanced shader and buffers.
+	//! @return false if point sources must be drawn without instancing.
+	bool initInstancing();
+
 	StelCore* core;
 	StelToneReproducer* eye;
 
 	Extinction extinction;
 	Refraction refraction;
+	//! Updated from extinction at each frame.
+	ExtinctionTable extinctionTable;
+	Vec3f j2000Zenith;
 
 	float maxAdaptFov, minAdaptFov, lnfovFactor;
 	bool flagStarTwinkle;
@@ -443,12 +502,46 @@ private:
 		int texture;
 	};
 	StarShaderVars starShaderVars;
+
+	//! Instance format for a point source drawn as an instanced quad.
+	struct StarInstance {
+		Vec3f posRadius;	//!< Window position and halo radius
+		unsigned char color[4];
+	};
+
+	//! Whether point sources are drawn as instanced quads, or as 6 vertices each.
+	bool useInstancing;
+	//! Buffer for storing the instance data when drawing with instancing.
+	StarInstance* instanceArray;
+	//! The corners of the quad, shared by all instances.
+	class QOpenGLBuffer* cornerBuffer;
+	//! Streaming buffer receiving the instance data. It is allocated once for several batches, which are
+	//! written one after the other; it is orphaned only when it is full.
+	class QOpenGLBuffer* instanceBuffer;
+	//! Offset of the next batch in instanceBuffer, in bytes.
+	int instanceBufferOffset;
+	class QOpenGLShaderProgram* starInstancedShaderProgram;
+	struct StarInstancedShaderVars {
+		int projectionMatrix;
+		int corner;
+		int posRadius;
+		int color;
+		int texture;
+	};
+	StarInstancedShaderVars starInstancedShaderVars;
+	//! glVertexAttribDivisor() and glDrawArraysInstanced(), or their extension variants.
+	QFunctionPointer vertexAttribDivisorFunc;
+	QFunctionPointer drawArraysInstancedFunc;
 	
 	//! Current number of sources stored in the buffers (still to display)
 	unsigned int nbPointSources;
 	//! Maximum number of sources which can be stored in the buffers
 	unsigned int maxPointSources;
 
+	//! Point source rendering counters of the current and previous frames
+	PointSourceStats currentStats;
+	PointSourceStats lastFrameStats;
+
 	//! The maximum transformed luminance to apply at the next update
 	float maxLum;
 	//! The previously used world luminance
@@ -39,7 +39,7 @@ void StelTextureMgr::init()
 
 StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const StelTexture::StelTextureParams& params)
 {
-	if (afilename.isEmpty())
+	if (afilename.isEmpty() || StelApp::getInstance().isHeadless())
 		return StelTextureSP();
 
 	StelTextureSP tex = StelTextureSP(new StelTexture());
@@ -62,7 +62,7 @@ StelTextureSP StelTextureMgr::createTexture(const QString& afilename, const Stel
 
 StelTextureSP StelTextureMgr::createTextureThread(const QString& url, const StelTexture::StelTextureParams& params, bool lazyLoading)
 {
-	if (url.isEmpty())
+	if (url.isEmpty() || StelApp::getInstance().isHeadless())
 		return StelTextureSP();
 
 	StelTextureSP tex = StelTextureSP(new StelTexture());
@@ -37,13 +37,15 @@ public:
 	//! Must be called after the creation of the GLContext.
 	void init();
 
-	//! Load an image from a file and create a new texture from it
+	//! Load an image from a file and create a new texture from it.
+	//! No texture is created when StelApp::isHeadless() is true.
 	//! @param filename the texture file name, can be absolute path if starts with '/' otherwise
 	//!    the file will be looked for in Stellarium's standard textures directories.
 	//! @param params the texture creation parameters.
 	StelTextureSP createTexture(const QString& filename, const StelTexture::StelTextureParams& params=StelTexture::StelTextureParams());
 
 	//! Load an image from a file and create a new texture from it in a new thread.
+	//! No texture is created when StelApp::isHeadless() is true.
 	//! @param url the texture file name or URL, can be absolute path if starts with '/' otherwise
 	//!    the file will be looked for in Stellarium's standard textures directories.
 	//! @param params the texture creation parameters.
@@ -89,11 +89,9 @@ Comet::Comet(const QString& englishName,
 	  dustTailBrightnessFactor(dustTailBrightnessFact)
 {
 	texMapName = atexMapName;
-	lastOrbitJDE =0;
 	deltaJDE = StelCore::JD_SECOND;
 	deltaJDEtail=15.0*StelCore::JD_MINUTE; // update tail geometry every 15 minutes only
 	lastJDEtail=0.0;
-	orbitCached = 0;
 	closeOrbit = acloseOrbit;
 
 	eclipticPos=Vec3d(0.,0.,0.);
@@ -289,18 +287,18 @@ double Comet::getSiderealPeriod() const
 	return period;
 }
 
-float Comet::getVMagnitude(const StelCore* core) const
+float Comet::computeVMagnitude(const MagnitudeContext& context) const
 {
 	//If the two parameter system is not used,
 	//use the default radius/albedo mechanism
 	if (slopeParameter < 0)
 	{
-		return Planet::getVMagnitude(core);
+		return Planet::computeVMagnitude(context);
 	}
 
 	//Calculate distances
-	const Vec3d& observerHeliocentricPosition = core->getObserverHeliocentricEclipticPos();
-	const Vec3d& cometHeliocentricPosition = getHeliocentricEclipticPos();
+	const Vec3d& observerHeliocentricPosition = context.observerHelioPos;
+	const Vec3d& cometHeliocentricPosition = context.planetHelioPos;
 	const double cometSunDistance = cometHeliocentricPosition.length();
 	const double observerCometDistance = (observerHeliocentricPosition - cometHeliocentricPosition).length();
 
@@ -0,0 +1,519 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "KeplerBatch.hpp"
+#include "StelSimd.hpp"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+	// Number of bodies computed together, so that the temporary arrays stay in the L1 cache.
+	// Must be a multiple of 4 (the AVX2 vector width).
+	const int BlockSize = 256;
+	// Maximum number of Laguerre-Conway iterations. From the initial guess of InitEll() (see Orbit.cpp),
+	// they converge in 2 to 6 iterations for all the eccentricities below 1.
+	const int MaxKeplerIterations = 8;
+
+	//! Solve Kepler's equation for a block of bodies by Laguerre-Conway iterations (Heafner, Fundamental
+	//! Ephemeris Computations, 5.3), and give the sine and cosine of the eccentric anomalies.
+	//! As in InitEll(), the iterations stop once they change E by less than 1e-10, here for all the bodies.
+	//! @param M the mean anomalies, in [-pi, pi]
+	//! @param count the number of bodies, a multiple of 4. The entries past the bodies are zero.
+	typedef void (*KeplerKernel)(const double* M, const double* e, int count, double* sinE, double* cosE);
+
+	void solveScalar(const double* M, const double* e, int count, double* sinE, double* cosE)
+	{
+		double E[BlockSize];
+		for (int k=0; k<count; ++k)
+			E[k] = M[k] + std::copysign(0.85*e[k], M[k]);
+		for (int iteration=0; iteration<MaxKeplerIterations; ++iteration)
+		{
+			double maxStep = 0.;
+			for (int k=0; k<count; ++k)
+			{
+				// 1-e*cos(E) is always positive
+				const double f2 = e[k]*std::sin(E[k]);
+				const double f = E[k]-f2-M[k];
+				const double f1 = 1.-e[k]*std::cos(E[k]);
+				const double step = 5.*f/(f1+std::sqrt(std::fabs(16.*f1*f1-20.*f*f2)));
+				E[k] -= step;
+				maxStep = qMax(maxStep, std::fabs(step));
+			}
+			if (maxStep<1e-10)
+				break;
+		}
+		for (int k=0; k<count; ++k)
+		{
+			sinE[k] = std::sin(E[k]);
+			cosE[k] = std::cos(E[k]);
+		}
+	}
+
+#ifdef STEL_SIMD_X86
+	// The vectorized sine and cosine, from the polynomials of the Cephes library (within 2 ulp).
+	// The argument is reduced to [-pi/4, pi/4] by the nearest multiple k*pi/2, where pi/2 is split in
+	// 3 parts so that the reduction is exact. Adding RoundMagic (1.5*2^52) rounds to the nearest integer,
+	// and leaves it in the low bits of the double: k mod 4 then selects and signs the sine and cosine.
+	const double SinCoeffs[6] = {1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+				     -1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1};
+	const double CosCoeffs[6] = {-1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+				     2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2};
+	const double PiO2Part1 = 1.57079625129699707031;
+	const double PiO2Part2 = 7.54978941586159635336e-8;
+	const double PiO2Part3 = 5.39030285815811905290e-15;
+	const double RoundMagic = 6755399441055744.0;
+
+	STEL_TARGET_SSE2
+	inline void sinCosSSE2(__m128d x, __m128d& sinX, __m128d& cosX)
+	{
+		const __m128d magic = _mm_set1_pd(RoundMagic);
+		const __m128d kMagic = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(2./M_PI)), magic);
+		const __m128d k = _mm_sub_pd(kMagic, magic);
+		__m128d z = _mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(PiO2Part1)));
+		z = _mm_sub_pd(z, _mm_mul_pd(k, _mm_set1_pd(PiO2Part2)));
+		z = _mm_sub_pd(z, _mm_mul_pd(k, _mm_set1_pd(PiO2Part3)));
+		const __m128d zz = _mm_mul_pd(z, z);
+		__m128d ps = _mm_set1_pd(SinCoeffs[0]);
+		__m128d pc = _mm_set1_pd(CosCoeffs[0]);
+		for (int i=1; i<6; ++i)
+		{
+			ps = _mm_add_pd(_mm_mul_pd(ps, zz), _mm_set1_pd(SinCoeffs[i]));
+			pc = _mm_add_pd(_mm_mul_pd(pc, zz), _mm_set1_pd(CosCoeffs[i]));
+		}
+		const __m128d sinZ = _mm_add_pd(z, _mm_mul_pd(_mm_mul_pd(z, zz), ps));
+		const __m128d cosZ = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.), _mm_mul_pd(zz, _mm_set1_pd(0.5))), _mm_mul_pd(_mm_mul_pd(zz, zz), pc));
+
+		// Odd quadrants swap the sine and cosine, the sine is negative in quadrants 2 and 3, the cosine in 1 and 2
+		const __m128i quadrant = _mm_castpd_si128(kMagic);
+		const __m128i one = _mm_set_epi32(0, 1, 0, 1);
+		const __m128i two = _mm_set_epi32(0, 2, 0, 2);
+		const __m128d swap = _mm_castsi128_pd(_mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(quadrant, one)));
+		const __m128d sinSign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(quadrant, two), 62));
+		const __m128d cosSign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi64(quadrant, one), two), 62));
+		sinX = _mm_xor_pd(_mm_or_pd(_mm_and_pd(swap, cosZ), _mm_andnot_pd(swap, sinZ)), sinSign);
+		cosX = _mm_xor_pd(_mm_or_pd(_mm_and_pd(swap, sinZ), _mm_andnot_pd(swap, cosZ)), cosSign);
+	}
+
+	STEL_TARGET_SSE2
+	void solveSSE2(const double* M, const double* e, int count, double* sinE, double* cosE)
+	{
+		const __m128d signMask = _mm_set1_pd(-0.);
+		double E[BlockSize];
+		for (int k=0; k<count; k+=2)
+		{
+			const __m128d m = _mm_loadu_pd(M+k);
+			_mm_storeu_pd(E+k, _mm_add_pd(m, _mm_or_pd(_mm_mul_pd(_mm_set1_pd(0.85), _mm_loadu_pd(e+k)), _mm_and_pd(m, signMask))));
+		}
+		for (int iteration=0; iteration<MaxKeplerIterations; ++iteration)
+		{
+			__m128d maxStep = _mm_setzero_pd();
+			for (int k=0; k<count; k+=2)
+			{
+				const __m128d ek = _mm_loadu_pd(e+k);
+				const __m128d Ek = _mm_loadu_pd(E+k);
+				__m128d sinEk, cosEk;
+				sinCosSSE2(Ek, sinEk, cosEk);
+				const __m128d f2 = _mm_mul_pd(ek, sinEk);
+				const __m128d f = _mm_sub_pd(_mm_sub_pd(Ek, f2), _mm_loadu_pd(M+k));
+				const __m128d f1 = _mm_sub_pd(_mm_set1_pd(1.), _mm_mul_pd(ek, cosEk));
+				const __m128d d = _mm_sub_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(16.), f1), f1), _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(20.), f), f2));
+				const __m128d step = _mm_div_pd(_mm_mul_pd(_mm_set1_pd(5.), f), _mm_add_pd(f1, _mm_sqrt_pd(_mm_andnot_pd(signMask, d))));
+				_mm_storeu_pd(E+k, _mm_sub_pd(Ek, step));
+				maxStep = _mm_max_pd(maxStep, _mm_andnot_pd(signMask, step));
+			}
+			double steps[2];
+			_mm_storeu_pd(steps, maxStep);
+			if (qMax(steps[0], steps[1])<1e-10)
+				break;
+		}
+		for (int k=0; k<count; k+=2)
+		{
+			__m128d sinEk, cosEk;
+			sinCosSSE2(_mm_loadu_pd(E+k), sinEk, cosEk);
+			_mm_storeu_pd(sinE+k, sinEk);
+			_mm_storeu_pd(cosE+k, cosEk);
+		}
+	}
+
+	STEL_TARGET_AVX2
+	inline void sinCosAVX2(__m256d x, __m256d& sinX, __m256d& cosX)
+	{
+		const __m256d magic = _mm256_set1_pd(RoundMagic);
+		const __m256d kMagic = _mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(2./M_PI)), magic);
+		const __m256d k = _mm256_sub_pd(kMagic, magic);
+		__m256d z = _mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(PiO2Part1)));
+		z = _mm256_sub_pd(z, _mm256_mul_pd(k, _mm256_set1_pd(PiO2Part2)));
+		z = _mm256_sub_pd(z, _mm256_mul_pd(k, _mm256_set1_pd(PiO2Part3)));
+		const __m256d zz = _mm256_mul_pd(z, z);
+		__m256d ps = _mm256_set1_pd(SinCoeffs[0]);
+		__m256d pc = _mm256_set1_pd(CosCoeffs[0]);
+		for (int i=1; i<6; ++i)
+		{
+			ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(SinCoeffs[i]));
+			pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(CosCoeffs[i]));
+		}
+		const __m256d sinZ = _mm256_add_pd(z, _mm256_mul_pd(_mm256_mul_pd(z, zz), ps));
+		const __m256d cosZ = _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.), _mm256_mul_pd(zz, _mm256_set1_pd(0.5))), _mm256_mul_pd(_mm256_mul_pd(zz, zz), pc));
+
+		// As in sinCosSSE2()
+		const __m256i quadrant = _mm256_castpd_si256(kMagic);
+		const __m256i one = _mm256_set1_epi64x(1);
+		const __m256i two = _mm256_set1_epi64x(2);
+		const __m256d swap = _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(quadrant, one)));
+		const __m256d sinSign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(quadrant, two), 62));
+		const __m256d cosSign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(quadrant, one), two), 62));
+		sinX = _mm256_xor_pd(_mm256_blendv_pd(sinZ, cosZ, swap), sinSign);
+		cosX = _mm256_xor_pd(_mm256_blendv_pd(cosZ, sinZ, swap), cosSign);
+	}
+
+	STEL_TARGET_AVX2
+	void solveAVX2(const double* M, const double* e, int count, double* sinE, double* cosE)
+	{
+		const __m256d signMask = _mm256_set1_pd(-0.);
+		double E[BlockSize];
+		for (int k=0; k<count; k+=4)
+		{
+			const __m256d m = _mm256_loadu_pd(M+k);
+			_mm256_storeu_pd(E+k, _mm256_add_pd(m, _mm256_or_pd(_mm256_mul_pd(_mm256_set1_pd(0.85), _mm256_loadu_pd(e+k)), _mm256_and_pd(m, signMask))));
+		}
+		for (int iteration=0; iteration<MaxKeplerIterations; ++iteration)
+		{
+			__m256d maxStep = _mm256_setzero_pd();
+			for (int k=0; k<count; k+=4)
+			{
+				const __m256d ek = _mm256_loadu_pd(e+k);
+				const __m256d Ek = _mm256_loadu_pd(E+k);
+				__m256d sinEk, cosEk;
+				sinCosAVX2(Ek, sinEk, cosEk);
+				const __m256d f2 = _mm256_mul_pd(ek, sinEk);
+				const __m256d f = _mm256_sub_pd(_mm256_sub_pd(Ek, f2), _mm256_loadu_pd(M+k));
+				const __m256d f1 = _mm256_sub_pd(_mm256_set1_pd(1.), _mm256_mul_pd(ek, cosEk));
+				const __m256d d = _mm256_sub_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(16.), f1), f1), _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(20.), f), f2));
+				const __m256d step = _mm256_div_pd(_mm256_mul_pd(_mm256_set1_pd(5.), f), _mm256_add_pd(f1, _mm256_sqrt_pd(_mm256_andnot_pd(signMask, d))));
+				_mm256_storeu_pd(E+k, _mm256_sub_pd(Ek, step));
+				maxStep = _mm256_max_pd(maxStep, _mm256_andnot_pd(signMask, step));
+			}
+			double steps[4];
+			_mm256_storeu_pd(steps, maxStep);
+			if (qMax(qMax(steps[0], steps[1]), qMax(steps[2], steps[3]))<1e-10)
+				break;
+		}
+		for (int k=0; k<count; k+=4)
+		{
+			__m256d sinEk, cosEk;
+			sinCosAVX2(_mm256_loadu_pd(E+k), sinEk, cosEk);
+			_mm256_storeu_pd(sinE+k, sinEk);
+			_mm256_storeu_pd(cosE+k, cosEk);
+		}
+	}
+#endif // STEL_SIMD_X86
+
+	KeplerBatch::Implementation detectBestImplementation()
+	{
+#ifdef STEL_SIMD_X86
+		if (StelSimd::cpuHasAVX2())
+			return KeplerBatch::AVX2;
+		if (StelSimd::cpuHasSSE2())
+			return KeplerBatch::SSE2;
+#endif
+		return KeplerBatch::Scalar;
+	}
+
+	KeplerKernel kernelFor(KeplerBatch::Implementation impl)
+	{
+		switch (impl)
+		{
+#ifdef STEL_SIMD_X86
+			case KeplerBatch::AVX2:
+				return &solveAVX2;
+			case KeplerBatch::SSE2:
+				return &solveSSE2;
+#endif
+			default:
+				return &solveScalar;
+		}
+	}
+
+	const KeplerBatch::Implementation bestImplementation = detectBestImplementation();
+	KeplerBatch::Implementation currentImplementation = bestImplementation;
+	KeplerKernel currentKernel = kernelFor(bestImplementation);
+}
+
+KeplerBatch::Implementation KeplerBatch::getBestImplementation()
+{
+	return bestImplementation;
+}
+
+KeplerBatch::Implementation KeplerBatch::getImplementation()
+{
+	return currentImplementation;
+}
+
+void KeplerBatch::setImplementation(Implementation impl)
+{
+	if (impl>bestImplementation)
+		impl = bestImplementation;
+	currentImplementation = impl;
+	currentKernel = kernelFor(impl);
+}
+
+const char* KeplerBatch::implementationName(Implementation impl)
+{
+	switch (impl)
+	{
+		case AVX2:
+			return "AVX2";
+		case SSE2:
+			return "SSE2";
+		default:
+			return "scalar";
+	}
+}
+
+KeplerBatch::Member* KeplerBatch::addCometOrbit(double pericenterDistance, double eccentricity, double inclination, double ascendingNode,
+						double argOfPerihelion, double timeAtPerihelion, double meanMotion,
+						double parentRotObliquity, double parentRotAscendingNode, double parentRotJ2000Longitude)
+{
+	return add(pericenterDistance, eccentricity, inclination, ascendingNode, argOfPerihelion, 0., meanMotion, timeAtPerihelion,
+		   parentRotObliquity, parentRotAscendingNode, parentRotJ2000Longitude);
+}
+
+KeplerBatch::Member* KeplerBatch::addEllipticalOrbit(double pericenterDistance, double eccentricity, double inclination, double ascendingNode,
+						     double argOfPeriapsis, double meanAnomalyAtEpoch, double period, double epoch,
+						     double parentRotObliquity, double parentRotAscendingNode, double parentRotJ2000Longitude)
+{
+	return add(pericenterDistance, eccentricity, inclination, ascendingNode, argOfPeriapsis, meanAnomalyAtEpoch, 2.*M_PI/period, epoch,
+		   parentRotObliquity, parentRotAscendingNode, parentRotJ2000Longitude);
+}
+
+KeplerBatch::Member* KeplerBatch::add(double pericenterDistance, double e, double i, double Omega, double w,
+				      double M0, double n, double t0,
+				      double parentRotObliquity, double parentRotAscendingNode, double parentRotJ2000Longitude)
+{
+	Q_ASSERT(e>=0. && e<1.);
+	const double a = pericenterDistance/(1.-e);
+	meanAnomalyAtEpoch.append(M0);
+	meanMotion.append(n);
+	epoch.append(t0);
+	eccentricity.append(e);
+	semiMajorAxis.append(a);
+	semiMinorAxis.append(a*std::sqrt(1.-e*e));
+
+	// Orientation of the orbit, as in Init3D() (see Orbit.cpp)...
+	const double cw = std::cos(w);
+	const double sw = std::sin(w);
+	const double cOm = std::cos(Omega);
+	const double sOm = std::sin(Omega);
+	const double ci = std::cos(i);
+	const double si = std::sin(i);
+	const double P[3] = {-sw*sOm*ci+cw*cOm, sw*cOm*ci+cw*sOm, sw*si};
+	const double Q[3] = {-cw*sOm*ci-sw*cOm, cw*cOm*ci-sw*sOm, cw*si};
+
+	// ...then rotated to VSOP87 coordinates, as in the constructors of CometOrbit and EllipticalOrbit
+	const double c_obl = std::cos(parentRotObliquity);
+	const double s_obl = std::sin(parentRotObliquity);
+	const double c_nod = std::cos(parentRotAscendingNode);
+	const double s_nod = std::sin(parentRotAscendingNode);
+	const double cj = std::cos(parentRotJ2000Longitude);
+	const double sj = std::sin(parentRotJ2000Longitude);
+	const double rotateToVsop87[9] = {
+		 c_nod*cj-s_nod*c_obl*sj, -c_nod*sj-s_nod*c_obl*cj,  s_nod*s_obl,
+		 s_nod*cj+c_nod*c_obl*sj, -s_nod*sj+c_nod*c_obl*cj, -c_nod*s_obl,
+		                s_obl*sj,                 s_obl*cj,        c_obl};
+	px.append(rotateToVsop87[0]*P[0] + rotateToVsop87[1]*P[1] + rotateToVsop87[2]*P[2]);
+	py.append(rotateToVsop87[3]*P[0] + rotateToVsop87[4]*P[1] + rotateToVsop87[5]*P[2]);
+	pz.append(rotateToVsop87[6]*P[0] + rotateToVsop87[7]*P[1] + rotateToVsop87[8]*P[2]);
+	qx.append(rotateToVsop87[0]*Q[0] + rotateToVsop87[1]*Q[1] + rotateToVsop87[2]*Q[2]);
+	qy.append(rotateToVsop87[3]*Q[0] + rotateToVsop87[4]*Q[1] + rotateToVsop87[5]*Q[2]);
+	qz.append(rotateToVsop87[6]*Q[0] + rotateToVsop87[7]*Q[1] + rotateToVsop87[8]*Q[2]);
+	skipped.append(false);
+
+	Member* member = new Member;
+	member->batch = this;
+	member->index = members.size();
+	members.append(member);
+	return member;
+}
+
+void KeplerBatch::clear()
+{
+	meanAnomalyAtEpoch.clear();
+	meanMotion.clear();
+	epoch.clear();
+	eccentricity.clear();
+	semiMajorAxis.clear();
+	semiMinorAxis.clear();
+	px.clear(); py.clear(); pz.clear();
+	qx.clear(); qy.clear(); qz.clear();
+	skipped.clear();
+	for (int k=0; k<2; ++k)
+	{
+		kept[k].dates.clear();
+		kept[k].positions.clear();
+	}
+	qDeleteAll(members);
+	members.clear();
+}
+
+void KeplerBatch::compute(double jde)
+{
+	generation.ref();
+	current = 1-current;
+	kept[current].dates.fill(jde, size());
+	computeKept();
+	generation.ref();
+}
+
+void KeplerBatch::compute(const double* jde)
+{
+	generation.ref();
+	current = 1-current;
+	kept[current].dates.resize(size());
+	std::copy(jde, jde+size(), kept[current].dates.begin());
+	computeKept();
+	generation.ref();
+}
+
+void KeplerBatch::computeKept()
+{
+	Kept& k = kept[current];
+	k.positions.resize(3*size());
+	// Compute each run of bodies which are not skipped. The skipped ones get a date which never
+	// matches, so that posFunc() computes them.
+	const int count = size();
+	int first = 0;
+	while (first<count)
+	{
+		if (skipped.at(first))
+		{
+			k.dates[first] = std::numeric_limits<double>::quiet_NaN();
+			++first;
+			continue;
+		}
+		int end = first+1;
+		while (end<count && !skipped.at(end))
+			++end;
+		computePositions(first, end-first, k.dates.constData()+first, k.positions.data()+3*first);
+		first = end;
+	}
+}
+
+void KeplerBatch::computePositions(int first, int count, const double* jde, double* xyz) const
+{
+	Q_ASSERT(first>=0 && first+count<=size());
+	const double* M0 = meanAnomalyAtEpoch.constData()+first;
+	const double* n = meanMotion.constData()+first;
+	const double* t0 = epoch.constData()+first;
+	const double* e = eccentricity.constData()+first;
+	const double* a = semiMajorAxis.constData()+first;
+	const double* b = semiMinorAxis.constData()+first;
+	const double* Px = px.constData()+first;
+	const double* Py = py.constData()+first;
+	const double* Pz = pz.constData()+first;
+	const double* Qx = qx.constData()+first;
+	const double* Qy = qy.constData()+first;
+	const double* Qz = qz.constData()+first;
+
+	const KeplerKernel kernel = currentKernel;
+	double M[BlockSize];
+	double ecc[BlockSize];
+	double sinE[BlockSize];
+	double cosE[BlockSize];
+	for (int start=0; start<count; start+=BlockSize)
+	{
+		const int end = qMin(start+BlockSize, count);
+		const int blockCount = end-start;
+
+		// Mean anomaly in [-pi, pi]
+		for (int k=0; k<blockCount; ++k)
+		{
+			const int i = start+k;
+			double m = M0[i] + n[i]*(jde[i]-t0[i]);
+			m -= 2.*M_PI*std::floor(m/(2.*M_PI)+0.5);
+			M[k] = m;
+			ecc[k] = e[i];
+		}
+		// Padding, so that the kernels work on whole vectors
+		const int paddedCount = (blockCount+3) & ~3;
+		for (int k=blockCount; k<paddedCount; ++k)
+			M[k] = ecc[k] = 0.;
+
+		kernel(M, ecc, paddedCount, sinE, cosE);
+
+		for (int k=0; k<blockCount; ++k)
+		{
+			const int i = start+k;
+			const double x = a[i]*(cosE[k]-e[i]);
+			const double y = b[i]*sinE[k];
+			xyz[3*i]   = Px[i]*x + Qx[i]*y;
+			xyz[3*i+1] = Py[i]*x + Qy[i]*y;
+			xyz[3*i+2] = Pz[i]*x + Qz[i]*y;
+		}
+	}
+}
+
+void KeplerBatch::posFunc(double jde, double xyz[3], void* member)
+{
+	const Member* m = static_cast<const Member*>(member);
+	const KeplerBatch* batch = m->batch;
+	// The kept positions are only used when compute() did not change them while they were read
+	const int generation = batch->generation.loadAcquire();
+	if ((generation & 1)==0)
+	{
+		bool found = false;
+		double pos[3];
+		for (int k=0; k<2 && !found; ++k)
+		{
+			const Kept& last = batch->kept[k==0 ? batch->current : 1-batch->current];
+			if (m->index<last.dates.size() && last.dates.at(m->index)==jde)
+			{
+				const double* keptPos = last.positions.constData()+3*m->index;
+				pos[0] = keptPos[0];
+				pos[1] = keptPos[1];
+				pos[2] = keptPos[2];
+				found = true;
+			}
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (found && batch->generation.load()==generation)
+		{
+			xyz[0] = pos[0];
+			xyz[1] = pos[1];
+			xyz[2] = pos[2];
+			return;
+		}
+	}
+	batch->computePositions(m->index, 1, &jde, xyz);
+}
+
+void KeplerBatch::samplingPosFunc(double jde, double xyz[3], void* member)
+{
+	const Member* m = static_cast<const Member*>(member);
+	m->batch->computePositions(m->index, 1, &jde, xyz);
+}
@@ -0,0 +1,151 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _KEPLERBATCH_HPP_
+#define _KEPLERBATCH_HPP_
+
+#include <QAtomicInt>
+#include <QVector>
+
+//! @class KeplerBatch
+//! Positions of many bodies on elliptical Keplerian orbits, computed together.
+//! The orbital elements are stored as a structure of arrays, and the positions of all the bodies
+//! are computed by a few loops over these arrays: Kepler's equation is solved by Laguerre-Conway
+//! iterations done for blocks of bodies at once. The iterations and their sines and cosines are
+//! computed by an SSE2 or AVX2 kernel chosen at runtime according to the CPU, as StarPositionKernel,
+//! with a scalar fallback for other architectures.
+//!
+//! The positions are the ones of CometOrbit::positionAtTimevInVSOP87Coordinates() within
+//! 1e-12 AU per AU of semi-major axis, as both solve Kepler's equation to convergence.
+//! EllipticalOrbit::positionAtTimevInVSOP87Coordinates() stops its iterations earlier: the difference
+//! is below 1e-9 AU per AU for eccentricities from 0.2, and below e^6 AU per AU under 0.2, where
+//! EllipticalOrbit uses 5 fixed-point iterations. Only elliptical orbits (e<1) can be added.
+//!
+//! The positions of the last two calls to compute() are kept for posFunc(), which SolarSystem uses
+//! as the position function of the bodies of the batch: both passes of the light time correction
+//! then find their positions computed. Bodies can be skipped by compute(), e.g. when too faint to be
+//! drawn: posFunc() then computes them alone when asked.
+class KeplerBatch
+{
+public:
+	enum Implementation
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	//! Get the implementation currently used to solve Kepler's equation.
+	static Implementation getImplementation();
+	//! Force the implementation used to solve Kepler's equation, e.g. for benchmarking.
+	//! Requesting an implementation not supported by the CPU falls back to the best supported one.
+	static void setImplementation(Implementation impl);
+	//! Get the best implementation supported by the CPU.
+	static Implementation getBestImplementation();
+	//! Get a readable name for an implementation.
+	static const char* implementationName(Implementation impl);
+
+	//! A body of the batch, to be given as user data to posFunc() and samplingPosFunc().
+	struct Member
+	{
+		KeplerBatch* batch;
+		int index;
+	};
+
+	KeplerBatch() : current(0), generation(0) {}
+	~KeplerBatch() {clear();}
+
+	//! Add a body with the orbital elements of a CometOrbit.
+	//! @return the member to give to posFunc(), owned by the batch
+	Member* addCometOrbit(double pericenterDistance, double eccentricity, double inclination, double ascendingNode,
+			      double argOfPerihelion, double timeAtPerihelion, double meanMotion,
+			      double parentRotObliquity, double parentRotAscendingNode, double parentRotJ2000Longitude);
+	//! Add a body with the orbital elements of an EllipticalOrbit.
+	//! @return the member to give to posFunc(), owned by the batch
+	Member* addEllipticalOrbit(double pericenterDistance, double eccentricity, double inclination, double ascendingNode,
+				   double argOfPeriapsis, double meanAnomalyAtEpoch, double period, double epoch,
+				   double parentRotObliquity, double parentRotAscendingNode, double parentRotJ2000Longitude);
+	//! Remove all the bodies.
+	void clear();
+	//! Number of bodies.
+	int size() const {return epoch.size();}
+	//! Set whether compute() skips a body.
+	void setSkipped(int index, bool skip) {skipped[index] = skip;}
+	bool isSkipped(int index) const {return skipped.at(index);}
+
+	//! Compute the positions of all the bodies at the same date, and keep them for posFunc().
+	void compute(double jde);
+	//! Compute the positions of all the bodies, each one at its own date, and keep them for posFunc().
+	//! @param jde size() dates
+	void compute(const double* jde);
+	//! Position of a body computed by the last compute().
+	const double* getPosition(int index) const {return kept[current].positions.constData()+3*index;}
+
+	//! Compute the positions of a range of bodies, without keeping them.
+	//! As it only reads the orbital elements, it may be called from any thread.
+	//! @param jde count dates, one for each body from @em first
+	//! @param xyz 3*count coordinates
+	void computePositions(int first, int count, const double* jde, double* xyz) const;
+
+	//! posFuncType for the bodies of the batch: the position kept by one of the last two compute()
+	//! when it was computed for the same date, else the position computed for this body alone.
+	//! It may be called from any thread: while compute() runs, the kept positions are not used.
+	static void posFunc(double jde, double xyz[3], void* member);
+	//! posFuncType which always computes the position of the body alone, and may be called from
+	//! any thread while compute() runs, e.g. to sample orbit lines.
+	static void samplingPosFunc(double jde, double xyz[3], void* member);
+
+private:
+	Q_DISABLE_COPY(KeplerBatch)
+
+	//! Append a body. The mean anomaly is meanAnomalyAtEpoch + meanMotion*(JDE-epoch).
+	Member* add(double pericenterDistance, double eccentricity, double inclination, double ascendingNode,
+		    double argOfPericenter, double meanAnomalyAtEpoch, double meanMotion, double epoch,
+		    double parentRotObliquity, double parentRotAscendingNode, double parentRotJ2000Longitude);
+
+	// Orbital elements, one element per body
+	QVector<double> meanAnomalyAtEpoch;
+	QVector<double> meanMotion;
+	QVector<double> epoch;
+	QVector<double> eccentricity;
+	QVector<double> semiMajorAxis;
+	QVector<double> semiMinorAxis;
+	// Directions of the pericenter (P) and of the semi-minor axis (Q), in VSOP87 coordinates
+	QVector<double> px, py, pz;
+	QVector<double> qx, qy, qz;
+	QVector<bool> skipped;
+
+	// Positions computed by the last two compute(), the last one being kept[current]
+	struct Kept
+	{
+		QVector<double> dates;
+		QVector<double> positions;
+	};
+	Kept kept[2];
+	int current;
+	//! Incremented before and after compute() changes the kept positions: odd while they change.
+	QAtomicInt generation;
+
+	//! Compute the positions for kept[current].dates.
+	void computeKept();
+
+	QVector<Member*> members;
+};
+
+#endif // _KEPLERBATCH_HPP_
@@ -0,0 +1,232 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _MINIMUMSEARCH_HPP_
+#define _MINIMUMSEARCH_HPP_
+
+#include <QMap>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
+
+#include <cmath>
+
+//! @class MinimumSearch
+//! Local minima of a function of the date over a range of dates, e.g. of the angular separation
+//! of two bodies to find their conjunctions.
+//! The function is first sampled at a fixed step: each sample lower than both its neighbours brackets
+//! a minimum, which is then refined by Brent's method (golden section search with parabolic steps).
+//! Minima are missed only when two of them fall within two steps, so the step must be small
+//! compared to the shortest period of the function.
+//! The range is split into chunks which are scanned and refined concurrently by the threads of
+//! the global thread pool. The result does not depend on whether the chunks are processed in
+//! parallel or not.
+class MinimumSearch
+{
+public:
+	//! Find the local minima of a function.
+	//! @param func a functor called as func(date), returning a double. Each chunk calls its own copy
+	//! of @em func, from one thread: a copy can keep the caches it needs, e.g. an EphemContext.
+	//! @param start, stop the range of dates
+	//! @param step the interval between the samples of the scan
+	//! @param maxValue the minima with a larger value are discarded
+	//! @param tolerance the precision of the dates of the minima
+	//! @param parallel when false, the chunks are processed in order by the calling thread
+	//! @return the dates of the minima, with the value of the function at these dates
+	template <class Func>
+	static QMap<double, double> findMinima(const Func& func, double start, double stop, double step,
+					       double maxValue, double tolerance, bool parallel=true)
+	{
+		QMap<double, double> minima;
+		if (!(step>0.) || !(stop-start>=2.*step))
+			return minima;
+
+		// Samples 0 to last, the minima being searched at samples 1 to last-1
+		const int last = (int)std::ceil((stop-start)/step);
+		const int samplesPerChunk = parallel ? qMax((int)MinSamplesPerChunk, last/(4*QThread::idealThreadCount())+1) : last;
+		QVector<Chunk> chunks;
+		for (int first=1; first<last; first+=samplesPerChunk)
+		{
+			Chunk chunk;
+			chunk.first = first;
+			chunk.end = qMin(first+samplesPerChunk, last);
+			chunks.append(chunk);
+		}
+
+		ScanChunk<Func> scan(func, start, stop, step, maxValue, tolerance);
+		if (parallel && chunks.size()>1)
+			QtConcurrent::blockingMap(chunks, scan);
+		else
+		{
+			for (int i=0;i<chunks.size();++i)
+				scan(chunks[i]);
+		}
+
+		// Brackets on both sides of a flat minimum may converge to the same date
+		foreach (const Chunk& chunk, chunks)
+		{
+			for (QMap<double, double>::ConstIterator it=chunk.minima.constBegin(); it!=chunk.minima.constEnd(); ++it)
+			{
+				if (!minima.isEmpty() && it.key()-(minima.constEnd()-1).key()<step)
+				{
+					if (it.value()<(minima.constEnd()-1).value())
+					{
+						minima.erase(minima.end()-1);
+						minima.insert(it.key(), it.value());
+					}
+				}
+				else
+					minima.insert(it.key(), it.value());
+			}
+		}
+		return minima;
+	}
+
+	//! Refine a minimum by Brent's method.
+	//! @param func a functor called as func(date), returning a double
+	//! @param a, b, c a bracket of the minimum, with a<b<c or c<b<a, f(b)<f(a) and f(b)<=f(c)
+	//! @param fb the value of the function at @em b
+	//! @param tolerance the precision of the returned date
+	//! @param fmin the value of the function at the returned date
+	//! @return the date of the minimum
+	template <class Func>
+	static double refine(Func& func, double a, double b, double c, double fb, double tolerance, double* fmin)
+	{
+		// Numerical Recipes, 10.3. The tolerance is absolute: dates are far from 0 and known to a few ulps.
+		const double goldenSection = 0.3819660112501051;
+		double lo = qMin(a, c);
+		double hi = qMax(a, c);
+		double x = b, w = b, v = b;
+		double fx = fb, fw = fb, fv = fb;
+		double d = 0., e = 0.;
+		for (int iteration=0; iteration<MaxRefineIterations; ++iteration)
+		{
+			const double xm = 0.5*(lo+hi);
+			if (std::fabs(x-xm) <= 2.*tolerance-0.5*(hi-lo))
+				break;
+			bool parabolic = false;
+			if (std::fabs(e)>tolerance)
+			{
+				// Parabola through x, w and v
+				const double r = (x-w)*(fx-fv);
+				double q = (x-v)*(fx-fw);
+				double p = (x-v)*q-(x-w)*r;
+				q = 2.*(q-r);
+				if (q>0.)
+					p = -p;
+				else
+					q = -q;
+				// Accepted only inside the bracket, and when moving less than half the step before last
+				if (std::fabs(p)<std::fabs(0.5*q*e) && p>q*(lo-x) && p<q*(hi-x))
+				{
+					e = d;
+					d = p/q;
+					const double u = x+d;
+					if (u-lo<2.*tolerance || hi-u<2.*tolerance)
+						d = xm>=x ? tolerance : -tolerance;
+					parabolic = true;
+				}
+			}
+			if (!parabolic)
+			{
+				e = x>=xm ? lo-x : hi-x;
+				d = goldenSection*e;
+			}
+			const double u = std::fabs(d)>=tolerance ? x+d : x+(d>=0. ? tolerance : -tolerance);
+			const double fu = func(u);
+			if (fu<=fx)
+			{
+				if (u>=x)
+					lo = x;
+				else
+					hi = x;
+				v = w; fv = fw;
+				w = x; fw = fx;
+				x = u; fx = fu;
+			}
+			else
+			{
+				if (u<x)
+					lo = u;
+				else
+					hi = u;
+				if (fu<=fw || w==x)
+				{
+					v = w; fv = fw;
+					w = u; fw = fu;
+				}
+				else if (fu<=fv || v==x || v==w)
+				{
+					v = u; fv = fu;
+				}
+			}
+		}
+		*fmin = fx;
+		return x;
+	}
+
+private:
+	enum
+	{
+		//! Smallest number of samples scanned by a thread
+		MinSamplesPerChunk = 64,
+		//! Brent's method gains at least a golden section every few iterations
+		MaxRefineIterations = 100
+	};
+
+	//! Samples first to end-1 of the scan, and the minima bracketed by them
+	struct Chunk
+	{
+		int first;
+		int end;
+		QMap<double, double> minima;
+	};
+
+	template <class Func>
+	struct ScanChunk
+	{
+		typedef void result_type;
+		ScanChunk(const Func& func, double start, double stop, double step, double maxValue, double tolerance)
+			: func(func), start(start), stop(stop), step(step), maxValue(maxValue), tolerance(tolerance) {}
+		double date(int sample) const {return qMin(start+sample*step, stop);}
+		void operator()(Chunk& chunk) const
+		{
+			Func f(func);
+			double prev = f(date(chunk.first-1));
+			double current = f(date(chunk.first));
+			for (int i=chunk.first; i<chunk.end; ++i)
+			{
+				const double next = f(date(i+1));
+				if (current<prev && current<=next)
+				{
+					double value;
+					const double minimum = refine(f, date(i-1), date(i), date(i+1), current, tolerance, &value);
+					if (value<=maxValue)
+						chunk.minima.insert(minimum, value);
+				}
+				prev = current;
+				current = next;
+			}
+		}
+		const Func& func;
+		double start, stop, step, maxValue, tolerance;
+	};
+};
+
+#endif // _MINIMUMSEARCH_HPP_
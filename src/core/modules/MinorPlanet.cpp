@@ -64,11 +64,11 @@ MinorPlanet::MinorPlanet(const QString& englishName,
 		  pTypeStr)
 {
 	texMapName = atexMapName;
-	lastOrbitJDE =0;
 	deltaJDE = StelCore::JD_SECOND;
-	orbitCached = 0;
 	closeOrbit = acloseOrbit;
 	semiMajorAxis = 0.;
+	perihelionDistance = 0.;
+	aphelionDistance = 0.;	// unknown
 
 	eclipticPos=Vec3d(0.,0.,0.);
 	rotLocalToParent = Mat4d::identity();
@@ -312,20 +312,47 @@ double MinorPlanet::getSiderealPeriod() const
 	return period;
 }
 
-float MinorPlanet::getVMagnitude(const StelCore* core) const
+void MinorPlanet::setDistanceRange(double perihelion, double aphelion)
+{
+	perihelionDistance = perihelion;
+	aphelionDistance = aphelion;
+}
+
+float MinorPlanet::getBrightestVMagnitude(double observerDistance, double margin) const
+{
+	if (slopeParameter < 0 || aphelionDistance <= 0.)
+		return -99.f;
+
+	// In getVMagnitude(), the reduced magnitude is never brighter than H for 0<=G<=1,
+	// and the distance from the observer is at least |r-d| for a heliocentric distance r.
+	// The smallest product r*|r-d| with r between the perihelion and the aphelion gives the bound.
+	const double minObserverDistance = observerDistance-margin;
+	const double maxObserverDistance = observerDistance+margin;
+	double minProduct;
+	if (maxObserverDistance < perihelionDistance)
+		minProduct = perihelionDistance*(perihelionDistance-maxObserverDistance);
+	else if (minObserverDistance > aphelionDistance)
+		minProduct = qMin(perihelionDistance*(minObserverDistance-perihelionDistance),
+				  aphelionDistance*(minObserverDistance-aphelionDistance));
+	else
+		return -99.f;
+	return absoluteMagnitude + 5.f*std::log10(minProduct);
+}
+
+float MinorPlanet::computeVMagnitude(const MagnitudeContext& context) const
 {
 	//If the H-G system is not used, use the default radius/albedo mechanism
 	if (slopeParameter < 0)
 	{
-		return Planet::getVMagnitude(core);
+		return Planet::computeVMagnitude(context);
 	}
 
 	//Calculate phase angle
 	//(Code copied from Planet::getVMagnitude())
 	//(this is actually vector subtraction + the cosine theorem :))
-	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	const Vec3d& observerHelioPos = context.observerHelioPos;
 	const float observerRq = observerHelioPos.lengthSquared();
-	const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
+	const Vec3d& planetHelioPos = context.planetHelioPos;
 	const float planetRq = planetHelioPos.lengthSquared();
 	const float observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
 	const float cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
@@ -72,7 +72,7 @@ public:
 	//was not designed to handle different types of objects.
 	// \todo Decide if this is going to be "MinorPlanet" or "Asteroid"
 	//virtual QString getType() const {return "MinorPlanet";}
-	virtual float getVMagnitude(const StelCore* core) const;
+	virtual float computeVMagnitude(const MagnitudeContext& context) const;
 	//! sets the nameI18 property with the appropriate translation.
 	//! Function overriden to handle the problem with name conflicts.
 	virtual void translateName(const StelTranslator& trans);
@@ -111,11 +111,22 @@ public:
 	//! get sidereal period for minor planet
 	double getSiderealPeriod() const;
 
+	//! set the smallest and largest heliocentric distances of the orbit in AU, used by getBrightestVMagnitude().
+	void setDistanceRange(double perihelion, double aphelion);
+	//! Get a magnitude the minor planet is never brighter than, whatever its position on its orbit,
+	//! for an observer at a heliocentric distance of observerDistance±margin AU.
+	//! The bound is only known when the H-G system is used and the distance range is set,
+	//! and when the observer is not between the perihelion and the aphelion.
+	//! @return -99 when there is no bound
+	float getBrightestVMagnitude(double observerDistance, double margin) const;
+
 private:
 	int minorPlanetNumber;
 	float absoluteMagnitude;
 	float  slopeParameter;
 	double semiMajorAxis;
+	double perihelionDistance;
+	double aphelionDistance;
 
 	bool nameIsProvisionalDesignation;
 	QString provisionalDesignationHtml;
@@ -0,0 +1,70 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "OrbitSampler.hpp"
+
+const int OrbitSampler::InitialIntervals = 32;
+const int OrbitSampler::MaxDepth = 7;
+
+OrbitSample OrbitSampler::at(double jde, double dateJDE) const
+{
+	OrbitSample sample;
+	sample.jde = jde;
+	if (osculatingFunc)
+		(*osculatingFunc)(dateJDE, jde, sample.pos, userData);
+	else
+		coordFunc(jde, sample.pos, userData);
+	return sample;
+}
+
+OrbitSampler::Samples OrbitSampler::sample(double dateJDE, double span, const Vec3d& observerPos, double tolerance) const
+{
+	// Uniform dates to start with, one of them being dateJDE, then at most MaxDepth halvings
+	Samples samples;
+	samples.dateJDE = dateJDE;
+	samples.observerPos = observerPos;
+	samples.tolerance = tolerance;
+	const double step = span/InitialIntervals;
+	OrbitSample previous = at(dateJDE - 0.5*span, dateJDE);
+	samples.points.append(previous);
+	for (int i=1; i<=InitialIntervals; ++i)
+	{
+		const OrbitSample next = at(dateJDE + (i-InitialIntervals/2)*step, dateJDE);
+		refine(previous, next, MaxDepth, samples);
+		samples.points.append(next);
+		previous = next;
+	}
+	return samples;
+}
+
+void OrbitSampler::refine(const OrbitSample& a, const OrbitSample& b, int depth, Samples& samples) const
+{
+	const OrbitSample middle = at(0.5*(a.jde+b.jde), samples.dateJDE);
+	const Vec3d chordMiddle = (a.pos+b.pos)*0.5;
+	const double deviation = (middle.pos-chordMiddle).length();
+	if (depth>0 && deviation > samples.tolerance*(chordMiddle-samples.observerPos).length())
+	{
+		refine(a, middle, depth-1, samples);
+		samples.points.append(middle);
+		refine(middle, b, depth-1, samples);
+	}
+	else
+		samples.points.append(middle);
+}
@@ -0,0 +1,83 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _ORBITSAMPLER_HPP_
+#define _ORBITSAMPLER_HPP_
+
+#include "VecMath.hpp"
+
+#include <QVector>
+
+// The callback type for the external position computation function
+// The last variable is the userData pointer.
+typedef void (*posFuncType)(double, double*, void*);
+
+typedef void (OsculatingFunctType)(double jde0,double jde,double xyz[3], void*);
+
+// A point of an orbit line
+struct OrbitSample
+{
+	double jde;
+	Vec3d pos;                       // position in the parent Planet coordinate system
+};
+
+//! @class OrbitSampler
+//! Adaptive sampling of the orbit line of a Planet, over a span of time centered on a date.
+//! The line starts with uniformly spaced dates, and the intervals are halved as long as the middle
+//! of their chord deviates from the orbit by more than the tolerance, as seen by the observer.
+//! The samples are therefore dense near the pericenter and where the orbit is close to the
+//! observer, and sparse elsewhere.
+//! sample() only uses the given position functions and data, so that it can run in a worker thread.
+class OrbitSampler
+{
+public:
+	//! Number of uniformly spaced intervals the span is first divided in
+	static const int InitialIntervals;
+	//! Maximum number of times an initial interval is halved
+	static const int MaxDepth;
+
+	struct Samples
+	{
+		Samples() : dateJDE(0.), tolerance(0.) {}
+		QVector<OrbitSample> points;     // samples ordered by date
+		double dateJDE;                  // middle date, also the epoch of the osculating elements
+		Vec3d observerPos;               // observer position in the parent Planet coordinate system
+		double tolerance;                // maximum deviation of the line from the orbit [rad]
+	};
+
+	OrbitSampler(posFuncType coordFunc, OsculatingFunctType* osculatingFunc, void* userData)
+		: coordFunc(coordFunc), osculatingFunc(osculatingFunc), userData(userData) {}
+
+	//! Sample the orbit from dateJDE-span/2 to dateJDE+span/2.
+	//! @param observerPos the observer position in the parent Planet coordinate system
+	//! @param tolerance the maximum angle between the line and the orbit seen by the observer [rad]
+	Samples sample(double dateJDE, double span, const Vec3d& observerPos, double tolerance) const;
+
+private:
+	OrbitSample at(double jde, double dateJDE) const;
+	//! Add the samples needed between a and b, excluded.
+	void refine(const OrbitSample& a, const OrbitSample& b, int depth, Samples& samples) const;
+
+	posFuncType coordFunc;
+	OsculatingFunctType* osculatingFunc;
+	void* userData;
+};
+
+#endif // _ORBITSAMPLER_HPP_
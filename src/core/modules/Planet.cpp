@@ -37,6 +37,7 @@
 #include "StelTranslator.hpp"
 #include "StelUtils.hpp"
 #include "StelOpenGL.hpp"
+#include "PlanetMeshCache.hpp"
 
 #include <iomanip>
 #include <limits>
@@ -46,6 +47,7 @@
 #include <QVarLengthArray>
 #include <QOpenGLContext>
 #include <QOpenGLShader>
+#include <QtConcurrentRun>
 
 Vec3f Planet::labelColor = Vec3f(0.4f,0.4f,0.8f);
 Vec3f Planet::orbitColor = Vec3f(1.0f,0.6f,1.0f);
@@ -53,6 +55,9 @@ StelTextureSP Planet::hintCircleTex;
 StelTextureSP Planet::texEarthShadow;
 
 bool Planet::permanentDrawingOrbits = false;
+Vec3d Planet::orbitSamplingObserver = Vec3d(0.,0.,0.);
+double Planet::orbitSamplingTolerance = 1e-3;
+const Planet* Planet::sunPlanet = NULL;
 
 bool Planet::flagCustomGrsSettings = false;
 double Planet::customGrsJD = 2456901.5;
@@ -100,14 +105,17 @@ Planet::Planet(const QString& englishName,
 	  osculatingFunc(osculatingFunc),
 	  parent(NULL),
 	  hidden(hidden),
+	  culled(false),
 	  atmosphere(hasAtmosphere),
 	  halo(hasHalo)
 {
 	texMapName = atexMapName;
 	normalMapName = anormalMapName;
-	lastOrbitJDE =0;
+	orbitSamplingPending = false;
+	orbitSamplingFunc = NULL;
+	orbitSamplingData = NULL;
+	orbitSamplingDataIsContext = false;
 	deltaJDE = StelCore::JD_SECOND;
-	orbitCached = 0;
 	closeOrbit = acloseOrbit;
 	deltaOrbitJDE = 0;
 	distance = 0;
@@ -168,6 +176,7 @@ void Planet::init()
 
 Planet::~Planet()
 {
+	waitForOrbitSampling();
 	if (rings)
 		delete rings;
 }
@@ -528,133 +537,82 @@ void Planet::computePosition(const double dateJDE)
 {
 	// Make sure the parent position is computed for the dateJDE, otherwise
 	// getHeliocentricPos() would return incorrect values.
-	if (parent)
+	// The Sun always stays at the origin: it is left alone so that the bodies
+	// orbiting it can be computed concurrently (see SolarSystem::computePositions()).
+	if (parent && parent.data()!=sunPlanet)
 		parent->computePositionWithoutOrbits(dateJDE);
 
-	if (orbitFader.getInterstate()>0.000001 && deltaOrbitJDE > 0 && (fabs(lastOrbitJDE-dateJDE)>deltaOrbitJDE || !orbitCached))
-	{
-		StelCore *core=StelApp::getInstance().getCore();
-
-		double calc_date;
-		// int delta_points = (int)(0.5 + (date - lastOrbitJD)/date_increment);
-		int delta_points;
-
-		if( dateJDE > lastOrbitJDE )
-		{
-			delta_points = (int)(0.5 + (dateJDE - lastOrbitJDE)/deltaOrbitJDE);
-		}
-		else
-		{
-			delta_points = (int)(-0.5 + (dateJDE - lastOrbitJDE)/deltaOrbitJDE);
-		}
-		double new_date = lastOrbitJDE + delta_points*deltaOrbitJDE;
-
-		// qDebug( "Updating orbit coordinates for %s (delta %f) (%d points)\n", getEnglishName().toUtf8().data(), deltaOrbitJDE, delta_points);
-
-		if( delta_points > 0 && delta_points < ORBIT_SEGMENTS && orbitCached)
-		{
-
-			for( int d=0; d<ORBIT_SEGMENTS; d++ )
-			{
-				if(d + delta_points >= ORBIT_SEGMENTS-1 )
-				{
-					// calculate new points
-					calc_date = new_date + (d-ORBIT_SEGMENTS/2)*deltaOrbitJDE;
-
-					// date increments between points will not be completely constant though
-					computeTransMatrix(calc_date-core->computeDeltaT(calc_date)/86400.0, calc_date);
-					if (osculatingFunc)
-					{
-						(*osculatingFunc)(dateJDE,calc_date,eclipticPos);
-					}
-					else
-					{
-						coordFunc(calc_date, eclipticPos, userDataPtr);
-					}
-					orbitP[d] = eclipticPos;
-					orbit[d] = getHeliocentricEclipticPos();
-				}
-				else
-				{
-					orbitP[d] = orbitP[d+delta_points];
-					orbit[d] = getHeliocentricPos(orbitP[d]);
-				}
-			}
-
-			lastOrbitJDE = new_date;
-		}
-		else if( delta_points < 0 && abs(delta_points) < ORBIT_SEGMENTS  && orbitCached)
-		{
-
-			for( int d=ORBIT_SEGMENTS-1; d>=0; d-- )
-			{
-				if(d + delta_points < 0 )
-				{
-					// calculate new points
-					calc_date = new_date + (d-ORBIT_SEGMENTS/2)*deltaOrbitJDE;
-
-					computeTransMatrix(calc_date-core->computeDeltaT(calc_date)/86400.0, calc_date);
-					if (osculatingFunc) {
-						(*osculatingFunc)(dateJDE,calc_date,eclipticPos);
-					}
-					else
-					{
-						coordFunc(calc_date, eclipticPos, userDataPtr);
-					}
-					orbitP[d] = eclipticPos;
-					orbit[d] = getHeliocentricEclipticPos();
-				}
-				else
-				{
-					orbitP[d] = orbitP[d+delta_points];
-					orbit[d] = getHeliocentricPos(orbitP[d]);
-				}
-			}
-
-			lastOrbitJDE = new_date;
-
-		}
-		else if( delta_points || !orbitCached)
-		{
-
-			// update all points (less efficient)
-			for( int d=0; d<ORBIT_SEGMENTS; d++ )
-			{
-				calc_date = dateJDE + (d-ORBIT_SEGMENTS/2)*deltaOrbitJDE;
-				computeTransMatrix(calc_date-core->computeDeltaT(calc_date)/86400.0, calc_date);
-				if (osculatingFunc)
-				{
-					(*osculatingFunc)(dateJDE,calc_date,eclipticPos);
-				}
-				else
-				{
-					coordFunc(calc_date, eclipticPos, userDataPtr);
-				}
-				orbitP[d] = eclipticPos;
-				orbit[d] = getHeliocentricEclipticPos();
-			}
-
-			lastOrbitJDE = dateJDE;
-			if (!osculatingFunc) orbitCached = 1;
-		}
-
+	if (orbitFader.getInterstate()>0.000001 && deltaOrbitJDE > 0)
+		updateOrbitSamples(dateJDE);
 
+	if (fabs(lastJDE-dateJDE)>deltaJDE)
+	{
 		// calculate actual Planet position
 		coordFunc(dateJDE, eclipticPos, userDataPtr);
-
 		lastJDE = dateJDE;
+	}
+}
+
+// Publish the orbit line sampled in the worker thread once it is done, and sample it again
+// when the date, the observer or the zoom have changed too much since the line was sampled.
+// Only one line is sampled at a time: the previous one is drawn in the meantime.
+void Planet::updateOrbitSamples(double dateJDE)
+{
+	if (orbitSamplingPending)
+	{
+		if (!orbitSamplingJob.isFinished())
+			return;
+		orbitSamples = orbitSamplingJob.result();
+		orbitSamplingPending = false;
+	}
+
+	const Vec3d observerPos = parent ? orbitSamplingObserver - parent->getHeliocentricEclipticPos() : orbitSamplingObserver;
+	const double tolerance = orbitSamplingTolerance;
+	if (!orbitSamples.points.isEmpty()
+	    && fabs(orbitSamples.dateJDE-dateJDE) <= deltaOrbitJDE
+	    && tolerance >= 0.5*orbitSamples.tolerance && tolerance <= 4.*orbitSamples.tolerance
+	    && (observerPos-orbitSamples.observerPos).length() <= 0.1*orbitSamples.observerPos.length())
+		return;
 
+	const double span = ORBIT_SEGMENTS*deltaOrbitJDE;
+	if (orbitSamplingFunc)
+	{
+		OrbitSampler sampler(orbitSamplingFunc, osculatingFunc, orbitSamplingData);
+		orbitSamplingJob = QtConcurrent::run(sampler, &OrbitSampler::sample, dateJDE, span, observerPos, tolerance);
+		orbitSamplingPending = true;
 	}
-	else if (fabs(lastJDE-dateJDE)>deltaJDE)
+	else
 	{
-		// calculate actual Planet position
-		coordFunc(dateJDE, eclipticPos, userDataPtr);
-		if (orbitFader.getInterstate()>0.000001)
-			for( int d=0; d<ORBIT_SEGMENTS; d++ )
-				orbit[d]=getHeliocentricPos(orbitP[d]);
-		lastJDE = dateJDE;
+		OrbitSampler sampler(coordFunc, osculatingFunc, userDataPtr);
+		orbitSamples = sampler.sample(dateJDE, span, observerPos, tolerance);
 	}
+}
 
+void Planet::setOrbitSamplingFunc(posFuncType func, void* userData, bool userDataIsContext)
+{
+	waitForOrbitSampling();
+	orbitSamplingFunc = func;
+	orbitSamplingData = userData;
+	orbitSamplingDataIsContext = userDataIsContext;
+}
+
+bool Planet::computeEclipticPosAt(double dateJDE, double xyz[3], EphemContext* context) const
+{
+	if (!orbitSamplingFunc)
+		return false;
+	orbitSamplingFunc(dateJDE, xyz, orbitSamplingDataIsContext ? context : orbitSamplingData);
+	return true;
+}
+
+void Planet::waitForOrbitSampling()
+{
+	orbitSamplingJob.waitForFinished();
+}
+
+void Planet::setOrbitSamplingView(const Vec3d& observerPos, double tolerance)
+{
+	orbitSamplingObserver = observerPos;
+	orbitSamplingTolerance = tolerance;
 }
 
 // Compute the transformation matrix from the local Planet coordinate system to the parent Planet coordinate system.
@@ -669,35 +627,41 @@ void Planet::computeTransMatrix(double JD, double JDE)
 	// not solar equator...
 
 	if (parent)
+		rotLocalToParent = computeRotLocalToParent(JDE);
+}
+
+Mat4d Planet::computeRotLocalToParent(double JDE) const
+{
+	if (!parent)
+		return rotLocalToParent;
+
+	// We can inject a proper precession plus even nutation matrix in this stage, if available.
+	if (englishName=="Earth")
 	{
-		// We can inject a proper precession plus even nutation matrix in this stage, if available.
-		if (englishName=="Earth")
+		// rotLocalToParent = Mat4d::zrotation(re.ascendingNode - re.precessionRate*(jd-re.epoch)) * Mat4d::xrotation(-getRotObliquity(jd));
+		// We follow Capitaine's (2003) formulation P=Rz(Chi_A)*Rx(-omega_A)*Rz(-psi_A)*Rx(eps_o).
+		// ADS: 2011A&A...534A..22V = A&A 534, A22 (2011): Vondrak, Capitane, Wallace: New Precession Expressions, valid for long time intervals:
+		// See also Hilton et al., Report on Precession and the Ecliptic. Cel.Mech.Dyn.Astr. 94:351-367 (2006), eqn (6) and (21).
+		double eps_A, chi_A, omega_A, psi_A;
+		getPrecessionAnglesVondrak(JDE, &eps_A, &chi_A, &omega_A, &psi_A);
+		// Canonical precession rotations: Nodal rotation psi_A,
+		// then rotation by omega_A, the angle between EclPoleJ2000 and EarthPoleOfDate.
+		// The final rotation by chi_A rotates the equinox (zero degree).
+		// To achieve ecliptical coords of date, you just have now to add a rotX by epsilon_A (obliquity of date).
+
+		Mat4d rot = Mat4d::zrotation(-psi_A) * Mat4d::xrotation(-omega_A) * Mat4d::zrotation(chi_A);
+		// Plus nutation IAU-2000B:
+		if (StelApp::getInstance().getCore()->getUseNutation())
 		{
-			// rotLocalToParent = Mat4d::zrotation(re.ascendingNode - re.precessionRate*(jd-re.epoch)) * Mat4d::xrotation(-getRotObliquity(jd));
-			// We follow Capitaine's (2003) formulation P=Rz(Chi_A)*Rx(-omega_A)*Rz(-psi_A)*Rx(eps_o).
-			// ADS: 2011A&A...534A..22V = A&A 534, A22 (2011): Vondrak, Capitane, Wallace: New Precession Expressions, valid for long time intervals:
-			// See also Hilton et al., Report on Precession and the Ecliptic. Cel.Mech.Dyn.Astr. 94:351-367 (2006), eqn (6) and (21).
-			double eps_A, chi_A, omega_A, psi_A;
-			getPrecessionAnglesVondrak(JDE, &eps_A, &chi_A, &omega_A, &psi_A);
-			// Canonical precession rotations: Nodal rotation psi_A,
-			// then rotation by omega_A, the angle between EclPoleJ2000 and EarthPoleOfDate.
-			// The final rotation by chi_A rotates the equinox (zero degree).
-			// To achieve ecliptical coords of date, you just have now to add a rotX by epsilon_A (obliquity of date).
-
-			rotLocalToParent= Mat4d::zrotation(-psi_A) * Mat4d::xrotation(-omega_A) * Mat4d::zrotation(chi_A);
-			// Plus nutation IAU-2000B:
-			if (StelApp::getInstance().getCore()->getUseNutation())
-			{
-				double deltaEps, deltaPsi;
-				getNutationAngles(JDE, &deltaPsi, &deltaEps);
-				//qDebug() << "deltaEps, arcsec" << deltaEps*180./M_PI*3600. << "deltaPsi" << deltaPsi*180./M_PI*3600.;
-				Mat4d nut2000B=Mat4d::xrotation(eps_A) * Mat4d::zrotation(deltaPsi)* Mat4d::xrotation(-eps_A-deltaEps);
-				rotLocalToParent=rotLocalToParent*nut2000B;
-			}
+			double deltaEps, deltaPsi;
+			getNutationAngles(JDE, &deltaPsi, &deltaEps);
+			//qDebug() << "deltaEps, arcsec" << deltaEps*180./M_PI*3600. << "deltaPsi" << deltaPsi*180./M_PI*3600.;
+			Mat4d nut2000B=Mat4d::xrotation(eps_A) * Mat4d::zrotation(deltaPsi)* Mat4d::xrotation(-eps_A-deltaEps);
+			rot=rot*nut2000B;
 		}
-		else
-			rotLocalToParent = Mat4d::zrotation(re.ascendingNode - re.precessionRate*(JDE-re.epoch)) * Mat4d::xrotation(re.obliquity);
+		return rot;
 	}
+	return Mat4d::zrotation(re.ascendingNode - re.precessionRate*(JDE-re.epoch)) * Mat4d::xrotation(re.obliquity);
 }
 
 Mat4d Planet::getRotEquatorialToVsop87(void) const
@@ -887,16 +851,32 @@ double Planet::getElongation(const Vec3d& obsPos) const
 
 // Computation of the visual magnitude (V band) of the planet.
 float Planet::getVMagnitude(const StelCore* core) const
+{
+	MagnitudeContext context;
+	context.observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	context.planetHelioPos = getHeliocentricEclipticPos();
+	context.parentHelioPos = parent ? parent->getHeliocentricEclipticPos() : Vec3d(0.);
+	static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
+	const PlanetP& earth = ssystem->getEarth();
+	context.earthHelioPos = earth ? earth->getHeliocentricEclipticPos() : Vec3d(0.);
+	context.JDE = core->getJDE();
+	context.fromEarth = core->getCurrentLocation().planetName=="Earth";
+	context.algorithm = core->getCurrentPlanet()->getApparentMagnitudeAlgorithm();
+	// Only the Sun needs the eclipses, which are long to compute
+	context.eclipseFactor = parent ? 1. : ssystem->getEclipseFactor(core);
+	return computeVMagnitude(context);
+}
+
+float Planet::computeVMagnitude(const MagnitudeContext& context) const
 {
 	if (parent == 0)
 	{
 		// Sun, compute the apparent magnitude for the absolute mag (V: 4.83) and observer's distance
 		// Hint: Absolute Magnitude of the Sun in Several Bands: http://mips.as.arizona.edu/~cnaw/sun.html
-		const double distParsec = std::sqrt(core->getObserverHeliocentricEclipticPos().lengthSquared())*AU/PARSEC;
+		const double distParsec = std::sqrt(context.observerHelioPos.lengthSquared())*AU/PARSEC;
 
 		// check how much of it is visible
-		const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
-		double shadowFactor = ssm->getEclipseFactor(core);
+		double shadowFactor = context.eclipseFactor;
 		// See: Hughes, D. W., Brightness during a solar eclipse // Journal of the British Astronomical Association, vol.110, no.4, p.203-205
 		// URL: http://adsabs.harvard.edu/abs/2000JBAA..110..203H
 		if(shadowFactor < 0.000128)
@@ -906,9 +886,9 @@ float Planet::getVMagnitude(const StelCore* core) const
 	}
 
 	// Compute the angular phase
-	const Vec3d& observerHelioPos = core->getObserverHeliocentricEclipticPos();
+	const Vec3d& observerHelioPos = context.observerHelioPos;
 	const double observerRq = observerHelioPos.lengthSquared();
-	const Vec3d& planetHelioPos = getHeliocentricEclipticPos();
+	const Vec3d& planetHelioPos = context.planetHelioPos;
 	const double planetRq = planetHelioPos.lengthSquared();
 	const double observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
 	const double cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
@@ -918,7 +898,7 @@ float Planet::getVMagnitude(const StelCore* core) const
 	// Check if the satellite is inside the inner shadow of the parent planet:
 	if (parent->parent != 0)
 	{
-		const Vec3d& parentHeliopos = parent->getHeliocentricEclipticPos();
+		const Vec3d& parentHeliopos = context.parentHelioPos;
 		const double parent_Rq = parentHeliopos.lengthSquared();
 		const double pos_times_parent_pos = planetHelioPos * parentHeliopos;
 		if (pos_times_parent_pos > parent_Rq)
@@ -955,7 +935,7 @@ float Planet::getVMagnitude(const StelCore* core) const
 	}
 
 	// Use empirical formulae for main planets when seen from earth
-	if (core->getCurrentLocation().planetName=="Earth")
+	if (context.fromEarth)
 	{
 		const double phaseDeg=phase*180./M_PI;
 		const double d = 5. * log10(std::sqrt(observerPlanetRq*planetRq));
@@ -968,7 +948,7 @@ float Planet::getVMagnitude(const StelCore* core) const
 		// I activate (1) for now, because we want to simulate the eye's impression. (Esp. Venus!)
 		// AW: (2) activated by default
 
-		switch (core->getCurrentPlanet()->getApparentMagnitudeAlgorithm())
+		switch (context.algorithm)
 		{
 			case Planesas:
 			{
@@ -990,12 +970,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=context.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=planetHelioPos - context.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinx=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1029,12 +1008,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=context.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=planetHelioPos - context.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1067,12 +1045,11 @@ float Planet::getVMagnitude(const StelCore* core) const
 				{
 					// add rings computation
 					// implemented from Meeus, Astr.Alg.1992
-					const double jde=core->getJDE();
+					const double jde=context.JDE;
 					const double T=(jde-2451545.0)/36525.0;
 					const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
 					const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
-					static SolarSystem *ssystem=GETSTELMODULE(SolarSystem);
-					const Vec3d saturnEarth=getHeliocentricEclipticPos() - ssystem->getEarth()->getHeliocentricEclipticPos();
+					const Vec3d saturnEarth=planetHelioPos - context.earthHelioPos;
 					double lambda=atan2(saturnEarth[1], saturnEarth[0]);
 					double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
 					const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
@@ -1116,15 +1093,16 @@ double Planet::getSpheroidAngularSize(const StelCore* core) const
 	return std::atan2(radius*sphereScale,getJ2000EquatorialPos(core).length()) * 180./M_PI;
 }
 
-// Draw the Planet and all the related infos : name, circle etc..
-void Planet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont)
+// Whether draw() leaves the body out: hidden, or too faint
+bool Planet::isDrawSkipped(const StelCore* core, float mag) const
 {
 	if (hidden)
-		return;
+		return true;
 
 	// Exclude drawing if user set a hard limit magnitude.
-	if (core->getSkyDrawer()->getFlagPlanetMagnitudeLimit() && (getVMagnitude(core) > core->getSkyDrawer()->getCustomPlanetMagnitudeLimit()))
-		return;
+	const StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	if (skyDrawer->getFlagPlanetMagnitudeLimit() && mag > skyDrawer->getCustomPlanetMagnitudeLimit())
+		return true;
 
 	// Try to improve speed for minor planets: test if visible at all.
 	// For a full catalog of NEAs (11000 objects), with this and resetting deltaJD according to distance, rendering time went 4.5fps->12fps.	
@@ -1135,10 +1113,14 @@ void Planet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFon
 	// If asteroid is too faint to be seen, don't bother rendering. (Massive speedup if people have hundreds of orbital elements!)
 	// AW: Added a special case for educational purpose to drawing orbits for the Solar System Observer
 	// Details: https://sourceforge.net/p/stellarium/discussion/278769/thread/4828ebe4/
-	if (((getVMagnitude(core)-5.0f) > core->getSkyDrawer()->getLimitMagnitude()) && pType>=Planet::isAsteroid && core->getCurrentLocation().planetName!="Solar System Observer")
-	{
+	return (mag-5.0f) > skyDrawer->getLimitMagnitude() && pType>=Planet::isAsteroid && core->getCurrentLocation().planetName!="Solar System Observer";
+}
+
+// Draw the Planet and all the related infos : name, circle etc..
+void Planet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont)
+{
+	if (isDrawSkipped(core, getVMagnitude(core)))
 		return;
-	}
 
 	Mat4d mat = Mat4d::translation(eclipticPos) * rotLocalToParent;
 	PlanetP p = parent;
@@ -1199,6 +1181,47 @@ void Planet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFon
 	return;
 }
 
+bool Planet::drawAsPointSource(StelCore* core, StelPainter* sPainter, float maxMagLabels, bool selected)
+{
+	// Bodies which may have a label, an orbit line, a disk, satellites or a tail are drawn by draw()
+	if (selected || pType<isAsteroid || pType==isComet || rings || !satellites.isEmpty() || permanentDrawingOrbits
+	    || labelsFader.getInterstate()>0.f || orbitFader.getInterstate()>0.f || getEnglishName()==core->getCurrentLocation().planetName)
+		return false;
+
+	const float mag = getVMagnitude(core);
+	if (isDrawSkipped(core, mag))
+		return true;
+	StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+	if (flagLabels && maxMagLabels>mag)
+		return false;
+	const float pixPerRad = sPainter->getProjector()->getPixelPerRadAtCenter();
+	if (getAngularSize(core)*M_PI/180.*pixPerRad>1.)
+		return false;
+	labelsFader = false;
+	if (!hasHalo())
+		return true;
+
+	// The halo of draw3dModel(), which is hidden behind the disk of the Sun
+	const Vec3d pos = getJ2000EquatorialPos(core);
+	if (core->getCurrentLocation().planetName=="Earth")
+	{
+		const Vec3d par = getParent()->getJ2000EquatorialPos(core);
+		if (pos.angle(par)*180./M_PI<=getParent()->getSpheroidAngularSize(core))
+			return true;
+	}
+	const float magWithExtinction = getVMagnitudeWithExtinction(core);
+	RCMag rcm;
+	skyDrawer->computeRCMag(magWithExtinction, &rcm);
+	// StelSkyDrawer::postDrawSky3dModel() truncates bigger halos and adapts the luminance to them
+	if (rcm.radius>9.f)
+		return false;
+	const float extinctedMag = magWithExtinction-mag;
+	const Vec3f color(haloColor[0], std::pow(0.85f, 0.6f*extinctedMag)*haloColor[1], std::pow(0.6f, 0.5f*extinctedMag)*haloColor[2]);
+	// As in postDrawSky3dModel(), the halo does not twinkle
+	skyDrawer->drawPointSource(sPainter, Vec3f(pos[0], pos[1], pos[2]), rcm, color, true, 0.f);
+	return true;
+}
+
 class StelPainterLight
 {
 public:
@@ -1490,6 +1513,7 @@ void Planet::deinitShader()
 	ringPlanetShaderProgram = NULL;
 	delete moonShaderProgram;
 	moonShaderProgram = NULL;
+	meshCache.clear();
 }
 
 void Planet::draw3dModel(StelCore* core, StelProjector::ModelViewTranformP transfo, float screenSz, bool drawOnlyRing)
@@ -1613,105 +1637,36 @@ void Planet::draw3dModel(StelCore* core, StelProjector::ModelViewTranformP trans
 	}
 }
 
-struct Planet3DModel
-{
-	QVector<float> vertexArr;
-	QVector<float> texCoordArr;
-	QVector<unsigned short> indiceArr;
-};
+// Meshes of all the bodies, and the buffers of their vertices scaled to the body and projected.
+// Bodies are only drawn from the main thread.
+static PlanetMeshCache meshCache;
+static QVector<float> scaledVertexArr;
+static QVector<float> projectedVertexArr;
 
-void sSphere(Planet3DModel* model, const float radius, const float oneMinusOblateness, const int slices, const int stacks)
+const PlanetMeshCache& Planet::getMeshCache()
 {
-	model->indiceArr.resize(0);
-	model->vertexArr.resize(0);
-	model->texCoordArr.resize(0);
-	
-	GLfloat x, y, z;
-	GLfloat s=0.f, t=1.f;
-	GLint i, j;
-
-	const float* cos_sin_rho = StelUtils::ComputeCosSinRho(stacks);
-	const float* cos_sin_theta =  StelUtils::ComputeCosSinTheta(slices);
-	
-	const float* cos_sin_rho_p;
-	const float *cos_sin_theta_p;
-
-	// texturing: s goes from 0.0/0.25/0.5/0.75/1.0 at +y/+x/-y/-x/+y axis
-	// t goes from -1.0/+1.0 at z = -radius/+radius (linear along longitudes)
-	// cannot use triangle fan on texturing (s coord. at top/bottom tip varies)
-	// If the texture is flipped, we iterate the coordinates backward.
-	const GLfloat ds = 1.f / slices;
-	const GLfloat dt = 1.f / stacks; // from inside texture is reversed
-
-	// draw intermediate  as quad strips
-	for (i = 0,cos_sin_rho_p = cos_sin_rho; i < stacks; ++i,cos_sin_rho_p+=2)
-	{
-		s = 0.f;
-		for (j = 0,cos_sin_theta_p = cos_sin_theta; j<=slices;++j,cos_sin_theta_p+=2)
-		{
-			x = -cos_sin_theta_p[1] * cos_sin_rho_p[1];
-			y = cos_sin_theta_p[0] * cos_sin_rho_p[1];
-			z = cos_sin_rho_p[0];
-			model->texCoordArr << s << t;
-			model->vertexArr << x * radius << y * radius << z * oneMinusOblateness * radius;
-			x = -cos_sin_theta_p[1] * cos_sin_rho_p[3];
-			y = cos_sin_theta_p[0] * cos_sin_rho_p[3];
-			z = cos_sin_rho_p[2];
-			model->texCoordArr << s << t - dt;
-			model->vertexArr << x * radius << y * radius << z * oneMinusOblateness * radius;
-			s += ds;
-		}
-		unsigned int offset = i*(slices+1)*2;
-		for (j = 2;j<slices*2+2;j+=2)
-		{
-			model->indiceArr << offset+j-2 << offset+j-1 << offset+j;
-			model->indiceArr << offset+j << offset+j-1 << offset+j+1;
-		}
-		t -= dt;
-	}
+	return meshCache;
 }
 
-struct Ring3DModel
+// Scale a mesh to a radius and project it, into scaledVertexArr and projectedVertexArr.
+static void projectMesh(const PlanetMeshCache::Mesh* mesh, float radius, const StelProjectorP& projector)
 {
-	QVector<float> vertexArr;
-	QVector<float> texCoordArr;
-	QVector<unsigned short> indiceArr;
-};
-
-
-void sRing(Ring3DModel* model, const float rMin, const float rMax, int slices, const int stacks)
-{
-	float x,y;
-	
-	const float dr = (rMax-rMin) / stacks;
-	const float* cos_sin_theta = StelUtils::ComputeCosSinTheta(slices);
-	const float* cos_sin_theta_p;
-
-	model->vertexArr.resize(0);
-	model->texCoordArr.resize(0);
-	model->indiceArr.resize(0);
-
-	float r = rMin;
-	for (int i=0; i<=stacks; ++i)
+	const int size = mesh->vertexArr.size();
+	if (scaledVertexArr.capacity()<size)
 	{
-		const float tex_r0 = (r-rMin)/(rMax-rMin);
-		int j;
-		for (j=0,cos_sin_theta_p=cos_sin_theta; j<=slices; ++j,cos_sin_theta_p+=2)
-		{
-			x = r*cos_sin_theta_p[0];
-			y = r*cos_sin_theta_p[1];
-			model->texCoordArr << tex_r0 << 0.5f;
-			model->vertexArr << x << y << 0.f;
-		}
-		r+=dr;
+		scaledVertexArr.reserve(size);
+		projectedVertexArr.reserve(size);
 	}
-	for (int i=0; i<stacks; ++i)
+	scaledVertexArr.resize(size);
+	projectedVertexArr.resize(size);
+	const float* v = mesh->vertexArr.constData();
+	float* scaled = scaledVertexArr.data();
+	float* projected = projectedVertexArr.data();
+	for (int i=0;i<size;i+=3)
 	{
-		for (int j=0; j<slices; ++j)
-		{
-			model->indiceArr << i*slices+j << (i+1)*slices+j << i*slices+j+1;
-			model->indiceArr << i*slices+j+1 << (i+1)*slices+j << (i+1)*slices+j+1;
-		}
+		Vec3f* vertex = (Vec3f*)(scaled+i);
+		vertex->set(v[i]*radius, v[i+1]*radius, v[i+2]*radius);
+		projector->project(*vertex, *((Vec3f*)(projected+i)));
 	}
 }
 
@@ -1747,13 +1702,8 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 	if (nb_facet>100) nb_facet = 100;
 
 	// Generates the vertice
-	Planet3DModel model;
-	sSphere(&model, radius*sphereScale, oneMinusOblateness, nb_facet, nb_facet);
-	
-	QVector<float> projectedVertexArr;
-	projectedVertexArr.resize(model.vertexArr.size());
-	for (int i=0;i<model.vertexArr.size()/3;++i)
-		painter->getProjector()->project(*((Vec3f*)(model.vertexArr.constData()+i*3)), *((Vec3f*)(projectedVertexArr.data()+i*3)));
+	const PlanetMeshCache::Mesh* model = meshCache.sphere(nb_facet, oneMinusOblateness);
+	projectMesh(model, radius*sphereScale, painter->getProjector());
 	
 	const SolarSystem* ssm = GETSTELMODULE(SolarSystem);
 		
@@ -1761,8 +1711,8 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 	{
 		texMap->bind();
 		//painter->setColor(2, 2, 0.2); // This is now in draw3dModel() to apply extinction
-		painter->setArrays((Vec3f*)projectedVertexArr.constData(), (Vec2f*)model.texCoordArr.constData());
-		painter->drawFromArray(StelPainter::Triangles, model.indiceArr.size(), 0, false, model.indiceArr.constData());
+		painter->setArrays((Vec3f*)projectedVertexArr.constData(), (Vec2f*)model->texCoordArr.constData());
+		painter->drawFromArray(StelPainter::Triangles, model->indiceArr.size(), 0, false, model->indiceArr.constData());
 		return;
 	}
 	
@@ -1866,9 +1816,9 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 
 	GL(shader->setAttributeArray(shaderVars->vertex, (const GLfloat*)projectedVertexArr.constData(), 3));
 	GL(shader->enableAttributeArray(shaderVars->vertex));
-	GL(shader->setAttributeArray(shaderVars->unprojectedVertex, (const GLfloat*)model.vertexArr.constData(), 3));
+	GL(shader->setAttributeArray(shaderVars->unprojectedVertex, (const GLfloat*)scaledVertexArr.constData(), 3));
 	GL(shader->enableAttributeArray(shaderVars->unprojectedVertex));
-	GL(shader->setAttributeArray(shaderVars->texCoord, (const GLfloat*)model.texCoordArr.constData(), 2));
+	GL(shader->setAttributeArray(shaderVars->texCoord, (const GLfloat*)model->texCoordArr.constData(), 2));
 	GL(shader->enableAttributeArray(shaderVars->texCoord));
 
 	if (rings)
@@ -1879,7 +1829,7 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 	}
 	
 	if (!drawOnlyRing)
-		GL(glDrawElements(GL_TRIANGLES, model.indiceArr.size(), GL_UNSIGNED_SHORT, model.indiceArr.constData()));
+		GL(glDrawElements(GL_TRIANGLES, model->indiceArr.size(), GL_UNSIGNED_SHORT, model->indiceArr.constData()));
 
 	if (rings)
 	{
@@ -1890,8 +1840,7 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glEnable(GL_BLEND);
 	
-		Ring3DModel ringModel;
-		sRing(&ringModel, rings->radiusMin, rings->radiusMax, 128, 32);
+		const PlanetMeshCache::Mesh* ringModel = meshCache.ring(128, rings->radiusMin/rings->radiusMax);
 		
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.isRing, true));
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.texture, 2));
@@ -1906,21 +1855,19 @@ void Planet::drawSphere(StelPainter* painter, float screenSz, bool drawOnlyRing)
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.shadowCount, 1));
 		GL(ringPlanetShaderProgram->setUniformValue(ringPlanetShaderVars.shadowData, shadowCandidatesData));
 		
-		projectedVertexArr.resize(ringModel.vertexArr.size());
-		for (int i=0;i<ringModel.vertexArr.size()/3;++i)
-			painter->getProjector()->project(*((Vec3f*)(ringModel.vertexArr.constData()+i*3)), *((Vec3f*)(projectedVertexArr.data()+i*3)));
+		projectMesh(ringModel, rings->radiusMax, painter->getProjector());
 		
 		GL(ringPlanetShaderProgram->setAttributeArray(ringPlanetShaderVars.vertex, (const GLfloat*)projectedVertexArr.constData(), 3));
 		GL(ringPlanetShaderProgram->enableAttributeArray(ringPlanetShaderVars.vertex));
-		GL(ringPlanetShaderProgram->setAttributeArray(ringPlanetShaderVars.unprojectedVertex, (const GLfloat*)ringModel.vertexArr.constData(), 3));
+		GL(ringPlanetShaderProgram->setAttributeArray(ringPlanetShaderVars.unprojectedVertex, (const GLfloat*)scaledVertexArr.constData(), 3));
 		GL(ringPlanetShaderProgram->enableAttributeArray(ringPlanetShaderVars.unprojectedVertex));
-		GL(ringPlanetShaderProgram->setAttributeArray(ringPlanetShaderVars.texCoord, (const GLfloat*)ringModel.texCoordArr.constData(), 2));
+		GL(ringPlanetShaderProgram->setAttributeArray(ringPlanetShaderVars.texCoord, (const GLfloat*)ringModel->texCoordArr.constData(), 2));
 		GL(ringPlanetShaderProgram->enableAttributeArray(ringPlanetShaderVars.texCoord));
 		
 		if (eyePos[2]<0)
 			glCullFace(GL_FRONT);
 					
-		GL(glDrawElements(GL_TRIANGLES, ringModel.indiceArr.size(), GL_UNSIGNED_SHORT, ringModel.indiceArr.constData()));
+		GL(glDrawElements(GL_TRIANGLES, ringModel->indiceArr.size(), GL_UNSIGNED_SHORT, ringModel->indiceArr.constData()));
 		
 		if (eyePos[2]<0)
 			glCullFace(GL_BACK);
@@ -1986,18 +1933,31 @@ void Planet::drawOrbit(const StelCore* core)
 	glEnable(GL_BLEND);
 
 	sPainter.setColor(orbitColor[0], orbitColor[1], orbitColor[2], orbitFader.getInterstate());
+	// Heliocentric positions of the samples around the current position of the parent,
+	// with the current Planet position inserted at its date, so that it is drawn on its orbit.
+	const QVector<OrbitSample>& points = orbitSamples.points;
+	QVarLengthArray<Vec3d, 1024> orbit;
+	bool planetInserted = false;
+	for (int i=0; i<points.size(); ++i)
+	{
+		if (!planetInserted && points.at(i).jde >= lastJDE)
+		{
+			orbit.append(getHeliocentricEclipticPos());
+			planetInserted = true;
+			if (points.at(i).jde == lastJDE)
+				continue;
+		}
+		orbit.append(getHeliocentricPos(points.at(i).pos));
+	}
+	if (closeOrbit && !orbit.isEmpty())
+		orbit.append(orbit.at(0));
+
 	Vec3d onscreen;
-	// special case - use current Planet position as center vertex so that draws
-	// on its orbit all the time (since segmented rather than smooth curve)
-	Vec3d savePos = orbit[ORBIT_SEGMENTS/2];
-	orbit[ORBIT_SEGMENTS/2]=getHeliocentricEclipticPos();
-	orbit[ORBIT_SEGMENTS]=orbit[0];
-	int nbIter = closeOrbit ? ORBIT_SEGMENTS : ORBIT_SEGMENTS-1;
 	QVarLengthArray<float, 1024> vertexArray;
 
 	sPainter.enableClientStates(true, false, false);
 
-	for (int n=0; n<=nbIter; ++n)
+	for (int n=0; n<orbit.size(); ++n)
 	{
 		if (prj->project(orbit[n],onscreen) && (vertexArray.size()==0 || !prj->intersectViewportDiscontinuity(orbit[n-1], orbit[n])))
 		{
@@ -2011,7 +1971,6 @@ void Planet::drawOrbit(const StelCore* core)
 			vertexArray.clear();
 		}
 	}
-	orbit[ORBIT_SEGMENTS/2]=savePos;
 	if (!vertexArray.isEmpty())
 	{
 		sPainter.setVertexPointer(2, GL_FLOAT, vertexArray.constData());
@@ -26,23 +26,23 @@
 #include "StelFader.hpp"
 #include "StelTextureTypes.hpp"
 #include "StelProjectorType.hpp"
+#include "OrbitSampler.hpp"
 
 #include <QString>
-
-// The callback type for the external position computation function
-// The last variable is the userData pointer.
-typedef void (*posFuncType)(double, double*, void*);
-
-typedef void (OsculatingFunctType)(double jde0,double jde,double xyz[3]);
+#include <QVector>
+#include <QFuture>
 
 // epoch J2000: 12 UT on 1 Jan 2000
 #define J2000 2451545.0
+// The orbit line is sampled again when the date changes by 1/ORBIT_SEGMENTS of the period
 #define ORBIT_SEGMENTS 360
 
 class StelFont;
 class StelPainter;
 class StelTranslator;
 class QOpenGLShaderProgram;
+class PlanetMeshCache;
+struct EphemContext;
 
 // Class used to store rotational elements, i.e. axis orientation for the planetary body.
 class RotationElements
@@ -127,6 +127,8 @@ public:
 	//! Initializes static vars. Must be called before creating first planet.
 	// Currently ensured by SolarSystem::init()
 	static void init();
+	//! The meshes shared by the spheres and rings of all the bodies, with their counters.
+	static const PlanetMeshCache& getMeshCache();
 
 	///////////////////////////////////////////////////////////////////////////
 	// Methods inherited from StelObject
@@ -166,6 +168,21 @@ public:
 	// Draw the Planet
 	// GZ Made that virtual to allow comets having their own draw().
 	virtual void draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont);
+	//! Draw a minor planet as a point source when this is all draw() would draw, i.e. when it is
+	//! smaller than a pixel and has neither label nor orbit line.
+	//! Must be called between StelSkyDrawer::preDrawPointSource() and postDrawPointSource().
+	//! @param sPainter the painter given to preDrawPointSource(), in the J2000 frame
+	//! @param selected whether the body is selected
+	//! @return false if draw() must be called instead
+	bool drawAsPointSource(StelCore* core, StelPainter* sPainter, float maxMagLabels, bool selected);
+	//! Whether draw() draws nothing for this body, because it is hidden or fainter than the magnitude limits.
+	//! @param mag the visual magnitude, from getVMagnitude()
+	bool isDrawSkipped(const StelCore* core, float mag) const;
+
+	//! Set whether the position of the body is left uncomputed because it is too faint to be drawn
+	//! (see SolarSystem::computePositions()).
+	void setCulled(bool b) {culled = b;}
+	bool isCulled() const {return culled;}
 
 	///////////////////////////////////////////////////////////////////////////
 	// Methods specific to Planet
@@ -192,6 +209,22 @@ public:
 	const QString getApparentMagnitudeAlgorithmString() const { return vMagAlgorithmMap.value(vMagAlgorithm); }
 	void setApparentMagnitudeAlgorithm(QString algorithm);
 
+	//! The positions and settings the magnitude of a body depends on, so that it can be computed
+	//! for other dates and observers than the ones of StelCore (see SolarSystemEphemeris).
+	struct MagnitudeContext
+	{
+		Vec3d observerHelioPos;	//!< Heliocentric ecliptic position of the observer
+		Vec3d planetHelioPos;	//!< Heliocentric ecliptic position of the body
+		Vec3d parentHelioPos;	//!< Heliocentric ecliptic position of the parent of the body, for the shadows on satellites
+		Vec3d earthHelioPos;	//!< Heliocentric ecliptic position of the Earth, for the rings of Saturn
+		double JDE;
+		bool fromEarth;		//!< Whether the observer is on the Earth, where the empirical formulae of the planets apply
+		ApparentMagnitudeAlgorithm algorithm;	//!< Algorithm of the planet of the observer
+		double eclipseFactor;	//!< Visible fraction of the Sun, for the magnitude of the Sun
+	};
+	//! Compute the magnitude from explicit positions. getVMagnitude() calls it with the ones of StelCore.
+	virtual float computeVMagnitude(const MagnitudeContext& context) const;
+
 	//! Compute the z rotation to use from equatorial to geographic coordinates. For general applicability we need both time flavours:
 	//! @param JD is JD(UT) for Earth
 	//! @param JDE is used for other locations
@@ -204,10 +237,21 @@ public:
 	// Compute the position in the parent Planet coordinate system
 	void computePositionWithoutOrbits(const double dateJDE);
 	void computePosition(const double dateJDE);
+	//! Set the Sun, which stays at the origin: computePosition() does not update it,
+	//! so that the bodies orbiting it can be computed concurrently.
+	static void setSun(const Planet* sun) {sunPlanet = sun;}
 
 	// Compute the transformation matrix from the local Planet coordinate to the parent Planet coordinate.
 	// This requires both flavours of JD in cases involving Earth.
 	void computeTransMatrix(double JD, double JDE);
+	//! The matrix computeTransMatrix() sets, returned without changing the body.
+	Mat4d computeRotLocalToParent(double JDE) const;
+
+	//! Compute the position in the parent Planet coordinate system without changing the body,
+	//! with the thread-safe position function set by setOrbitSamplingFunc().
+	//! @param context the EphemContext of the analytical theories, used only by the calling thread
+	//! @return false if the body has no thread-safe position function
+	bool computeEclipticPosAt(double dateJDE, double xyz[3], EphemContext* context) const;
 
 	// Get the phase angle (rad) for an observer at pos obsPos in heliocentric coordinates (in AU)
 	double getPhaseAngle(const Vec3d& obsPos) const;
@@ -277,12 +321,29 @@ public:
 	LinearFader orbitFader;
 	// draw orbital path of Planet
 	void drawOrbit(const StelCore*);
-	Vec3d orbit[ORBIT_SEGMENTS+1];   // store heliocentric coordinates for drawing the orbit
-	Vec3d orbitP[ORBIT_SEGMENTS+1];  // store local coordinate for orbit
-	double lastOrbitJDE;
+	//! Set the position function and data used to sample the orbit line in a worker thread.
+	//! They must be usable concurrently with the ones computing the position, e.g. with
+	//! a separate EphemContext. Without them, the orbit line is sampled by the thread
+	//! computing the position.
+	//! @param userDataIsContext whether userData is an EphemContext, which computeEclipticPosAt() replaces by its own
+	void setOrbitSamplingFunc(posFuncType func, void* userData, bool userDataIsContext=false);
+	//! Wait until the orbit line being sampled in a worker thread, if any, is done.
+	void waitForOrbitSampling();
+	//! Set the view for which the orbit lines are sampled.
+	//! @param observerPos the heliocentric position of the observer
+	//! @param tolerance the maximum angle between the orbit lines and the orbits [rad]
+	static void setOrbitSamplingView(const Vec3d& observerPos, double tolerance);
+	OrbitSampler::Samples orbitSamples;      // the orbit line drawn by drawOrbit()
+	QFuture<OrbitSampler::Samples> orbitSamplingJob; // the next orbit line, sampled in a worker thread
+	bool orbitSamplingPending;       // whether orbitSamplingJob has not been published to orbitSamples yet
+	posFuncType orbitSamplingFunc;   // thread-safe counterparts of coordFunc and userDataPtr for the worker
+	void* orbitSamplingData;
+	bool orbitSamplingDataIsContext;
+	static Vec3d orbitSamplingObserver;
+	static double orbitSamplingTolerance;
+	static const Planet* sunPlanet;
 	double deltaJDE;                 // time difference between positional updates.
-	double deltaOrbitJDE;
-	bool orbitCached;                // whether orbit calculations are cached for drawing orbit yet
+	double deltaOrbitJDE;            // time difference between orbit line updates.
 	bool closeOrbit;                 // whether to connect the beginning of the orbit line to
 					 // the end: good for elliptical orbits, bad for parabolic
 					 // and hyperbolic orbits
@@ -300,6 +361,9 @@ protected:
 	static StelTextureSP texEarthShadow;     // for lunar eclipses
 
 	void computeModelMatrix(Mat4d &result) const;
+
+	// Update the samples of the orbit line for the date
+	void updateOrbitSamples(double dateJDE);
 	
 	// Return the information string "ready to print" :)
 	QString getSkyLabel(const StelCore* core) const;
@@ -343,7 +407,7 @@ protected:
 	double lastJDE;                  // caches JDE of last positional computation
 	// The callback for the calculation of the equatorial rect heliocentric position at time JDE.
 	posFuncType coordFunc;
-	void* userDataPtr;               // this is always used with an Orbit object.
+	void* userDataPtr;               // the Orbit object, or the EphemContext of the analytical theories.
 
 	OsculatingFunctType *const osculatingFunc;
 	QSharedPointer<Planet> parent;           // Planet parent i.e. sun for earth
@@ -352,6 +416,7 @@ protected:
 	LinearFader labelsFader;         // Store the current state of the label for this planet
 	bool flagLabels;                 // Define whether labels should be displayed
 	bool hidden;                     // useful for fake planets used as observation positions - not drawn or labeled
+	bool culled;                     // too faint to be drawn: the position is only computed on demand (see SolarSystem::computeCulledPositions())
 	bool atmosphere;                 // Does the planet have an atmosphere?
 	bool halo;                       // Does the planet have a halo?	
 	PlanetType pType;                // Type of body
@@ -0,0 +1,116 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _PLANETFAMILIES_HPP_
+#define _PLANETFAMILIES_HPP_
+
+#include "StelUtils.hpp"
+#include "VecMath.hpp"
+
+#include <QVector>
+#include <QtConcurrentMap>
+
+//! @class PlanetFamilies
+//! Groups of solar system bodies whose positions can be computed independently of each other.
+//! A family is a body orbiting the Sun (or a body without parent) followed by all its satellites,
+//! each parent before its own satellites. Apart from the Sun, which stays at the origin, the
+//! position of a body only depends on its ancestors, and the analytical theories used by the
+//! bodies of a family share the same EphemContext. The families can therefore be computed
+//! concurrently, each one by a single thread in the order of its bodies, and the results do not
+//! depend on whether the families are computed in parallel or not.
+//! @tparam Body the class of the bodies, i.e. Planet. computePositions() uses its methods
+//! computePositionWithoutOrbits(), computePosition(), getHeliocentricEclipticPos() and computeTransMatrix().
+template <class Body>
+class PlanetFamilies
+{
+public:
+	typedef QVector<Body*> Family;
+
+	PlanetFamilies() : bodyCount(0) {}
+
+	//! Remove all the families.
+	void clear() {families.clear(); bodyCount=0;}
+	//! Add a family. The parents of the family must be listed before their satellites.
+	void append(const Family& family) {families.append(family); bodyCount += family.size();}
+	//! Number of families.
+	int size() const {return families.size();}
+	//! Total number of bodies in all the families.
+	int getBodyCount() const {return bodyCount;}
+	const Family& at(int i) const {return families.at(i);}
+
+	//! Call @em func on each family. The call returns once all the families have been processed.
+	//! @param func a functor called as func(const Family&). When @em parallel is true it is
+	//! called concurrently from the threads of the global thread pool, so it must only
+	//! modify the bodies of the family it is given.
+	//! @param parallel when false, the families are processed in order by the calling thread.
+	template <class Func>
+	void forEach(Func func, bool parallel)
+	{
+		if (parallel && families.size()>1)
+			QtConcurrent::blockingMap(families, func);
+		else
+		{
+			for (int i=0;i<families.size();++i)
+				func(families.at(i));
+		}
+	}
+
+	//! Compute the positions and then the transformation matrices of the bodies of a family, in order.
+	//! This is how SolarSystem computes each family.
+	//! @param dateJDE, dateJD the date, TT and UT
+	//! @param observerPos the heliocentric ecliptic position of the observer
+	//! @param lightTravelTime whether the bodies are computed at the date their light left them
+	static void computePositions(const Family& family, double dateJDE, double dateJD, const Vec3d& observerPos, bool lightTravelTime)
+	{
+		if (lightTravelTime)
+		{
+			foreach (Body* b, family)
+			{
+				b->computePositionWithoutOrbits(dateJDE);
+			}
+			foreach (Body* b, family)
+			{
+				const double light_speed_correction = (b->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+				b->computePosition(dateJDE-light_speed_correction);
+			}
+			foreach (Body* b, family)
+			{
+				const double light_speed_correction = (b->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+				b->computeTransMatrix(dateJD-light_speed_correction, dateJDE-light_speed_correction);
+			}
+		}
+		else
+		{
+			foreach (Body* b, family)
+			{
+				b->computePosition(dateJDE);
+			}
+			foreach (Body* b, family)
+			{
+				b->computeTransMatrix(dateJD, dateJDE);
+			}
+		}
+	}
+
+private:
+	QVector<Family> families;
+	int bodyCount;
+};
+
+#endif // _PLANETFAMILIES_HPP_
@@ -0,0 +1,156 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "PlanetMeshCache.hpp"
+#include "StelUtils.hpp"
+
+#include <QtGlobal>
+
+namespace
+{
+	// Shapes are rounded to this, far below a pixel for the largest disks on screen
+	const float ShapeBucket = 1e-4f;
+}
+
+PlanetMeshCache::PlanetMeshCache(int maxBytes)
+	: cache(maxBytes)
+	, hits(0)
+	, misses(0)
+{
+}
+
+const PlanetMeshCache::Mesh* PlanetMeshCache::sphere(int facets, float oneMinusOblateness)
+{
+	return find(facets, oneMinusOblateness, false);
+}
+
+const PlanetMeshCache::Mesh* PlanetMeshCache::ring(int slices, float innerToOuterRadius)
+{
+	return find(slices, innerToOuterRadius, true);
+}
+
+const PlanetMeshCache::Mesh* PlanetMeshCache::find(int facets, float shape, bool isRing)
+{
+	const quint32 bucket = (quint32)qRound(qBound(0.f, shape, 1.f)/ShapeBucket);
+	const quint64 key = (quint64)(quint16)facets | ((quint64)bucket<<16) | ((quint64)isRing<<48);
+	Mesh* mesh = cache.object(key);
+	if (mesh)
+	{
+		++hits;
+		return mesh;
+	}
+	++misses;
+	mesh = new Mesh;
+	if (isRing)
+		buildRing(mesh, bucket*ShapeBucket, facets, qMax(1, facets/4));
+	else
+		buildSphere(mesh, bucket*ShapeBucket, facets, facets);
+	const int cost = mesh->vertexArr.size()*sizeof(float) + mesh->texCoordArr.size()*sizeof(float)
+			 + mesh->indiceArr.size()*sizeof(unsigned short);
+	// A mesh bigger than the budget is kept alone, instead of being deleted by insert()
+	cache.insert(key, mesh, qMin(cost, cache.maxCost()));
+	return mesh;
+}
+
+void PlanetMeshCache::buildSphere(Mesh* mesh, const float oneMinusOblateness, const int slices, const int stacks)
+{
+	mesh->vertexArr.reserve(stacks*(slices+1)*6);
+	mesh->texCoordArr.reserve(stacks*(slices+1)*4);
+	mesh->indiceArr.reserve(stacks*slices*6);
+
+	float x, y, z;
+	float s=0.f, t=1.f;
+	int i, j;
+
+	const float* cos_sin_rho = StelUtils::ComputeCosSinRho(stacks);
+	const float* cos_sin_theta =  StelUtils::ComputeCosSinTheta(slices);
+
+	const float* cos_sin_rho_p;
+	const float *cos_sin_theta_p;
+
+	// texturing: s goes from 0.0/0.25/0.5/0.75/1.0 at +y/+x/-y/-x/+y axis
+	// t goes from -1.0/+1.0 at z = -radius/+radius (linear along longitudes)
+	// cannot use triangle fan on texturing (s coord. at top/bottom tip varies)
+	const float ds = 1.f / slices;
+	const float dt = 1.f / stacks;
+
+	// draw intermediate  as quad strips
+	for (i = 0,cos_sin_rho_p = cos_sin_rho; i < stacks; ++i,cos_sin_rho_p+=2)
+	{
+		s = 0.f;
+		for (j = 0,cos_sin_theta_p = cos_sin_theta; j<=slices;++j,cos_sin_theta_p+=2)
+		{
+			x = -cos_sin_theta_p[1] * cos_sin_rho_p[1];
+			y = cos_sin_theta_p[0] * cos_sin_rho_p[1];
+			z = cos_sin_rho_p[0];
+			mesh->texCoordArr << s << t;
+			mesh->vertexArr << x << y << z * oneMinusOblateness;
+			x = -cos_sin_theta_p[1] * cos_sin_rho_p[3];
+			y = cos_sin_theta_p[0] * cos_sin_rho_p[3];
+			z = cos_sin_rho_p[2];
+			mesh->texCoordArr << s << t - dt;
+			mesh->vertexArr << x << y << z * oneMinusOblateness;
+			s += ds;
+		}
+		unsigned int offset = i*(slices+1)*2;
+		for (j = 2;j<slices*2+2;j+=2)
+		{
+			mesh->indiceArr << offset+j-2 << offset+j-1 << offset+j;
+			mesh->indiceArr << offset+j << offset+j-1 << offset+j+1;
+		}
+		t -= dt;
+	}
+}
+
+void PlanetMeshCache::buildRing(Mesh* mesh, const float rMin, int slices, const int stacks)
+{
+	const float rMax = 1.f;
+	mesh->vertexArr.reserve((stacks+1)*(slices+1)*3);
+	mesh->texCoordArr.reserve((stacks+1)*(slices+1)*2);
+	mesh->indiceArr.reserve(stacks*slices*6);
+
+	float x,y;
+
+	const float dr = (rMax-rMin) / stacks;
+	const float* cos_sin_theta = StelUtils::ComputeCosSinTheta(slices);
+	const float* cos_sin_theta_p;
+
+	float r = rMin;
+	for (int i=0; i<=stacks; ++i)
+	{
+		const float tex_r0 = (r-rMin)/(rMax-rMin);
+		int j;
+		for (j=0,cos_sin_theta_p=cos_sin_theta; j<=slices; ++j,cos_sin_theta_p+=2)
+		{
+			x = r*cos_sin_theta_p[0];
+			y = r*cos_sin_theta_p[1];
+			mesh->texCoordArr << tex_r0 << 0.5f;
+			mesh->vertexArr << x << y << 0.f;
+		}
+		r+=dr;
+	}
+	for (int i=0; i<stacks; ++i)
+	{
+		for (int j=0; j<slices; ++j)
+		{
+			mesh->indiceArr << i*slices+j << (i+1)*slices+j << i*slices+j+1;
+			mesh->indiceArr << i*slices+j+1 << (i+1)*slices+j << (i+1)*slices+j+1;
+		}
+	}
+}
@@ -0,0 +1,74 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _PLANETMESHCACHE_HPP_
+#define _PLANETMESHCACHE_HPP_
+
+#include <QCache>
+#include <QVector>
+
+//! @class PlanetMeshCache
+//! Meshes of spheroids and rings of radius 1, shared by all the planets and moons so that they are
+//! not generated again at each frame. A mesh is identified by its number of facets, the ratio
+//! of its polar to its equatorial radius (the inner to the outer radius for rings) rounded to
+//! 1e-4, and whether it is a ring. The least recently used meshes are dropped beyond a memory budget.
+//! Planet scales the meshes by the radius of the body when projecting them.
+class PlanetMeshCache
+{
+public:
+	//! Vertices, texture coordinates and triangles of a mesh.
+	struct Mesh
+	{
+		QVector<float> vertexArr;
+		QVector<float> texCoordArr;
+		QVector<unsigned short> indiceArr;
+	};
+
+	//! @param maxBytes the memory budget of the meshes
+	explicit PlanetMeshCache(int maxBytes=8*1024*1024);
+
+	//! Spheroid of equatorial radius 1, with as many slices as stacks.
+	//! The returned mesh is valid until the next call.
+	const Mesh* sphere(int facets, float oneMinusOblateness);
+	//! Ring of outer radius 1, with 4 times fewer stacks than slices.
+	//! The returned mesh is valid until the next call.
+	const Mesh* ring(int slices, float innerToOuterRadius);
+
+	//! Remove all the meshes. The counters are kept.
+	void clear() {cache.clear();}
+	//! Number of meshes found in the cache.
+	qint64 getHits() const {return hits;}
+	//! Number of meshes generated.
+	qint64 getMisses() const {return misses;}
+	//! Number of bytes used by the meshes.
+	int memoryUsage() const {return cache.totalCost();}
+
+private:
+	Q_DISABLE_COPY(PlanetMeshCache)
+
+	const Mesh* find(int facets, float shape, bool isRing);
+	static void buildSphere(Mesh* mesh, float oneMinusOblateness, int slices, int stacks);
+	static void buildRing(Mesh* mesh, float rMin, int slices, int stacks);
+
+	QCache<quint64, Mesh> cache;
+	qint64 hits;
+	qint64 misses;
+};
+
+#endif // _PLANETMESHCACHE_HPP_
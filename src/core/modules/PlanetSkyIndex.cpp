@@ -0,0 +1,124 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "PlanetSkyIndex.hpp"
+
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+	// Cells of 1 degree: DecBands bands of RaCells cells
+	const int DecBands = 180;
+	const int RaCells = 360;
+	const double CellSize = M_PI/DecBands;
+}
+
+void PlanetSkyIndex::clear()
+{
+	entries.clear();
+	cellStart.clear();
+	maxSize = 0.f;
+}
+
+void PlanetSkyIndex::insert(const Vec3d& direction, float size, int id)
+{
+	Entry entry;
+	entry.direction = direction;
+	entry.size = size;
+	entry.id = id;
+	entries.append(entry);
+	maxSize = qMax(maxSize, size);
+}
+
+int PlanetSkyIndex::cellOf(const Vec3d& direction)
+{
+	const double dec = std::asin(qBound(-1., direction[2], 1.));
+	const double ra = std::atan2(direction[1], direction[0]);
+	const int band = qBound(0, (int)((dec+M_PI/2)/CellSize), DecBands-1);
+	const int cell = qBound(0, (int)((ra+M_PI)/CellSize), RaCells-1);
+	return band*RaCells + cell;
+}
+
+void PlanetSkyIndex::build()
+{
+	// Counting sort of the bodies by cell
+	QVector<int> cells(entries.size());
+	cellStart.fill(0, DecBands*RaCells+1);
+	for (int i=0;i<entries.size();++i)
+	{
+		cells[i] = cellOf(entries.at(i).direction);
+		++cellStart[cells.at(i)+1];
+	}
+	for (int c=0;c<DecBands*RaCells;++c)
+		cellStart[c+1] += cellStart.at(c);
+	QVector<int> next = cellStart;
+	QVector<Entry> sorted(entries.size());
+	for (int i=0;i<entries.size();++i)
+		sorted[next[cells.at(i)]++] = entries.at(i);
+	entries = sorted;
+}
+
+void PlanetSkyIndex::findAround(const Vec3d& direction, double radius, QVector<Entry>& result) const
+{
+	if (entries.isEmpty())
+		return;
+	Q_ASSERT(cellStart.size()==DecBands*RaCells+1);
+
+	const double cosRadius = std::cos(radius);
+	const double dec = std::asin(qBound(-1., direction[2], 1.));
+	const double ra = std::atan2(direction[1], direction[0]);
+	// A small margin keeps the bodies on the limit of the cells
+	const double margin = radius+1e-9;
+	const int bandMin = qMax(0, (int)std::floor((dec-margin+M_PI/2)/CellSize));
+	const int bandMax = qMin(DecBands-1, (int)std::floor((dec+margin+M_PI/2)/CellSize));
+
+	// Range of right ascensions of the cap: all of them when it contains a pole
+	int cellMin = 0;
+	int cellMax = RaCells-1;
+	if (dec+margin<M_PI/2 && dec-margin>-M_PI/2)
+	{
+		const double halfWidth = std::asin(qMin(1., std::sin(margin)/std::cos(dec)));
+		const int first = (int)std::floor((ra-halfWidth+M_PI)/CellSize);
+		const int last = (int)std::floor((ra+halfWidth+M_PI)/CellSize);
+		if (last-first<RaCells-1)
+		{
+			cellMin = first;
+			cellMax = last;
+		}
+	}
+
+	for (int band=bandMin;band<=bandMax;++band)
+	{
+		for (int c=cellMin;c<=cellMax;++c)
+		{
+			// The range may go past 0h or 24h
+			const int cell = band*RaCells + (c+RaCells)%RaCells;
+			for (int i=cellStart.at(cell);i<cellStart.at(cell+1);++i)
+			{
+				const Entry& entry = entries.at(i);
+				if (entry.direction*direction>=cosRadius)
+					result.append(entry);
+			}
+		}
+	}
+}
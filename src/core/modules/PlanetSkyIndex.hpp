@@ -0,0 +1,73 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _PLANETSKYINDEX_HPP_
+#define _PLANETSKYINDEX_HPP_
+
+#include "VecMath.hpp"
+
+#include <QVector>
+
+//! @class PlanetSkyIndex
+//! Directions of solar system bodies on the sky, grouped in cells of 1 degree in declination
+//! and right ascension so that the bodies around a direction are found without looking at
+//! all of them. SolarSystem fills it once per computation of the positions, when first needed.
+class PlanetSkyIndex
+{
+public:
+	//! A body of the index.
+	struct Entry
+	{
+		Vec3d direction;	//!< Unit vector of the direction of the body
+		float size;		//!< Angular size of the body, in degrees
+		int id;			//!< Number of the body given to insert()
+	};
+
+	PlanetSkyIndex() : maxSize(0.f) {}
+
+	//! Remove all the bodies.
+	void clear();
+	//! Add a body. build() must then be called before findAround().
+	//! @param direction the direction of the body, normalized
+	void insert(const Vec3d& direction, float size, int id);
+	//! Sort the bodies by cell.
+	void build();
+
+	//! Append to result the bodies whose direction is within radius of direction.
+	//! @param direction normalized direction
+	//! @param radius in radians
+	void findAround(const Vec3d& direction, double radius, QVector<Entry>& result) const;
+
+	//! Number of bodies.
+	int size() const {return entries.size();}
+	//! Largest angular size of the bodies, in degrees.
+	float getMaxSize() const {return maxSize;}
+
+private:
+	//! Cell of a direction.
+	static int cellOf(const Vec3d& direction);
+
+	//! The bodies, sorted by cell by build().
+	QVector<Entry> entries;
+	//! Index in entries of the first body of each cell, and the number of bodies at the end.
+	QVector<int> cellStart;
+	float maxSize;
+};
+
+#endif // _PLANETSKYINDEX_HPP_
@@ -33,7 +33,7 @@
 #include "StelSkyCultureMgr.hpp"
 #include "StelFileMgr.hpp"
 #include "StelModuleMgr.hpp"
-#include "StelIniParser.hpp"
+#include "StelCompiledIni.hpp"
 #include "Planet.hpp"
 #include "MinorPlanet.hpp"
 #include "Comet.hpp"
@@ -59,6 +59,9 @@
 #include <QMapIterator>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QCryptographicHash>
 
 SolarSystem::SolarSystem()
 	: shadowPlanetCount(0)
@@ -67,6 +70,7 @@ SolarSystem::SolarSystem()
 	, labelsAmount(false)
 	, flagOrbits(false)
 	, flagLightTravelTime(true)
+	, flagParallelPositions(true)
 	, flagShow(false)
 	, flagPointer(false)
 	, flagNativeNames(false)
@@ -77,6 +81,12 @@ SolarSystem::SolarSystem()
 	, ephemerisDatesDisplayed(false)
 	, allTrails(NULL)
 	, conf(StelApp::getInstance().getSettings())
+	, cullingObserverDistance(-1.)
+	, lastDateJDE(0.)
+	, lastDateJD(0.)
+	, lastObserverPos(0.)
+	, culledPositionsDirty(true)
+	, skyIndexDirty(true)
 {
 	planetNameFont.setPixelSize(StelApp::getInstance().getBaseFontSize());
 	setObjectName("SolarSystem");
@@ -92,11 +102,20 @@ SolarSystem::~SolarSystem()
 {
 	// release selected:
 	selected.clear();
+	foreach (const PlanetP& p, systemPlanets)
+		p->waitForOrbitSampling();
 	foreach (Orbit* orb, orbits)
 	{
 		delete orb;
 		orb = NULL;
 	}
+	qDeleteAll(ephemContexts);
+	ephemContexts.clear();
+	qDeleteAll(orbitSamplingContexts);
+	orbitSamplingContexts.clear();
+	keplerBatch.clear();
+	cullableBodies.clear();
+	planetFamilies.clear();
 	sun.clear();
 	moon.clear();
 	earth.clear();
@@ -154,6 +173,7 @@ void SolarSystem::init()
 	setLabelsAmount(conf->value("astro/labels_amount", 3.).toFloat());
 	setFlagOrbits(conf->value("astro/flag_planets_orbits").toBool());
 	setFlagLightTravelTime(conf->value("astro/flag_light_travel_time", true).toBool());
+	setFlagParallelPositions(conf->value("astro/flag_parallel_positions", true).toBool());
 	setFlagPointer(conf->value("astro/flag_planets_pointers", true).toBool());
 	// Set the algorithm from Astronomical Almanac for computation of apparent magnitudes for
 	// planets in case  observer on the Earth by default
@@ -362,6 +382,11 @@ void cometOrbitPosFunc(double jd,double xyz[3], void* userDataPtr)
 {
 	static_cast<CometOrbit*>(userDataPtr)->positionAtTimevInVSOP87Coordinates(jd, xyz);
 }
+// Does not update the velocity of the comet, so that orbit lines can be sampled in a worker thread.
+void cometOrbitSamplingFunc(double jd,double xyz[3], void* userDataPtr)
+{
+	static_cast<CometOrbit*>(userDataPtr)->positionAtTimevInVSOP87Coordinates(jd, xyz, false);
+}
 
 // Init and load the solar system data
 void SolarSystem::loadPlanets()
@@ -386,10 +411,17 @@ void SolarSystem::loadPlanets()
 
 			foreach (PlanetP p, systemPlanets)
 			{
+				p->waitForOrbitSampling();
 				p->satellites.clear();
 				p.clear();
 			}
 			systemPlanets.clear();
+			qDeleteAll(ephemContexts);
+			ephemContexts.clear();
+			qDeleteAll(orbitSamplingContexts);
+			orbitSamplingContexts.clear();
+			keplerBatch.clear();
+			cullableBodies.clear();
 			//Memory leak? What's the proper way of cleaning shared pointers?
 
 			//If the file is in the user data directory, rename it:
@@ -412,16 +444,66 @@ void SolarSystem::loadPlanets()
 	foreach (const PlanetP& planet, systemPlanets)
 		if(planet->parent != sun || !planet->satellites.isEmpty())
 			shadowPlanetCount++;
+
+	buildPlanetFamilies();
+
+	// Minor planets with satellites are computed with them
+	for (int i=cullableBodies.size()-1; i>=0; --i)
+	{
+		if (!cullableBodies.at(i).planet->satellites.isEmpty())
+			cullableBodies.remove(i);
+	}
+	cullingObserverDistance = -1.;
+	skyIndexDirty = true;
+}
+
+void SolarSystem::appendToFamily(const PlanetP& p, PlanetFamilies<Planet>::Family& family)
+{
+	family.append(p.data());
+	foreach (const PlanetP& satellite, p->satellites)
+		appendToFamily(satellite, family);
+}
+
+void SolarSystem::buildPlanetFamilies()
+{
+	planetFamilies.clear();
+	foreach (const PlanetP& p, systemPlanets)
+	{
+		if (!p->parent.isNull())
+			continue;
+		if (p==sun)
+		{
+			// The Sun is computed alone before the families, see computePositions()
+			foreach (const PlanetP& satellite, p->satellites)
+			{
+				PlanetFamilies<Planet>::Family family;
+				appendToFamily(satellite, family);
+				planetFamilies.append(family);
+			}
+		}
+		else
+		{
+			PlanetFamilies<Planet>::Family family;
+			appendToFamily(p, family);
+			planetFamilies.append(family);
+		}
+	}
+	Planet::setSun(sun.data());
 }
 
 bool SolarSystem::loadPlanets(const QString& filePath)
 {
-	QSettings pd(filePath, StelIniFormat);
+	// The parsed file is cached in a binary file per source file, used while the source file is unchanged
+	const QString cachePath = QString("%1/ssystem/%2.bin").arg(StelFileMgr::getCacheDir())
+				  .arg(QString(QCryptographicHash::hash(QFileInfo(filePath).absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex()));
+	StelCompiledIni pd(filePath, cachePath);
 	if (pd.status() != QSettings::NoError)
 	{
 		qWarning() << "ERROR while parsing" << QDir::toNativeSeparators(filePath);
 		return false;
 	}
+	if (pd.isLoadedFromCache())
+		qDebug() << "Solar System data read from" << QDir::toNativeSeparators(cachePath);
 
 	// QSettings does not allow us to say that the sections of the file
 	// will be listed in the same order  as in the file like the old
@@ -529,8 +611,16 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		const QString funcName = pd.value(secname+"/coord_func").toString();
 		posFuncType posfunc=NULL;
 		void* userDataPtr=NULL;
+		// Position function and data for sampling the orbit line in a worker thread
+		posFuncType orbitSamplingFunc=NULL;
+		void* orbitSamplingData=NULL;
+		bool orbitSamplingDataIsContext=false;
 		OsculatingFunctType *osculatingFunc = 0;
 		bool closeOrbit = pd.value(secname+"/closeOrbit", true).toBool();
+		// Distances of elliptical orbits around the Sun, for the culling of faint minor planets
+		double perihelion = 0.;
+		double aphelion = 0.;
+		int batchIndex = -1;
 
 		if (funcName=="ell_orbit")
 		{
@@ -634,6 +724,13 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 
 			userDataPtr = orb;
 			posfunc = &ellipticalOrbitPosFunc;
+			orbitSamplingFunc = &ellipticalOrbitPosFunc;
+			orbitSamplingData = orb;
+			if (eccentricity < 1.0 && !parent->getParent())
+			{
+				perihelion = pericenterDistance;
+				aphelion = pericenterDistance*(1.0+eccentricity)/(1.0-eccentricity);
+			}
 		}
 		else if (funcName=="comet_orbit")
 		{
@@ -724,21 +821,48 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 							J2000NodeOrigin.normalize();
 							parent_rot_j2000_longitude = atan2(J2000NodeOrigin*OrbitAxis1,J2000NodeOrigin*OrbitAxis0);
 						}
-			//qDebug() << "Creating CometOrbit for" << englishName;
-			CometOrbit *orb = new CometOrbit(pericenterDistance,
-							 eccentricity,
-							 inclination,
-							 ascending_node,
-							 arg_of_pericenter,
-							 time_at_pericenter,
-							 orbitGoodDays,
-							 meanMotion,
-							 parentRotObliquity,
-							 parent_rot_asc_node,
-							 parent_rot_j2000_longitude);
-			orbits.push_back(orb);
-			userDataPtr = orb;
-			posfunc = &cometOrbitPosFunc;
+			// The minor planets on elliptical orbits around the Sun are computed all at once.
+			// Comets keep their CometOrbit, which also computes the velocity needed by their tails.
+			if (eccentricity < 1.0 && !parent->getParent() && pd.value(secname+"/type").toString() != "comet")
+			{
+				KeplerBatch::Member* member = keplerBatch.addCometOrbit(pericenterDistance,
+											 eccentricity,
+											 inclination,
+											 ascending_node,
+											 arg_of_pericenter,
+											 time_at_pericenter,
+											 meanMotion,
+											 parentRotObliquity,
+											 parent_rot_asc_node,
+											 parent_rot_j2000_longitude);
+				userDataPtr = member;
+				posfunc = &KeplerBatch::posFunc;
+				orbitSamplingFunc = &KeplerBatch::samplingPosFunc;
+				orbitSamplingData = member;
+				perihelion = pericenterDistance;
+				aphelion = pericenterDistance*(1.0+eccentricity)/(1.0-eccentricity);
+				batchIndex = member->index;
+			}
+			else
+			{
+				//qDebug() << "Creating CometOrbit for" << englishName;
+				CometOrbit *orb = new CometOrbit(pericenterDistance,
+								 eccentricity,
+								 inclination,
+								 ascending_node,
+								 arg_of_pericenter,
+								 time_at_pericenter,
+								 orbitGoodDays,
+								 meanMotion,
+								 parentRotObliquity,
+								 parent_rot_asc_node,
+								 parent_rot_j2000_longitude);
+				orbits.push_back(orb);
+				userDataPtr = orb;
+				posfunc = &cometOrbitPosFunc;
+				orbitSamplingFunc = &cometOrbitSamplingFunc;
+				orbitSamplingData = orb;
+			}
 		}
 
 		if (funcName=="sun_special")
@@ -854,6 +978,35 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 			exit(-1);
 		}
 
+		// The analytical theories used by a body and its satellites share one EphemContext,
+		// so that the families of bodies orbiting the Sun can be computed concurrently.
+		EphemContext* newRootContext = NULL;
+		if (!userDataPtr)
+		{
+			const Planet* root = NULL;
+			if (!parent.isNull() && !parent->parent.isNull())
+			{
+				root = parent.data();
+				while (!root->parent->parent.isNull())
+					root = root->parent.data();
+			}
+			EphemContext* ephemContext = root ? ephemContexts.value(root) : NULL;
+			if (!ephemContext)
+			{
+				ephemContext = new EphemContext;
+				if (root)
+					ephemContexts.insert(root, ephemContext);
+				else
+					newRootContext = ephemContext;
+			}
+			userDataPtr = ephemContext;
+			// Each orbit line has its own context, as the lines of a family are sampled concurrently
+			orbitSamplingFunc = posfunc;
+			orbitSamplingData = new EphemContext;
+			orbitSamplingDataIsContext = true;
+			orbitSamplingContexts.append(static_cast<EphemContext*>(orbitSamplingData));
+		}
+
 		// Create the Solar System body and add it to the list
 		QString type = pd.value(secname+"/type").toString();		
 		PlanetP p;
@@ -909,6 +1062,13 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 
 			mp->setSemiMajorAxis(pd.value(secname+"/orbit_SemiMajorAxis", 0).toDouble());
 
+			if (aphelion > 0.)
+			{
+				mp->setDistanceRange(perihelion, aphelion);
+				CullableBody body = {p, batchIndex, -99.f};
+				cullableBodies.append(body);
+			}
+
 		}
 		else if (type == "comet")
 		{
@@ -979,6 +1139,11 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 		}
 
 
+		if (newRootContext)
+			ephemContexts.insert(p.data(), newRootContext);
+		if (orbitSamplingFunc)
+			p->setOrbitSamplingFunc(orbitSamplingFunc, orbitSamplingData, orbitSamplingDataIsContext);
+
 		if (!parent.isNull())
 		{
 			parent->satellites.append(p);
@@ -1052,55 +1217,149 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 	return true;
 }
 
-// Compute the position for every elements of the solar system.
-// The order is not important since the position is computed relatively to the mother body
+struct SolarSystem::FamilyPositions
+{
+	typedef void result_type;
+	const SolarSystem* ssystem;
+	double dateJDE;
+	double dateJD;
+	Vec3d observerPos;
+	//! Compute the families of the culled bodies instead of the others
+	bool culled;
+	void operator()(const PlanetFamilies<Planet>::Family& family) const;
+};
+
+// Compute the position and transformation matrix for every elements of the solar system.
+// The Sun is computed first. The other bodies are grouped in families which only depend on
+// the Sun and on themselves (see PlanetFamilies), so that they can be computed in parallel
+// with the same results as when computed one after the other.
 void SolarSystem::computePositions(double dateJDE, const Vec3d& observerPos)
 {
-	if (flagLightTravelTime)
+	StelCore* core = StelApp::getInstance().getCore();
+	const double dateJD=dateJDE - (core->computeDeltaT(dateJDE))/86400.0;
+
+	// Orbit lines deviate from the orbits by less than half a pixel at the center of the view
+	Planet::setOrbitSamplingView(observerPos, 0.5/core->getProjection(StelCore::FrameJ2000)->getPixelPerRadAtCenter());
+
+	lastDateJDE = dateJDE;
+	lastDateJD = dateJD;
+	lastObserverPos = observerPos;
+	skyIndexDirty = true;
+	culledPositionsDirty = true;
+	updateCulling(observerPos);
+
+	if (sun)
 	{
-		foreach (PlanetP p, systemPlanets)
-		{
-			p->computePositionWithoutOrbits(dateJDE);
-		}
-		foreach (PlanetP p, systemPlanets)
-		{
-			const double light_speed_correction = (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
-			p->computePosition(dateJDE-light_speed_correction);
-		}
+		PlanetFamilies<Planet>::Family sunFamily;
+		sunFamily.append(sun.data());
+		computeFamilyPositions(sunFamily, dateJDE, dateJD, observerPos);
 	}
-	else
+
+	// The minor planets of keplerBatch are computed all at once. With the light time correction,
+	// they are computed again at the dates computeFamilyPositions() then uses, found the same way.
+	if (keplerBatch.size())
 	{
-		foreach (PlanetP p, systemPlanets)
+		keplerBatch.compute(dateJDE);
+		if (flagLightTravelTime)
 		{
-			p->computePosition(dateJDE);
+			QVector<double> dates(keplerBatch.size());
+			for (int i=0;i<dates.size();++i)
+			{
+				if (keplerBatch.isSkipped(i))
+					continue;
+				const double* pos = keplerBatch.getPosition(i);
+				const double light_speed_correction = (Vec3d(pos[0], pos[1], pos[2])-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+				dates[i] = dateJDE-light_speed_correction;
+			}
+			keplerBatch.compute(dates.constData());
 		}
 	}
-	computeTransMatrices(dateJDE, observerPos);
+
+	FamilyPositions func = {this, dateJDE, dateJD, observerPos, false};
+	planetFamilies.forEach(func, flagParallelPositions);
+}
+
+void SolarSystem::FamilyPositions::operator()(const PlanetFamilies<Planet>::Family& family) const
+{
+	// Culled minor planets have no satellites: they are alone in their family
+	if (family.first()->isCulled()!=culled)
+		return;
+	ssystem->computeFamilyPositions(family, dateJDE, dateJD, observerPos);
 }
 
-// Compute the transformation matrix for every elements of the solar system.
-// The elements have to be ordered hierarchically, eg. it's important to compute earth before moon.
-void SolarSystem::computeTransMatrices(double dateJDE, const Vec3d& observerPos)
+// The culled bodies are computed at the date of the last computePositions(), without keplerBatch:
+// it skips them, so that KeplerBatch::posFunc() computes them one by one.
+void SolarSystem::computeCulledPositions()
 {
-	double dateJD=dateJDE - (StelApp::getInstance().getCore()->computeDeltaT(dateJDE))/86400.0;
+	Q_ASSERT(QThread::currentThread()==thread());
+	if (!culledPositionsDirty)
+		return;
+	culledPositionsDirty = false;
+	if (cullableBodies.isEmpty())
+		return;
+	FamilyPositions func = {this, lastDateJDE, lastDateJD, lastObserverPos, true};
+	planetFamilies.forEach(func, flagParallelPositions);
+}
+
+// The brightest magnitude a minor planet can have on its orbit is enough to know that it is too faint to be drawn
+// by Planet::draw() in the next frames: its position is then not computed, unless it is selected or observed from.
+void SolarSystem::updateCulling(const Vec3d& observerPos)
+{
+	if (cullableBodies.isEmpty())
+		return;
+	StelCore* core = StelApp::getInstance().getCore();
 
-	if (flagLightTravelTime)
+	// The brightest magnitudes hold while the observer stays within this distance of the one they are computed for
+	static const double CullingDistanceMargin = 0.02;	// AU
+	const double observerDistance = observerPos.length();
+	if (std::fabs(observerDistance-cullingObserverDistance)>CullingDistanceMargin)
 	{
-		foreach (PlanetP p, systemPlanets)
+		cullingObserverDistance = observerDistance;
+		for (int i=0; i<cullableBodies.size(); ++i)
 		{
-			const double light_speed_correction = (p->getHeliocentricEclipticPos()-observerPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
-			p->computeTransMatrix(dateJD-light_speed_correction, dateJDE-light_speed_correction);
+			CullableBody& body = cullableBodies[i];
+			body.brightestMagnitude = static_cast<const MinorPlanet*>(body.planet.data())->getBrightestVMagnitude(observerDistance, CullingDistanceMargin);
 		}
 	}
-	else
+
+	QVector<const StelObject*> exempt;
+	exempt << core->getCurrentPlanet().data();
+	foreach (const StelObjectP& obj, GETSTELMODULE(StelObjectMgr)->getSelectedObject("Planet"))
+		exempt << obj.data();
+
+	for (int i=0; i<cullableBodies.size(); ++i)
 	{
-		foreach (PlanetP p, systemPlanets)
+		const CullableBody& body = cullableBodies.at(i);
+		Planet* p = body.planet.data();
+		// Not drawn by Planet::draw() even at its brightest
+		const bool culled = p->isDrawSkipped(core, body.brightestMagnitude) && !exempt.contains(p);
+		if (culled!=p->isCulled())
 		{
-			p->computeTransMatrix(dateJD, dateJDE);
+			p->setCulled(culled);
+			if (body.batchIndex>=0)
+				keplerBatch.setSkipped(body.batchIndex, culled);
 		}
 	}
 }
 
+void SolarSystem::computeCulledPosition(const PlanetP& p) const
+{
+	// The positions of the bodies only change in the main thread
+	Q_ASSERT(QThread::currentThread()==thread());
+	if (!culledPositionsDirty)
+		return;
+	PlanetFamilies<Planet>::Family family;
+	family.append(p.data());
+	computeFamilyPositions(family, lastDateJDE, lastDateJD, lastObserverPos);
+}
+
+// Compute the positions and then the transformation matrices of the bodies of a family.
+// The bodies are ordered hierarchically, eg. it's important to compute earth before moon.
+void SolarSystem::computeFamilyPositions(const PlanetFamilies<Planet>::Family& family, double dateJDE, double dateJD, const Vec3d& observerPos) const
+{
+	PlanetFamilies<Planet>::computePositions(family, dateJDE, dateJD, observerPos, flagLightTravelTime);
+}
+
 // And sort them from the furthest to the closest to the observer
 struct biggerDistance : public std::binary_function<PlanetP, PlanetP, bool>
 {
@@ -1117,16 +1376,33 @@ void SolarSystem::draw(StelCore* core)
 	if (!flagShow)
 		return;
 
-	// Compute each Planet distance to the observer
-	Vec3d obsHelioPos = core->getObserverHeliocentricEclipticPos();
+	// Make some voodoo to determine when labels should be displayed
+	float maxMagLabel = (core->getSkyDrawer()->getLimitMagnitude()<5.f ? core->getSkyDrawer()->getLimitMagnitude() :
+			5.f+(core->getSkyDrawer()->getLimitMagnitude()-5.f)*1.2f) +(labelsAmount-3.f)*1.2f;
 
-	foreach (PlanetP p, systemPlanets)
+	// Compute each Planet distance to the observer. The small minor planets are drawn
+	// together as point sources, the other bodies are kept to be drawn one by one.
+	Vec3d obsHelioPos = core->getObserverHeliocentricEclipticPos();
+	QVector<const StelObject*> selectedPlanets;
+	foreach (const StelObjectP& obj, GETSTELMODULE(StelObjectMgr)->getSelectedObject("Planet"))
+		selectedPlanets << obj.data();
+	QList<PlanetP> drawnPlanets;
 	{
-		p->computeDistance(obsHelioPos);
+		StelPainter sPainter(core->getProjection(StelCore::FrameJ2000));
+		core->getSkyDrawer()->preDrawPointSource(&sPainter);
+		foreach (const PlanetP& p, systemPlanets)
+		{
+			if (p->isCulled())
+				continue;
+			p->computeDistance(obsHelioPos);
+			if (!p->drawAsPointSource(core, &sPainter, maxMagLabel, selectedPlanets.contains(p.data())))
+				drawnPlanets.append(p);
+		}
+		core->getSkyDrawer()->postDrawPointSource(&sPainter);
 	}
 
 	// And sort them from the furthest to the closest
-	sort(systemPlanets.begin(),systemPlanets.end(),biggerDistance());
+	sort(drawnPlanets.begin(),drawnPlanets.end(),biggerDistance());
 
 	if (trailFader.getInterstate()>0.0000001f)
 	{
@@ -1136,12 +1412,8 @@ void SolarSystem::draw(StelCore* core)
 		delete sPainter;
 	}
 
-	// Make some voodoo to determine when labels should be displayed
-	float maxMagLabel = (core->getSkyDrawer()->getLimitMagnitude()<5.f ? core->getSkyDrawer()->getLimitMagnitude() :
-			5.f+(core->getSkyDrawer()->getLimitMagnitude()-5.f)*1.2f) +(labelsAmount-3.f)*1.2f;
-
 	// Draw the elements
-	foreach (const PlanetP& p, systemPlanets)
+	foreach (const PlanetP& p, drawnPlanets)
 	{
 		p->draw(core, maxMagLabel, planetNameFont);
 	}
@@ -1198,7 +1470,11 @@ PlanetP SolarSystem::searchByEnglishName(QString planetEnglishName) const
 	foreach (const PlanetP& p, systemPlanets)
 	{
 		if (p->getEnglishName() == planetEnglishName)
+		{
+			if (p->isCulled())
+				computeCulledPosition(p);
 			return p;
+		}
 	}
 	return PlanetP();
 }
@@ -1208,7 +1484,11 @@ StelObjectP SolarSystem::searchByNameI18n(const QString& planetNameI18) const
 	foreach (const PlanetP& p, systemPlanets)
 	{
 		if (p->getNameI18n() == planetNameI18)
+		{
+			if (p->isCulled())
+				computeCulledPosition(p);
 			return qSharedPointerCast<StelObject>(p);
+		}
 	}
 	return StelObjectP();
 }
@@ -1219,7 +1499,11 @@ StelObjectP SolarSystem::searchByName(const QString& name) const
 	foreach (const PlanetP& p, systemPlanets)
 	{
 		if (p->getEnglishName() == name)
+		{
+			if (p->isCulled())
+				computeCulledPosition(p);
 			return qSharedPointerCast<StelObject>(p);
+		}
 	}
 	return StelObjectP();
 }
@@ -1279,16 +1563,17 @@ StelObjectP SolarSystem::search(Vec3d pos, const StelCore* core) const
 	pos.normalize();
 	PlanetP closest;
 	double cos_angle_closest = 0.;
-	Vec3d equPos;
 
-	foreach (const PlanetP& p, systemPlanets)
+	if (skyIndexDirty)
+		buildSkyIndex(core);
+	QVector<PlanetSkyIndex::Entry> around;
+	skyIndex.findAround(pos, std::acos(0.999), around);
+	foreach (const PlanetSkyIndex::Entry& entry, around)
 	{
-		equPos = p->getEquinoxEquatorialPos(core);
-		equPos.normalize();
-		double cos_ang_dist = equPos*pos;
+		double cos_ang_dist = entry.direction*pos;
 		if (cos_ang_dist>cos_angle_closest)
 		{
-			closest = p;
+			closest = systemPlanets.at(entry.id);
 			cos_angle_closest = cos_ang_dist;
 		}
 	}
@@ -1310,24 +1595,43 @@ QList<StelObjectP> SolarSystem::searchAround(const Vec3d& vv, double limitFov, c
 	Vec3d v = core->j2000ToEquinoxEqu(vv);
 	v.normalize();
 	double cosLimFov = std::cos(limitFov * M_PI/180.);
-	Vec3d equPos;
 	double cosAngularSize;
 
-	foreach (const PlanetP& p, systemPlanets)
+	// Only the bodies closer than the limit or than their angular size can match
+	if (skyIndexDirty)
+		buildSkyIndex(core);
+	QVector<PlanetSkyIndex::Entry> around;
+	skyIndex.findAround(v, qMax(limitFov, (double)skyIndex.getMaxSize()) * M_PI/180., around);
+	foreach (const PlanetSkyIndex::Entry& entry, around)
 	{
-		equPos = p->getEquinoxEquatorialPos(core);
-		equPos.normalize();
+		cosAngularSize = std::cos(entry.size * M_PI/180.);
 
-		cosAngularSize = std::cos(p->getSpheroidAngularSize(core) * M_PI/180.);
-
-		if (equPos*v>=std::min(cosLimFov, cosAngularSize))
+		if (entry.direction*v>=std::min(cosLimFov, cosAngularSize))
 		{
-			result.append(qSharedPointerCast<StelObject>(p));
+			result.append(qSharedPointerCast<StelObject>(systemPlanets.at(entry.id)));
 		}
 	}
 	return result;
 }
 
+// The directions are the ones search() and searchAround() used to compute for each body.
+// The bodies which are culled are left out: they are too faint to be drawn.
+void SolarSystem::buildSkyIndex(const StelCore* core) const
+{
+	skyIndex.clear();
+	for (int i=0; i<systemPlanets.size(); ++i)
+	{
+		const PlanetP& p = systemPlanets.at(i);
+		if (p->isCulled())
+			continue;
+		Vec3d equPos = p->getEquinoxEquatorialPos(core);
+		equPos.normalize();
+		skyIndex.insert(equPos, p->getSpheroidAngularSize(core), i);
+	}
+	skyIndex.build();
+	skyIndexDirty = false;
+}
+
 // Update i18 names from english names according to current sky culture translator
 void SolarSystem::updateI18n()
 {
@@ -1739,12 +2043,21 @@ void SolarSystem::reloadPlanets()
 	}
 	// Unload all Solar System objects
 	selected.clear();//Release the selected one
+	foreach (const PlanetP& p, systemPlanets)
+		p->waitForOrbitSampling();
 	foreach (Orbit* orb, orbits)
 	{
 		delete orb;
 		orb = NULL;
 	}
 	orbits.clear();
+	qDeleteAll(ephemContexts);
+	ephemContexts.clear();
+	qDeleteAll(orbitSamplingContexts);
+	orbitSamplingContexts.clear();
+	keplerBatch.clear();
+	cullableBodies.clear();
+	planetFamilies.clear();
 
 	sun.clear();
 	moon.clear();
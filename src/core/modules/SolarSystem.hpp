@@ -28,11 +28,15 @@
 #include "StelObjectModule.hpp"
 #include "StelTextureTypes.hpp"
 #include "Planet.hpp"
+#include "PlanetFamilies.hpp"
+#include "KeplerBatch.hpp"
+#include "PlanetSkyIndex.hpp"
 #include "StelGui.hpp"
 
 #include <QFont>
 
 class Orbit;
+struct EphemContext;
 class StelTranslator;
 class StelObject;
 class StelCore;
@@ -239,6 +243,13 @@ public slots:
 	//! Get the current value of the flag which determines if planet pointers are drawn or hidden.
 	bool getFlagPointer() const { return flagPointer;}
 
+	//! Set flag which determines if the positions of the bodies are computed
+	//! on several threads. The results are the same in both cases.
+	void setFlagParallelPositions(bool b) {flagParallelPositions=b;}
+	//! Get the current value of the flag which determines if the positions of
+	//! the bodies are computed on several threads.
+	bool getFlagParallelPositions() const {return flagParallelPositions;}
+
 	//! Set flag which determines if the light travel time calculation is used or not.
 	void setFlagLightTravelTime(bool b);
 	//! Get the current value of the flag which determines if light travel time
@@ -457,9 +468,16 @@ public:
 	//! Compute the position and transform matrix for every element of the solar system.
 	//! @param observerPos Position of the observer in heliocentric ecliptic frame (Required for light travel time computation).
 	//! @param dateJDE the Julian Day in JDE (Ephemeris Time or equivalent)	
+	//! The minor planets too faint to be drawn are left out (see Planet::isCulled()).
 	void computePositions(double dateJDE, const Vec3d& observerPos = Vec3d(0.));
 
+	//! Compute the positions of the bodies left out by the last computePositions() because they are too faint
+	//! to be drawn, e.g. before listing the positions of all the bodies. Nothing is done when they are current.
+	//! As computePositions(), it must be called from the main thread.
+	void computeCulledPositions();
+
 	//! Get the list of all the bodies of the solar system.	
+	//! The positions of the culled bodies are only current after computeCulledPositions().
 	const QList<PlanetP>& getAllPlanets() const {return systemPlanets;}	
 
 private slots:
@@ -485,9 +503,24 @@ private:
 	//! @return a pointer to a StelObject if found, else NULL
 	StelObjectP search(Vec3d v, const StelCore* core) const;
 
-	//! Compute the transformation matrix for every elements of the solar system.
+	//! Functor calling computeFamilyPositions() from PlanetFamilies::forEach().
+	struct FamilyPositions;
+	//! Compute the positions and the transformation matrices of the bodies of a family.
 	//! observerPos is needed for light travel time computation.
-	void computeTransMatrices(double dateJDE, const Vec3d& observerPos = Vec3d(0.));
+	void computeFamilyPositions(const PlanetFamilies<Planet>::Family& family, double dateJDE, double dateJD, const Vec3d& observerPos) const;
+
+	//! Set which minor planets are too faint to be drawn, and are therefore not computed by computePositions().
+	void updateCulling(const Vec3d& observerPos);
+	//! Compute the position of a body left uncomputed by the culling, e.g. when it is found by its name.
+	//! Must be called from the main thread, as the searches which call it.
+	void computeCulledPosition(const PlanetP& p) const;
+	//! Fill skyIndex with the bodies which are computed.
+	void buildSkyIndex(const StelCore* core) const;
+
+	//! Group the loaded bodies in families for computePositions().
+	void buildPlanetFamilies();
+	//! Append a body and all its satellites to a family, each parent before its satellites.
+	static void appendToFamily(const PlanetP& p, PlanetFamilies<Planet>::Family& family);
 
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(const StelCore* core);
@@ -534,9 +567,13 @@ private:
 	//! List of all the bodies of the solar system.
 	QList<PlanetP> systemPlanets;
 
+	//! The bodies of systemPlanets other than the Sun, grouped for computePositions().
+	PlanetFamilies<Planet> planetFamilies;
+
 	// Master settings
 	bool flagOrbits;
 	bool flagLightTravelTime;
+	bool flagParallelPositions;
 
 	//! The selection pointer texture.
 	StelTextureSP texPointer;
@@ -561,6 +598,34 @@ private:
 	QHash<QString, QString> planetNativeNamesMap;
 
 	QList<Orbit*> orbits;           // Pointers on created elliptical orbits
+	//! Interpolation caches of the analytical theories of each family, by family root.
+	QHash<const Planet*, EphemContext*> ephemContexts;
+	//! Contexts of the analytical theories used to sample the orbit lines in worker threads.
+	QList<EphemContext*> orbitSamplingContexts;
+	//! Orbits of the minor planets on elliptical orbits around the Sun.
+	KeplerBatch keplerBatch;
+
+	//! A minor planet which is not computed while it is too faint to be drawn.
+	struct CullableBody
+	{
+		PlanetP planet;
+		int batchIndex;			//!< Index in keplerBatch, or -1
+		float brightestMagnitude;	//!< MinorPlanet::getBrightestVMagnitude() for cullingObserverDistance
+	};
+	QVector<CullableBody> cullableBodies;
+	//! Heliocentric distance of the observer for which the brightest magnitudes were computed.
+	double cullingObserverDistance;
+
+	//! Dates and observer position of the last computePositions().
+	double lastDateJDE;
+	double lastDateJD;
+	Vec3d lastObserverPos;
+	//! Whether the culled bodies are not computed for the last computePositions().
+	bool culledPositionsDirty;
+
+	//! Directions of the bodies for search() and searchAround(), filled when first needed after computePositions().
+	mutable PlanetSkyIndex skyIndex;
+	mutable bool skyIndexDirty;
 };
 
 
@@ -0,0 +1,262 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SolarSystemEphemeris.hpp"
+#include "SolarSystem.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelObserver.hpp"
+#include "StelUtils.hpp"
+#include "EphemWrapper.hpp"
+#include "MinimumSearch.hpp"
+
+#include <QScopedPointer>
+
+#include <cmath>
+
+SolarSystemEphemeris::SolarSystemEphemeris(const StelCore* core, const StelLocation& location)
+	: core(core)
+	, location(location)
+	, distanceFromCenter(0.)
+	, topocentric(core->getUseTopocentricCoordinates())
+	, lightTravelTime(GETSTELMODULE(SolarSystem)->getFlagLightTravelTime())
+	, magnitudeAlgorithm(Planet::UndefinedAlgorithm)
+{
+	StelObserver observer(location);
+	observerPlanet = observer.getHomePlanet();
+	if (observerPlanet->getEnglishName()!=location.planetName)
+	{
+		observerPlanet.clear();
+		return;
+	}
+	distanceFromCenter = observer.getDistanceFromCenter();
+	magnitudeAlgorithm = observerPlanet->getApparentMagnitudeAlgorithm();
+	earth = GETSTELMODULE(SolarSystem)->getEarth();
+}
+
+bool SolarSystemEphemeris::computeHeliocentricEclipticPos(const Planet* body, double JDE, Vec3d& pos, EphemContext* context)
+{
+	// As Planet::getHeliocentricPos(): the Sun stays at the origin
+	pos.set(0., 0., 0.);
+	for (const Planet* p=body; p && p->getParent(); p=p->getParent().data())
+	{
+		double xyz[3];
+		if (!p->computeEclipticPosAt(JDE, xyz, context))
+			return false;
+		pos += Vec3d(xyz[0], xyz[1], xyz[2]);
+	}
+	return true;
+}
+
+// As StelCore::updateTransformMatrices() and StelObserver
+bool SolarSystemEphemeris::computeObserver(double JD, double JDE, Observer& observer, EphemContext* context) const
+{
+	if (!computeHeliocentricEclipticPos(observerPlanet.data(), JDE, observer.heliocentricEclipticPos, context))
+		return false;
+
+	Mat4d equToVsop87 = observerPlanet->computeRotLocalToParent(JDE);
+	for (const Planet* p=observerPlanet->getParent().data(); p && p->getParent(); p=p->getParent().data())
+		equToVsop87 = p->computeRotLocalToParent(JDE) * equToVsop87;
+	observer.vsop87ToEquinoxEqu = equToVsop87.transpose();
+
+	const double lat = qBound(-90., (double)location.latitude, 90.);
+	const Mat4d altAzToEqu = Mat4d::zrotation((observerPlanet->getSiderealTime(JD, JDE)+location.longitude)*M_PI/180.)
+				 * Mat4d::yrotation((90.-lat)*M_PI/180.);
+	observer.equinoxEquToAltAz = altAzToEqu.transpose();
+
+	if (topocentric)
+		observer.heliocentricEclipticPos += equToVsop87.multiplyWithoutTranslation(altAzToEqu.multiplyWithoutTranslation(Vec3d(0., 0., distanceFromCenter)));
+	return true;
+}
+
+bool SolarSystemEphemeris::compute(const PlanetP& body, double JD, Position& position, EphemContext* context) const
+{
+	if (!isValid() || !body)
+		return false;
+	QScopedPointer<EphemContext> temporaryContext;
+	if (!context)
+	{
+		temporaryContext.reset(new EphemContext);
+		context = temporaryContext.data();
+	}
+
+	position.JD = JD;
+	position.JDE = JD + core->computeDeltaT(JD)/86400.;
+	Observer observer;
+	if (!computeObserver(JD, position.JDE, observer, context))
+		return false;
+	return computeBody(body, observer, position, context);
+}
+
+bool SolarSystemEphemeris::computeBody(const PlanetP& body, const Observer& observer, Position& position, EphemContext* context, bool withMagnitude) const
+{
+	// As SolarSystem::computeFamilyPositions()
+	double bodyJDE = position.JDE;
+	Vec3d& pos = position.heliocentricEclipticPos;
+	if (!computeHeliocentricEclipticPos(body.data(), bodyJDE, pos, context))
+		return false;
+	if (lightTravelTime)
+	{
+		bodyJDE -= (pos-observer.heliocentricEclipticPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+		computeHeliocentricEclipticPos(body.data(), bodyJDE, pos, context);
+	}
+
+	const Vec3d relativePos = pos-observer.heliocentricEclipticPos;
+	position.distance = relativePos.length();
+	position.j2000EquatorialPos = StelCore::matVsop87ToJ2000.multiplyWithoutTranslation(relativePos);
+	position.equinoxEquatorialPos = observer.vsop87ToEquinoxEqu.multiplyWithoutTranslation(relativePos);
+	position.altAzPos = observer.equinoxEquToAltAz.multiplyWithoutTranslation(position.equinoxEquatorialPos);
+	position.vMagnitude = 0.f;
+	if (!withMagnitude)
+		return true;
+
+	Planet::MagnitudeContext magnitude;
+	magnitude.observerHelioPos = observer.heliocentricEclipticPos;
+	magnitude.planetHelioPos = pos;
+	magnitude.parentHelioPos.set(0., 0., 0.);
+	if (body->getParent())
+		computeHeliocentricEclipticPos(body->getParent().data(), bodyJDE, magnitude.parentHelioPos, context);
+	magnitude.earthHelioPos.set(0., 0., 0.);
+	if (earth && body->getEnglishName()=="Saturn")
+		computeHeliocentricEclipticPos(earth.data(), position.JDE, magnitude.earthHelioPos, context);
+	magnitude.JDE = position.JDE;
+	magnitude.fromEarth = location.planetName=="Earth";
+	magnitude.algorithm = magnitudeAlgorithm;
+	magnitude.eclipseFactor = 1.;
+	position.vMagnitude = body->computeVMagnitude(magnitude);
+	return true;
+}
+
+bool SolarSystemEphemeris::compute(const PlanetP& body, const QVector<double>& JDs, QVector<Position>& positions) const
+{
+	EphemContext context;
+	positions.resize(JDs.size());
+	for (int i=0; i<JDs.size(); ++i)
+	{
+		if (!compute(body, JDs.at(i), positions[i], &context))
+		{
+			positions.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SolarSystemEphemeris::computeDirection(const Vec3d& j2000EquatorialPos, double JD, Position& position, EphemContext* context) const
+{
+	if (!isValid())
+		return false;
+	QScopedPointer<EphemContext> temporaryContext;
+	if (!context)
+	{
+		temporaryContext.reset(new EphemContext);
+		context = temporaryContext.data();
+	}
+
+	position.JD = JD;
+	position.JDE = JD + core->computeDeltaT(JD)/86400.;
+	Observer observer;
+	if (!computeObserver(JD, position.JDE, observer, context))
+		return false;
+	Vec3d dir = j2000EquatorialPos;
+	dir.normalize();
+	position.heliocentricEclipticPos.set(0., 0., 0.);
+	position.j2000EquatorialPos = dir;
+	position.equinoxEquatorialPos = observer.vsop87ToEquinoxEqu.multiplyWithoutTranslation(StelCore::matJ2000ToVsop87.multiplyWithoutTranslation(dir));
+	position.altAzPos = observer.equinoxEquToAltAz.multiplyWithoutTranslation(position.equinoxEquatorialPos);
+	position.distance = 0.;
+	position.vMagnitude = 0.f;
+	return true;
+}
+
+struct SolarSystemEphemeris::Separation
+{
+	typedef double result_type;
+
+	Separation(const SolarSystemEphemeris* ephemeris, const PlanetP& body1, const PlanetP& body2, const Vec3d& fixedPos, bool opposition)
+		: ephemeris(ephemeris), body1(body1), body2(body2), fixedPos(fixedPos), opposition(opposition), context(new EphemContext) {}
+	//! Each copy has its own caches, as it is used by its own thread
+	Separation(const Separation& other)
+		: ephemeris(other.ephemeris), body1(other.body1), body2(other.body2), fixedPos(other.fixedPos), opposition(other.opposition),
+		  context(new EphemContext) {}
+
+	//! The separation at a date, or 2 pi when a body cannot be computed, so that no minimum is found
+	double operator()(double JD) const
+	{
+		Position pos1, pos2;
+		pos1.JD = pos2.JD = JD;
+		pos1.JDE = pos2.JDE = JD + ephemeris->core->computeDeltaT(JD)/86400.;
+		Observer observer;
+		if (!ephemeris->computeObserver(JD, pos1.JDE, observer, context.data()) || !ephemeris->computeBody(body1, observer, pos1, context.data(), false))
+			return 2.*M_PI;
+		Vec3d otherPos = fixedPos;
+		if (body2)
+		{
+			if (!ephemeris->computeBody(body2, observer, pos2, context.data(), false))
+				return 2.*M_PI;
+			otherPos = pos2.j2000EquatorialPos;
+		}
+		const double angle = pos1.j2000EquatorialPos.angle(otherPos);
+		return opposition ? M_PI-angle : angle;
+	}
+
+	const SolarSystemEphemeris* ephemeris;
+	PlanetP body1;
+	PlanetP body2;
+	Vec3d fixedPos;
+	bool opposition;
+	QScopedPointer<EphemContext> context;
+
+private:
+	Separation& operator=(const Separation&);
+};
+
+double SolarSystemEphemeris::getScanStep(const Planet* body)
+{
+	// Small enough to separate the minima due to the motions of the body and of the observer,
+	// e.g. the loops of the planets when the Earth passes them
+	const QString& name = body->getEnglishName();
+	if (body->getParent() && body->getParent()->getParent())
+		return 0.25;	// The Moon and the other satellites
+	if (name=="Mercury" || name=="Venus" || name=="Mars")
+		return 1.;
+	if (name=="Jupiter" || name=="Saturn" || name=="Uranus" || name=="Neptune" || name=="Pluto")
+		return 2.;
+	return 1.;	// The Sun, and the minor bodies which may pass close to the observer
+}
+
+QMap<double, double> SolarSystemEphemeris::findClosestApproaches(const PlanetP& body1, const PlanetP& body2, double startJD, double stopJD,
+								 double maxSeparation, bool opposition) const
+{
+	if (!isValid() || !body1 || !body2)
+		return QMap<double, double>();
+	const double step = qMin(getScanStep(body1.data()), getScanStep(body2.data()));
+	const Separation separation(this, body1, body2, Vec3d(0.), opposition);
+	return MinimumSearch::findMinima(separation, startJD, stopJD, step, maxSeparation, StelCore::JD_SECOND);
+}
+
+QMap<double, double> SolarSystemEphemeris::findClosestApproaches(const PlanetP& body, const Vec3d& j2000EquatorialPos, double startJD, double stopJD,
+								 double maxSeparation) const
+{
+	if (!isValid() || !body)
+		return QMap<double, double>();
+	const Separation separation(this, body, PlanetP(), j2000EquatorialPos, false);
+	return MinimumSearch::findMinima(separation, startJD, stopJD, getScanStep(body.data()), maxSeparation, StelCore::JD_SECOND);
+}
@@ -0,0 +1,132 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _SOLARSYSTEMEPHEMERIS_HPP_
+#define _SOLARSYSTEMEPHEMERIS_HPP_
+
+#include "Planet.hpp"
+#include "StelLocation.hpp"
+#include "VecMath.hpp"
+
+#include <QMap>
+#include <QVector>
+
+class StelCore;
+struct EphemContext;
+
+//! @class SolarSystemEphemeris
+//! Positions and magnitudes of the bodies of the solar system, seen from a location at any list of dates,
+//! computed without changing StelCore nor the bodies. Setting the date of StelCore and updating it
+//! instead recomputes the whole scene for each date, and changes the date the user sees.
+//! The positions are computed by the thread-safe position functions of the bodies
+//! (see Planet::computeEclipticPosAt()), so that compute() may be called from any thread,
+//! e.g. by QtConcurrent workers, scripts, or the RemoteControl server.
+//!
+//! The observer, its precession and rotation are computed for each date as StelCore does.
+//! The settings of StelCore and SolarSystem (topocentric coordinates, light travel time, nutation,
+//! DeltaT) are the ones current when the ephemeris is created.
+//! Refraction, extinction and the eclipses of the Sun are not taken into account.
+//! An ephemeris must be created in the main thread, and not be used after the planets are reloaded:
+//! a thread which cannot ensure it must compute the positions in the main thread.
+class SolarSystemEphemeris
+{
+public:
+	//! The position of a body at a date.
+	struct Position
+	{
+		double JD;			//!< Date, UT
+		double JDE;			//!< Date, TT
+		Vec3d heliocentricEclipticPos;	//!< Heliocentric ecliptic J2000 (VSOP87) position, at the date the light left the body
+		Vec3d j2000EquatorialPos;	//!< Equatorial J2000 position relative to the observer, in AU
+		Vec3d equinoxEquatorialPos;	//!< Equatorial position of date relative to the observer, in AU
+		Vec3d altAzPos;			//!< Geometric horizontal position relative to the observer, in AU
+		double distance;		//!< Distance to the observer, in AU
+		float vMagnitude;		//!< Magnitude, without extinction
+	};
+
+	//! Create the ephemeris for an observer at a location, with the settings of core.
+	SolarSystemEphemeris(const StelCore* core, const StelLocation& location);
+
+	//! Whether the planet of the location exists and can be computed.
+	bool isValid() const {return !observerPlanet.isNull();}
+	const StelLocation& getLocation() const {return location;}
+
+	//! Compute the position of a body at a date.
+	//! @param context the caches of the analytical theories, used only by the calling thread.
+	//! Giving the same context to successive calls saves time for close dates. When NULL, a temporary one is used.
+	//! @return false if the body or the observer cannot be computed
+	bool compute(const PlanetP& body, double JD, Position& position, EphemContext* context=NULL) const;
+	//! Compute the positions of a body at a list of dates.
+	//! @return false if the body or the observer cannot be computed
+	bool compute(const PlanetP& body, const QVector<double>& JDs, QVector<Position>& positions) const;
+	//! Compute a fixed direction seen by the observer at a date, e.g. the one of a star or of a deep-sky object.
+	//! The positions are unit vectors, the distance is 0 and the magnitude is not set.
+	//! @param j2000EquatorialPos the direction, in the equatorial J2000 frame
+	//! @return false if the observer cannot be computed
+	bool computeDirection(const Vec3d& j2000EquatorialPos, double JD, Position& position, EphemContext* context=NULL) const;
+
+	//! Find the closest approaches of two bodies, i.e. the dates where their angular separation has a minimum.
+	//! The range is scanned at the step of the fastest body (see getScanStep()) by the threads of the global
+	//! thread pool, and each minimum is refined to about a second by Brent's method (see MinimumSearch).
+	//! @param startJD, stopJD the range of dates (JD, UT)
+	//! @param maxSeparation the closest approaches with a larger separation are discarded, in radians
+	//! @param opposition when true, find the dates where the separation is closest to 180 degrees instead
+	//! @return the dates (JD, UT) with the separation, or 180 degrees minus the separation for an opposition, in radians
+	QMap<double, double> findClosestApproaches(const PlanetP& body1, const PlanetP& body2, double startJD, double stopJD,
+						   double maxSeparation, bool opposition=false) const;
+	//! Find the closest approaches of a body to a fixed direction, e.g. to a deep-sky object.
+	//! @param j2000EquatorialPos the direction, in the equatorial J2000 frame
+	//! @see findClosestApproaches(const PlanetP&, const PlanetP&, double, double, double, bool) const
+	QMap<double, double> findClosestApproaches(const PlanetP& body, const Vec3d& j2000EquatorialPos, double startJD, double stopJD,
+						   double maxSeparation) const;
+	//! Interval between the dates scanned for the closest approaches of a body, in days.
+	static double getScanStep(const Planet* body);
+
+	//! Heliocentric ecliptic J2000 position of a body at a date, without correction for light time.
+	//! @return false if the body has no thread-safe position function
+	static bool computeHeliocentricEclipticPos(const Planet* body, double JDE, Vec3d& pos, EphemContext* context);
+
+private:
+	//! The observer at a date.
+	struct Observer
+	{
+		Vec3d heliocentricEclipticPos;
+		//! From VSOP87 to the equatorial frame of date of the planet of the observer
+		Mat4d vsop87ToEquinoxEqu;
+		Mat4d equinoxEquToAltAz;
+	};
+	bool computeObserver(double JD, double JDE, Observer& observer, EphemContext* context) const;
+	//! Compute a body seen by an observer computed for the same date.
+	//! @param withMagnitude when false, the magnitude is not computed, which saves the position of the parent
+	bool computeBody(const PlanetP& body, const Observer& observer, Position& position, EphemContext* context, bool withMagnitude=true) const;
+
+	//! The angular separation of two bodies, or of a body and a fixed direction, as a function of the date
+	struct Separation;
+
+	const StelCore* core;
+	StelLocation location;
+	PlanetP observerPlanet;
+	PlanetP earth;
+	double distanceFromCenter;
+	bool topocentric;
+	bool lightTravelTime;
+	Planet::ApparentMagnitudeAlgorithm magnitudeAlgorithm;
+};
+
+#endif // _SOLARSYSTEMEPHEMERIS_HPP_
@@ -0,0 +1,204 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarDesignationIndex.hpp"
+
+#include <QtGlobal>
+#include <algorithm>
+
+namespace
+{
+	bool numberLess(const QPair<qint32, qint32>& a, const QPair<qint32, qint32>& b)
+	{
+		return a.first < b.first;
+	}
+
+	//! Sort by number and keep the last inserted HIP number of each number.
+	void buildNumbers(QVector<QPair<qint32, qint32> >& numbers)
+	{
+		std::stable_sort(numbers.begin(), numbers.end(), numberLess);
+		int n = 0;
+		for (int i=0;i<numbers.size();++i)
+		{
+			if (n>0 && numbers.at(n-1).first==numbers.at(i).first)
+				numbers[n-1] = numbers.at(i);
+			else
+				numbers[n++] = numbers.at(i);
+		}
+		numbers.resize(n);
+		numbers.squeeze();
+	}
+}
+
+void StarDesignationIndex::clear(Catalog catalog)
+{
+	int n = 0;
+	for (int i=0;i<entries.size();++i)
+	{
+		if (entries.at(i).catalog!=catalog)
+			entries[n++] = entries.at(i);
+	}
+	entries.resize(n);
+	if (entries.isEmpty())
+		arena.clear();
+	// The arena is compacted by build()
+	dirty = true;
+}
+
+void StarDesignationIndex::clear(NumberedCatalog catalog)
+{
+	numbers[catalog].clear();
+}
+
+void StarDesignationIndex::insert(Catalog catalog, const QString& designation, int hip)
+{
+	const QString key = normalize(designation);
+	Entry e;
+	e.offset = arena.size();
+	e.length = qMin(key.size(), 0xffff);
+	e.catalog = catalog;
+	e.hip = hip;
+	arena.append(key.constData(), e.length);
+	entries.append(e);
+	dirty = true;
+}
+
+void StarDesignationIndex::insert(NumberedCatalog catalog, int number, int hip)
+{
+	QVector<NumberEntry>& n = numbers[catalog];
+	// Keep the array sorted when inserting in order, as when reading the cross-identification file
+	if (!n.isEmpty() && n.last().first>=number)
+		dirty = true;
+	n.append(NumberEntry(number, hip));
+}
+
+bool StarDesignationIndex::isLess(const Entry& a, const Entry& b) const
+{
+	const int c = QStringRef::compare(QStringRef(&arena, a.offset, a.length), QStringRef(&arena, b.offset, b.length));
+	return c<0 || (c==0 && a.catalog<b.catalog);
+}
+
+void StarDesignationIndex::build()
+{
+	if (!dirty)
+		return;
+
+	// Sort by designation then catalog. The sort is stable so that the last
+	// insertion of a designation in a catalog comes last among its duplicates.
+	struct Less
+	{
+		const StarDesignationIndex* index;
+		bool operator()(const Entry& a, const Entry& b) const {return index->isLess(a, b);}
+	};
+	Less less = {this};
+	std::stable_sort(entries.begin(), entries.end(), less);
+
+	// Remove the duplicates and copy the designations in order into a new arena
+	QString compacted;
+	int n = 0;
+	Entry previous;	// last kept entry, with its offset in the old arena
+	for (int i=0;i<entries.size();++i)
+	{
+		const Entry e = entries.at(i);
+		if (n>0 && !less(previous, e) && !less(e, previous))
+		{
+			entries[n-1].hip = e.hip;
+			continue;
+		}
+		Entry moved = e;
+		// Consecutive equal designations of different catalogs share their characters
+		if (n>0 && QStringRef(&arena, previous.offset, previous.length)==QStringRef(&arena, e.offset, e.length))
+			moved.offset = entries.at(n-1).offset;
+		else
+		{
+			moved.offset = compacted.size();
+			compacted.append(arena.constData()+e.offset, e.length);
+		}
+		entries[n++] = moved;
+		previous = e;
+	}
+	entries.resize(n);
+	entries.squeeze();
+	compacted.squeeze();
+	arena = compacted;
+
+	for (int c=0;c<NbNumberedCatalogs;++c)
+		buildNumbers(numbers[c]);
+	dirty = false;
+}
+
+int StarDesignationIndex::lowerBound(const QString& key) const
+{
+	Q_ASSERT(!dirty);
+	int first = 0;
+	int count = entries.size();
+	while (count>0)
+	{
+		const int step = count/2;
+		const int i = first+step;
+		if (QStringRef::compare(this->key(i), key)<0)
+		{
+			first = i+1;
+			count -= step+1;
+		}
+		else
+			count = step;
+	}
+	return first;
+}
+
+int StarDesignationIndex::find(const QString& key, unsigned int catalogs) const
+{
+	// Equal designations are sorted by catalog, i.e. by priority
+	for (int i=lowerBound(key);i<entries.size() && this->key(i)==key;++i)
+	{
+		if (catalogs & (1u<<entries.at(i).catalog))
+			return entries.at(i).hip;
+	}
+	return 0;
+}
+
+int StarDesignationIndex::find(NumberedCatalog catalog, int number) const
+{
+	Q_ASSERT(!dirty);
+	const QVector<NumberEntry>& n = numbers[catalog];
+	QVector<NumberEntry>::const_iterator it = std::lower_bound(n.constBegin(), n.constEnd(), NumberEntry(number, 0), numberLess);
+	if (it!=n.constEnd() && it->first==number)
+		return it->second;
+	return 0;
+}
+
+QVector<int> StarDesignationIndex::findPrefix(const QString& prefix, unsigned int catalogs) const
+{
+	QVector<int> result;
+	for (int i=lowerBound(prefix);i<entries.size() && key(i).startsWith(prefix);++i)
+	{
+		if (catalogs & (1u<<entries.at(i).catalog))
+			result.append(i);
+	}
+	return result;
+}
+
+qint64 StarDesignationIndex::memoryUsage() const
+{
+	qint64 size = arena.capacity()*sizeof(QChar) + entries.capacity()*sizeof(Entry);
+	for (int c=0;c<NbNumberedCatalogs;++c)
+		size += numbers[c].capacity()*sizeof(NumberEntry);
+	return size;
+}
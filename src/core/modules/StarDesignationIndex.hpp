@@ -0,0 +1,122 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STARDESIGNATIONINDEX_HPP_
+#define _STARDESIGNATIONINDEX_HPP_
+
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+#include <QPair>
+
+//! @class StarDesignationIndex
+//! Index of all the designations of the Hipparcos stars (common names, Bayer/Flamsteed
+//! names, GCVS and WDS designations, SAO and HD numbers) giving their HIP number.
+//! The normalized designations of all the catalogs are stored in a single string arena
+//! and referenced from one array sorted by designation, so that an exact or a prefix
+//! query over all the catalogs is a single binary search. Numbered catalogs are stored
+//! as sorted arrays of (number, HIP) pairs.
+//! Designations are inserted unsorted: build() must be called before querying the index.
+class StarDesignationIndex
+{
+public:
+	//! Catalogs of textual designations, in decreasing priority for exact queries.
+	enum Catalog
+	{
+		CommonName = 0,		//!< English common names of the current sky culture
+		CommonNameI18n,		//!< Translated common names of the current sky culture
+		SciName,		//!< Bayer or Flamsteed names
+		SciAdditionalName,	//!< Additional Bayer or Flamsteed names
+		GcvsName,		//!< Variable star designations
+		WdsName,		//!< Double star designations, as "WDS J..."
+		NbCatalogs
+	};
+
+	//! Catalogs of numbered designations.
+	enum NumberedCatalog
+	{
+		SaoNumber = 0,
+		HdNumber,
+		NbNumberedCatalogs
+	};
+
+	StarDesignationIndex() : dirty(false) {}
+
+	//! Normalize a designation as stored in the index, so that queries are case insensitive.
+	static QString normalize(const QString& designation) {return designation.toUpper();}
+
+	//! Remove all the designations of a catalog.
+	void clear(Catalog catalog);
+	//! Remove all the numbers of a catalog.
+	void clear(NumberedCatalog catalog);
+	//! Add a designation. If it is already in the catalog, the HIP number of the last insertion is kept.
+	void insert(Catalog catalog, const QString& designation, int hip);
+	//! Add a number. If it is already in the catalog, the HIP number of the last insertion is kept.
+	void insert(NumberedCatalog catalog, int number, int hip);
+	//! Sort the designations inserted since the last call and compact the string arena.
+	void build();
+
+	//! Find the HIP number of a designation in the first matching catalog.
+	//! @param key the normalized designation
+	//! @param catalogs the catalogs to search, as a mask of (1<<Catalog) bits
+	//! @return the HIP number, or 0 if not found
+	int find(const QString& key, unsigned int catalogs) const;
+	//! Find the HIP number of a numbered designation.
+	//! @return the HIP number, or 0 if not found
+	int find(NumberedCatalog catalog, int number) const;
+
+	//! Number of designations, all catalogs together.
+	int size() const {return entries.size();}
+	//! Position of the first designation not lesser than @em key in the sorted index.
+	int lowerBound(const QString& key) const;
+	//! Normalized designation at position @em i.
+	QStringRef key(int i) const {return QStringRef(&arena, entries.at(i).offset, entries.at(i).length);}
+	//! Catalog of the designation at position @em i.
+	Catalog catalog(int i) const {return (Catalog)entries.at(i).catalog;}
+	//! HIP number of the designation at position @em i.
+	int hip(int i) const {return entries.at(i).hip;}
+
+	//! Find all the designations starting with a prefix, in designation order.
+	//! @param prefix the normalized prefix
+	//! @param catalogs the catalogs to search, as a mask of (1<<Catalog) bits
+	//! @return the positions of the matching designations
+	QVector<int> findPrefix(const QString& prefix, unsigned int catalogs) const;
+
+	//! Number of bytes allocated by the index.
+	qint64 memoryUsage() const;
+
+private:
+	struct Entry
+	{
+		quint32 offset;
+		quint16 length;
+		quint8 catalog;
+		qint32 hip;
+	};
+	typedef QPair<qint32, qint32> NumberEntry;
+
+	bool isLess(const Entry& a, const Entry& b) const;
+
+	QString arena;
+	QVector<Entry> entries;
+	QVector<NumberEntry> numbers[NbNumberedCatalogs];
+	bool dirty;
+};
+
+#endif // _STARDESIGNATIONINDEX_HPP_
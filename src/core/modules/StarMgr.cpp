@@ -42,6 +42,7 @@
 #include "StelPainter.hpp"
 #include "StelJsonParser.hpp"
 #include "ZoneArray.hpp"
+#include "StarDesignationIndex.hpp"
 #include "StelSkyDrawer.hpp"
 #include "RefractionExtinction.hpp"
 #include "StelModuleMgr.hpp"
@@ -56,7 +57,16 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QCryptographicHash>
-
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QFuture>
+#include <QtConcurrent>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <errno.h>
 
 static QStringList spectral_array;
@@ -66,25 +76,20 @@ static QStringList component_array;
 // It can also be incremented when the defaultStarsConfig.json file change.
 // It should always matchs the version field of the defaultStarsConfig.json file
 static const int StarCatalogFormatVersion = 8;
+// Largest number of stars returned by searchAround()
+static const int MaxSearchAroundResults = 1000;
 
 // Initialise statics
 bool StarMgr::flagSciNames = true;
 QHash<int,QString> StarMgr::commonNamesMap;
 QHash<int,QString> StarMgr::commonNamesMapI18n;
-QMap<QString,int> StarMgr::commonNamesIndexI18n;
-QMap<QString,int> StarMgr::commonNamesIndex;
 QHash<int,QString> StarMgr::sciNamesMapI18n;
-QMap<QString,int> StarMgr::sciNamesIndexI18n;
 QHash<int,QString> StarMgr::sciAdditionalNamesMapI18n;
-QMap<QString,int> StarMgr::sciAdditionalNamesIndexI18n;
 QHash<int, varstar> StarMgr::varStarsMapI18n;
-QMap<QString, int> StarMgr::varStarsIndexI18n;
 QHash<int, wds> StarMgr::wdsStarsMapI18n;
-QMap<QString, int> StarMgr::wdsStarsIndexI18n;
 QHash<int, int> StarMgr::saoStarsMap;
-QMap<int, int> StarMgr::saoStarsIndex;
 QHash<int, int> StarMgr::hdStarsMap;
-QMap<int, int> StarMgr::hdStarsIndex;
+StarDesignationIndex StarMgr::designationIndex;
 
 QStringList initStringListFromFile(const QString& file_name)
 {
@@ -134,6 +139,14 @@ StarMgr::StarMgr(void)
 	: flagStarName(false)
 	, labelsAmount(0.)
 	, gravityLabel(false)
+	, flagMultithreadedDraw(false)
+	, drawThreadCount(0)
+	, drawThreadPool(NULL)
+	, flagDrawCache(true)
+	, drawCache(new StarDrawCache())
+	, backgroundLoadingLevel(-1)
+	, nbPublishedCatalogs(0)
+	, catalogLoader(NULL)
 	, hipIndex(new HipIndexStruct[NR_OF_HIP+1])
 {
 	setObjectName("StarMgr");
@@ -142,7 +155,6 @@ StarMgr::StarMgr(void)
 		qFatal("ERROR: StarMgr::StarMgr: no memory");
 	}
 	maxGeodesicGridLevel = -1;
-	lastMaxSearchLevel = -1;	
 	objectMgr = GETSTELMODULE(StelObjectMgr);
 	Q_ASSERT(objectMgr);
 }
@@ -160,6 +172,19 @@ double StarMgr::getCallOrder(StelModuleActionName actionName) const
 
 StarMgr::~StarMgr(void)
 {
+	if (catalogLoader)
+	{
+		abortCatalogLoading.store(1);
+		catalogLoader->waitForFinished();
+		delete catalogLoader;
+		catalogLoader = NULL;
+		qDeleteAll(loadedCatalogs);
+		loadedCatalogs.clear();
+	}
+	if (drawThreadPool)
+		drawThreadPool->waitForDone();
+	delete drawCache;
+	drawCache = NULL;
 	foreach(ZoneArray* z, gridLevels)
 		delete z;
 	gridLevels.clear();
@@ -388,12 +413,17 @@ void StarMgr::init()
 		}
 	}
 
+	backgroundLoadingLevel = conf->value("stars/background_loading_level",4).toInt();
+	loadChecksumCache();
 	loadData(starSettings);
 	starFont.setPixelSize(StelApp::getInstance().getBaseFontSize());
 
 	setFlagStars(conf->value("astro/flag_stars", true).toBool());
 	setFlagLabels(conf->value("astro/flag_star_name",true).toBool());
 	setLabelsAmount(conf->value("stars/labels_amount",3.f).toFloat());
+	setDrawThreadCount(conf->value("stars/draw_thread_count",0).toInt());
+	setFlagMultithreadedDraw(conf->value("stars/flag_multithreaded_draw",false).toBool());
+	setFlagDrawCache(conf->value("stars/flag_draw_cache",true).toBool());
 
 	// Load colors from config file
 	QString defaultColor = conf->value("color/default_color").toString();
@@ -405,6 +435,14 @@ void StarMgr::init()
 	StelApp::getInstance().getCore()->getGeodesicGrid(maxGeodesicGridLevel)->visitTriangles(maxGeodesicGridLevel,initTriangleFunc,this);
 	foreach(ZoneArray* z, gridLevels)
 		z->scaleAxis();
+
+	// The sky is displayed with the bright stars while the deep catalogs are loading
+	if (!backgroundCatalogs.isEmpty())
+	{
+		qDebug() << "Loading" << backgroundCatalogs.size() << "star catalogs in the background";
+		catalogLoader = new QFuture<void>(QtConcurrent::run(this, &StarMgr::loadCatalogsInBackground, backgroundCatalogs));
+	}
+
 	StelApp *app = &StelApp::getInstance();
 	connect(app, SIGNAL(languageChanged()), this, SLOT(updateI18n()));
 	connect(&app->getSkyCultureMgr(), SIGNAL(currentSkyCultureChanged(QString)), this, SLOT(updateSkyCulture(const QString&)));
@@ -438,7 +476,7 @@ void StarMgr::drawPointer(StelPainter& sPainter, const StelCore* core)
 	}
 }
 
-bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
+QString StarMgr::findCatalog(const QVariantMap& catDesc, QByteArray* pendingChecksum)
 {
 	const bool checked = catDesc.value("checked").toBool();
 	QString catalogFileName = catDesc.value("fileName").toString();
@@ -456,72 +494,253 @@ bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
 			qWarning() << QString("Warning: could not find star catalog %1").arg(QDir::toNativeSeparators(catalogFileName));
 			setCheckFlag(catDesc.value("id").toString(), false);
 		}
-		return false;
+		return QString();
 	}
 	// Possibly fixes crash on Vista
 	if (!StelFileMgr::isReadable(catalogFilePath))
 	{
 		qWarning() << QString("Warning: User does not have permissions to read catalog %1").arg(QDir::toNativeSeparators(catalogFilePath));
-		return false;
+		return QString();
 	}
 
 	if (!checked)
 	{
 		// The file is not checked but we found it, maybe from a previous download/version
-		qWarning() << "Found file " << QDir::toNativeSeparators(catalogFilePath) << ", checking md5sum..";
+		const QByteArray checksum = catDesc.value("checksum").toByteArray();
+		if (isChecksumCached(catalogFilePath, checksum))
+		{
+			qDebug() << "Found file " << QDir::toNativeSeparators(catalogFilePath) << ", MD5 sum already verified";
+			setCheckFlag(catDesc.value("id").toString(), true);
+		}
+		else if (pendingChecksum)
+		{
+			*pendingChecksum = checksum;
+		}
+		else
+		{
+			qWarning() << "Found file " << QDir::toNativeSeparators(catalogFilePath) << ", checking md5sum..";
+			if (!verifyCatalog(catalogFilePath, checksum))
+				return QString();
+			qWarning() << "MD5 sum correct!";
+			setCheckFlag(catDesc.value("id").toString(), true);
+			cacheChecksum(catalogFilePath, checksum);
+		}
+	}
+
+	return catalogFilePath;
+}
+
+namespace
+{
+	QByteArray readChunk(QFile* file, qint64 size)
+	{
+		return file->read(size);
+	}
+}
+
+bool StarMgr::verifyCatalog(const QString& catalogFilePath, const QByteArray& checksum)
+{
+	QFile fic(catalogFilePath);
+	if (!fic.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+	{
+		qWarning() << "Error: could not open" << QDir::toNativeSeparators(catalogFilePath) << "to check its MD5 sum";
+		return false;
+	}
+
+	// MD5 can't be split between threads, but reading the next chunk of the file
+	// while the current one is hashed keeps both the disk and the CPU busy.
+	static const qint64 chunkSize = 1024*1024*8;
+	QCryptographicHash md5Hash(QCryptographicHash::Md5);
+	QByteArray chunk = fic.read(chunkSize);
+	while (!chunk.isEmpty())
+	{
+		QFuture<QByteArray> nextChunk = QtConcurrent::run(readChunk, &fic, chunkSize);
+		md5Hash.addData(chunk);
+		chunk = nextChunk.result();
+	}
+	fic.close();
+
+	const QByteArray md5 = md5Hash.result().toHex();
+	if (md5!=checksum)
+	{
+		qWarning() << "Error: File " << QDir::toNativeSeparators(catalogFilePath) << " is corrupt, MD5 mismatch! Found " << md5 << " expected " << checksum;
+		fic.remove();
+		return false;
+	}
+	return true;
+}
 
-		QFile fic(catalogFilePath);
-		if(fic.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+void StarMgr::loadChecksumCache()
+{
+	checksumCacheFilePath = StelFileMgr::getUserDir()+"/stars/default/catalogChecksums.json";
+	QFile fic(checksumCacheFilePath);
+	if (fic.open(QIODevice::ReadOnly))
+	{
+		try
 		{
-			// Compute the MD5 sum
-			QCryptographicHash md5Hash(QCryptographicHash::Md5);
-			const qint64 cat_sz = fic.size();
-			qint64 maxStarBufMd5 = qMin(cat_sz, 9223372036854775807LL);
-			uchar *cat = maxStarBufMd5 ? fic.map(0, maxStarBufMd5) : NULL;
-			if (!cat)
-			{
-				// The OS was not able to map the file, revert to slower not mmap based method
-				static const qint64 maxStarBufMd5 = 1024*1024*8;
-				char* mmd5buf = (char*)malloc(maxStarBufMd5);
-				while (!fic.atEnd())
-				{
-					qint64 sz = fic.read(mmd5buf, maxStarBufMd5);
-					md5Hash.addData(mmd5buf, sz);
-				}
-				free(mmd5buf);
-			}
-			else
+			checksumCache = StelJsonParser::parse(&fic).toMap();
+		}
+		catch (std::runtime_error& e)
+		{
+			qWarning() << "Ignoring invalid catalog checksum cache:" << e.what();
+			checksumCache.clear();
+		}
+		fic.close();
+	}
+}
+
+bool StarMgr::isChecksumCached(const QString& catalogFilePath, const QByteArray& checksum) const
+{
+	const QFileInfo info(catalogFilePath);
+	const QVariantMap entry = checksumCache.value(info.absoluteFilePath()).toMap();
+	return !checksum.isEmpty() && entry.value("checksum").toByteArray()==checksum
+		&& entry.value("size").toString()==QString::number(info.size())
+		&& entry.value("modified").toString()==QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+void StarMgr::cacheChecksum(const QString& catalogFilePath, const QByteArray& checksum)
+{
+	const QFileInfo info(catalogFilePath);
+	QVariantMap entry;
+	entry["checksum"] = checksum;
+	entry["size"] = QString::number(info.size());
+	entry["modified"] = QString::number(info.lastModified().toMSecsSinceEpoch());
+	checksumCache[info.absoluteFilePath()] = entry;
+
+	try
+	{
+		StelFileMgr::makeSureDirExistsAndIsWritable(QFileInfo(checksumCacheFilePath).path());
+		QFile fic(checksumCacheFilePath);
+		if (fic.open(QIODevice::WriteOnly))
+		{
+			StelJsonParser::write(checksumCache, &fic);
+			fic.close();
+		}
+	}
+	catch (std::runtime_error& e)
+	{
+		qWarning() << "Could not save the catalog checksum cache:" << e.what();
+	}
+}
+
+bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
+{
+	const QString catalogFilePath = findCatalog(catDesc);
+	if (catalogFilePath.isEmpty())
+		return false;
+
+	ZoneArray* z = ZoneArray::create(catalogFilePath, true);
+	if (z)
+		appendZoneArray(z);
+	return true;
+}
+
+bool StarMgr::appendZoneArray(ZoneArray* z)
+{
+	if (z->level<gridLevels.size())
+	{
+		qWarning() << QDir::toNativeSeparators(z->fname) << ", " << z->level << ": duplicate level";
+		delete z;
+		return false;
+	}
+	Q_ASSERT(z->level==maxGeodesicGridLevel+1);
+	Q_ASSERT(z->level==gridLevels.size());
+	++maxGeodesicGridLevel;
+	gridLevels.append(z);
+	return true;
+}
+
+namespace
+{
+	//! Initialize the zones of a single level, as StarMgr::initTriangleFunc() does for all levels.
+	void initLevelTriangleFunc(int lev, int index, const Vec3f &c0, const Vec3f &c1, const Vec3f &c2, void *context)
+	{
+		ZoneArray* z = static_cast<ZoneArray*>(context);
+		if (lev==z->level)
+			z->initTriangle(index, c0, c1, c2);
+	}
+}
+
+void StarMgr::loadCatalogsInBackground(const QList<BackgroundCatalog>& catalogs)
+{
+	// StelCore's grid may be replaced by the main thread at any time, so use our own.
+	StelGeodesicGrid* grid = NULL;
+	foreach (const BackgroundCatalog& cat, catalogs)
+	{
+		if (abortCatalogLoading.load())
+			break;
+		if (!cat.checksum.isEmpty())
+		{
+			qDebug() << "Checking MD5 sum of" << QDir::toNativeSeparators(cat.path) << "in the background";
+			if (!verifyCatalog(cat.path, cat.checksum))
 			{
-				md5Hash.addData((const char*)cat, cat_sz);
-				fic.unmap(cat);
+				// The deeper levels can't be used without this one
+				QMutexLocker lock(&loadedCatalogsMutex);
+				loadedCatalogs.append(NULL);
+				break;
 			}
-			fic.close();
-			if (md5Hash.result().toHex()!=catDesc.value("checksum").toByteArray())
+			QMutexLocker lock(&loadedCatalogsMutex);
+			verifiedCatalogs.append(cat);
+		}
+		ZoneArray* z = ZoneArray::create(cat.path, true);
+		if (z)
+		{
+			if (!grid || grid->getMaxLevel()<z->level)
 			{
-				qWarning() << "Error: File " << QDir::toNativeSeparators(catalogFileName) << " is corrupt, MD5 mismatch! Found " << md5Hash.result().toHex() << " expected " << catDesc.value("checksum").toByteArray();
-				fic.remove();
-				return false;
+				delete grid;
+				grid = new StelGeodesicGrid(z->level);
 			}
-			qWarning() << "MD5 sum correct!";
-			setCheckFlag(catDesc.value("id").toString(), true);
+			grid->visitTriangles(z->level, initLevelTriangleFunc, z);
+			z->scaleAxis();
+			z->prefetch();
 		}
+		QMutexLocker lock(&loadedCatalogsMutex);
+		loadedCatalogs.append(z);
 	}
+	delete grid;
+}
 
-	ZoneArray* z = ZoneArray::create(catalogFilePath, true);
-	if (z)
+void StarMgr::publishLoadedCatalogs()
+{
+	const bool finished = catalogLoader->isFinished();
+	QList<ZoneArray*> loaded;
+	QList<BackgroundCatalog> verified;
+	{
+		QMutexLocker lock(&loadedCatalogsMutex);
+		loaded.swap(loadedCatalogs);
+		verified.swap(verifiedCatalogs);
+	}
+	foreach (const BackgroundCatalog& cat, verified)
 	{
-		if (z->level<gridLevels.size())
+		qDebug() << "MD5 sum of" << QDir::toNativeSeparators(cat.path) << "correct";
+		setCheckFlag(cat.id, true);
+		cacheChecksum(cat.path, cat.checksum);
+	}
+	foreach (ZoneArray* z, loaded)
+	{
+		++nbPublishedCatalogs;
+		if (z && appendZoneArray(z))
 		{
-			qWarning() << QDir::toNativeSeparators(catalogFileName) << ", " << z->level << ": duplicate level";
-			delete z;
-			return true;
+			z->updateHipIndex(hipIndex);
+			drawCache->clear();
+			qDebug() << "Star catalog of level" << z->level << "loaded in the background";
 		}
-		Q_ASSERT(z->level==maxGeodesicGridLevel+1);
-		Q_ASSERT(z->level==gridLevels.size());
-		++maxGeodesicGridLevel;
-		gridLevels.append(z);
+		emit catalogLoadingProgress(nbPublishedCatalogs, backgroundCatalogs.size());
+	}
+	if (finished)
+	{
+		delete catalogLoader;
+		catalogLoader = NULL;
+		qDebug() << "Finished loading star catalogue data, max_geodesic_level: " << maxGeodesicGridLevel;
 	}
-	return true;
+}
+
+void StarMgr::update(double deltaTime)
+{
+	labelsFader.update((int)(deltaTime*1000));
+	starsFader.update((int)(deltaTime*1000));
+	if (catalogLoader)
+		publishLoadedCatalogs();
 }
 
 void StarMgr::setCheckFlag(const QString& catId, bool b)
@@ -557,10 +776,22 @@ void StarMgr::loadData(QVariantMap starsConfig)
 	qDebug() << "Loading star data ...";
 
 	catalogsDescription = starsConfig.value("catalogs").toList();
+	int catalogIndex = 0;
 	foreach (const QVariant& catV, catalogsDescription)
 	{
 		QVariantMap m = catV.toMap();
-		checkAndLoadCatalog(m);
+		if (backgroundLoadingLevel>=0 && catalogIndex>=backgroundLoadingLevel)
+		{
+			// Deep catalogs are verified and loaded by init() in the background
+			BackgroundCatalog cat;
+			cat.id = m.value("id").toString();
+			cat.path = findCatalog(m, &cat.checksum);
+			if (!cat.path.isEmpty())
+				backgroundCatalogs << cat;
+		}
+		else
+			checkAndLoadCatalog(m);
+		++catalogIndex;
 	}
 
 	for (int i=0; i<=NR_OF_HIP; i++)
@@ -600,7 +831,6 @@ void StarMgr::loadData(QVariantMap starsConfig)
 			component_array = initStringListFromFile(tmpFic);
 	}
 
-	lastMaxSearchLevel = maxGeodesicGridLevel;
 	qDebug() << "Finished loading star catalogue data, max_geodesic_level: " << maxGeodesicGridLevel;
 }
 
@@ -609,8 +839,8 @@ int StarMgr::loadCommonNames(const QString& commonNameFile)
 {
 	commonNamesMap.clear();
 	commonNamesMapI18n.clear();
-	commonNamesIndexI18n.clear();
-	commonNamesIndex.clear();
+	designationIndex.clear(StarDesignationIndex::CommonName);
+	designationIndex.clear(StarDesignationIndex::CommonNameI18n);
 
 	qDebug() << "Loading star names from" << QDir::toNativeSeparators(commonNameFile);
 	QFile cnFile(commonNameFile);
@@ -668,16 +898,16 @@ int StarMgr::loadCommonNames(const QString& commonNameFile)
 			}
 
 			const QString commonNameI18n = englishCommonName;
-			QString commonNameI18n_cap = commonNameI18n.toUpper();
 
 			commonNamesMap[hip] = englishCommonName;
 			commonNamesMapI18n[hip] = commonNameI18n;
-			commonNamesIndexI18n[commonNameI18n_cap] = hip;
-			commonNamesIndex[englishCommonName.toUpper()] = hip;
+			designationIndex.insert(StarDesignationIndex::CommonNameI18n, commonNameI18n, hip);
+			designationIndex.insert(StarDesignationIndex::CommonName, englishCommonName, hip);
 			readOk++;
 		}
 	}
 	cnFile.close();
+	designationIndex.build();
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "common star names";
 	return 1;
@@ -688,9 +918,9 @@ int StarMgr::loadCommonNames(const QString& commonNameFile)
 void StarMgr::loadSciNames(const QString& sciNameFile)
 {
 	sciNamesMapI18n.clear();
-	sciNamesIndexI18n.clear();
 	sciAdditionalNamesMapI18n.clear();
-	sciAdditionalNamesIndexI18n.clear();
+	designationIndex.clear(StarDesignationIndex::SciName);
+	designationIndex.clear(StarDesignationIndex::SciAdditionalName);
 
 	qDebug() << "Loading star names from" << QDir::toNativeSeparators(sciNameFile);
 	QFile snFile(sciNameFile);
@@ -747,16 +977,17 @@ void StarMgr::loadSciNames(const QString& sciNameFile)
 			if (sciNamesMapI18n.find(hip)!=sciNamesMapI18n.end())
 			{
 				sciAdditionalNamesMapI18n[hip] = sci_name_i18n;
-				sciAdditionalNamesIndexI18n[sci_name_i18n.toUpper()] = hip;
+				designationIndex.insert(StarDesignationIndex::SciAdditionalName, sci_name_i18n, hip);
 			}
 			else
 			{
 				sciNamesMapI18n[hip] = sci_name_i18n;
-				sciNamesIndexI18n[sci_name_i18n.toUpper()] = hip;
+				designationIndex.insert(StarDesignationIndex::SciName, sci_name_i18n, hip);
 			}
 			++readOk;
 		}
 	}
+	designationIndex.build();
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "scientific star names";
 }
@@ -765,7 +996,7 @@ void StarMgr::loadSciNames(const QString& sciNameFile)
 void StarMgr::loadGcvs(const QString& GcvsFile)
 {
 	varStarsMapI18n.clear();
-	varStarsIndexI18n.clear();
+	designationIndex.clear(StarDesignationIndex::GcvsName);
 
 	qDebug() << "Loading variable stars from" << QDir::toNativeSeparators(GcvsFile);
 	QFile vsFile(GcvsFile);
@@ -828,9 +1059,10 @@ void StarMgr::loadGcvs(const QString& GcvsFile)
 		variableStar.stype = fields.at(11).trimmed();
 
 		varStarsMapI18n[hip] = variableStar;
-		varStarsIndexI18n[variableStar.designation.toUpper()] = hip;
+		designationIndex.insert(StarDesignationIndex::GcvsName, variableStar.designation, hip);
 		++readOk;
 	}
+	designationIndex.build();
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "variable stars";
 }
@@ -839,7 +1071,7 @@ void StarMgr::loadGcvs(const QString& GcvsFile)
 void StarMgr::loadWds(const QString& WdsFile)
 {
 	wdsStarsMapI18n.clear();
-	wdsStarsIndexI18n.clear();
+	designationIndex.clear(StarDesignationIndex::WdsName);
 
 	qDebug() << "Loading double stars from" << QDir::toNativeSeparators(WdsFile);
 	QFile dsFile(WdsFile);
@@ -886,9 +1118,10 @@ void StarMgr::loadWds(const QString& WdsFile)
 		doubleStar.separation = fields.at(4).toFloat();
 
 		wdsStarsMapI18n[hip] = doubleStar;
-		wdsStarsIndexI18n[QString("WDS J%1").arg(doubleStar.designation.toUpper())] = hip;
+		designationIndex.insert(StarDesignationIndex::WdsName, QString("WDS J%1").arg(doubleStar.designation), hip);
 		++readOk;
 	}
+	designationIndex.build();
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "double stars";
 }
@@ -897,9 +1130,9 @@ void StarMgr::loadWds(const QString& WdsFile)
 void StarMgr::loadCrossIdentificationData(const QString& crossIdFile)
 {
 	saoStarsMap.clear();
-	saoStarsIndex.clear();
 	hdStarsMap.clear();
-	hdStarsIndex.clear();
+	designationIndex.clear(StarDesignationIndex::SaoNumber);
+	designationIndex.clear(StarDesignationIndex::HdNumber);
 
 	qDebug() << "Loading cross-identification data from" << QDir::toNativeSeparators(crossIdFile);
 	QFile ciFile(crossIdFile);
@@ -949,18 +1182,19 @@ void StarMgr::loadCrossIdentificationData(const QString& crossIdFile)
 			if (sao>0)
 			{
 				saoStarsMap[hip] = sao;
-				saoStarsIndex[sao] = hip;
+				designationIndex.insert(StarDesignationIndex::SaoNumber, sao, hip);
 			}
 
 			if (hd>0)
 			{
 				hdStarsMap[hip] = hd;
-				hdStarsIndex[hd] = hip;
+				designationIndex.insert(StarDesignationIndex::HdNumber, hd, hip);
 			}
 
 			++readOk;
 		}
 	}
+	designationIndex.build();
 
 	qDebug() << "Loaded" << readOk << "/" << totalRecords << "cross-identification data records for stars";
 }
@@ -980,6 +1214,150 @@ int StarMgr::getMaxSearchLevel() const
 }
 
 
+//! @struct StarDrawCache
+//! Frame-coherent cache of the point sources and labels computed for each drawn zone.
+//! On a static view (e.g. with a time rate of 0) the zones are drawn again from their
+//! buffers instead of being recomputed. Each level has a stamp which is renewed when its
+//! magnitude tables change, and the stamps of all levels are renewed when any of the frame
+//! parameters change. A zone buffer is valid while the stamp of its level is unchanged.
+struct StarDrawCache
+{
+	//! The buffer of a zone and the stamp of its level when it was computed.
+	struct Entry
+	{
+		Entry() : stamp(0), isInside(false), used(false) {}
+		StarDrawBuffer buffer;
+		quint64 stamp;
+		bool isInside;
+		bool used;
+	};
+
+	//! The parameters of a frame which all the zone buffers depend on.
+	struct FrameParams
+	{
+		FrameParams() : withExtinction(false), extinctionCoefficient(0.f), extinctionMode(0), pressure(0.f), temperature(0.f),
+			properMotionDate(0), flagMagnitudeLimit(false), magnitudeLimit(0.), flagSciNames(false)
+		{
+			altAzAxes[0] = altAzAxes[1] = altAzAxes[2] = Vec3f(0.f);
+		}
+		StelProjectorP prj;
+		StarKernelCaps caps;
+		bool withExtinction;
+		Vec3f altAzAxes[3];
+		float extinctionCoefficient;
+		int extinctionMode;
+		float pressure;
+		float temperature;
+		qint64 properMotionDate;
+		bool flagMagnitudeLimit;
+		double magnitudeLimit;
+		bool flagSciNames;
+
+		bool operator==(const FrameParams& o) const
+		{
+			return prj && o.prj && prj->isSameProjection(*o.prj) && caps==o.caps
+				&& withExtinction==o.withExtinction && altAzAxes[0]==o.altAzAxes[0]
+				&& altAzAxes[1]==o.altAzAxes[1] && altAzAxes[2]==o.altAzAxes[2]
+				&& extinctionCoefficient==o.extinctionCoefficient && extinctionMode==o.extinctionMode && pressure==o.pressure
+				&& temperature==o.temperature && properMotionDate==o.properMotionDate
+				&& flagMagnitudeLimit==o.flagMagnitudeLimit && magnitudeLimit==o.magnitudeLimit
+				&& flagSciNames==o.flagSciNames;
+		}
+	};
+
+	//! The parameters of a level which its zone buffers depend on.
+	struct LevelParams
+	{
+		LevelParams() : stamp(0), limitMagIndex(0), maxMagStarName(0) {}
+		quint64 stamp;
+		std::vector<RCMag> rcmagTable;
+		int limitMagIndex;
+		int maxMagStarName;
+	};
+
+	StarDrawCache() : lastStamp(0) {}
+	~StarDrawCache() {clear();}
+
+	//! Invalidate and release all the zone buffers.
+	void clear()
+	{
+		qDeleteAll(entries);
+		entries.clear();
+		levels.clear();
+		frame = FrameParams();
+	}
+
+	//! Buffers of the zones drawn at the previous frame, indexed by level<<24|zone.
+	QHash<quint32, Entry*> entries;
+	FrameParams frame;
+	QVector<LevelParams> levels;
+	quint64 lastStamp;
+};
+
+namespace
+{
+	//! A zone of a given level to be drawn, with the per-level parameters prepared by StarMgr::draw().
+	struct ZoneDrawJob
+	{
+		const ZoneArray* z;
+		int zone;
+		bool isInside;
+		const RCMag* rcmagTable;
+		int limitMagIndex;
+		int maxMagStarName;
+		StarDrawBuffer* buffer;
+	};
+
+	//! Compute a contiguous range of zone jobs, each into its own draw buffer.
+	void drawZoneJobs(const ZoneDrawJob* begin, const ZoneDrawJob* end, const StelProjector* prj,
+			  const StelCore* core, const StarKernelCaps* viewportCaps)
+	{
+		for (const ZoneDrawJob* job=begin;job<end;++job)
+		{
+			job->buffer->clear();
+			job->z->draw(*job->buffer, prj, job->zone, job->isInside, job->rcmagTable, job->limitMagIndex, core, job->maxMagStarName, *viewportCaps);
+		}
+	}
+
+	//! Runs drawZoneJobs() in the star drawing thread pool.
+	class StarDrawTask : public QRunnable
+	{
+	public:
+		StarDrawTask(const ZoneDrawJob* begin, const ZoneDrawJob* end, const StelProjector* prj,
+			     const StelCore* core, const StarKernelCaps* viewportCaps)
+			: begin(begin), end(end), prj(prj), core(core), viewportCaps(viewportCaps)
+		{
+		}
+		virtual void run()
+		{
+			drawZoneJobs(begin, end, prj, core, viewportCaps);
+		}
+	private:
+		const ZoneDrawJob* begin;
+		const ZoneDrawJob* end;
+		const StelProjector* prj;
+		const StelCore* core;
+		const StarKernelCaps* viewportCaps;
+	};
+}
+
+void StarMgr::setFlagMultithreadedDraw(bool b)
+{
+	flagMultithreadedDraw = b;
+	if (flagMultithreadedDraw && !drawThreadPool)
+	{
+		drawThreadPool = new QThreadPool(this);
+		drawThreadPool->setMaxThreadCount(drawThreadCount>0 ? drawThreadCount : QThread::idealThreadCount());
+	}
+}
+
+void StarMgr::setDrawThreadCount(int n)
+{
+	drawThreadCount = qMax(0, n);
+	if (drawThreadPool)
+		drawThreadPool->setMaxThreadCount(drawThreadCount>0 ? drawThreadCount : QThread::idealThreadCount());
+}
+
 // Draw all the stars
 void StarMgr::draw(StelCore* core)
 {
@@ -994,19 +1372,43 @@ void StarMgr::draw(StelCore* core)
 	QVector<SphericalCap> viewportCaps = prj->getViewportConvexPolygon()->getBoundingSphericalCaps();
 	viewportCaps.append(core->getVisibleSkyArea());
 	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(maxSearchLevel)->search(viewportCaps,maxSearchLevel);
+	const StarKernelCaps kernelCaps(viewportCaps);
 
 	// Set temporary static variable for optimization
 	const float names_brightness = labelsFader.getInterstate() * starsFader.getInterstate();
 
-	// Prepare openGL for drawing many stars
-	StelPainter sPainter(prj);
-	sPainter.setFont(starFont);
-	skyDrawer->preDrawPointSource(&sPainter);
-
-	// Prepare a table for storing precomputed RCMag for all ZoneArrays
-	RCMag rcmag_table[RCMAG_TABLE_SIZE];
-	
-	// Draw all the stars of all the selected zones
+	// Check whether the zones computed at the previous frame are still valid
+	StarDrawCache::FrameParams frame;
+	frame.prj = prj;
+	frame.caps = kernelCaps;
+	frame.withExtinction = skyDrawer->getFlagHasAtmosphere() && skyDrawer->getExtinction().getExtinctionCoefficient()>=0.01f;
+	if (frame.withExtinction)
+	{
+		frame.altAzAxes[0].set(1.f, 0.f, 0.f);
+		frame.altAzAxes[1].set(0.f, 1.f, 0.f);
+		frame.altAzAxes[2].set(0.f, 0.f, 1.f);
+		for (int i=0;i<3;++i)
+			core->j2000ToAltAzInPlaceNoRefraction(&frame.altAzAxes[i]);
+	}
+	frame.extinctionCoefficient = skyDrawer->getExtinction().getExtinctionCoefficient();
+	frame.extinctionMode = skyDrawer->getExtinction().getUndergroundExtinctionMode();
+	frame.pressure = skyDrawer->getRefraction().getPressure();
+	frame.temperature = skyDrawer->getRefraction().getTemperature();
+	// Quantize the date so that the fastest proper motion (Barnard's star, 10.4"/year) moves
+	// by less than 0.1 pixel within a period.
+	const double dateResolution = 365.25*0.1/(prj->getPixelPerRadAtCenter()*(10.4/3600.*M_PI/180.));
+	frame.properMotionDate = (qint64)std::floor(core->getJDE()/qMax(dateResolution, 1e-6));
+	frame.flagMagnitudeLimit = skyDrawer->getFlagStarMagnitudeLimit();
+	frame.magnitudeLimit = skyDrawer->getCustomStarMagnitudeLimit();
+	frame.flagSciNames = getFlagSciNames();
+	const bool frameChanged = !flagDrawCache || !(frame==drawCache->frame);
+	drawCache->frame = frame;
+	if (drawCache->levels.size()!=gridLevels.size())
+		drawCache->levels.resize(gridLevels.size());
+
+	// Collect all the selected zones of all levels
+	QVector<ZoneDrawJob> jobs;
+	std::vector<RCMag> rcmag_table(RCMAG_TABLE_SIZE);
 	foreach(const ZoneArray* z, gridLevels)
 	{
 		int limitMagIndex=RCMAG_TABLE_SIZE;
@@ -1034,7 +1436,6 @@ void StarMgr::draw(StelCore* core)
 			}
 			rcmag_table[i].radius *= starsFader.getInterstate();
 		}
-		lastMaxSearchLevel = z->level;
 
 		unsigned int maxMagStarName = 0;
 		if (labelsFader.getInterstate()>0.f)
@@ -1045,15 +1446,105 @@ void StarMgr::draw(StelCore* core)
 			if (x > 0)
 				maxMagStarName = x;
 		}
-		int zone;
-		
-		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, true, rcmag_table, limitMagIndex, core, maxMagStarName, names_brightness, viewportCaps);
-		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-			z->draw(&sPainter, zone, false, rcmag_table, limitMagIndex, core, maxMagStarName,names_brightness, viewportCaps);
+
+		// The table stays valid until the worker threads are done
+		StarDrawCache::LevelParams& level = drawCache->levels[z->level];
+		if (frameChanged || level.limitMagIndex!=limitMagIndex || level.maxMagStarName!=(int)maxMagStarName
+		    || level.rcmagTable.size()!=rcmag_table.size()
+		    || memcmp(&level.rcmagTable[0], &rcmag_table[0], RCMAG_TABLE_SIZE*sizeof(RCMag))!=0)
+		{
+			level.rcmagTable.swap(rcmag_table);
+			rcmag_table.resize(RCMAG_TABLE_SIZE);
+			level.limitMagIndex = limitMagIndex;
+			level.maxMagStarName = maxMagStarName;
+			level.stamp = ++drawCache->lastStamp;
+		}
+
+		ZoneDrawJob job;
+		job.z = z;
+		job.rcmagTable = &level.rcmagTable[0];
+		job.limitMagIndex = limitMagIndex;
+		job.maxMagStarName = maxMagStarName;
+		job.isInside = true;
+		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(job.zone = it1.next()) >= 0;)
+			jobs.append(job);
+		job.isInside = false;
+		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level);(job.zone = it1.next()) >= 0;)
+			jobs.append(job);
 	}
 	exit_loop:
 
+	// Attach a buffer to each zone and keep only the zones which must be recomputed
+	QVector<ZoneDrawJob> dirtyJobs;
+	for (QVector<ZoneDrawJob>::iterator job=jobs.begin();job!=jobs.end();++job)
+	{
+		StarDrawCache::Entry*& entry = drawCache->entries[(job->z->level<<24)|job->zone];
+		if (!entry)
+			entry = new StarDrawCache::Entry();
+		entry->used = true;
+		job->buffer = &entry->buffer;
+		const quint64 stamp = drawCache->levels[job->z->level].stamp;
+		if (entry->stamp!=stamp || entry->isInside!=job->isInside)
+		{
+			entry->stamp = stamp;
+			entry->isInside = job->isInside;
+			dirtyJobs.append(*job);
+		}
+	}
+
+	// Release the zones which are not drawn anymore
+	for (QHash<quint32, StarDrawCache::Entry*>::iterator it=drawCache->entries.begin();it!=drawCache->entries.end();)
+	{
+		if (it.value()->used)
+		{
+			it.value()->used = false;
+			++it;
+		}
+		else
+		{
+			delete it.value();
+			it = drawCache->entries.erase(it);
+		}
+	}
+
+	// Split the zones to recompute in contiguous chunks.
+	int nbChunks = 1;
+	if (flagMultithreadedDraw && drawThreadPool && dirtyJobs.size()>1)
+		nbChunks = qMin(dirtyJobs.size(), drawThreadPool->maxThreadCount()*4);
+
+	const ZoneDrawJob* firstJob = dirtyJobs.constData();
+	const int jobsPerChunk = (dirtyJobs.size()+nbChunks-1)/nbChunks;
+	for (int c=0;c<nbChunks;++c)
+	{
+		const ZoneDrawJob* begin = firstJob + qMin(dirtyJobs.size(), c*jobsPerChunk);
+		const ZoneDrawJob* end = firstJob + qMin(dirtyJobs.size(), (c+1)*jobsPerChunk);
+		if (c>0)
+			drawThreadPool->start(new StarDrawTask(begin, end, prj.data(), core, &kernelCaps));
+		else
+			drawZoneJobs(begin, end, prj.data(), core, &kernelCaps);
+	}
+	if (nbChunks>1)
+		drawThreadPool->waitForDone();
+
+	// Prepare openGL for drawing many stars
+	StelPainter sPainter(prj);
+	sPainter.setFont(starFont);
+	skyDrawer->preDrawPointSource(&sPainter);
+
+	// Merge the zone buffers into the vertex arrays, in order so that the result
+	// does not depend on thread scheduling.
+	for (QVector<ZoneDrawJob>::const_iterator job=jobs.constBegin();job!=jobs.constEnd();++job)
+	{
+		const StarDrawBuffer* buffer = job->buffer;
+		for (std::vector<StelSkyDrawer::PointSource>::const_iterator it=buffer->points.begin();it!=buffer->points.end();++it)
+			skyDrawer->drawPointSource(&sPainter, *it);
+		for (std::vector<StarDrawBuffer::Label>::const_iterator it=buffer->labels.begin();it!=buffer->labels.end();++it)
+		{
+			sPainter.setColor(it->color[0], it->color[1], it->color[2], names_brightness);
+			sPainter.drawText(Vec3d(it->pos[0], it->pos[1], it->pos[2]), it->text, 0, it->offset, it->offset, false);
+		}
+	}
+
 	// Finish drawing many stars
 	skyDrawer->postDrawPointSource(&sPainter);
 
@@ -1066,12 +1557,55 @@ void StarMgr::draw(StelCore* core)
 // inside the limFov circle around position v
 QList<StelObjectP > StarMgr::searchAround(const Vec3d& vv, double limFov, const StelCore* core) const
 {
-	QList<StelObjectP > result;
 	if (!getFlagStars())
-		return result;
+		return QList<StelObjectP >();
+	// Only the stars bright enough to be drawn can be picked, and a wide cone
+	// must not wrap the millions of stars of the deep catalogs
+	return searchCone(vv, limFov, core, core->getSkyDrawer()->getLimitMagnitude(), MaxSearchAroundResults);
+}
+
+QList<StelObjectP > StarMgr::searchCone(const Vec3d& v, double limitFov, const StelCore* core, float maxMag, int maxNb) const
+{
+	QVector<StarSearchHit> hits;
+	searchConeHits(v, limitFov, core, maxMag, hits);
+	return createSearchResult(hits, maxNb);
+}
+
+QList<StelObjectP > StarMgr::searchNearest(const Vec3d& v, int n, const StelCore* core, float maxMag) const
+{
+	// Widen the cone until it contains enough stars: all the stars outside
+	// of it are then farther than the n nearest stars found inside.
+	QVector<StarSearchHit> hits;
+	for (double fov=0.1;n>0;fov*=4.)
+	{
+		hits.clear();
+		searchConeHits(v, qMin(fov, 180.), core, maxMag, hits);
+		if (hits.size()>=n || fov>=180.)
+			break;
+	}
+	return createSearchResult(hits, n);
+}
 
+void StarMgr::searchConeHits(const Vec3d& vv, double limFov, const StelCore* core, float maxMag, QVector<StarSearchHit>& hits) const
+{
+	if (gridLevels.isEmpty())
+		return;
 	Vec3d v(vv);
 	v.normalize();
+	const Vec3f vf(v[0], v[1], v[2]);
+	const float cosLimFov = cos(limFov * M_PI/180.);
+
+	if (limFov >= 60.)
+	{
+		// The bounding polygon below degenerates for wide cones, just test all the zones
+		foreach(const ZoneArray* z, gridLevels)
+		{
+			const int maxMagIndex = z->getMagIndex(maxMag);
+			for (int zone=0;zone<StelGeodesicGrid::nrOfZones(z->level);++zone)
+				z->searchCone(core, zone, vf, cosLimFov, maxMagIndex, hits);
+		}
+		return;
+	}
 
 	// find any vectors h0 and h1 (length 1), so that h0*v=h1*v=h0*h1=0
 	int i;
@@ -1110,28 +1644,37 @@ QList<StelObjectP > StarMgr::searchAround(const Vec3d& vv, double limFov, const
 	e1 *= f;
 	e2 *= f;
 	e3 *= f;
-	// Search the triangles
-	SphericalConvexPolygon c(e3, e2, e2, e0);
-	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(lastMaxSearchLevel)->search(c.getBoundingSphericalCaps(),lastMaxSearchLevel);
+
+	// Search the triangles of all the loaded levels, whatever was drawn last
+	SphericalConvexPolygon c(e3, e2, e1, e0);
+	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(maxGeodesicGridLevel)->search(c.getBoundingSphericalCaps(),maxGeodesicGridLevel);
 
 	// Iterate over the stars inside the triangles
-	f = cos(limFov * M_PI/180.);
-	foreach(ZoneArray* z, gridLevels)
+	foreach(const ZoneArray* z, gridLevels)
 	{
-		//qDebug() << "search inside(" << it->first << "):";
+		const int maxMagIndex = z->getMagIndex(maxMag);
 		int zone;
 		for (GeodesicSearchInsideIterator it1(*geodesic_search_result,z->level);(zone = it1.next()) >= 0;)
-		{
-			z->searchAround(core, zone,v,f,result);
-			//qDebug() << " " << zone;
-		}
-		//qDebug() << endl << "search border(" << it->first << "):";
+			z->searchCone(core, zone, vf, cosLimFov, maxMagIndex, hits);
 		for (GeodesicSearchBorderIterator it1(*geodesic_search_result,z->level); (zone = it1.next()) >= 0;)
-		{
-			z->searchAround(core, zone,v,f,result);
-			//qDebug() << " " << zone;
-		}
+			z->searchCone(core, zone, vf, cosLimFov, maxMagIndex, hits);
+	}
+}
+
+QList<StelObjectP > StarMgr::createSearchResult(QVector<StarSearchHit>& hits, int maxNb)
+{
+	if (maxNb>=0 && maxNb<hits.size())
+	{
+		std::partial_sort(hits.begin(), hits.begin()+maxNb, hits.end());
+		hits.resize(maxNb);
 	}
+	else
+		std::sort(hits.begin(), hits.end());
+
+	QList<StelObjectP > result;
+	result.reserve(hits.size());
+	foreach (const StarSearchHit& hit, hits)
+		result.append(hit.a->createStelObject(hit.zone, hit.star));
 	return result;
 }
 
@@ -1142,14 +1685,17 @@ void StarMgr::updateI18n()
 {
 	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getSkyTranslator();
 	commonNamesMapI18n.clear();
-	commonNamesIndexI18n.clear();
+	designationIndex.clear(StarDesignationIndex::CommonNameI18n);
 	for (QHash<int,QString>::ConstIterator it(commonNamesMap.constBegin());it!=commonNamesMap.constEnd();it++)
 	{
 		const int i = it.key();
 		const QString t(trans.qtranslate(it.value()));
 		commonNamesMapI18n[i] = t;
-		commonNamesIndexI18n[t.toUpper()] = i;
+		designationIndex.insert(StarDesignationIndex::CommonNameI18n, t, i);
 	}
+	designationIndex.build();
+	// The labels of the drawn zones must be translated again
+	drawCache->clear();
 }
 
 // Search the star by HP number
@@ -1170,7 +1716,7 @@ StelObjectP StarMgr::searchHP(int hp) const
 
 StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 {
-	QString objw = nameI18n.toUpper();
+	const QString objw = StarDesignationIndex::normalize(nameI18n);
 
 	// Search by HP number if it's an HP formated number
 	QRegExp rx("^\\s*(HIP|HP)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
@@ -1183,10 +1729,10 @@ StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 	QRegExp rx2("^\\s*(SAO)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx2.exactMatch(objw))
 	{
-		QMap<int,int>::const_iterator sao(saoStarsIndex.find(rx2.capturedTexts().at(2).toInt()));
-		if (sao!=saoStarsIndex.end())
+		const int hip = designationIndex.find(StarDesignationIndex::SaoNumber, rx2.capturedTexts().at(2).toInt());
+		if (hip>0)
 		{
-			return searchHP(sao.value());
+			return searchHP(hip);
 		}
 	}
 
@@ -1194,47 +1740,22 @@ StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 	QRegExp rx3("^\\s*(HD)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx3.exactMatch(objw))
 	{
-		QMap<int,int>::const_iterator hd(hdStarsIndex.find(rx3.capturedTexts().at(2).toInt()));
-		if (hd!=hdStarsIndex.end())
+		const int hip = designationIndex.find(StarDesignationIndex::HdNumber, rx3.capturedTexts().at(2).toInt());
+		if (hip>0)
 		{
-			return searchHP(hd.value());
+			return searchHP(hip);
 		}
 	}
 
-	// Search by I18n common name
-	QMap<QString,int>::const_iterator it(commonNamesIndexI18n.find(objw));
-	if (it!=commonNamesIndexI18n.end())
-	{
-		return searchHP(it.value());
-	}
-
-	// Search by sci name
-	QMap<QString,int>::const_iterator it2 = sciNamesIndexI18n.find(objw);
-	if (it2!=sciNamesIndexI18n.end())
+	// Search by I18n common name, sci name, additional sci name, GCVS name and WDS name, in this order
+	const int hip = designationIndex.find(objw, (1u<<StarDesignationIndex::CommonNameI18n)
+					      | (1u<<StarDesignationIndex::SciName)
+					      | (1u<<StarDesignationIndex::SciAdditionalName)
+					      | (1u<<StarDesignationIndex::GcvsName)
+					      | (1u<<StarDesignationIndex::WdsName));
+	if (hip>0)
 	{
-		return searchHP(it2.value());
-	}
-
-
-	// Search by additional sci name
-	QMap<QString,int>::const_iterator it3 = sciAdditionalNamesIndexI18n.find(objw);
-	if (it3!=sciAdditionalNamesIndexI18n.end())
-	{
-		return searchHP(it3.value());
-	}
-
-	// Search by GCVS name
-	QMap<QString,int>::const_iterator it4 = varStarsIndexI18n.find(objw);
-	if (it4!=varStarsIndexI18n.end())
-	{
-		return searchHP(it4.value());
-	}
-
-	// Search by WDS name
-	QMap<QString,int>::const_iterator wdsIt = wdsStarsIndexI18n.find(objw);
-	if (wdsIt!=wdsStarsIndexI18n.end())
-	{
-		return searchHP(wdsIt.value());
+		return searchHP(hip);
 	}
 
 	return StelObjectP();
@@ -1243,7 +1764,7 @@ StelObjectP StarMgr::searchByNameI18n(const QString& nameI18n) const
 
 StelObjectP StarMgr::searchByName(const QString& name) const
 {
-	QString objw = name.toUpper();
+	const QString objw = StarDesignationIndex::normalize(name);
 
 	// Search by HP number if it's an HP formated number
 	QRegExp rx("^\\s*(HP|HIP)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
@@ -1256,10 +1777,10 @@ StelObjectP StarMgr::searchByName(const QString& name) const
 	QRegExp rx2("^\\s*(SAO)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx2.exactMatch(objw))
 	{
-		QMap<int,int>::const_iterator sao(saoStarsIndex.find(rx2.capturedTexts().at(2).toInt()));
-		if (sao!=saoStarsIndex.end())
+		const int hip = designationIndex.find(StarDesignationIndex::SaoNumber, rx2.capturedTexts().at(2).toInt());
+		if (hip>0)
 		{
-			return searchHP(sao.value());
+			return searchHP(hip);
 		}
 	}
 
@@ -1267,32 +1788,20 @@ StelObjectP StarMgr::searchByName(const QString& name) const
 	QRegExp rx3("^\\s*(HD)\\s*(\\d+)\\s*$", Qt::CaseInsensitive);
 	if (rx3.exactMatch(objw))
 	{
-		QMap<int,int>::const_iterator hd(hdStarsIndex.find(rx3.capturedTexts().at(2).toInt()));
-		if (hd!=hdStarsIndex.end())
+		const int hip = designationIndex.find(StarDesignationIndex::HdNumber, rx3.capturedTexts().at(2).toInt());
+		if (hip>0)
 		{
-			return searchHP(hd.value());
+			return searchHP(hip);
 		}
 	}
 
-	// Search by I18n common name
-	QMap<QString,int>::const_iterator it(commonNamesIndex.find(objw));
-	if (it!=commonNamesIndex.end())
-	{
-		return searchHP(it.value());
-	}
-
-	// Search by sci name
-	QMap<QString,int>::const_iterator it2 = sciNamesIndexI18n.find(objw);
-	if (it2!=sciNamesIndexI18n.end())
+	// Search by english common name, sci name and additional sci name, in this order
+	const int hip = designationIndex.find(objw, (1u<<StarDesignationIndex::CommonName)
+					      | (1u<<StarDesignationIndex::SciName)
+					      | (1u<<StarDesignationIndex::SciAdditionalName));
+	if (hip>0)
 	{
-		return searchHP(it2.value());
-	}
-
-	// Search by additional sci name
-	QMap<QString,int>::const_iterator it3 = sciAdditionalNamesIndexI18n.find(objw);
-	if (it3!=sciAdditionalNamesIndexI18n.end())
-	{
-		return searchHP(it3.value());
+		return searchHP(hip);
 	}
 
 	return StelObjectP();
@@ -1302,48 +1811,27 @@ StelObjectP StarMgr::searchByName(const QString& name) const
 QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
 {
 	QStringList result;
-	if (maxNbItem <= 0)
+	if (maxNbItem <= 0 || objPrefix.isEmpty())
 	{
 		return result;
 	}
 
-	QString objw = objPrefix.toUpper();
+	const QString objw = StarDesignationIndex::normalize(objPrefix);
+	const StarDesignationIndex::Catalog commonCatalog = inEnglish ? StarDesignationIndex::CommonName : StarDesignationIndex::CommonNameI18n;
 
-	QMap<QString, int> cNamesIdx = inEnglish ? commonNamesIndex : commonNamesIndexI18n;
+	// Matching names of each catalog, in alphabetical order of their designations
+	QStringList matches[StarDesignationIndex::NbCatalogs];
 
-	// Search for common names
-	if (useStartOfWords)
+	// Search for common names containing the string
+	if (!useStartOfWords)
 	{
-		for (QMap<QString,int>::const_iterator it(cNamesIdx.lowerBound(objw)); it!=cNamesIdx.end(); ++it)
+		for (int i=0; i<designationIndex.size() && matches[commonCatalog].size()<maxNbItem; ++i)
 		{
-			if (it.key().startsWith(objw))
-			{
-				if (maxNbItem<=0)
-					break;
-				result.append(inEnglish ? getCommonEnglishName(it.value()) : getCommonName(it.value()));
-				--maxNbItem;
-			}
-			else
-				break;
-		}
-	}
-	else
-	{
-		QMapIterator<QString, int> i(cNamesIdx);
-		while (i.hasNext())
-		{
-			i.next();
-			if (i.key().contains(objw))
-			{
-				if (maxNbItem<=0)
-					break;
-				result.append(inEnglish ? getCommonEnglishName(i.value()) : getCommonName(i.value()));
-				--maxNbItem;
-			}
+			if (designationIndex.catalog(i)==commonCatalog && designationIndex.key(i).contains(objw))
+				matches[commonCatalog] << (inEnglish ? getCommonEnglishName(designationIndex.hip(i)) : getCommonName(designationIndex.hip(i)));
 		}
 	}
 
-	// Search for sci names
 	QString bayerPattern = objw;
 	QRegExp bayerRegEx(bayerPattern);
 
@@ -1352,44 +1840,57 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	if (objw.at(0).unicode() >= 0x0391 && objw.at(0).unicode() <= 0x03A9)
 		bayerRegEx.setPattern(bayerPattern.insert(1,"\\d?"));
 
-	for (QMap<QString,int>::const_iterator it(sciNamesIndexI18n.lowerBound(objw)); it!=sciNamesIndexI18n.end(); ++it)
-	{
-		if (it.key().indexOf(bayerRegEx)==0)
-		{
-			if (maxNbItem<=0)
-				break;
-			result << getSciName(it.value());
-			--maxNbItem;
-		}
-		else if (it.key().at(0) != objw.at(0))
-			break;
-	}
+	QRegExp wdsRx("^(WDS)\\s*(\\S+)\\s*$");
+	wdsRx.setCaseSensitivity(Qt::CaseInsensitive);
+	const bool searchWds = wdsRx.exactMatch(objw);
 
-	for (QMap<QString,int>::const_iterator it(sciAdditionalNamesIndexI18n.lowerBound(objw)); it!=sciAdditionalNamesIndexI18n.end(); ++it)
+	// Search all the other catalogs at once: the matching designations all start with the same
+	// letter as the string, and all but the Bayer names with an index start with the string.
+	for (int i=designationIndex.lowerBound(objw); i<designationIndex.size(); ++i)
 	{
-		if (it.key().indexOf(bayerRegEx)==0)
+		const QStringRef key = designationIndex.key(i);
+		if (key.at(0)!=objw.at(0))
+			break;
+		const StarDesignationIndex::Catalog catalog = designationIndex.catalog(i);
+		if (matches[catalog].size()>=maxNbItem)
+			continue;
+		const int hip = designationIndex.hip(i);
+		switch (catalog)
 		{
-			if (maxNbItem<=0)
+			case StarDesignationIndex::CommonName:
+			case StarDesignationIndex::CommonNameI18n:
+				if (useStartOfWords && catalog==commonCatalog && key.startsWith(objw))
+					matches[catalog] << (inEnglish ? getCommonEnglishName(hip) : getCommonName(hip));
+				break;
+			case StarDesignationIndex::SciName:
+				if (key.toString().indexOf(bayerRegEx)==0)
+					matches[catalog] << getSciName(hip);
+				break;
+			case StarDesignationIndex::SciAdditionalName:
+				if (key.toString().indexOf(bayerRegEx)==0)
+					matches[catalog] << getSciAdditionalName(hip);
+				break;
+			case StarDesignationIndex::GcvsName:
+				if (key.startsWith(objw))
+					matches[catalog] << getGcvsName(hip);
+				break;
+			case StarDesignationIndex::WdsName:
+				if (searchWds && key.startsWith(objw))
+					matches[catalog] << getWdsName(hip);
+				break;
+			default:
 				break;
-			result << getSciAdditionalName(it.value());
-			--maxNbItem;
 		}
-		else if (it.key().at(0) != objw.at(0))
-			break;
 	}
 
-	// Search for sci names for var stars
-	for (QMap<QString,int>::const_iterator it(varStarsIndexI18n.lowerBound(objw)); it!=varStarsIndexI18n.end(); ++it)
+	// Add common names, sci names, additional sci names and var stars names, in this order
+	const StarDesignationIndex::Catalog catalogs[] = {commonCatalog, StarDesignationIndex::SciName,
+							  StarDesignationIndex::SciAdditionalName, StarDesignationIndex::GcvsName};
+	for (unsigned int c=0; c<sizeof(catalogs)/sizeof(catalogs[0]); ++c)
 	{
-		if (it.key().startsWith(objw))
-		{
-			if (maxNbItem<=0)
-				break;
-			result << getGcvsName(it.value());
-			--maxNbItem;
-		}
-		else
-			break;
+		const QStringList& names = matches[catalogs[c]];
+		for (int i=0; i<names.size() && maxNbItem>0; ++i, --maxNbItem)
+			result << names.at(i);
 	}
 
 	// Add exact Hp catalogue numbers
@@ -1415,12 +1916,11 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	saoRx.setCaseSensitivity(Qt::CaseInsensitive);
 	if (saoRx.exactMatch(objw))
 	{
-		bool ok;
-		int saoNum = saoRx.capturedTexts().at(2).toInt(&ok);
-		QMap<int,int>::const_iterator sao(saoStarsIndex.find(saoNum));
-		if (sao!=saoStarsIndex.end())
+		int saoNum = saoRx.capturedTexts().at(2).toInt();
+		const int hip = designationIndex.find(StarDesignationIndex::SaoNumber, saoNum);
+		if (hip>0)
 		{
-			StelObjectP s = searchHP(sao.value());
+			StelObjectP s = searchHP(hip);
 			if (s && maxNbItem>0)
 			{
 				result << QString("SAO%1").arg(saoNum);
@@ -1434,12 +1934,11 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	hdRx.setCaseSensitivity(Qt::CaseInsensitive);
 	if (hdRx.exactMatch(objw))
 	{
-		bool ok;
-		int hdNum = hdRx.capturedTexts().at(2).toInt(&ok);
-		QMap<int,int>::const_iterator hd(hdStarsIndex.find(hdNum));
-		if (hd!=hdStarsIndex.end())
+		int hdNum = hdRx.capturedTexts().at(2).toInt();
+		const int hip = designationIndex.find(StarDesignationIndex::HdNumber, hdNum);
+		if (hip>0)
 		{
-			StelObjectP s = searchHP(hd.value());
+			StelObjectP s = searchHP(hip);
 			if (s && maxNbItem>0)
 			{
 				result << QString("HD%1").arg(hdNum);
@@ -1449,29 +1948,14 @@ QStringList StarMgr::listMatchingObjects(const QString& objPrefix, int maxNbItem
 	}
 
 	// Add exact WDS catalogue numbers
-	QRegExp wdsRx("^(WDS)\\s*(\\S+)\\s*$");
-	wdsRx.setCaseSensitivity(Qt::CaseInsensitive);
-	if (wdsRx.exactMatch(objw))
-	{
-		for (QMap<QString,int>::const_iterator wds(wdsStarsIndexI18n.lowerBound(objw)); wds!=wdsStarsIndexI18n.end(); ++wds)
-		{
-			if (wds.key().startsWith(objw))
-			{
-				if (maxNbItem==0)
-					break;
-				result << getWdsName(wds.value());
-				--maxNbItem;
-			}
-			else
-				break;
-		}
-	}
+	const QStringList& wdsNames = matches[StarDesignationIndex::WdsName];
+	for (int i=0; i<wdsNames.size() && maxNbItem>0; ++i, --maxNbItem)
+		result << wdsNames.at(i);
 
 	result.sort();
 	return result;
 }
 
-
 //! Define font file name and size to use for star names display
 void StarMgr::setFontSize(float newFontSize)
 {
@@ -1519,23 +2003,12 @@ void StarMgr::updateSkyCulture(const QString& skyCultureDir)
 QStringList StarMgr::listAllObjects(bool inEnglish) const
 {
 	QStringList result;
-	if (inEnglish)
+	const StarDesignationIndex::Catalog catalog = inEnglish ? StarDesignationIndex::CommonName : StarDesignationIndex::CommonNameI18n;
+	for (int i=0; i<designationIndex.size(); ++i)
 	{
-		QMapIterator<QString, int> i(commonNamesIndex);
-		while (i.hasNext())
-		{
-			i.next();
-			result << getCommonEnglishName(i.value());
-		}
-	}
-	else
-	{
-		QMapIterator<QString, int> i(commonNamesIndexI18n);
-		while (i.hasNext())
-		{
-			i.next();
-			result << getCommonName(i.value());
-		}
+		if (designationIndex.catalog(i)!=catalog)
+			continue;
+		result << (inEnglish ? getCommonEnglishName(designationIndex.hip(i)) : getCommonName(designationIndex.hip(i)));
 	}
 	return result;
 }
@@ -20,7 +20,9 @@
 #ifndef _STARMGR_HPP_
 #define _STARMGR_HPP_
 
+#include <QAtomicInt>
 #include <QFont>
+#include <QMutex>
 #include <QVariantMap>
 #include <QVector>
 #include "StelFader.hpp"
@@ -36,6 +38,11 @@ class QSettings;
 
 class ZoneArray;
 struct HipIndexStruct;
+struct StarDrawCache;
+struct StarSearchHit;
+class StarDesignationIndex;
+class QThreadPool;
+template <class T> class QFuture;
 
 static const int RCMAG_TABLE_SIZE = 4096;
 
@@ -121,16 +128,35 @@ public:
 
 	//! Update any time-dependent features.
 	//! Includes fading in and out stars and labels when they are turned on and off.
-	virtual void update(double deltaTime) {labelsFader.update((int)(deltaTime*1000)); starsFader.update((int)(deltaTime*1000));}
+	//! Also makes the star catalogs loaded in the background visible.
+	virtual void update(double deltaTime);
 
 	//! Used to determine the order in which the various StelModules are drawn.
 	virtual double getCallOrder(StelModuleActionName actionName) const;
 
 	///////////////////////////////////////////////////////////////////////////
 	// Methods defined in StelObjectManager class
-	//! Return a list containing the stars located inside the limFov circle around position v
+	//! Return a list containing the stars located inside the limFov circle around position v.
+	//! Only the stars brighter than the limiting magnitude of the sky drawer are returned, at most
+	//! the 1000 nearest ones.
 	virtual QList<StelObjectP > searchAround(const Vec3d& v, double limitFov, const StelCore* core) const;
 
+	//! Find the stars located inside a cone, in all the loaded catalogs.
+	//! Unlike the drawing, the search is not limited by the current field of view or limiting magnitude.
+	//! @param v the direction of the cone axis in the J2000 frame
+	//! @param limitFov the radius of the cone in degrees
+	//! @param maxMag only stars at least as bright as this magnitude are returned
+	//! @param maxNb the maximum number of stars to return, or -1 for no limit
+	//! @return the stars sorted by increasing angular distance to @em v
+	QList<StelObjectP > searchCone(const Vec3d& v, double limitFov, const StelCore* core, float maxMag=99.f, int maxNb=-1) const;
+
+	//! Find the stars nearest to a direction, in all the loaded catalogs.
+	//! @param v a direction in the J2000 frame
+	//! @param n the number of stars to return
+	//! @param maxMag only stars at least as bright as this magnitude are returned
+	//! @return at most @em n stars sorted by increasing angular distance to @em v
+	QList<StelObjectP > searchNearest(const Vec3d& v, int n, const StelCore* core, float maxMag=99.f) const;
+
 	//! Return the matching Stars object's pointer if exists or NULL
 	//! @param nameI18n The case in-sensistive star common name or HP
 	//! catalog name (format can be HP1234 or HP 1234 or HIP 1234) or sci name
@@ -189,6 +215,23 @@ public slots:
 	static void setFlagSciNames(bool f) {flagSciNames = f;}
 	static bool getFlagSciNames(void) {return flagSciNames;}
 
+	//! Set whether the star zones are computed by a pool of worker threads.
+	void setFlagMultithreadedDraw(bool b);
+	//! Get whether the star zones are computed by a pool of worker threads.
+	bool getFlagMultithreadedDraw(void) const {return flagMultithreadedDraw;}
+
+	//! Set the number of worker threads used for drawing stars.
+	//! @param n the number of threads, or 0 to use the number of CPU cores.
+	void setDrawThreadCount(int n);
+	//! Get the number of worker threads used for drawing stars (0 means the number of CPU cores).
+	int getDrawThreadCount(void) const {return drawThreadCount;}
+
+	//! Set whether the stars computed for a zone are reused at the next frames as long as the
+	//! view, date, extinction and magnitude settings do not change.
+	void setFlagDrawCache(bool b) {flagDrawCache = b;}
+	//! Get whether the stars computed for a zone are reused between frames.
+	bool getFlagDrawCache(void) const {return flagDrawCache;}
+
 public:
 	///////////////////////////////////////////////////////////////////////////
 	// Other methods
@@ -317,6 +360,9 @@ public:
 	//! @return false in case of failure.
 	bool checkAndLoadCatalog(const QVariantMap& m);
 
+	//! Get whether deep star catalogs are still being loaded in the background.
+	bool isLoadingCatalogs() const {return catalogLoader!=NULL;}
+
 private slots:
 	//! Translate text.
 	void updateI18n();
@@ -330,8 +376,20 @@ signals:
 	void starLabelsDisplayedChanged(const bool displayed);
 	void starsDisplayedChanged(const bool displayed);
 	void labelsAmountChanged(float a);
+	//! Emitted each time a star catalog loaded in the background becomes visible.
+	//! @param loaded the number of background catalogs processed so far
+	//! @param total the number of catalogs to load in the background
+	void catalogLoadingProgress(int loaded, int total);
 
 private:
+	//! A catalog to load in the background.
+	struct BackgroundCatalog
+	{
+		QString id;
+		QString path;
+		//! The expected MD5 sum if the file must be verified before loading, else empty.
+		QByteArray checksum;
+	};
 
 	void setCheckFlag(const QString& catalogId, bool b);
 
@@ -367,6 +425,41 @@ private:
 	//! Load all the stars from the files.
 	void loadData(QVariantMap starsConfigFile);
 
+	//! Find the file of a catalog and check its MD5 sum if it is not marked as checked,
+	//! unless the sum of this very file is in the checksum cache.
+	//! @param pendingChecksum if not NULL, the MD5 sum is not computed but the expected
+	//! sum is returned there, and the caller must verify the file with verifyCatalog().
+	//! @return the path of the catalog, or an empty string if it can't be loaded.
+	QString findCatalog(const QVariantMap& catDesc, QByteArray* pendingChecksum=NULL);
+
+	//! Compute the MD5 sum of a catalog file and compare it to the expected one.
+	//! The file is removed if it is corrupt. Can be called from any thread.
+	static bool verifyCatalog(const QString& catalogFilePath, const QByteArray& checksum);
+
+	//! Load the checksums of the catalog files verified in previous sessions.
+	void loadChecksumCache();
+	//! Whether a catalog file with the given checksum was verified and is unchanged since.
+	bool isChecksumCached(const QString& catalogFilePath, const QByteArray& checksum) const;
+	//! Remember that a catalog file was verified, along with its size and modification time.
+	void cacheChecksum(const QString& catalogFilePath, const QByteArray& checksum);
+
+	//! Find the stars inside a cone without wrapping them into StelObjects.
+	void searchConeHits(const Vec3d& v, double limitFov, const StelCore* core, float maxMag, QVector<StarSearchHit>& hits) const;
+	//! Sort the stars found by searchConeHits() and wrap the nearest @em maxNb ones into StelObjects.
+	static QList<StelObjectP > createSearchResult(QVector<StarSearchHit>& hits, int maxNb);
+
+	//! Append a loaded catalog to gridLevels.
+	//! @return false if its level is already loaded, in which case @em z is deleted.
+	bool appendZoneArray(ZoneArray* z);
+
+	//! Load catalogs one after the other in a worker thread.
+	//! The catalogs are prepared for drawing and queued for publishLoadedCatalogs().
+	void loadCatalogsInBackground(const QList<BackgroundCatalog>& catalogs);
+
+	//! Make the catalogs loaded in the background visible to draw() and searchAround().
+	//! Called from the main thread, so that a level appears atomically between two frames.
+	void publishLoadedCatalogs();
+
 	//! Draw a nice animated pointer around the object.
 	void drawPointer(StelPainter& sPainter, const StelCore* core);
 
@@ -378,7 +471,34 @@ private:
 	bool gravityLabel;
 
 	int maxGeodesicGridLevel;
-	int lastMaxSearchLevel;
+
+	//! Whether star zones are computed in drawThreadPool.
+	bool flagMultithreadedDraw;
+	//! Number of threads of drawThreadPool, 0 for QThread::idealThreadCount().
+	int drawThreadCount;
+	QThreadPool* drawThreadPool;
+	//! Whether the computed zones are reused between frames.
+	bool flagDrawCache;
+	//! Point sources and labels computed for each drawn zone.
+	StarDrawCache* drawCache;
+
+	//! Catalogs from this index on are loaded in the background, or all at startup if negative.
+	int backgroundLoadingLevel;
+	//! Catalogs loaded in the background.
+	QList<BackgroundCatalog> backgroundCatalogs;
+	//! Number of background catalogs published so far.
+	int nbPublishedCatalogs;
+	QFuture<void>* catalogLoader;
+	//! Catalogs loaded by catalogLoader and not published yet. NULL for failed catalogs.
+	QList<ZoneArray*> loadedCatalogs;
+	//! Catalogs verified by catalogLoader, to be marked as checked by publishLoadedCatalogs().
+	QList<BackgroundCatalog> verifiedCatalogs;
+	QMutex loadedCatalogsMutex;
+
+	//! Size, modification time and MD5 sum of the verified catalog files, by path.
+	QVariantMap checksumCache;
+	QString checksumCacheFilePath;
+	QAtomicInt abortCatalogLoading;
 	
 	// A ZoneArray per grid level
 	QVector<ZoneArray*> gridLevels;
@@ -400,25 +520,15 @@ private:
 
 	static QHash<int, QString> commonNamesMap;     // the original names from skyculture (star_names.fab)
 	static QHash<int, QString> commonNamesMapI18n; // translated names
-	static QMap<QString, int> commonNamesIndexI18n;
-	static QMap<QString, int> commonNamesIndex;
-
-	static QHash<int, QString> sciNamesMapI18n;	
-	static QMap<QString, int> sciNamesIndexI18n;
-
+	static QHash<int, QString> sciNamesMapI18n;
 	static QHash<int, QString> sciAdditionalNamesMapI18n;
-	static QMap<QString, int> sciAdditionalNamesIndexI18n;
-
 	static QHash<int, varstar> varStarsMapI18n;
-	static QMap<QString, int> varStarsIndexI18n;
-
 	static QHash<int, wds> wdsStarsMapI18n;
-	static QMap<QString, int> wdsStarsIndexI18n;
-
 	static QHash<int, int> saoStarsMap;
-	static QMap<int, int> saoStarsIndex;
 	static QHash<int, int> hdStarsMap;
-	static QMap<int, int> hdStarsIndex;
+
+	//! Reverse index of all the designations above, giving the HIP number.
+	static StarDesignationIndex designationIndex;
 
 	QFont starFont;
 	static bool flagSciNames;
@@ -0,0 +1,229 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarPositionKernel.hpp"
+#include "StelSphereGeometry.hpp"
+#include "StelSimd.hpp"
+
+#include <cmath>
+
+StarKernelCaps::StarKernelCaps(const QVector<SphericalCap>& caps)
+{
+	nx.reserve(caps.size());
+	ny.reserve(caps.size());
+	nz.reserve(caps.size());
+	d.reserve(caps.size());
+	foreach (const SphericalCap& cap, caps)
+	{
+		nx.append(cap.n[0]);
+		ny.append(cap.n[1]);
+		nz.append(cap.n[2]);
+		d.append(cap.d);
+	}
+}
+
+namespace
+{
+	//! The star columns of a block, see StarPositionKernel::compute().
+	struct Columns
+	{
+		const float* x0;
+		const float* x1;
+		const float* dx0;
+		const float* dx1;
+		int size;
+	};
+
+	typedef void (*KernelFunc)(const ZoneData*, float, const Columns&, const StarKernelCaps&, StarBlockPositions&);
+
+	void computeScalar(const ZoneData* z, float mf, const Columns& b, const StarKernelCaps& caps, StarBlockPositions& out)
+	{
+		out.visible = 0;
+		const int nbCaps = caps.size();
+		for (int i=0;i<b.size;++i)
+		{
+			const float a0 = b.x0[i]+mf*b.dx0[i];
+			const float a1 = b.x1[i]+mf*b.dx1[i];
+			float x = z->axis0[0]*a0 + a1*z->axis1[0] + z->center[0];
+			float y = z->axis0[1]*a0 + a1*z->axis1[1] + z->center[1];
+			float w = z->axis0[2]*a0 + a1*z->axis1[2] + z->center[2];
+			const float s = 1.f/std::sqrt(x*x+y*y+w*w);
+			x*=s; y*=s; w*=s;
+			out.x[i]=x; out.y[i]=y; out.z[i]=w;
+			bool visible = true;
+			for (int c=0;c<nbCaps && visible;++c)
+				visible = x*caps.nx[c]+y*caps.ny[c]+w*caps.nz[c] >= caps.d[c];
+			if (visible)
+				out.visible |= Q_UINT64_C(1)<<i;
+		}
+	}
+
+#ifdef STEL_SIMD_X86
+	STEL_TARGET_SSE2
+	void computeSSE2(const ZoneData* z, float mf, const Columns& b, const StarKernelCaps& caps, StarBlockPositions& out)
+	{
+		const __m128 vmf = _mm_set1_ps(mf);
+		const __m128 ax0 = _mm_set1_ps(z->axis0[0]), ay0 = _mm_set1_ps(z->axis0[1]), az0 = _mm_set1_ps(z->axis0[2]);
+		const __m128 ax1 = _mm_set1_ps(z->axis1[0]), ay1 = _mm_set1_ps(z->axis1[1]), az1 = _mm_set1_ps(z->axis1[2]);
+		const __m128 cx = _mm_set1_ps(z->center[0]), cy = _mm_set1_ps(z->center[1]), cz = _mm_set1_ps(z->center[2]);
+		const __m128 one = _mm_set1_ps(1.f);
+		const int nbCaps = caps.size();
+		quint64 visible = 0;
+		for (int i=0;i<b.size;i+=4)
+		{
+			const __m128 a0 = _mm_add_ps(_mm_loadu_ps(b.x0+i), _mm_mul_ps(vmf, _mm_loadu_ps(b.dx0+i)));
+			const __m128 a1 = _mm_add_ps(_mm_loadu_ps(b.x1+i), _mm_mul_ps(vmf, _mm_loadu_ps(b.dx1+i)));
+			__m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax0, a0), _mm_mul_ps(a1, ax1)), cx);
+			__m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ay0, a0), _mm_mul_ps(a1, ay1)), cy);
+			__m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(az0, a0), _mm_mul_ps(a1, az1)), cz);
+			const __m128 l2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(w, w));
+			const __m128 s = _mm_div_ps(one, _mm_sqrt_ps(l2));
+			x = _mm_mul_ps(x, s);
+			y = _mm_mul_ps(y, s);
+			w = _mm_mul_ps(w, s);
+			_mm_storeu_ps(out.x+i, x);
+			_mm_storeu_ps(out.y+i, y);
+			_mm_storeu_ps(out.z+i, w);
+			__m128 mask = _mm_cmpeq_ps(one, one);
+			for (int c=0;c<nbCaps;++c)
+			{
+				const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(caps.nx[c])), _mm_mul_ps(y, _mm_set1_ps(caps.ny[c]))), _mm_mul_ps(w, _mm_set1_ps(caps.nz[c])));
+				mask = _mm_and_ps(mask, _mm_cmpge_ps(dot, _mm_set1_ps(caps.d[c])));
+			}
+			visible |= ((quint64)_mm_movemask_ps(mask))<<i;
+		}
+		// Clear the bits of the padding entries
+		out.visible = b.size<64 ? visible & ((Q_UINT64_C(1)<<b.size)-1) : visible;
+	}
+
+	STEL_TARGET_AVX2
+	void computeAVX2(const ZoneData* z, float mf, const Columns& b, const StarKernelCaps& caps, StarBlockPositions& out)
+	{
+		const __m256 vmf = _mm256_set1_ps(mf);
+		const __m256 ax0 = _mm256_set1_ps(z->axis0[0]), ay0 = _mm256_set1_ps(z->axis0[1]), az0 = _mm256_set1_ps(z->axis0[2]);
+		const __m256 ax1 = _mm256_set1_ps(z->axis1[0]), ay1 = _mm256_set1_ps(z->axis1[1]), az1 = _mm256_set1_ps(z->axis1[2]);
+		const __m256 cx = _mm256_set1_ps(z->center[0]), cy = _mm256_set1_ps(z->center[1]), cz = _mm256_set1_ps(z->center[2]);
+		const __m256 one = _mm256_set1_ps(1.f);
+		const int nbCaps = caps.size();
+		quint64 visible = 0;
+		for (int i=0;i<b.size;i+=8)
+		{
+			const __m256 a0 = _mm256_add_ps(_mm256_loadu_ps(b.x0+i), _mm256_mul_ps(vmf, _mm256_loadu_ps(b.dx0+i)));
+			const __m256 a1 = _mm256_add_ps(_mm256_loadu_ps(b.x1+i), _mm256_mul_ps(vmf, _mm256_loadu_ps(b.dx1+i)));
+			__m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax0, a0), _mm256_mul_ps(a1, ax1)), cx);
+			__m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ay0, a0), _mm256_mul_ps(a1, ay1)), cy);
+			__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(az0, a0), _mm256_mul_ps(a1, az1)), cz);
+			const __m256 l2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(w, w));
+			const __m256 s = _mm256_div_ps(one, _mm256_sqrt_ps(l2));
+			x = _mm256_mul_ps(x, s);
+			y = _mm256_mul_ps(y, s);
+			w = _mm256_mul_ps(w, s);
+			_mm256_storeu_ps(out.x+i, x);
+			_mm256_storeu_ps(out.y+i, y);
+			_mm256_storeu_ps(out.z+i, w);
+			__m256 mask = _mm256_cmp_ps(one, one, _CMP_EQ_OQ);
+			for (int c=0;c<nbCaps;++c)
+			{
+				const __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(caps.nx[c])), _mm256_mul_ps(y, _mm256_set1_ps(caps.ny[c]))), _mm256_mul_ps(w, _mm256_set1_ps(caps.nz[c])));
+				mask = _mm256_and_ps(mask, _mm256_cmp_ps(dot, _mm256_set1_ps(caps.d[c]), _CMP_GE_OQ));
+			}
+			visible |= ((quint64)_mm256_movemask_ps(mask))<<i;
+		}
+		// Clear the bits of the padding entries
+		out.visible = b.size<64 ? visible & ((Q_UINT64_C(1)<<b.size)-1) : visible;
+	}
+#endif // STEL_SIMD_X86
+
+	StarPositionKernel::Implementation detectBestImplementation()
+	{
+#ifdef STEL_SIMD_X86
+		if (StelSimd::cpuHasAVX2())
+			return StarPositionKernel::AVX2;
+		if (StelSimd::cpuHasSSE2())
+			return StarPositionKernel::SSE2;
+#endif
+		return StarPositionKernel::Scalar;
+	}
+
+	KernelFunc kernelFor(StarPositionKernel::Implementation impl)
+	{
+		switch (impl)
+		{
+#ifdef STEL_SIMD_X86
+			case StarPositionKernel::AVX2:
+				return &computeAVX2;
+			case StarPositionKernel::SSE2:
+				return &computeSSE2;
+#endif
+			default:
+				return &computeScalar;
+		}
+	}
+
+	const StarPositionKernel::Implementation bestImplementation = detectBestImplementation();
+	StarPositionKernel::Implementation currentImplementation = bestImplementation;
+	KernelFunc currentKernel = kernelFor(bestImplementation);
+}
+
+StarPositionKernel::Implementation StarPositionKernel::getBestImplementation()
+{
+	return bestImplementation;
+}
+
+StarPositionKernel::Implementation StarPositionKernel::getImplementation()
+{
+	return currentImplementation;
+}
+
+void StarPositionKernel::setImplementation(Implementation impl)
+{
+	if (impl>bestImplementation)
+		impl = bestImplementation;
+	currentImplementation = impl;
+	currentKernel = kernelFor(impl);
+}
+
+const char* StarPositionKernel::implementationName(Implementation impl)
+{
+	switch (impl)
+	{
+		case AVX2:
+			return "AVX2";
+		case SSE2:
+			return "SSE2";
+		default:
+			return "scalar";
+	}
+}
+
+void StarPositionKernel::compute(const ZoneData* z, float movementFactor, const StarBlock& block, const StarKernelCaps& caps, StarBlockPositions& out)
+{
+	const Columns columns = {block.x0, block.x1, block.dx0, block.dx1, block.size};
+	currentKernel(z, movementFactor, columns, caps, out);
+}
+
+void StarPositionKernel::compute(const ZoneData* z, float movementFactor, const float* x0, const float* x1,
+				 const float* dx0, const float* dx1, int n, const StarKernelCaps& caps, StarBlockPositions& out)
+{
+	Q_ASSERT(n>0 && n<=STAR_BLOCK_SIZE);
+	// Stars without proper motion
+	static const float zeros[STAR_BLOCK_SIZE] = {0.f};
+	const Columns columns = {x0, x1, dx0 ? dx0 : zeros, dx1 ? dx1 : zeros, n};
+	currentKernel(z, movementFactor, columns, caps, out);
+}
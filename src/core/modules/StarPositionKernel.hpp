@@ -0,0 +1,155 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STARPOSITIONKERNEL_HPP_
+#define _STARPOSITIONKERNEL_HPP_
+
+#include "ZoneData.hpp"
+#include "Star.hpp"
+
+#include <QtGlobal>
+#include <QVector>
+
+class SphericalCap;
+
+//! Number of stars handled by one call to StarPositionKernel::compute().
+//! Must be a multiple of 8 (the AVX2 vector width) and at most 64 (bits of the visibility mask).
+#define STAR_BLOCK_SIZE 64
+
+//! @struct StarBlock
+//! Positions and proper motions of a block of consecutive stars of a zone,
+//! unpacked from the Star1/Star2/Star3 records into a structure of arrays.
+//! Entries past @em size are zero so that the kernels may run on full vectors.
+struct StarBlock
+{
+	int size;
+	float x0[STAR_BLOCK_SIZE];
+	float x1[STAR_BLOCK_SIZE];
+	float dx0[STAR_BLOCK_SIZE];
+	float dx1[STAR_BLOCK_SIZE];
+
+	//! Unpack up to STAR_BLOCK_SIZE stars starting at @em stars.
+	//! @tparam Star either Star1, Star2 or Star3.
+	template <class Star>
+	void unpack(const Star* stars, int n)
+	{
+		Q_ASSERT(n>0 && n<=STAR_BLOCK_SIZE);
+		size = n;
+		int i=0;
+		for (;i<n;++i)
+		{
+			x0[i] = stars[i].getX0();
+			x1[i] = stars[i].getX1();
+			dx0[i] = getDx0(stars[i]);
+			dx1[i] = getDx1(stars[i]);
+		}
+		for (;i<STAR_BLOCK_SIZE;++i)
+			x0[i] = x1[i] = dx0[i] = dx1[i] = 0.f;
+	}
+
+private:
+	// Star3 has no proper motion.
+	template <class Star> static float getDx0(const Star& s) {return s.getDx0();}
+	template <class Star> static float getDx1(const Star& s) {return s.getDx1();}
+	static float getDx0(const Star3&) {return 0.f;}
+	static float getDx1(const Star3&) {return 0.f;}
+};
+
+//! @struct StarBlockPositions
+//! Output of StarPositionKernel::compute(): normalized J2000 positions of a
+//! StarBlock and a bit mask of the stars lying inside all the bounding caps.
+struct StarBlockPositions
+{
+	float x[STAR_BLOCK_SIZE];
+	float y[STAR_BLOCK_SIZE];
+	float z[STAR_BLOCK_SIZE];
+	//! Bit i is set when star i is inside all the caps.
+	quint64 visible;
+
+	Vec3f getPos(int i) const {return Vec3f(x[i], y[i], z[i]);}
+	bool isVisible(int i) const {return (visible>>i) & 1;}
+
+	//! Compute the sine of the geometric altitude of all the stars of the block.
+	//! @param zenith the zenith in J2000 frame, as given by StelSkyDrawer::getJ2000Zenith()
+	void computeSinAltitudes(const Vec3f& zenith, float* sinAlt) const
+	{
+		for (int i=0;i<STAR_BLOCK_SIZE;++i)
+			sinAlt[i] = x[i]*zenith[0] + y[i]*zenith[1] + z[i]*zenith[2];
+	}
+};
+
+//! @struct StarKernelCaps
+//! The bounding caps of the viewport, in the flat layout used by the kernels.
+struct StarKernelCaps
+{
+	StarKernelCaps() {}
+	explicit StarKernelCaps(const QVector<SphericalCap>& caps);
+
+	QVector<float> nx;
+	QVector<float> ny;
+	QVector<float> nz;
+	QVector<float> d;
+	int size() const {return d.size();}
+	bool operator==(const StarKernelCaps& o) const {return nx==o.nx && ny==o.ny && nz==o.nz && d==o.d;}
+};
+
+//! @namespace StarPositionKernel
+//! Batched computation of the star positions used by SpecialZoneArray::draw().
+//! For a block of stars, the kernel applies the proper motion, converts the zone relative
+//! coordinates to a normalized J2000 vector and tests it against all the viewport caps.
+//! The SSE2 or AVX2 implementation is chosen at runtime according to the CPU, with a
+//! scalar fallback for other architectures. All implementations perform the same float
+//! operations in the same order as Star::getJ2000Pos() followed by Vec3f::normalize(),
+//! so the results only differ by float rounding of the normalization and the cap tests.
+namespace StarPositionKernel
+{
+	enum Implementation
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	//! Get the implementation currently used by compute().
+	Implementation getImplementation();
+	//! Force the implementation used by compute(), e.g. for benchmarking.
+	//! Requesting an implementation not supported by the CPU falls back to the best supported one.
+	void setImplementation(Implementation impl);
+	//! Get the best implementation supported by the CPU.
+	Implementation getBestImplementation();
+	//! Get a readable name for an implementation.
+	const char* implementationName(Implementation impl);
+
+	//! Compute the normalized J2000 positions and visibility mask of a block of stars.
+	//! @param z the zone containing the stars, with axes already scaled by ZoneArray::scaleAxis()
+	//! @param movementFactor the proper motion factor as computed in SpecialZoneArray::draw()
+	//! @param block the unpacked stars
+	//! @param caps the caps which a visible star must be inside of. If empty, all stars are visible.
+	//! @param out the positions and visibility mask
+	void compute(const ZoneData* z, float movementFactor, const StarBlock& block, const StarKernelCaps& caps, StarBlockPositions& out);
+
+	//! Same as above, for stars already stored in columns, e.g. in a memory mapped catalog.
+	//! The SIMD implementations read the columns up to @em n rounded up to a multiple of 8.
+	//! @param dx0,dx1 the proper motion columns, or NULL for stars without proper motion
+	//! @param n the number of stars, at most STAR_BLOCK_SIZE
+	void compute(const ZoneData* z, float movementFactor, const float* x0, const float* x1,
+		     const float* dx0, const float* dx1, int n, const StarKernelCaps& caps, StarBlockPositions& out);
+}
+
+#endif // _STARPOSITIONKERNEL_HPP_
@@ -305,3 +305,27 @@ StelObjectP Star3::createStelObject(const SpecialZoneArray<Star3> *a,
   return StelObjectP(new StarWrapper3(a,z,this), true);
 }
 
+
+Vec3d StarWrapperColumnar::getJ2000EquatorialPos(const StelCore* core) const
+{
+	static const double d2000 = 2451545.0;
+	Vec3f v;
+	a->getJ2000Pos(z, slot, (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25) / a->star_position_scale, v);
+	return Vec3d(v[0], v[1], v[2]);
+}
+
+Vec3f StarWrapperColumnar::getInfoColor(void) const
+{
+	return StelSkyDrawer::indexToColor(a->getBVIndex(slot));
+}
+
+float StarWrapperColumnar::getVMagnitude(const StelCore* core) const
+{
+	Q_UNUSED(core);
+	return 0.001f*a->mag_min + a->getMag(slot)*(0.001f*a->mag_range)/a->mag_steps;
+}
+
+float StarWrapperColumnar::getBV(void) const
+{
+	return IndexToBV(a->getBVIndex(slot));
+}
@@ -31,6 +31,8 @@
 
 template <class Star> class SpecialZoneArray;
 template <class Star> struct SpecialZoneData;
+class ColumnarZoneArray;
+struct ZoneData;
 
 
 //! @class StarWrapperBase
@@ -140,5 +142,27 @@ public:
 			   const Star3 *s) : StarWrapper<Star3>(a,z,s) {;}
 };
 
+//! @class StarWrapperColumnar
+//! StarWrapper of a star of a catalog in the columnar format. Such a star is
+//! identified by its slot in the columns of its ColumnarZoneArray.
+class StarWrapperColumnar : public StarWrapperBase
+{
+public:
+	StarWrapperColumnar(const ColumnarZoneArray *a,
+			    const ZoneData *z,
+			    quint32 slot) : a(a), z(z), slot(slot) {;}
+protected:
+	Vec3d getJ2000EquatorialPos(const StelCore* core) const;
+	Vec3f getInfoColor(void) const;
+	float getVMagnitude(const StelCore* core) const;
+	float getBV(void) const;
+	QString getEnglishName(void) const {return QString();}
+	QString getNameI18n(void) const {return QString();}
+	virtual double getAngularSize(const StelCore*) const {return 0.;}
+private:
+	const ColumnarZoneArray *const a;
+	const ZoneData *const z;
+	const quint32 slot;
+};
 
 #endif // _STARWRAPPER_HPP_
@@ -23,6 +23,7 @@
 #include "StelGeodesicGrid.hpp"
 #include "StelObject.hpp"
 #include "StelPainter.hpp"
+#include "StarWrapper.hpp"
 
 #include <QDebug>
 #include <QFile>
@@ -31,6 +32,10 @@
 #include <io.h>
 #include <windows.h>
 #endif
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 
 static unsigned int stel_bswap_32(unsigned int val)
@@ -114,6 +119,47 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 		qDebug() << dbStr;
 		return 0;
 	}
+	if (magic == FILE_MAGIC_COLUMNAR)
+	{
+		ColumnarCatalogHeader header;
+		if (!file->seek(0) || file->read((char*)&header, sizeof(header)) != (qint64)sizeof(header))
+		{
+			dbStr += "error - file format is bad.";
+			qDebug() << dbStr;
+			return 0;
+		}
+		dbStr += QString("%1_%2v%3_%4 columnar; ").arg(level).arg(type).arg(major).arg(minor);
+		if (header.major != COLUMNAR_FILE_VERSION)
+		{
+			dbStr += "warning - unsupported version";
+			qDebug() << dbStr;
+			return 0;
+		}
+		if (header.type != 1 && header.type != 2)
+		{
+			dbStr += "error - bad file type";
+			qDebug() << dbStr;
+			return 0;
+		}
+		ColumnarZoneArray* rval = new ColumnarZoneArray(file, header, use_mmap);
+		if (!rval->isInitialized())
+		{
+			dbStr += " - initialization failed";
+			qDebug() << dbStr;
+			delete rval;
+			return 0;
+		}
+		dbStr += QString("%1").arg(rval->getNrOfStars());
+		qDebug() << dbStr;
+		return rval;
+	}
+	if (magic == stel_bswap_32(FILE_MAGIC_COLUMNAR))
+	{
+		// columnar catalogs are used as is and cannot be byte swapped
+		dbStr += "error - columnar catalogue was converted on a machine with a different byte order.";
+		qDebug() << dbStr;
+		return 0;
+	}
 	const bool byte_swap = (magic == FILE_MAGIC_OTHER_ENDIAN);
 	if (byte_swap)
 	{
@@ -434,6 +480,21 @@ SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mm
 	}
 }
 
+template<class Star>
+void SpecialZoneArray<Star>::prefetch() const
+{
+#ifdef Q_OS_UNIX
+	if (mmap_start)
+	{
+		// posix_madvise() requires a page aligned address
+		const quintptr pageSize = sysconf(_SC_PAGESIZE);
+		const quintptr begin = (quintptr)mmap_start & ~(pageSize-1);
+		const quintptr end = (quintptr)mmap_start + sizeof(Star)*nr_of_stars;
+		posix_madvise((void*)begin, end-begin, POSIX_MADV_WILLNEED);
+	}
+#endif
+}
+
 template<class Star>
 SpecialZoneArray<Star>::~SpecialZoneArray(void)
 {
@@ -460,18 +521,19 @@ SpecialZoneArray<Star>::~SpecialZoneArray(void)
 }
 
 template<class Star>
-void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
-				  int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness,
-				  const QVector<SphericalCap> &boundingCaps) const
+void SpecialZoneArray<Star>::draw(StarDrawBuffer& buffer, const StelProjector* prj, int index, bool isInsideViewport, const RCMag* rcmag_table,
+				  int limitMagIndex, const StelCore* core, int maxMagStarName,
+				  const StarKernelCaps& boundingCaps) const
 {
-	StelSkyDrawer* drawer = core->getSkyDrawer();
+	const StelSkyDrawer* drawer = core->getSkyDrawer();
 	Vec3f vf;
 	static const double d2000 = 2451545.0;
 	const float movementFactor = (M_PI/180)*(0.0001/3600) * ((core->getJDE()-d2000)/365.25) / star_position_scale;
 
 	// GZ, added for extinction
-	const Extinction& extinction=core->getSkyDrawer()->getExtinction();
-	const bool withExtinction=drawer->getFlagHasAtmosphere() && extinction.getExtinctionCoefficient()>=0.01f;
+	const ExtinctionTable& extinction=drawer->getExtinctionTable();
+	const bool withExtinction=drawer->getFlagHasAtmosphere() && drawer->getExtinction().getExtinctionCoefficient()>=0.01f;
+	const Vec3f& zenith=drawer->getJ2000Zenith();
 	const float k = 0.001f*mag_range/mag_steps; // from StarMgr.cpp line 654
 	
 	// Allow artificial cutoff:
@@ -485,10 +547,17 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 	}
 	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
     
+	StelSkyDrawer::PointSource ps;
+	StarBlock block;
+	StarBlockPositions blockPos;
+	float sinAlt[STAR_BLOCK_SIZE];
+	int i = 0;
+
 	// Go through all stars, which are sorted by magnitude (bright stars first)
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
-	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
-	for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
+	const Star* firstStar = zoneToDraw->getStars();
+	const Star* lastStar = firstStar + zoneToDraw->size;
+	for (const Star* s=firstStar;s<lastStar;++s)
 	{
 		// Artifical cutoff per magnitude
 		if (s->getMag() > cutoffMagStep)
@@ -499,71 +568,371 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 		// Array of 2 numbers containing radius and magnitude
 		const RCMag* tmpRcmag = &rcmag_table[s->getMag()];
 		
-		// Get the star position from the array
-		s->getJ2000Pos(zoneToDraw, movementFactor, vf);
-		
-		// If the star zone is not strictly contained inside the viewport, eliminate from the 
-		// beginning the stars actually outside viewport.
-		if (!isInsideViewport)
+		if (isInsideViewport)
 		{
-			vf.normalize();
-			bool isVisible = true;
-			foreach (const SphericalCap& cap, boundingCaps)
+			// Get the star position from the array
+			s->getJ2000Pos(zoneToDraw, movementFactor, vf);
+			if (withExtinction)
+				sinAlt[0] = vf.dot(zenith)/vf.length();
+			i = 0;
+		}
+		else
+		{
+			// If the star zone is not strictly contained inside the viewport, eliminate from the 
+			// beginning the stars actually outside viewport. Positions and visibility are computed
+			// for blocks of stars at once by the vectorized kernel.
+			i = (s-firstStar) % STAR_BLOCK_SIZE;
+			if (i==0)
 			{
-				if (!cap.contains(vf))
+				block.unpack(s, qMin<int>(STAR_BLOCK_SIZE, lastStar-s));
+				StarPositionKernel::compute(zoneToDraw, movementFactor, block, boundingCaps, blockPos);
+				if (blockPos.visible==0)
 				{
-					isVisible = false;
+					// The whole block is outside the viewport
+					s += block.size-1;
 					continue;
 				}
+				if (withExtinction)
+					blockPos.computeSinAltitudes(zenith, sinAlt);
 			}
-			if (!isVisible)
+			if (!blockPos.isVisible(i))
 				continue;
+			vf = blockPos.getPos(i);
 		}
 
 		int extinctedMagIndex = s->getMag();
 		float twinkleFactor=1.0f; // allow height-dependent twinkle.
 		if (withExtinction)
 		{
-			Vec3f altAz(vf);
-			altAz.normalize();
-			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
-			float extMagShift=0.0f;
-			extinction.forward(altAz, &extMagShift);
-			extinctedMagIndex = s->getMag() + (int)(extMagShift/k);
+			extinctedMagIndex = s->getMag() + (int)(extinction.getMagShift(sinAlt[i])/k);
 			if (extinctedMagIndex >= cutoffMagStep) // i.e., if extincted it is dimmer than cutoff, so remove
 				continue;
 			tmpRcmag = &rcmag_table[extinctedMagIndex];
-			twinkleFactor=qMin(1.0f, 1.0f-0.9f*altAz[2]); // suppress twinkling in higher altitudes. Keep 0.1 twinkle amount in zenith.
+			twinkleFactor=StelSkyDrawer::getTwinkleFactor(sinAlt[i]);
 		}
 	
-		if (drawer->drawPointSource(sPainter, vf, *tmpRcmag, s->getBVIndex(), !isInsideViewport, twinkleFactor) && s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
+		if (!drawer->computePointSource(prj, vf, *tmpRcmag, s->getBVIndex(), !isInsideViewport, twinkleFactor, ps))
+			continue;
+		buffer.points.push_back(ps);
+
+		if (s->hasName() && extinctedMagIndex < maxMagStarName && s->hasComponentID()<=1)
 		{
-			const float offset = tmpRcmag->radius*0.7f;
-			const Vec3f colorr = StelSkyDrawer::indexToColor(s->getBVIndex())*0.75f;
-			sPainter->setColor(colorr[0], colorr[1], colorr[2],names_brightness);
-			sPainter->drawText(Vec3d(vf[0], vf[1], vf[2]), s->getNameI18n(), 0, offset, offset, false);
+			StarDrawBuffer::Label label;
+			label.pos = vf;
+			label.color = StelSkyDrawer::indexToColor(s->getBVIndex())*0.75f;
+			label.offset = tmpRcmag->radius*0.7f;
+			label.text = s->getNameI18n();
+			buffer.labels.push_back(label);
 		}
 	}
 }
 
 template<class Star>
-void SpecialZoneArray<Star>::searchAround(const StelCore* core, int index, const Vec3d &v, double cosLimFov,
-					  QList<StelObjectP > &result)
+void SpecialZoneArray<Star>::searchCone(const StelCore* core, int index, const Vec3f& v, float cosLimFov,
+					int maxMagIndex, QVector<StarSearchHit>& hits) const
 {
 	static const double d2000 = 2451545.0;
-	const double movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25)/ star_position_scale;
+	const float movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25)/ star_position_scale;
 	const SpecialZoneData<Star> *const z = getZones()+index;
+	StarSearchHit hit;
+	hit.a = this;
+	hit.zone = index;
 	Vec3f tmp;
-	Vec3f vf(v[0], v[1], v[2]);
-	for (const Star* s=z->getStars();s<z->getStars()+z->size;++s)
+	for (int i=0;i<z->size;++i)
 	{
-		s->getJ2000Pos(z,movementFactor, tmp);
+		const Star& s = z->getStars()[i];
+		// Stars are sorted by magnitude (bright stars first)
+		if (s.getMag() > maxMagIndex)
+			break;
+		s.getJ2000Pos(z, movementFactor, tmp);
 		tmp.normalize();
-		if (tmp*vf >= cosLimFov)
+		hit.cosDistance = tmp*v;
+		if (hit.cosDistance >= cosLimFov)
 		{
-			// TODO: do not select stars that are too faint to display
-			result.push_back(s->createStelObject(this,z));
+			hit.star = i;
+			hits.append(hit);
 		}
 	}
 }
 
+template<class Star>
+StelObjectP SpecialZoneArray<Star>::createStelObject(int index, int star) const
+{
+	const SpecialZoneData<Star> *const z = getZones()+index;
+	return z->getStars()[star].createStelObject(this, z);
+}
+
+
+//! Check that a column of a columnar catalog is aligned and lies inside [begin,end).
+static bool isColumnInside(quint64 offset, quint64 size, quint64 begin, quint64 end)
+{
+	return offset%64 == 0 && begin <= offset && offset + size <= end;
+}
+
+ColumnarZoneArray::ColumnarZoneArray(QFile* file, const ColumnarCatalogHeader& header, bool use_mmap)
+	: ZoneArray(file->fileName(), file, header.level, header.mag_min, header.mag_range, header.mag_steps),
+	  x0(0), x1(0), dx0(0), dx1(0), mag(0), bV(0), mmap_start(0), data(0), columnsSize(0)
+{
+	star_position_scale = header.star_position_scale;
+	if (nr_of_zones == 0)
+		return;
+	if (header.nr_of_zones != nr_of_zones)
+	{
+		qDebug() << "ERROR: ColumnarZoneArray(" << level << "): bad number of zones"
+			 << header.nr_of_zones << "in catalog" << file->fileName();
+		nr_of_zones = 0;
+		return;
+	}
+
+	std::vector<ColumnarZoneRecord> records(nr_of_zones);
+	const qint64 recordsSize = sizeof(ColumnarZoneRecord)*nr_of_zones;
+	if (file->read((char*)&records[0], recordsSize) != recordsSize)
+	{
+		qDebug() << "Error reading zones from catalog:" << file->fileName();
+		nr_of_zones = 0;
+		return;
+	}
+
+	// The columns are stored one after the other, x0 first and bV last.
+	// Check that they lie inside the file, so that a truncated catalog
+	// cannot make us read past the mapping.
+	const quint64 slots = header.nr_of_slots;
+	const quint64 begin = header.x0Offset;
+	const quint64 end = header.bVOffset + slots;
+	const bool hasMotion = (header.type == 1);
+	bool valid = begin >= sizeof(ColumnarCatalogHeader) && end <= (quint64)file->size()
+		     && isColumnInside(header.x0Offset, slots*sizeof(float), begin, end)
+		     && isColumnInside(header.x1Offset, slots*sizeof(float), begin, end)
+		     && isColumnInside(header.magOffset, slots, begin, end)
+		     && isColumnInside(header.bVOffset, slots, begin, end);
+	if (hasMotion)
+		valid = valid && isColumnInside(header.dx0Offset, slots*sizeof(float), begin, end)
+			      && isColumnInside(header.dx1Offset, slots*sizeof(float), begin, end);
+	quint32 nrOfStars = 0;
+	for (unsigned int z=0;valid && z<nr_of_zones;z++)
+	{
+		// the kernel reads the columns by vectors of 8 stars
+		const ColumnarZoneRecord& r = records[z];
+		valid = (r.offset%8 == 0) && (quint64)r.offset + ((r.size+7)&~7u) <= slots;
+		nrOfStars += r.size;
+	}
+	if (!valid || nrOfStars != header.nr_of_stars)
+	{
+		qDebug() << "ERROR: ColumnarZoneArray(" << level << "): bad column layout in catalog" << file->fileName();
+		nr_of_zones = 0;
+		return;
+	}
+
+	columnsSize = end - begin;
+	const char* columns = 0;
+	if (use_mmap)
+	{
+		mmap_start = file->map(begin, columnsSize);
+		if (mmap_start == 0)
+		{
+			qDebug() << "ERROR: ColumnarZoneArray(" << level
+				 << "): QFile(" << file->fileName()
+				 << ").map(" << begin << ',' << columnsSize
+				 << ") failed: " << file->errorString();
+		}
+		columns = (const char*)mmap_start;
+	}
+	if (columns == 0)
+	{
+		data = new char[columnsSize];
+		if (!file->seek(begin) || !readFile(*file, data, columnsSize))
+		{
+			qDebug() << "Error reading columns from catalog:" << file->fileName();
+			delete[] data;
+			data = 0;
+			nr_of_zones = 0;
+			file->close();
+			return;
+		}
+		columns = data;
+	}
+	file->close();
+
+	x0 = (const float*)(columns + (header.x0Offset-begin));
+	x1 = (const float*)(columns + (header.x1Offset-begin));
+	if (hasMotion)
+	{
+		dx0 = (const float*)(columns + (header.dx0Offset-begin));
+		dx1 = (const float*)(columns + (header.dx1Offset-begin));
+	}
+	mag = (const quint8*)(columns + (header.magOffset-begin));
+	bV = (const quint8*)(columns + (header.bVOffset-begin));
+
+	zones = new ZoneData[nr_of_zones];
+	zoneOffsets.resize(nr_of_zones);
+	for (unsigned int z=0;z<nr_of_zones;z++)
+	{
+		const ColumnarZoneRecord& r = records[z];
+		ZoneData& zone = zones[z];
+		zone.center.set(r.center[0], r.center[1], r.center[2]);
+		zone.axis0.set(r.axis0[0], r.axis0[1], r.axis0[2]);
+		zone.axis1.set(r.axis1[0], r.axis1[1], r.axis1[2]);
+		zone.size = r.size;
+		zone.stars = 0;
+		zoneOffsets[z] = r.offset;
+	}
+	nr_of_stars = nrOfStars;
+	if (nr_of_stars == 0)
+	{
+		delete[] zones;
+		zones = 0;
+		nr_of_zones = 0;
+	}
+}
+
+ColumnarZoneArray::~ColumnarZoneArray()
+{
+	if (mmap_start != 0)
+		file->unmap(mmap_start);
+	delete[] data;
+	delete file;
+	delete[] zones;
+	zones = 0;
+	nr_of_zones = 0;
+	nr_of_stars = 0;
+}
+
+void ColumnarZoneArray::prefetch() const
+{
+#ifdef Q_OS_UNIX
+	if (mmap_start)
+	{
+		// posix_madvise() requires a page aligned address
+		const quintptr pageSize = sysconf(_SC_PAGESIZE);
+		const quintptr begin = (quintptr)mmap_start & ~(pageSize-1);
+		const quintptr end = (quintptr)mmap_start + columnsSize;
+		posix_madvise((void*)begin, end-begin, POSIX_MADV_WILLNEED);
+	}
+#endif
+}
+
+float ColumnarZoneArray::getMovementFactor(const StelCore* core) const
+{
+	static const double d2000 = 2451545.0;
+	return (M_PI/180)*(0.0001/3600) * ((core->getJDE()-d2000)/365.25) / star_position_scale;
+}
+
+void ColumnarZoneArray::getJ2000Pos(const ZoneData* z, quint32 slot, float movementFactor, Vec3f& pos) const
+{
+	// same operations as Star2::getJ2000Pos()
+	pos = z->axis0;
+	if (dx0)
+	{
+		pos*=(x0[slot]+movementFactor*dx0[slot]);
+		pos+=(x1[slot]+movementFactor*dx1[slot])*z->axis1;
+	}
+	else
+	{
+		pos*=x0[slot];
+		pos+=x1[slot]*z->axis1;
+	}
+	pos+=z->center;
+}
+
+void ColumnarZoneArray::draw(StarDrawBuffer& buffer, const StelProjector* prj, int index, bool isInsideViewport, const RCMag* rcmag_table,
+			     int limitMagIndex, const StelCore* core, int maxMagStarName,
+			     const StarKernelCaps& boundingCaps) const
+{
+	// Stars of the columnar catalogs have no names
+	Q_UNUSED(maxMagStarName);
+	const StelSkyDrawer* drawer = core->getSkyDrawer();
+	const float movementFactor = getMovementFactor(core);
+
+	const ExtinctionTable& extinction=drawer->getExtinctionTable();
+	const bool withExtinction=drawer->getFlagHasAtmosphere() && drawer->getExtinction().getExtinctionCoefficient()>=0.01f;
+	const Vec3f& zenith=drawer->getJ2000Zenith();
+	const float k = 0.001f*mag_range/mag_steps;
+
+	int cutoffMagStep=limitMagIndex;
+	if (drawer->getFlagStarMagnitudeLimit())
+	{
+		cutoffMagStep = ((int)(drawer->getCustomStarMagnitudeLimit()*1000.f) - mag_min)*mag_steps/mag_range;
+		if (cutoffMagStep>limitMagIndex)
+			cutoffMagStep = limitMagIndex;
+	}
+	Q_ASSERT(cutoffMagStep<RCMAG_TABLE_SIZE);
+
+	// Inside the viewport, the kernel is only used to compute the positions
+	static const StarKernelCaps noCaps;
+	const StarKernelCaps& caps = isInsideViewport ? noCaps : boundingCaps;
+
+	StelSkyDrawer::PointSource ps;
+	StarBlockPositions blockPos;
+	float sinAlt[STAR_BLOCK_SIZE];
+
+	// Go through all stars, which are sorted by magnitude (bright stars first)
+	const ZoneData* zoneToDraw = zones + index;
+	const quint32 firstSlot = zoneOffsets[index];
+	const quint32 lastSlot = firstSlot + zoneToDraw->size;
+	for (quint32 blockSlot=firstSlot;blockSlot<lastSlot;blockSlot+=STAR_BLOCK_SIZE)
+	{
+		// Artifical cutoff per magnitude
+		if (mag[blockSlot] > cutoffMagStep)
+			break;
+		const int n = qMin<quint32>(STAR_BLOCK_SIZE, lastSlot-blockSlot);
+		StarPositionKernel::compute(zoneToDraw, movementFactor, x0+blockSlot, x1+blockSlot,
+					    dx0 ? dx0+blockSlot : 0, dx1 ? dx1+blockSlot : 0, n, caps, blockPos);
+		if (blockPos.visible==0)
+			continue;
+		if (withExtinction)
+			blockPos.computeSinAltitudes(zenith, sinAlt);
+		for (int i=0;i<n;++i)
+		{
+			const int starMag = mag[blockSlot+i];
+			if (starMag > cutoffMagStep)
+				return;
+			if (!blockPos.isVisible(i))
+				continue;
+			const Vec3f vf = blockPos.getPos(i);
+
+			const RCMag* tmpRcmag = &rcmag_table[starMag];
+			float twinkleFactor=1.0f;
+			if (withExtinction)
+			{
+				const int extinctedMagIndex = starMag + (int)(extinction.getMagShift(sinAlt[i])/k);
+				if (extinctedMagIndex >= cutoffMagStep)
+					continue;
+				tmpRcmag = &rcmag_table[extinctedMagIndex];
+				twinkleFactor=StelSkyDrawer::getTwinkleFactor(sinAlt[i]);
+			}
+
+			if (drawer->computePointSource(prj, vf, *tmpRcmag, bV[blockSlot+i], !isInsideViewport, twinkleFactor, ps))
+				buffer.points.push_back(ps);
+		}
+	}
+}
+
+void ColumnarZoneArray::searchCone(const StelCore* core, int index, const Vec3f& v, float cosLimFov,
+				   int maxMagIndex, QVector<StarSearchHit>& hits) const
+{
+	const float movementFactor = getMovementFactor(core);
+	const ZoneData* z = zones+index;
+	const quint32 firstSlot = zoneOffsets[index];
+	StarSearchHit hit;
+	hit.a = this;
+	hit.zone = index;
+	Vec3f tmp;
+	for (int i=0;i<z->size;++i)
+	{
+		if (mag[firstSlot+i] > maxMagIndex)
+			break;
+		getJ2000Pos(z, firstSlot+i, movementFactor, tmp);
+		tmp.normalize();
+		hit.cosDistance = tmp*v;
+		if (hit.cosDistance >= cosLimFov)
+		{
+			hit.star = i;
+			hits.append(hit);
+		}
+	}
+}
+
+StelObjectP ColumnarZoneArray::createStelObject(int index, int star) const
+{
+	return StelObjectP(new StarWrapperColumnar(this, zones+index, zoneOffsets[index]+star), true);
+}
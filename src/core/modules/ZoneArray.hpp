@@ -25,6 +25,7 @@
 
 #include "ZoneData.hpp"
 #include "Star.hpp"
+#include "StarPositionKernel.hpp"
 
 #include "StelCore.hpp"
 #include "StelSkyDrawer.hpp"
@@ -33,6 +34,9 @@
 #include <QString>
 #include <QFile>
 #include <QDebug>
+#include <QVector>
+
+#include <vector>
 
 #ifdef __OpenBSD__
 #include <unistd.h>
@@ -57,6 +61,8 @@ class StelPainter;
 #define FILE_MAGIC_OTHER_ENDIAN 0x0a045f83
 #define FILE_MAGIC_NATIVE 0x835f040b
 #define MAX_MAJOR_FILE_VERSION 0
+#define FILE_MAGIC_COLUMNAR 0x835f040c
+#define COLUMNAR_FILE_VERSION 2
 
 //! @struct HipIndexStruct
 //! Container for Hipparcos information. Stores a pointer to a Hipparcos star,
@@ -68,6 +74,86 @@ struct HipIndexStruct
 	const Star1 *s;
 };
 
+//! @struct StarDrawBuffer
+//! Point sources and labels computed by ZoneArray::draw() for a range of zones.
+//! A buffer is filled without touching any OpenGL state, possibly from a worker
+//! thread, and is flushed on the main thread by StarMgr::draw().
+struct StarDrawBuffer
+{
+	//! A star label waiting to be drawn.
+	struct Label
+	{
+		Vec3f pos;
+		Vec3f color;
+		float offset;
+		QString text;
+	};
+	std::vector<StelSkyDrawer::PointSource> points;
+	std::vector<Label> labels;
+
+	//! Empty the buffer, keeping the allocated memory for the next frame.
+	void clear() {points.clear(); labels.clear();}
+};
+
+//! @struct ColumnarCatalogHeader
+//! Header of a star catalog in the columnar format, as written by util/ConvertCatToColumnar.C.
+//! All values are in the byte order of the machine which converted the catalog.
+//! The header is followed by nr_of_zones ColumnarZoneRecord and by the columns, which
+//! start at the given file offsets, aligned on 64 bytes. Each column has nr_of_slots
+//! entries: the stars of a zone start at a slot multiple of 8, sorted by magnitude,
+//! and the unused slots are filled with zeros.
+struct ColumnarCatalogHeader
+{
+	quint32 magic;			//!< FILE_MAGIC_COLUMNAR
+	quint32 type;			//!< 1 for stars with proper motion (Star2), 2 for stars without (Star3)
+	quint32 major;			//!< COLUMNAR_FILE_VERSION
+	quint32 minor;			//!< Minor version of the original catalog
+	quint32 level;
+	qint32 mag_min;
+	quint32 mag_range;
+	quint32 mag_steps;
+	quint32 nr_of_zones;
+	quint32 nr_of_stars;
+	quint32 nr_of_slots;
+	float star_position_scale;	//!< Already applied to the zone axes
+	quint64 x0Offset;		//!< float column
+	quint64 x1Offset;		//!< float column
+	quint64 dx0Offset;		//!< float column, 0 for type 2
+	quint64 dx1Offset;		//!< float column, 0 for type 2
+	quint64 magOffset;		//!< quint8 column
+	quint64 bVOffset;		//!< quint8 column
+};
+
+//! @struct ColumnarZoneRecord
+//! Zone of a catalog in the columnar format. The axes are already scaled, so that
+//! the J2000 position of a star is center + (x0+movementFactor*dx0)*axis0 + (x1+movementFactor*dx1)*axis1.
+struct ColumnarZoneRecord
+{
+	float center[3];
+	float axis0[3];
+	float axis1[3];
+	quint32 offset;			//!< First slot of the zone
+	quint32 size;			//!< Number of stars in the zone
+	quint32 reserved;
+};
+
+class ZoneArray;
+
+//! @struct StarSearchHit
+//! A star found by ZoneArray::searchCone(). The star is only wrapped into a
+//! StelObject by ZoneArray::createStelObject() once it is part of a search result.
+struct StarSearchHit
+{
+	//! Cosine of the angular distance to the searched direction.
+	float cosDistance;
+	const ZoneArray* a;
+	int zone;
+	//! Index of the star in its zone.
+	int star;
+	//! Nearest stars first.
+	bool operator<(const StarSearchHit& o) const {return cosDistance>o.cosDistance;}
+};
+
 //! @class ZoneArray
 //! Manages all ZoneData structures of a given StelGeodesicGrid level. An
 //! instance of this class is never created directly; the named constructor
@@ -77,11 +163,11 @@ class ZoneArray
 {
 public:
 	//! Named public constructor for ZoneArray. Opens a catalog, reads its
-	//! header info, and creates a SpecialZoneArray or HipZoneArray for
-	//! loading.
+	//! header info, and creates a SpecialZoneArray, HipZoneArray or
+	//! ColumnarZoneArray according to its magic number.
 	//! @param extended_file_name path of the star catalog to load from
 	//! @param use_mmap whether or not to mmap the star catalog
-	//! @return an instance of SpecialZoneArray or HipZoneArray
+	//! @return an instance of SpecialZoneArray, HipZoneArray or ColumnarZoneArray
 	static ZoneArray *create(const QString &extended_file_name, bool use_mmap);
 	virtual ~ZoneArray()
 	{
@@ -94,25 +180,42 @@ public:
 	//! Dummy method that does nothing. See subclass implementation.
 	virtual void updateHipIndex(HipIndexStruct hipIndex[]) const {Q_UNUSED(hipIndex);}
 
-	//! Pure virtual method. See subclass implementation.
-	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
-							  QList<StelObjectP > &result) = 0;
+	//! Find the stars of a zone lying inside a cone.
+	//! @param index the zone to search
+	//! @param v the normalized direction of the cone axis
+	//! @param cosLimFov the cosine of the cone radius
+	//! @param maxMagIndex only stars with a magnitude index up to this one are returned, see getMagIndex()
+	//! @param hits the list to append the stars found to
+	virtual void searchCone(const StelCore* core, int index, const Vec3f& v, float cosLimFov,
+				int maxMagIndex, QVector<StarSearchHit>& hits) const = 0;
+
+	//! Wrap a star found by searchCone() into a StelObject.
+	virtual StelObjectP createStelObject(int index, int star) const = 0;
+
+	//! Get the magnitude index of the faintest stars of this catalog not fainter than @em mag.
+	int getMagIndex(float mag) const
+	{
+		return ((int)(mag*1000.f) - mag_min)*mag_steps/mag_range;
+	}
 
 	//! Pure virtual method. See subclass implementation.
-	virtual void draw(StelPainter* sPainter, int index,bool is_inside,
-					  const RCMag* rcmag_table, int limitMagIndex, StelCore* core,
-					  int maxMagStarName, float names_brightness,
-					  const QVector<SphericalCap>& boundingCaps) const = 0;
+	virtual void draw(StarDrawBuffer& buffer, const StelProjector* prj, int index, bool is_inside,
+					  const RCMag* rcmag_table, int limitMagIndex, const StelCore* core,
+					  int maxMagStarName, const StarKernelCaps& boundingCaps) const = 0;
 
 	//! Get whether or not the catalog was successfully loaded.
 	//! @return @c true if at least one zone was loaded, otherwise @c false
 	bool isInitialized(void) const { return (nr_of_zones>0); }
 
 	//! Initialize the ZoneData struct at the given index.
-	void initTriangle(int index, const Vec3f &c0, const Vec3f &c1, const Vec3f &c2);
+	virtual void initTriangle(int index, const Vec3f &c0, const Vec3f &c1, const Vec3f &c2);
 	
 	virtual void scaleAxis() = 0;
 
+	//! Ask the OS to start reading a memory mapped catalog ahead of its first use.
+	//! Does nothing if the catalog is not memory mapped.
+	virtual void prefetch() const {}
+
 	//! File path of the catalog.
 	const QString fname;
 
@@ -170,23 +273,26 @@ protected:
 		return static_cast<SpecialZoneData<Star>*>(zones);
 	}
 
-	//! Draw stars and their names onto the viewport.
-	//! @param sPainter the painter to use 
+	//! Compute the stars and names of a zone and append them to a draw buffer.
+	//! No OpenGL call is made, so this can run in a worker thread.
+	//! @param buffer the buffer receiving point sources and labels
+	//! @param prj the projector to use
 	//! @param index zone index to draw
 	//! @param isInsideViewport whether the zone is inside the current viewport
 	//! @param rcmag_table table of magnitudes
 	//! @param limitMagIndex index from rcmag_table at which stars are not visible anymore
 	//! @param core core to use for drawing
 	//! @param maxMagStarName magnitude limit of stars that display labels
-	//! @param names_brightness brightness of labels
-	virtual void draw(StelPainter* sPainter, int index, bool isInsideViewport,
-			  const RCMag *rcmag_table, int limitMagIndex, StelCore* core,
-			  int maxMagStarName, float names_brightness,
-			  const QVector<SphericalCap>& boundingCaps) const;
+	//! @param boundingCaps the caps bounding the viewport, used if the zone is not inside the viewport
+	virtual void draw(StarDrawBuffer& buffer, const StelProjector* prj, int index, bool isInsideViewport,
+			  const RCMag *rcmag_table, int limitMagIndex, const StelCore* core,
+			  int maxMagStarName, const StarKernelCaps& boundingCaps) const;
 
 	virtual void scaleAxis();
-	virtual void searchAround(const StelCore* core, int index,const Vec3d &v,double cosLimFov,
-					  QList<StelObjectP > &result);
+	virtual void prefetch() const;
+	virtual void searchCone(const StelCore* core, int index, const Vec3f& v, float cosLimFov,
+				int maxMagIndex, QVector<StarSearchHit>& hits) const;
+	virtual StelObjectP createStelObject(int index, int star) const;
 
 	Star *stars;
 private:
@@ -209,4 +315,54 @@ public:
 	void updateHipIndex(HipIndexStruct hipIndex[]) const;
 };
 
+//! @class ColumnarZoneArray
+//! ZoneArray of a catalog in the columnar format (FILE_MAGIC_COLUMNAR).
+//! The file is memory mapped and used as is: each star property is stored in its own
+//! column which is fed directly to StarPositionKernel, and the zone frames are read from
+//! the file instead of being computed at load time.
+class ColumnarZoneArray : public ZoneArray
+{
+public:
+	//! Load the zones of a catalog and map its columns.
+	//! @param file catalog to load from, positioned after the header
+	//! @param header the catalog header
+	//! @param use_mmap whether to mmap the columns or read them in memory
+	ColumnarZoneArray(QFile* file, const ColumnarCatalogHeader& header, bool use_mmap);
+	~ColumnarZoneArray();
+
+	//! The zone frames are read from the file.
+	virtual void initTriangle(int, const Vec3f&, const Vec3f&, const Vec3f&) {}
+	//! The zone axes are already scaled in the file.
+	virtual void scaleAxis() {}
+	virtual void prefetch() const;
+
+	virtual void draw(StarDrawBuffer& buffer, const StelProjector* prj, int index, bool isInsideViewport,
+			  const RCMag *rcmag_table, int limitMagIndex, const StelCore* core,
+			  int maxMagStarName, const StarKernelCaps& boundingCaps) const;
+	virtual void searchCone(const StelCore* core, int index, const Vec3f& v, float cosLimFov,
+				int maxMagIndex, QVector<StarSearchHit>& hits) const;
+	virtual StelObjectP createStelObject(int index, int star) const;
+
+	//! Get the J2000 position of the star in the given slot.
+	void getJ2000Pos(const ZoneData* z, quint32 slot, float movementFactor, Vec3f& pos) const;
+	//! Get the magnitude index of the star in the given slot.
+	int getMag(quint32 slot) const {return mag[slot];}
+	//! Get the B-V index of the star in the given slot.
+	int getBVIndex(quint32 slot) const {return bV[slot];}
+
+private:
+	float getMovementFactor(const StelCore* core) const;
+
+	std::vector<quint32> zoneOffsets;
+	const float* x0;
+	const float* x1;
+	const float* dx0;
+	const float* dx1;
+	const quint8* mag;
+	const quint8* bV;
+	uchar* mmap_start;
+	char* data;
+	qint64 columnsSize;
+};
+
 #endif // _ZONEARRAY_HPP_
@@ -0,0 +1,262 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "ChebyshevEphemeris.hpp"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QtNumeric>
+#include <QSaveFile>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+	const quint32 FileMagic = 0x43484542;	// "CHEB"
+	// Version 2: the segments which cannot be fitted are marked invalid
+	const qint32 FileVersion = 2;
+
+	// Limits of the length of the segments, in days. The fit of the segments starts with the
+	// longest length, which is halved when a segment fails, and doubled after a few successes.
+	const double MaxSegmentDays = 1024.;
+	const double MinSegmentDays = 1./16.;
+	const int SuccessesBeforeDoubling = 8;
+}
+
+ChebyshevEphemeris::ChebyshevEphemeris()
+	: startJDE(0.)
+	, endJDE(0.)
+	, tolerance(0.)
+	, degree(0)
+{
+}
+
+ChebyshevEphemeris::ChebyshevEphemeris(const QString& theory, int bodyCount, double startJDE, double endJDE, double tolerance, int degree)
+	: theory(theory)
+	, startJDE(startJDE)
+	, endJDE(endJDE)
+	, tolerance(tolerance)
+	, degree(qMax(degree, 2))
+	, bodies(bodyCount)
+{
+}
+
+bool ChebyshevEphemeris::fit(TheoryFunc func, const QAtomicInt* abort)
+{
+	for (int i=0;i<bodies.size();++i)
+	{
+		if (!fitBody(func, i, abort))
+			return false;
+	}
+	return true;
+}
+
+bool ChebyshevEphemeris::fitBody(TheoryFunc func, int body, const QAtomicInt* abort)
+{
+	Q_ASSERT(body>=0 && body<bodies.size());
+	Body fitted;
+	QVector<double> coeffs(3*(degree+1));
+	double length = MaxSegmentDays;
+	int successes = 0;
+	double start = startJDE;
+	fitted.bounds.append(start);
+	while (start<endJDE)
+	{
+		if (abort && abort->load())
+			return false;
+		const double end = qMin(start+length, endJDE);
+		if (!fitSegment(func, body, start, end, coeffs.data()))
+		{
+			if (length>MinSegmentDays)
+			{
+				length *= 0.5;
+				successes = 0;
+				continue;
+			}
+			// Keep the segment, but invalid, so that the theory itself is used for its dates
+			qWarning() << "ChebyshevEphemeris: cannot fit" << theory << "body" << body << "within" << tolerance << "AU at JDE" << start;
+			coeffs[0] = qQNaN();
+		}
+		fitted.bounds.append(end);
+		fitted.coeffs += coeffs;
+		start = end;
+		if (++successes==SuccessesBeforeDoubling && length<MaxSegmentDays)
+		{
+			length *= 2.;
+			successes = 0;
+		}
+	}
+	fitted.bounds.squeeze();
+	fitted.coeffs.squeeze();
+	bodies[body] = fitted;
+	return true;
+}
+
+bool ChebyshevEphemeris::fitSegment(TheoryFunc func, int body, double start, double end, double* coeffs) const
+{
+	const int n = degree+1;
+	const double mid = 0.5*(start+end);
+	const double half = 0.5*(end-start);
+
+	// Interpolate the theory at the Chebyshev nodes
+	QVarLengthArray<double, 3*32> values(3*n);
+	for (int k=0;k<n;++k)
+		func(mid + half*std::cos(M_PI*(k+0.5)/n), body, values.data()+3*k);
+	for (int j=0;j<n;++j)
+	{
+		double sum[3] = {0., 0., 0.};
+		for (int k=0;k<n;++k)
+		{
+			const double t = std::cos(M_PI*j*(k+0.5)/n);
+			for (int c=0;c<3;++c)
+				sum[c] += values[3*k+c]*t;
+		}
+		for (int c=0;c<3;++c)
+			coeffs[c*n+j] = (j==0 ? 1. : 2.)*sum[c]/n;
+	}
+
+	// The last coefficients estimate the truncation error...
+	for (int c=0;c<3;++c)
+	{
+		if (std::fabs(coeffs[c*n+n-1]) + std::fabs(coeffs[c*n+n-2]) > tolerance)
+			return false;
+	}
+	// ...which is checked near the ends of the segment, where it is largest, and in the middle.
+	static const double checks[3] = {-0.995, 0.05, 0.995};
+	for (int i=0;i<3;++i)
+	{
+		double exact[3], approx[3];
+		func(mid + half*checks[i], body, exact);
+		evaluate(coeffs, checks[i], approx);
+		for (int c=0;c<3;++c)
+		{
+			if (!(std::fabs(exact[c]-approx[c]) <= tolerance))
+				return false;
+		}
+	}
+	return true;
+}
+
+void ChebyshevEphemeris::evaluate(const double* coeffs, double x, double xyz[3]) const
+{
+	const int n = degree+1;
+	const double twoX = 2.*x;
+	for (int c=0;c<3;++c)
+	{
+		// Clenshaw recurrence
+		const double* a = coeffs + c*n;
+		double b1 = 0., b2 = 0.;
+		for (int j=degree;j>=1;--j)
+		{
+			const double b0 = twoX*b1 - b2 + a[j];
+			b2 = b1;
+			b1 = b0;
+		}
+		xyz[c] = x*b1 - b2 + a[0];
+	}
+}
+
+bool ChebyshevEphemeris::compute(int body, double jde, double xyz[3]) const
+{
+	if (body<0 || body>=bodies.size())
+		return false;
+	const Body& b = bodies.at(body);
+	if (b.bounds.size()<2 || !(jde>=b.bounds.first() && jde<=b.bounds.last()))
+		return false;
+	int i = std::upper_bound(b.bounds.constBegin(), b.bounds.constEnd(), jde) - b.bounds.constBegin() - 1;
+	i = qMin(i, b.bounds.size()-2);
+	const double start = b.bounds.at(i);
+	const double end = b.bounds.at(i+1);
+	const double* coeffs = b.coeffs.constData() + i*3*(degree+1);
+	if (qIsNaN(coeffs[0]))
+		return false;
+	evaluate(coeffs, (2.*jde-start-end)/(end-start), xyz);
+	return true;
+}
+
+bool ChebyshevEphemeris::save(const QString& fileName) const
+{
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qWarning() << "ChebyshevEphemeris: cannot write" << fileName << file.errorString();
+		return false;
+	}
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_5_2);
+	out << FileMagic << FileVersion << theory << startJDE << endJDE << tolerance << (qint32)degree << (qint32)bodies.size();
+	foreach (const Body& b, bodies)
+		out << b.bounds << b.coeffs;
+	if (out.status()!=QDataStream::Ok)
+	{
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
+bool ChebyshevEphemeris::load(const QString& fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_5_2);
+	quint32 magic;
+	qint32 version, fileDegree, bodyCount;
+	QString fileTheory;
+	double fileStart, fileEnd, fileTolerance;
+	in >> magic >> version;
+	if (in.status()!=QDataStream::Ok || magic!=FileMagic || version!=FileVersion)
+		return false;
+	in >> fileTheory >> fileStart >> fileEnd >> fileTolerance >> fileDegree >> bodyCount;
+	if (in.status()!=QDataStream::Ok || fileTheory!=theory || fileStart!=startJDE || fileEnd!=endJDE
+	    || fileTolerance!=tolerance || fileDegree!=degree || bodyCount!=bodies.size())
+		return false;
+
+	QVector<Body> loaded(bodyCount);
+	for (int i=0;i<bodyCount;++i)
+	{
+		Body& b = loaded[i];
+		in >> b.bounds >> b.coeffs;
+		if (in.status()!=QDataStream::Ok || b.bounds.size()<2 || b.coeffs.size()!=(b.bounds.size()-1)*3*(degree+1)
+		    || b.bounds.first()!=startJDE || b.bounds.last()!=endJDE)
+		{
+			qWarning() << "ChebyshevEphemeris: invalid file" << fileName;
+			return false;
+		}
+	}
+	bodies = loaded;
+	return true;
+}
+
+qint64 ChebyshevEphemeris::memoryUsage() const
+{
+	qint64 size = 0;
+	foreach (const Body& b, bodies)
+		size += (b.bounds.capacity() + b.coeffs.capacity())*sizeof(double);
+	return size;
+}
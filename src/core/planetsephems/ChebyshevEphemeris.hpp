@@ -0,0 +1,109 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _CHEBYSHEVEPHEMERIS_HPP_
+#define _CHEBYSHEVEPHEMERIS_HPP_
+
+#include <QString>
+#include <QVector>
+#include <QAtomicInt>
+
+//! @class ChebyshevEphemeris
+//! Piecewise Chebyshev approximation of the positions given by an analytical theory,
+//! such as VSOP87 or ELP82B, over a window of dates.
+//! The window is split into segments separately for each body. A segment is halved until the
+//! approximation agrees with the theory within the tolerance, both at check dates and by
+//! the size of the last coefficients. A segment which still does not agree at the shortest
+//! length is marked invalid, and compute() fails for its dates. A position then costs a binary search and the
+//! summation of a few coefficients instead of the evaluation of the series of the theory.
+//! The fitted segments can be saved to a file, which is only loaded back by an ephemeris
+//! with the same theory name, window, tolerance and degree.
+//! Once fitted or loaded, the ephemeris is read only and may be used from any thread.
+class ChebyshevEphemeris
+{
+public:
+	//! Compute the position of a body of the theory.
+	//! As fitting is typically done in a background thread, it must not use the static caches of the theory.
+	//! @param jde the Julian Ephemeris Date
+	//! @param body the number of the body in the theory, from 0 to getBodyCount()-1
+	//! @param xyz the position, in AU
+	typedef void (*TheoryFunc)(double jde, int body, double xyz[3]);
+
+	ChebyshevEphemeris();
+	//! Create an empty ephemeris, to be filled by fit() or load().
+	//! @param theory name and version of the theory. Change it when the theory changes so that saved fits are discarded.
+	//! @param bodyCount number of bodies of the theory
+	//! @param startJDE, endJDE the window of dates
+	//! @param tolerance maximum difference with the theory on each coordinate, in AU
+	//! @param degree degree of the Chebyshev polynomials
+	ChebyshevEphemeris(const QString& theory, int bodyCount, double startJDE, double endJDE, double tolerance, int degree=24);
+
+	//! Fit all the bodies, one after the other.
+	//! @param abort when not NULL, fitting stops as soon as it becomes non zero
+	//! @return false if fitting was aborted
+	bool fit(TheoryFunc func, const QAtomicInt* abort=NULL);
+	//! Fit one body.
+	bool fitBody(TheoryFunc func, int body, const QAtomicInt* abort=NULL);
+
+	//! Compute the position of a body from its fitted segments.
+	//! @return false if the date is out of the window, the body has not been fitted or its segment is invalid
+	bool compute(int body, double jde, double xyz[3]) const;
+
+	//! Save the fitted segments in a binary file.
+	bool save(const QString& fileName) const;
+	//! Load the segments saved by save().
+	//! @return false if the file cannot be read or was saved with other parameters
+	bool load(const QString& fileName);
+
+	const QString& getTheory() const {return theory;}
+	int getBodyCount() const {return bodies.size();}
+	double getStartJDE() const {return startJDE;}
+	double getEndJDE() const {return endJDE;}
+	double getTolerance() const {return tolerance;}
+	int getDegree() const {return degree;}
+	//! Number of segments of a body, 0 when not fitted.
+	int getSegmentCount(int body) const {return qMax(0, bodies.at(body).bounds.size()-1);}
+	//! Number of bytes used by the segments.
+	qint64 memoryUsage() const;
+
+private:
+	struct Body
+	{
+		//! Dates of the limits of the segments, in increasing order.
+		QVector<double> bounds;
+		//! (degree+1) coefficients of x, then of y and z, for each segment.
+		//! The first coefficient of an invalid segment is NaN.
+		QVector<double> coeffs;
+	};
+
+	//! Fit a segment and check it against the theory.
+	//! @return false if the approximation is not within the tolerance
+	bool fitSegment(TheoryFunc func, int body, double start, double end, double* coeffs) const;
+	//! Evaluate the 3 coordinates of a segment at x in [-1, 1].
+	void evaluate(const double* coeffs, double x, double xyz[3]) const;
+
+	QString theory;
+	double startJDE;
+	double endJDE;
+	double tolerance;
+	int degree;
+	QVector<Body> bodies;
+};
+
+#endif // _CHEBYSHEVEPHEMERIS_HPP_
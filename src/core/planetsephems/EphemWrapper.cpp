@@ -19,17 +19,21 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 */
 
 #include "EphemWrapper.hpp"
+#ifndef UNIT_TEST
 #include "StelApp.hpp"
 #include "StelCore.hpp"
-#include "vsop87.h"
-#include "elp82b.h"
-#include "marssat.h"
-#include "l1.h"
-#include "tass17.h"
-#include "gust86.h"
+#endif
 #include "de431.hpp"
 #include "de430.hpp"
 #include "pluto.h"
+#include "ChebyshevEphemeris.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <cmath>
 
 #define EPHEM_MERCURY_ID  0
 #define EPHEM_VENUS_ID    1
@@ -58,6 +62,194 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 **            7 = uranus 
 **/
 
+EphemContext::EphemContext()
+{
+	InitVsop87Context(&vsop87);
+	InitElp82bContext(&elp82b);
+	InitMarsSatContext(&marsSat);
+	InitL1Context(&l1);
+	InitTass17Context(&tass17);
+	InitGust86Context(&gust86);
+	de430Cache = jpl_alloc_cache();
+	de431Cache = jpl_alloc_cache();
+}
+
+EphemContext::~EphemContext()
+{
+	jpl_free_cache(de430Cache);
+	jpl_free_cache(de431Cache);
+}
+
+// Chebyshev approximations of VSOP87 and ELP82B, published once loaded or fitted.
+// Change the theory names when the theories change, so that the saved fits are discarded.
+#define VSOP87_CHEBYSHEV_THEORY "VSOP87/1"
+#define ELP82B_CHEBYSHEV_THEORY "ELP82B/1"
+static QAtomicPointer<ChebyshevEphemeris> vsop87Chebyshev;
+static QAtomicPointer<ChebyshevEphemeris> elp82bChebyshev;
+// Number of threads using a published approximation. An approximation is only deleted
+// once it is no longer published and no thread uses it.
+static QAtomicInt chebyshevReaders;
+static QAtomicInt chebyshevAbort;
+
+//! Use of the published approximation of a theory for the lifetime of the object.
+class ChebyshevReader
+{
+public:
+	ChebyshevReader(const QAtomicPointer<ChebyshevEphemeris>& published)
+	{
+		// Counted before the pointer is read, so that stop_chebyshev_cache() waits for this thread
+		chebyshevReaders.ref();
+		ephem = published.loadAcquire();
+	}
+	~ChebyshevReader() {chebyshevReaders.deref();}
+	const ChebyshevEphemeris* get() const {return ephem;}
+private:
+	const ChebyshevEphemeris* ephem;
+	Q_DISABLE_COPY(ChebyshevReader)
+};
+
+static void vsop87Exact(double jde, int body, double xyz[3])
+{
+	GetVsop87CoorExact(jde, body, xyz);
+}
+
+static void elp82bExact(double jde, int body, double xyz[3])
+{
+	Q_UNUSED(body);
+	GetElp82bCoorExact(jde, xyz);
+}
+
+static void loadOrFitChebyshev(QAtomicPointer<ChebyshevEphemeris>* published, ChebyshevEphemeris* ephem,
+			       ChebyshevEphemeris::TheoryFunc func, const QString& fileName)
+{
+	if (!ephem->load(fileName))
+	{
+		QElapsedTimer timer;
+		timer.start();
+		if (!ephem->fit(func, &chebyshevAbort))
+		{
+			delete ephem;
+			return;
+		}
+		qDebug() << "Fitted" << ephem->getTheory() << "Chebyshev ephemeris in" << timer.elapsed() << "ms,"
+			 << ephem->memoryUsage()/1024 << "kB";
+		ephem->save(fileName);
+	}
+	published->storeRelease(ephem);
+}
+
+// Fitting takes about a minute, so it has its own thread rather than one of the global thread pool,
+// which computes the positions of the planets.
+class ChebyshevBuilder : public QThread
+{
+public:
+	ChebyshevBuilder(const QString& cacheDir, double startJDE, double endJDE, double tolerance)
+		: cacheDir(cacheDir), startJDE(startJDE), endJDE(endJDE), tolerance(tolerance) {}
+protected:
+	void run()
+	{
+		loadOrFitChebyshev(&vsop87Chebyshev, new ChebyshevEphemeris(VSOP87_CHEBYSHEV_THEORY, 8, startJDE, endJDE, tolerance),
+				   &vsop87Exact, cacheDir + "/vsop87.cheb");
+		loadOrFitChebyshev(&elp82bChebyshev, new ChebyshevEphemeris(ELP82B_CHEBYSHEV_THEORY, 1, startJDE, endJDE, tolerance),
+				   &elp82bExact, cacheDir + "/elp82b.cheb");
+	}
+private:
+	QString cacheDir;
+	double startJDE;
+	double endJDE;
+	double tolerance;
+};
+
+static ChebyshevBuilder* chebyshevBuilder = NULL;
+
+void EphemWrapper::init_chebyshev_cache(const QString& cacheDir, double startJDE, double endJDE, double tolerance)
+{
+	stop_chebyshev_cache();
+	if (!QDir().mkpath(cacheDir))
+		qWarning() << "Cannot create" << cacheDir << "- the Chebyshev ephemeris will not be saved";
+	chebyshevAbort.store(0);
+	chebyshevBuilder = new ChebyshevBuilder(cacheDir, startJDE, endJDE, tolerance);
+	chebyshevBuilder->start(QThread::LowPriority);
+}
+
+void EphemWrapper::stop_chebyshev_cache()
+{
+	chebyshevAbort.store(1);
+	if (chebyshevBuilder)
+	{
+		chebyshevBuilder->wait();
+		delete chebyshevBuilder;
+		chebyshevBuilder = NULL;
+	}
+	ChebyshevEphemeris* vsop87 = vsop87Chebyshev.fetchAndStoreOrdered(NULL);
+	ChebyshevEphemeris* elp82b = elp82bChebyshev.fetchAndStoreOrdered(NULL);
+	// The threads which started to use them before they were withdrawn finish quickly
+	while (chebyshevReaders.load()!=0)
+		QThread::yieldCurrentThread();
+	delete vsop87;
+	delete elp82b;
+}
+
+// Use the Chebyshev approximation of a theory when it covers the date.
+// Else dispatch to the given context of the theory, or to its static context when there is none.
+static void vsop87Coor(void* context, double jd, int body, double xyz[3])
+{
+	{
+		const ChebyshevReader chebyshev(vsop87Chebyshev);
+		if (chebyshev.get() && chebyshev.get()->compute(body, jd, xyz))
+			return;
+	}
+	if (context)
+		GetVsop87CoorCtx(&static_cast<EphemContext*>(context)->vsop87, jd, body, xyz);
+	else
+		GetVsop87Coor(jd, body, xyz);
+}
+
+static void elp82bCoor(void* context, double jd, double xyz[3])
+{
+	{
+		const ChebyshevReader chebyshev(elp82bChebyshev);
+		if (chebyshev.get() && chebyshev.get()->compute(0, jd, xyz))
+			return;
+	}
+	if (context)
+		GetElp82bCoorCtx(&static_cast<EphemContext*>(context)->elp82b, jd, xyz);
+	else
+		GetElp82bCoor(jd, xyz);
+}
+
+static void marsSatCoor(void* context, double jd, int body, double xyz[3])
+{
+	if (context)
+		GetMarsSatCoorCtx(&static_cast<EphemContext*>(context)->marsSat, jd, body, xyz);
+	else
+		GetMarsSatCoor(jd, body, xyz);
+}
+
+static void l1Coor(void* context, double jd, int body, double xyz[3])
+{
+	if (context)
+		GetL1CoorCtx(&static_cast<EphemContext*>(context)->l1, jd, body, xyz);
+	else
+		GetL1Coor(jd, body, xyz);
+}
+
+static void tass17Coor(void* context, double jd, int body, double xyz[3])
+{
+	if (context)
+		GetTass17CoorCtx(&static_cast<EphemContext*>(context)->tass17, jd, body, xyz);
+	else
+		GetTass17Coor(jd, body, xyz);
+}
+
+static void gust86Coor(void* context, double jd, int body, double xyz[3])
+{
+	if (context)
+		GetGust86CoorCtx(&static_cast<EphemContext*>(context)->gust86, jd, body, xyz);
+	else
+		GetGust86Coor(jd, body, xyz);
+}
+
 void EphemWrapper::init_de430(const char* filepath)
 {
 	InitDE430(filepath);
@@ -68,6 +260,17 @@ void EphemWrapper::init_de431(const char* filepath)
 	InitDE431(filepath);
 }
 
+// Read DE430/DE431 with the cache of the given context, or with the shared one when there is none.
+static bool getDe430Coor(void* context, const double jde, const int planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID)
+{
+	return GetDe430CoorCached(context ? static_cast<EphemContext*>(context)->de430Cache : NULL, jde, planet_id, xyz, centralBody_id);
+}
+
+static bool getDe431Coor(void* context, const double jde, const int planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID)
+{
+	return GetDe431CoorCached(context ? static_cast<EphemContext*>(context)->de431Cache : NULL, jde, planet_id, xyz, centralBody_id);
+}
+
 bool jd_fits_de431(const double jd)
 {
 	//Correct limits found via jpl_get_double(). Limits hardcoded to avoid calls each time.
@@ -84,6 +287,20 @@ bool jd_fits_de430(const double jd)
 	return ((jd > 2287184.5) && (jd < 2688976.5));
 }
 
+#ifdef UNIT_TEST
+// NOTE: Added hook for unit testing: the analytical theories are used
+bool use_de430(const double jd)
+{
+	Q_UNUSED(jd);
+	return false;
+}
+
+bool use_de431(const double jd)
+{
+	Q_UNUSED(jd);
+	return false;
+}
+#else
 bool use_de430(const double jd)
 {
 	return StelApp::getInstance().getCore()->de430IsActive() && jd_fits_de430(jd);
@@ -93,9 +310,10 @@ bool use_de431(const double jd)
 {
 	return StelApp::getInstance().getCore()->de431IsActive() && jd_fits_de431(jd);
 }
+#endif
 
 // planet_id is ONLY one of the #defined values 0..8 above.
-void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_id)
+void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_id, void* context)
 {
 	bool deOk=false;
 	if(!std::isfinite(jd))
@@ -106,21 +324,21 @@ void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_i
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, planet_id + 1, xyz);
+		deOk=getDe430Coor(context, jd, planet_id + 1, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, planet_id + 1, xyz);
+		deOk=getDe431Coor(context, jd, planet_id + 1, xyz);
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87Coor(jd, planet_id, xyz);
+		vsop87Coor(context, jd, planet_id, xyz);
 	}
 }
 
 // Osculating positions for time JDE in elements for JDE0, if possible by the theory used (e.g. VSOP87).
 // For ephemerides like DE4xx, JDE0 is irrelevant.
-void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], int planet_id)
+void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], int planet_id, EphemContext* context)
 {
 	bool deOk=false;
 	if(!(std::isfinite(jd) && std::isfinite(jd0)))
@@ -131,15 +349,18 @@ void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], i
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, planet_id + 1, xyz);
+		deOk=getDe430Coor(context, jd, planet_id + 1, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, planet_id + 1, xyz);
+		deOk=getDe431Coor(context, jd, planet_id + 1, xyz);
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
-		GetVsop87OsculatingCoor(jd0, jd, planet_id, xyz);
+		if (context)
+			GetVsop87OsculatingCoorCtx(&context->vsop87, jd0, jd, planet_id, xyz);
+		else
+			GetVsop87OsculatingCoor(jd0, jd, planet_id, xyz);
 	}
 }
 
@@ -148,9 +369,8 @@ void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], i
  * for given Julian Day. Values are in AU.
  * params : Julian day, rect coords */
 
-void get_pluto_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_pluto_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
 	bool deOk=false;
 	if(!std::isfinite(jd))
 	{
@@ -160,11 +380,11 @@ void get_pluto_helio_coordsv(double jd,double xyz[3], void* unused)
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, EPHEM_JPL_PLUTO_ID, xyz);
+		deOk=getDe430Coor(context, jd, EPHEM_JPL_PLUTO_ID, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, EPHEM_JPL_PLUTO_ID, xyz);
+		deOk=getDe431Coor(context, jd, EPHEM_JPL_PLUTO_ID, xyz);
 	}
 	if (!deOk) // fallback to previous solution
 	{
@@ -180,20 +400,17 @@ void get_sun_helio_coordsv(double jd,double xyz[3], void* unused)
 	xyz[0]=0.; xyz[1]=0.; xyz[2]=0.;
 }
 
-void get_mercury_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_mercury_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-  	get_planet_helio_coordsv(jd, xyz, EPHEM_MERCURY_ID);
+  	get_planet_helio_coordsv(jd, xyz, EPHEM_MERCURY_ID, context);
 }
-void get_venus_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_venus_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-  	get_planet_helio_coordsv(jd, xyz, EPHEM_VENUS_ID);
+  	get_planet_helio_coordsv(jd, xyz, EPHEM_VENUS_ID, context);
 }
 
-void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused) 
+void get_earth_helio_coordsv(const double jd,double xyz[3], void* context) 
 {
-	Q_UNUSED(unused);
 	bool deOk=false;
 	if(!std::isfinite(jd))
 	{
@@ -203,17 +420,17 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused)
 
 	if(use_de430(jd))
 	{
-		deOk=GetDe430Coor(jd, EPHEM_JPL_EARTH_ID, xyz);
+		deOk=getDe430Coor(context, jd, EPHEM_JPL_EARTH_ID, xyz);
 	}
 	else if(use_de431(jd))
 	{
-		deOk=GetDe431Coor(jd, EPHEM_JPL_EARTH_ID, xyz);
+		deOk=getDe431Coor(context, jd, EPHEM_JPL_EARTH_ID, xyz);
 	}
 	if (!deOk) //VSOP87 as fallback
 	{
 		double moon[3];
-		GetVsop87Coor(jd,EPHEM_EMB_ID,xyz);
-		GetElp82bCoor(jd,moon);
+		vsop87Coor(context, jd, EPHEM_EMB_ID, xyz);
+		elp82bCoor(context, jd, moon);
 		/* Earth != EMB:
 	0.0121505677733761 = mu_m/(1+mu_m),
 	mu_m = mass(moon)/mass(earth) = 0.01230002 */
@@ -223,74 +440,69 @@ void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused)
 	}
 }
 
-void get_mars_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_mars_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_MARS_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_MARS_ID, context);
 }
 
-void get_jupiter_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_jupiter_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_JUPITER_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_JUPITER_ID, context);
 }
 
-void get_saturn_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_saturn_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_SATURN_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_SATURN_ID, context);
 }
 
-void get_uranus_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_uranus_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_URANUS_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_URANUS_ID, context);
 }
 
-void get_neptune_helio_coordsv(double jd,double xyz[3], void* unused)
+void get_neptune_helio_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	get_planet_helio_coordsv(jd, xyz, EPHEM_NEPTUNE_ID);
+	get_planet_helio_coordsv(jd, xyz, EPHEM_NEPTUNE_ID, context);
 }
 
-void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MERCURY_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MERCURY_ID, static_cast<EphemContext*>(context));
 }
 
-void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_VENUS_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_VENUS_ID, static_cast<EphemContext*>(context));
 }
 
-void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_EMB_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_EMB_ID, static_cast<EphemContext*>(context));
 }
 
-void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MARS_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_MARS_ID, static_cast<EphemContext*>(context));
 }
 
-void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_JUPITER_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_JUPITER_ID, static_cast<EphemContext*>(context));
 }
 
-void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_SATURN_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_SATURN_ID, static_cast<EphemContext*>(context));
 }
 
-void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_URANUS_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_URANUS_ID, static_cast<EphemContext*>(context));
 }
 
-void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3])
+void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context)
 {
-	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_NEPTUNE_ID);
+	get_planet_helio_osculating_coordsv(jd0, jd, xyz, EPHEM_NEPTUNE_ID, static_cast<EphemContext*>(context));
 }
 
 /* Calculate the rectangular geocentric lunar coordinates to the inertial mean
@@ -300,129 +512,109 @@ void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3])
  * Michelle Chapront-Touze and Jean Chapront of the Bureau des Longitudes,
  * Paris. ELP 2000-82B theory
  * param jd Julian day, rect pos */
-void get_lunar_parent_coordsv(double jde,double xyz[3], void* unused)
+void get_lunar_parent_coordsv(double jde,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
 	bool deOk=false;
 	if(use_de430(jde))
-		deOk=GetDe430Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
+		deOk=getDe430Coor(context, jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
 	else if(use_de431(jde))
-		deOk=GetDe431Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
+		deOk=getDe431Coor(context, jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
 	if (!deOk) // fallback...
-		GetElp82bCoor(jde,xyz);
+		elp82bCoor(context, jde, xyz);
 }
 
-void get_phobos_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_phobos_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetMarsSatCoor(jd,MARS_SAT_PHOBOS,xyz);
+	marsSatCoor(context, jd, MARS_SAT_PHOBOS, xyz);
 }
 
-void get_deimos_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_deimos_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetMarsSatCoor(jd,MARS_SAT_DEIMOS,xyz);
+	marsSatCoor(context, jd, MARS_SAT_DEIMOS, xyz);
 }
 
-void get_io_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_io_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetL1Coor(jd,L1_IO,xyz);
+	l1Coor(context, jd, L1_IO, xyz);
 }
 
-void get_europa_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_europa_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetL1Coor(jd,L1_EUROPA,xyz);
+	l1Coor(context, jd, L1_EUROPA, xyz);
 }
 
-void get_ganymede_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_ganymede_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetL1Coor(jd,L1_GANYMEDE,xyz);
+	l1Coor(context, jd, L1_GANYMEDE, xyz);
 }
 
-void get_callisto_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_callisto_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetL1Coor(jd,L1_CALLISTO,xyz);
+	l1Coor(context, jd, L1_CALLISTO, xyz);
 }
 
-void get_mimas_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_mimas_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_MIMAS,xyz);
+	tass17Coor(context, jd, TASS17_MIMAS, xyz);
 }
 
-void get_enceladus_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_enceladus_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_ENCELADUS,xyz);
+	tass17Coor(context, jd, TASS17_ENCELADUS, xyz);
 }
 
-void get_tethys_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_tethys_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_TETHYS,xyz);
+	tass17Coor(context, jd, TASS17_TETHYS, xyz);
 }
 
-void get_dione_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_dione_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_DIONE,xyz);
+	tass17Coor(context, jd, TASS17_DIONE, xyz);
 }
 
-void get_rhea_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_rhea_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_RHEA,xyz);
+	tass17Coor(context, jd, TASS17_RHEA, xyz);
 }
 
-void get_titan_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_titan_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_TITAN,xyz);
+	tass17Coor(context, jd, TASS17_TITAN, xyz);
 }
 
-void get_hyperion_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_hyperion_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_HYPERION,xyz);
+	tass17Coor(context, jd, TASS17_HYPERION, xyz);
 }
 
-void get_iapetus_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_iapetus_parent_coordsv(double jd,double xyz[3], void* context)
 { 
-	Q_UNUSED(unused);
-	GetTass17Coor(jd,TASS17_IAPETUS,xyz);
+	tass17Coor(context, jd, TASS17_IAPETUS, xyz);
 }
 
-void get_miranda_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_miranda_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetGust86Coor(jd,GUST86_MIRANDA,xyz);
+	gust86Coor(context, jd, GUST86_MIRANDA, xyz);
 }
 
-void get_ariel_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_ariel_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetGust86Coor(jd,GUST86_ARIEL,xyz);
+	gust86Coor(context, jd, GUST86_ARIEL, xyz);
 }
 
-void get_umbriel_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_umbriel_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetGust86Coor(jd,GUST86_UMBRIEL,xyz);
+	gust86Coor(context, jd, GUST86_UMBRIEL, xyz);
 }
 
-void get_titania_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_titania_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetGust86Coor(jd,GUST86_TITANIA,xyz);
+	gust86Coor(context, jd, GUST86_TITANIA, xyz);
 }
 
-void get_oberon_parent_coordsv(double jd,double xyz[3], void* unused)
+void get_oberon_parent_coordsv(double jd,double xyz[3], void* context)
 {
-	Q_UNUSED(unused);
-	GetGust86Coor(jd,GUST86_OBERON,xyz);
+	gust86Coor(context, jd, GUST86_OBERON, xyz);
 }
 
@@ -35,57 +35,108 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #define DE430_FILENAME  "linux_p1550p2650.430"
 #define DE431_FILENAME  "lnxm13000p17000.431"
 
+#include "vsop87.h"
+#include "elp82b.h"
+#include "marssat.h"
+#include "l1.h"
+#include "tass17.h"
+#include "gust86.h"
+
+#include <QtGlobal>
+#include <QString>
+
+//! @struct EphemContext
+//! Interpolation caches of the analytical theories (VSOP87, ELP82B, and the theories of
+//! the satellites of Mars, Jupiter, Saturn and Uranus) used by the get_*_coordsv functions.
+//! The last argument of these functions may point to an EphemContext, so that positions
+//! can be computed concurrently by several threads, each one using its own context.
+//! With a NULL argument the functions use the static caches of the theories, which must
+//! only be used by the main thread.
+//! The context also holds the caches of the DE430/DE431 coefficient blocks (see jpl_alloc_cache()).
+//! Positions read from DE430/DE431 do not depend on the context.
+struct EphemContext
+{
+	EphemContext();
+	~EphemContext();
+
+	Vsop87Context vsop87;
+	Elp82bContext elp82b;
+	MarsSatContext marsSat;
+	L1Context l1;
+	Tass17Context tass17;
+	Gust86Context gust86;
+	void* de430Cache;
+	void* de431Cache;
+
+private:
+	Q_DISABLE_COPY(EphemContext)
+};
+
 class EphemWrapper{
 public:
     static void init_de430(const char* filepath);
     static void init_de431(const char* filepath);
+    //! Compute VSOP87 and ELP82B positions from Chebyshev approximations (see ChebyshevEphemeris)
+    //! for the dates of a window. The approximations are loaded from @em cacheDir if they were fitted
+    //! with the same parameters before, else they are fitted in a dedicated low priority thread and saved there.
+    //! Until then, and for the dates out of the window, the theories are evaluated as usual.
+    //! @param tolerance maximum difference with the theories on each coordinate, in AU
+    static void init_chebyshev_cache(const QString& cacheDir, double startJDE, double endJDE, double tolerance);
+    //! Stop fitting and using the Chebyshev approximations.
+    //! The approximations are deleted once the positions being computed from them in other threads are done.
+    static void stop_chebyshev_cache();
 };
 
-void get_sun_helio_coordsv(double jd,double xyz[3], void*);
-void get_mercury_helio_coordsv(double jd,double xyz[3], void*);
-void get_venus_helio_coordsv(double jd,double xyz[3], void*);
-void get_earth_helio_coordsv(double jd,double xyz[3], void*);
-void get_mars_helio_coordsv(double jd,double xyz[3], void*);
-void get_jupiter_helio_coordsv(double jd,double xyz[3], void*);
-void get_saturn_helio_coordsv(double jd,double xyz[3], void*);
-void get_uranus_helio_coordsv(double jd,double xyz[3], void*);
-void get_neptune_helio_coordsv(double jd,double xyz[3], void*);
-void get_pluto_helio_coordsv(double jd,double xyz[3], void*);
-
-void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-void get_pluto_helio_osculating_coords(double jd0,double jd,double xyz[3]);
-
-void get_lunar_parent_coordsv(double jde, double xyz[3], void*);
-
-void get_phobos_parent_coordsv(double jd,double xyz[3], void*);
-void get_deimos_parent_coordsv(double jd,double xyz[3], void*);
-
-void get_io_parent_coordsv(double jd,double xyz[3], void*);
-void get_europa_parent_coordsv(double jd,double xyz[3], void*);
-void get_ganymede_parent_coordsv(double jd,double xyz[3], void*);
-void get_callisto_parent_coordsv(double jd,double xyz[3], void*);
-
-void get_mimas_parent_coordsv(double jd,double xyz[3], void*);
-void get_enceladus_parent_coordsv(double jd,double xyz[3], void*);
-void get_tethys_parent_coordsv(double jd,double xyz[3], void*);
-void get_dione_parent_coordsv(double jd,double xyz[3], void*);
-void get_rhea_parent_coordsv(double jd,double xyz[3], void*);
-void get_titan_parent_coordsv(double jd,double xyz[3], void*);
-void get_hyperion_parent_coordsv(double jd,double xyz[3], void*);
-void get_iapetus_parent_coordsv(double jd,double xyz[3], void*);
-
-void get_miranda_parent_coordsv(double jd,double xyz[3], void*);
-void get_ariel_parent_coordsv(double jd,double xyz[3], void*);
-void get_umbriel_parent_coordsv(double jd,double xyz[3], void*);
-void get_titania_parent_coordsv(double jd,double xyz[3], void*);
-void get_oberon_parent_coordsv(double jd,double xyz[3], void*);
+void get_sun_helio_coordsv(double jd,double xyz[3], void* context);
+void get_mercury_helio_coordsv(double jd,double xyz[3], void* context);
+void get_venus_helio_coordsv(double jd,double xyz[3], void* context);
+void get_earth_helio_coordsv(double jd,double xyz[3], void* context);
+void get_mars_helio_coordsv(double jd,double xyz[3], void* context);
+void get_jupiter_helio_coordsv(double jd,double xyz[3], void* context);
+void get_saturn_helio_coordsv(double jd,double xyz[3], void* context);
+void get_uranus_helio_coordsv(double jd,double xyz[3], void* context);
+void get_neptune_helio_coordsv(double jd,double xyz[3], void* context);
+void get_pluto_helio_coordsv(double jd,double xyz[3], void* context);
+
+void get_mercury_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_venus_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_earth_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_mars_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_jupiter_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_saturn_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_uranus_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+
+//! Osculating VSOP87 position of a planet with a given context.
+//! @param planet_id VSOP87 number of the planet, from 0 (Mercury) to 7 (Neptune), 2 being the Earth-Moon barycenter.
+//! @param context the interpolation caches to use, or NULL for the default ones
+void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], int planet_id, EphemContext* context);
+void get_pluto_helio_osculating_coords(double jd0,double jd,double xyz[3], void* context);
+
+void get_lunar_parent_coordsv(double jde, double xyz[3], void* context);
+
+void get_phobos_parent_coordsv(double jd,double xyz[3], void* context);
+void get_deimos_parent_coordsv(double jd,double xyz[3], void* context);
+
+void get_io_parent_coordsv(double jd,double xyz[3], void* context);
+void get_europa_parent_coordsv(double jd,double xyz[3], void* context);
+void get_ganymede_parent_coordsv(double jd,double xyz[3], void* context);
+void get_callisto_parent_coordsv(double jd,double xyz[3], void* context);
+
+void get_mimas_parent_coordsv(double jd,double xyz[3], void* context);
+void get_enceladus_parent_coordsv(double jd,double xyz[3], void* context);
+void get_tethys_parent_coordsv(double jd,double xyz[3], void* context);
+void get_dione_parent_coordsv(double jd,double xyz[3], void* context);
+void get_rhea_parent_coordsv(double jd,double xyz[3], void* context);
+void get_titan_parent_coordsv(double jd,double xyz[3], void* context);
+void get_hyperion_parent_coordsv(double jd,double xyz[3], void* context);
+void get_iapetus_parent_coordsv(double jd,double xyz[3], void* context);
+
+void get_miranda_parent_coordsv(double jd,double xyz[3], void* context);
+void get_ariel_parent_coordsv(double jd,double xyz[3], void* context);
+void get_umbriel_parent_coordsv(double jd,double xyz[3], void* context);
+void get_titania_parent_coordsv(double jd,double xyz[3], void* context);
+void get_oberon_parent_coordsv(double jd,double xyz[3], void* context);
 
 #endif // _EPHEMWRAPPER_HPP_
 
@@ -26,13 +26,15 @@ For documentation see the header file.
 
 #include "calc_interpolated_elements.h"
 
-void CalcInterpolatedElements(const double t,double elem[],
-                              const int dim,
-                              void (*calc_func)(const double t,double elem[]),
-                              const double delta_t,
-                              double *t0,double e0[],
-                              double *t1,double e1[],
-                              double *t2,double e2[]) {
+void CalcInterpolatedElementsData(const double t,double elem[],
+                                  const int dim,
+                                  void (*calc_func)(const double t,double elem[],
+                                                    void *user_data),
+                                  void *user_data,
+                                  const double delta_t,
+                                  double *t0,double e0[],
+                                  double *t1,double e1[],
+                                  double *t2,double e2[]) {
 /*
 printf("CalcInterpolatedElements: %12.9f %12.9f %12.9f %12.9f\n",t,*t0,*t1,*t2);
 */
@@ -41,7 +43,7 @@ printf("CalcInterpolatedElements: %12.9f %12.9f %12.9f %12.9f\n",t,*t0,*t1,*t2);
     *t0 = -1e100;
     *t2 = -1e100;
     *t1 = t;
-    (*calc_func)(*t1,e1);
+    (*calc_func)(*t1,e1,user_data);
     for (i=0;i<dim;i++) elem[i] = e1[i];
     return;
   }
@@ -49,22 +51,22 @@ printf("CalcInterpolatedElements: %12.9f %12.9f %12.9f %12.9f\n",t,*t0,*t1,*t2);
     if (*t1 - delta_t <= t) { /* interpolate */
       if (*t0 < -1e99) {
         *t0 = *t1 - delta_t;
-        (*calc_func)(*t0,e0);
+        (*calc_func)(*t0,e0,user_data);
       }
     } else if (*t1 - 2.0*delta_t <= t) { /* interpolate */
       if (*t0 < -1e99) {
         *t0 = *t1 - delta_t;
-        (*calc_func)(*t0,e0);
+        (*calc_func)(*t0,e0,user_data);
       }
       *t2 = *t1;*t1 = *t0;
       for (i=0;i<dim;i++) {e2[i] = e1[i];e1[i] = e0[i];}
       *t0 = *t1 - delta_t;
-      (*calc_func)(*t0,e0);
+      (*calc_func)(*t0,e0,user_data);
     } else {
       *t0 = -1e100;
       *t2 = -1e100;
       *t1 = t;
-      (*calc_func)(*t1,e1);
+      (*calc_func)(*t1,e1,user_data);
       for (i=0;i<dim;i++) elem[i] = e1[i];
       return;
     }
@@ -78,22 +80,22 @@ printf("CalcInterpolatedElements: %12.9f %12.9f %12.9f %12.9f\n",t,*t0,*t1,*t2);
     if (*t1 + delta_t >= t) { /* interpolate */
       if (*t2 < -1e99) {
         *t2 = *t1 + delta_t;
-        (*calc_func)(*t2,e2);
+        (*calc_func)(*t2,e2,user_data);
       }
     } else if (*t1 + 2.0*delta_t >= t) { /* interpolate */
       if (*t2 < -1e99) {
         *t2 = *t1 + delta_t;
-        (*calc_func)(*t2,e2);
+        (*calc_func)(*t2,e2,user_data);
       }
       *t0 = *t1;*t1 = *t2;
       for (i=0;i<dim;i++) {e0[i] = e1[i];e1[i] = e2[i];}
       *t2 = *t1 + delta_t;
-      (*calc_func)(*t2,e2);
+      (*calc_func)(*t2,e2,user_data);
     } else {
       *t0 = -1e100;
       *t2 = -1e100;
       *t1 = t;
-      (*calc_func)(*t1,e1);
+      (*calc_func)(*t1,e1,user_data);
       for (i=0;i<dim;i++) elem[i] = e1[i];
       return;
     }
@@ -106,3 +108,23 @@ printf("CalcInterpolatedElements: %12.9f %12.9f %12.9f %12.9f\n",t,*t0,*t1,*t2);
   }
 }
 
+struct CalcFuncWrapper {
+  void (*calc_func)(const double t,double elem[]);
+};
+
+static void CallCalcFunc(const double t,double elem[],void *user_data) {
+  (*((const struct CalcFuncWrapper*)user_data)->calc_func)(t,elem);
+}
+
+void CalcInterpolatedElements(const double t,double elem[],
+                              const int dim,
+                              void (*calc_func)(const double t,double elem[]),
+                              const double delta_t,
+                              double *t0,double e0[],
+                              double *t1,double e1[],
+                              double *t2,double e2[]) {
+  struct CalcFuncWrapper wrapper;
+  wrapper.calc_func = calc_func;
+  CalcInterpolatedElementsData(t,elem,dim,&CallCalcFunc,&wrapper,delta_t,
+                               t0,e0,t1,e1,t2,e2);
+}
@@ -23,6 +23,8 @@ THE SOFTWARE.
 
 #include "de430.hpp"
 #include "StelUtils.hpp"
+#include <QMutex>
+#include <QVector>
 #ifndef UNIT_TEST
 #include "StelCore.hpp"
 #include "StelApp.hpp"
@@ -35,12 +37,12 @@ THE SOFTWARE.
 #endif
 
 static void * ephem;
+// Interpolation state used by GetDe430Coor(), shared by all its callers.
+static void * defaultCache;
+static QMutex defaultCacheMutex;
 
-static Vec3d tempECL = Vec3d(0,0,0);
-static Vec3d tempICRF = Vec3d(0,0,0);
 static char nams[JPL_MAX_N_CONSTANTS][6];
 static double vals[JPL_MAX_N_CONSTANTS];
-static double tempXYZ[6];
 #ifdef UNIT_TEST
 // NOTE: Added hook for unit testing
 static const Mat4d matJ2000ToVsop87(Mat4d::xrotation(-23.4392803055555555556*(M_PI/180)) * Mat4d::zrotation(0.0000275*(M_PI/180)));
@@ -61,6 +63,8 @@ void InitDE430(const char* filepath)
 	}
 	else
 	{
+		if (!defaultCache)
+			defaultCache = jpl_alloc_cache();
 		initDone = true;
 		double jd1, jd2;
 		jd1=jpl_get_double(ephem, JPL_EPHEM_START_JD);
@@ -74,58 +78,70 @@ void TerminateDE430()
   jpl_close_ephemeris(ephem);
 }
 
+// Rotate a position from ICRF to the VSOP87 frame.
+static void icrfToVsop87(const double * pos, double * xyz)
+{
+	const Vec3d tempICRF(pos[0], pos[1], pos[2]);
+	#ifdef UNIT_TEST
+	const Vec3d tempECL = matJ2000ToVsop87 * tempICRF;
+	#else
+	const Vec3d tempECL = StelCore::matJ2000ToVsop87 * tempICRF;
+	#endif
+
+	xyz[0] = tempECL[0];
+	xyz[1] = tempECL[1];
+	xyz[2] = tempECL[2];
+}
+
+// Compute a position with a cache owned by the calling thread, or with defaultCache while holding its mutex.
+static bool computeCoor(void * cache, const double jde, const int planet_id, double * xyz, const int centralBody_id)
+{
+	double tempXYZ[6];
+	const int jplresult=jpl_pleph_cached(ephem, cache, jde, planet_id, centralBody_id, tempXYZ, 0);
+	if (!jpl_check_result("GetDe430Coor", jplresult, jde, planet_id))
+		return false;
+	icrfToVsop87(tempXYZ, xyz);
+	return true;
+}
+
 bool GetDe430Coor(const double jde, const int planet_id, double * xyz, const int centralBody_id)
 {
-    if(initDone)
-    {
-	// This may return some error code!
-	int jplresult=jpl_pleph(ephem, jde, planet_id, centralBody_id, tempXYZ, 0);
+	if(!initDone || !defaultCache)
+		return false;
+	QMutexLocker lock(&defaultCacheMutex);
+	return computeCoor(defaultCache, jde, planet_id, xyz, centralBody_id);
+}
+
+bool GetDe430CoorCached(void * cache, const double jde, const int planet_id, double * xyz, const int centralBody_id)
+{
+	if(!cache)
+		return GetDe430Coor(jde, planet_id, xyz, centralBody_id);
+	if(!initDone)
+		return false;
+	return computeCoor(cache, jde, planet_id, xyz, centralBody_id);
+}
 
-	switch (jplresult)
+bool GetDe430CoorMulti(void * cache, const int n_jde, const double * jde, const int n_planets, const int * planet_id, double * xyz, const int centralBody_id)
+{
+	if(!initDone)
+		return false;
+
+	QVector<double> states(6*n_jde*n_planets);
+	int jplresult;
+	if(cache)
+		jplresult=jpl_pleph_multi(ephem, cache, n_jde, jde, n_planets, planet_id, centralBody_id, states.data(), 0);
+	else
 	{
-		case 0: // all OK.
-			break;
-		case JPL_EPH_OUTSIDE_RANGE:
-			qDebug() << "GetDe430Coor: JPL_EPH_OUTSIDE_RANGE at jde" << jde << "for planet" << planet_id;
-			return false;
-			break;
-		case JPL_EPH_READ_ERROR:
-			qDebug() << "GetDe430Coor: JPL_EPH_READ_ERROR at jde" << jde << "for planet" << planet_id;
-			return false;
-			break;
-		case JPL_EPH_QUANTITY_NOT_IN_EPHEMERIS:
-			qDebug() << "GetDe430Coor: JPL_EPH_QUANTITY_NOT_IN_EPHEMERIS at jde" << jde << "for planet" << planet_id;
-			return false;
-			break;
-		case JPL_EPH_INVALID_INDEX:
-			qDebug() << "GetDe430Coor: JPL_EPH_INVALID_INDEX at jde" << jde << "for planet" << planet_id;
-			return false;
-			break;
-		case JPL_EPH_FSEEK_ERROR:
-			qDebug() << "GetDe430Coor: JPL_EPH_FSEEK_ERROR at jde" << jde << "for planet" << planet_id;
+		if(!defaultCache)
 			return false;
-			break;
-		default: // Should never happen...
-			qDebug() << "GetDe430Coor: unknown error" << jplresult << "at jde" << jde << "for planet" << planet_id;
-			return false;
-			break;
+		QMutexLocker lock(&defaultCacheMutex);
+		jplresult=jpl_pleph_multi(ephem, defaultCache, n_jde, jde, n_planets, planet_id, centralBody_id, states.data(), 0);
 	}
-
-	jpl_pleph(ephem, jde, planet_id, centralBody_id, tempXYZ, 0);
-
-        tempICRF = Vec3d(tempXYZ[0], tempXYZ[1], tempXYZ[2]);
-	#ifdef UNIT_TEST
-	tempECL = matJ2000ToVsop87 * tempICRF;
-	#else
-        tempECL = StelCore::matJ2000ToVsop87 * tempICRF;
-	#endif
-
-        xyz[0] = tempECL[0];
-        xyz[1] = tempECL[1];
-        xyz[2] = tempECL[2];
+	if (!jpl_check_result("GetDe430CoorMulti", jplresult, jde[0], planet_id[0]))
+		return false;
+	for (int i=0; i<n_jde*n_planets; ++i)
+		icrfToVsop87(states.constData()+6*i, xyz+3*i);
 	return true;
-    }
-    return false;
 }
 
 
@@ -34,6 +34,13 @@ void InitDE430(const char* filepath);
 // most of the time centralBody_id likely is the Sun. However, for Moon, use centralBody_id=EPHEM_JPL_EARTH_ID=3
 // return true if OK, false if something was wrong with the JPL functions. In this case, see log for details.
 bool GetDe430Coor(const double jde, const int planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID);
+// Same as GetDe430Coor(), with the interpolation state kept in a cache allocated by jpl_alloc_cache(),
+// so that several threads may read the ephemeris at once, each one with its own cache.
+// With a NULL cache, the shared state of GetDe430Coor() is used.
+bool GetDe430CoorCached(void * cache, const double jde, const int planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID);
+// Positions of n_planets bodies at n_jde dates in one call, see jpl_pleph_multi(). cache may be NULL as above.
+// xyz must hold 3*n_jde*n_planets values: the position of planet_id[j] at jde[i] starts at xyz[3*(i*n_planets+j)].
+bool GetDe430CoorMulti(void * cache, const int n_jde, const double * jde, const int n_planets, const int * planet_id, double * xyz, const int centralBody_id=CENTRAL_PLANET_ID);
 // Not possible for a DE.
 //void GetDe430OsculatingCoor(double jd0, double jd, int planet_id, double *xyz, const int centralBody_id=CENTRAL_PLANET_ID);
 
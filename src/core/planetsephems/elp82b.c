@@ -43,6 +43,7 @@ the original Fortran code:
 
 ****************************************************************/
 
+#include "elp82b.h"
 #include "calc_interpolated_elements.h"
 
 #include <math.h>
@@ -162709,13 +162710,21 @@ void GetElp82bSphericalCoor(const double t,double r[3]) {
   r[2] = (accu[2] + t*(accu[5] + t*accu[8])) * a0_div_ath_times_au;
 }
 
-  /* ugly static variable for caching: */
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double r_0[3];
-static double r_1[3];
-static double r_2[3];
+static struct Elp82bContext default_context = {
+  -1e100,-1e100,-1e100,{0},{0},{0}
+};
+
+static
+void GetElp82bSphericalCoorData(const double t,double r[3],void *user_data) {
+  (void)user_data;
+  GetElp82bSphericalCoor(t,r);
+}
+
+void InitElp82bContext(struct Elp82bContext *ctx) {
+  ctx->t_0 = -1e100;
+  ctx->t_1 = -1e100;
+  ctx->t_2 = -1e100;
+}
 
 #define DELTA_T (1.0/(24.0*36525.0))
 
@@ -162732,10 +162741,11 @@ static const double q4 = -1.371808e-12;
 static const double q5 = -3.20334e-15;
 
 void GetElp82bCoor(const double jd,double xyz[3]) {
-  const double t = (jd - 2451545.0) / 36525.0;
-  double r[3];
-  CalcInterpolatedElements(t,r,3,&GetElp82bSphericalCoor,DELTA_T,
-                           &t_0,r_0,&t_1,r_1,&t_2,r_2);
+  GetElp82bCoorCtx(&default_context,jd,xyz);
+}
+
+static
+void Elp82bSphericalToRectangular(const double t,const double r[3],double xyz[3]) {
   {
     const double rh = r[2] * cos(r[1]);
     const double x3 = r[2] * sin(r[1]);
@@ -162758,12 +162768,27 @@ void GetElp82bCoor(const double jd,double xyz[3]) {
     xyz[0] = pw2 *x1 + pwqw*x2                + pw*x3;
     xyz[1] = pwqw*x1 + qw2 *x2                - qw*x3;
     xyz[2] = -pw *x1 + qw  *x2 + (pw2 + qw2 - 1.0)*x3;
+  }
+}
 
+void GetElp82bCoorCtx(struct Elp82bContext *ctx,const double jd,double xyz[3]) {
+  const double t = (jd - 2451545.0) / 36525.0;
+  double r[3];
+  CalcInterpolatedElementsData(t,r,3,&GetElp82bSphericalCoorData,NULL,DELTA_T,
+                               &ctx->t_0,ctx->r_0,&ctx->t_1,ctx->r_1,
+                               &ctx->t_2,ctx->r_2);
+  Elp82bSphericalToRectangular(t,r,xyz);
 /*
     printf("Moon: %f  %22.15f %22.15f %22.15f\n",
            jd,xyz[0],xyz[1],xyz[2]);
 */
-  }
+}
+
+void GetElp82bCoorExact(const double jd,double xyz[3]) {
+  const double t = (jd - 2451545.0) / 36525.0;
+  double r[3];
+  GetElp82bSphericalCoor(t,r);
+  Elp82bSphericalToRectangular(t,r,xyz);
 }
 
 
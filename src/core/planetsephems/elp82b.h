@@ -80,6 +80,27 @@ void GetElp82bCoor(double jd,double xyz[3]);
      ICRF <-> VSOP87 must be done with the matrix given above.
    */
      
+struct Elp82bContext {
+  double t_0,t_1,t_2;
+  double r_0[3],r_1[3],r_2[3];
+};
+  /* Interpolation cache of the spherical coordinates of the moon.
+     GetElp82bCoor() uses a static context, so it must only be called
+     from one thread at a time. Each thread computing positions concurrently
+     must use its own context, initialized by InitElp82bContext().
+  */
+
+void InitElp82bContext(struct Elp82bContext *ctx);
+
+void GetElp82bCoorCtx(struct Elp82bContext *ctx,double jd,double xyz[3]);
+  /* Same as GetElp82bCoor(), using the given context. */
+
+void GetElp82bCoorExact(double jd,double xyz[3]);
+  /* Same as GetElp82bCoor(), evaluating the series at jd instead of
+     interpolating between evaluations. Needs no context, but is slower
+     when called for close dates.
+  */
+
 
 #ifdef __cplusplus
 }
@@ -50,6 +50,7 @@ My implementation of GUST86 has the following modifications:
 #include "elliptic_to_rectangular.h"
 
 #include <math.h>
+#include <stddef.h>
 
 #ifndef M_PI
 #define M_PI           3.14159265358979323846
@@ -425,43 +426,60 @@ const double GUST86toVsop87[9] = {
    9.214881523275189928e-02,-9.864478281437795399e-01,-1.357544776485127136e-01
 };
 
-#define GUST86_DIM (5*6)
-static double t_0 = -1e100;
-static double t_1 = -1e100;
-static double t_2 = -1e100;
-static double gust86_elem_0[GUST86_DIM];
-static double gust86_elem_1[GUST86_DIM];
-static double gust86_elem_2[GUST86_DIM];
+static struct Gust86Context default_context = {
+  -1e100,-1e100,-1e100,{0},{0},{0},-1e100,{0}
+};
+
 /* 1 day: */
 #define DELTA_T 1.0
 
-static double gust86_jd0 = -1e100;
-static double gust86_elem[GUST86_DIM];
+static void CalcGust86ElemData(const double t,double elem[],void *user_data) {
+  (void)user_data;
+  CalcGust86Elem(t,elem);
+}
+
+void InitGust86Context(struct Gust86Context *ctx) {
+  ctx->t_0 = -1e100;
+  ctx->t_1 = -1e100;
+  ctx->t_2 = -1e100;
+  ctx->jd0 = -1e100;
+}
 
 void GetGust86Coor(const double jd,const int body,double *xyz) {
-  GetGust86OsculatingCoor(jd,jd,body,xyz);
+  GetGust86OsculatingCoorCtx(&default_context,jd,jd,body,xyz);
 }
 
 void GetGust86OsculatingCoor(const double jd0,const double jd,
                              const int body,double *xyz) {
+  GetGust86OsculatingCoorCtx(&default_context,jd0,jd,body,xyz);
+}
+
+void GetGust86CoorCtx(struct Gust86Context *ctx,
+                      const double jd,const int body,double *xyz) {
+  GetGust86OsculatingCoorCtx(ctx,jd,jd,body,xyz);
+}
+
+void GetGust86OsculatingCoorCtx(struct Gust86Context *ctx,
+                                const double jd0,const double jd,
+                                const int body,double *xyz) {
   double x[3];
-  if (jd0 != gust86_jd0) {
+  if (jd0 != ctx->jd0) {
     const double t0 = jd0 - 2444239.5;
-    gust86_jd0 = jd0;
-    CalcInterpolatedElements(t0,gust86_elem,
-                             GUST86_DIM,
-                             &CalcGust86Elem,DELTA_T,
-                             &t_0,gust86_elem_0,
-                             &t_1,gust86_elem_1,
-                             &t_2,gust86_elem_2);
+    ctx->jd0 = jd0;
+    CalcInterpolatedElementsData(t0,ctx->elem,
+                                 GUST86_DIM,
+                                 &CalcGust86ElemData,NULL,DELTA_T,
+                                 &ctx->t_0,ctx->elem_0,
+                                 &ctx->t_1,ctx->elem_1,
+                                 &ctx->t_2,ctx->elem_2);
 /*
     printf("GetGust86Coor(%d): %f %f  %f %f  %f %f\n",
            body,
-           gust86_elem[body*6+0],gust86_elem[body*6+1],gust86_elem[body*6+2],
-           gust86_elem[body*6+3],gust86_elem[body*6+4],gust86_elem[body*6+5]);
+           ctx->elem[body*6+0],ctx->elem[body*6+1],ctx->elem[body*6+2],
+           ctx->elem[body*6+3],ctx->elem[body*6+4],ctx->elem[body*6+5]);
 */
   }
-  EllipticToRectangularN(gust86_rmu[body],gust86_elem+(body*6),jd-jd0,x);
+  EllipticToRectangularN(gust86_rmu[body],ctx->elem+(body*6),jd-jd0,x);
   xyz[0] = GUST86toVsop87[0]*x[0]+GUST86toVsop87[1]*x[1]+GUST86toVsop87[2]*x[2];
   xyz[1] = GUST86toVsop87[3]*x[0]+GUST86toVsop87[4]*x[1]+GUST86toVsop87[5]*x[2];
   xyz[2] = GUST86toVsop87[6]*x[0]+GUST86toVsop87[7]*x[1]+GUST86toVsop87[8]*x[2];
@@ -92,6 +92,33 @@ void GetGust86OsculatingCoor(const double jd0, const double jd, const int body,
   /* The oculating orbit of epoch jd0, evaluated at jd, is returned.
   */
 
+#define GUST86_DIM (5*6)
+
+struct Gust86Context {
+  double t_0,t_1,t_2;
+  double elem_0[GUST86_DIM];
+  double elem_1[GUST86_DIM];
+  double elem_2[GUST86_DIM];
+  double jd0;
+  double elem[GUST86_DIM];
+};
+  /* Interpolation cache of the GUST86 elements.
+     GetGust86Coor() and GetGust86OsculatingCoor() use a static context,
+     so they must only be called from one thread at a time.
+     Each thread computing positions concurrently must use its own context,
+     initialized by InitGust86Context().
+  */
+
+void InitGust86Context(struct Gust86Context *ctx);
+
+void GetGust86CoorCtx(struct Gust86Context *ctx,
+                      const double jd, const int body, double *xyz);
+
+void GetGust86OsculatingCoorCtx(struct Gust86Context *ctx,
+                                const double jd0, const double jd,
+                                const int body, double *xyz);
+  /* Same as above, using the given context. */
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,15 +46,48 @@ struct jpl_eph_data {
                /* items computed within my code.                     */
    uint32_t kernel_size, recsize, ncoeff;
    uint32_t swap_bytes;
-   uint32_t curr_cache_loc;
+   uint32_t curr_cache_loc;     /* unused,  see default_cache */
    double pvsun[9];
    double pvsun_t;
-   double *cache;
-   struct interpolation_info iinfo;
+               /* Everything below is read only once the ephemeris is     */
+               /* initialized,  except 'default_cache' and the file      */
+               /* position of 'ifile' (guarded by 'file_lock').          */
+   struct jpl_eph_cache *default_cache;  /* used by jpl_state()/jpl_pleph() */
+   uint32_t serial;
+   const char *map;    /* the whole file mapped in memory, or NULL */
+   int64_t map_size;
+   void *map_file;     /* the QFile owning 'map' */
+   void *file_lock;    /* QMutex serializing the reads from 'ifile' */
    FILE *ifile;
    };
 #pragma pack()
 
+            /* Number of coefficient blocks kept by each cache.  Orbit  */
+            /* sampling and light-time iterations alternate between a  */
+            /* few neighbouring blocks,  so a handful is plenty.       */
+#define JPL_CACHE_N_BLOCKS 4
+
+struct jpl_cache_block
+   {
+   uint32_t loc;             /* record number,  or (uint32_t)-1 if unused */
+   uint32_t last_use;
+   const double *coeffs;     /* into the mapped file,  or into 'buffer'   */
+   double *buffer;           /* decoded copy,  when the map can't be used */
+   };
+
+            /* All the state modified while interpolating.  Each thread */
+            /* uses its own cache,  see jpl_alloc_cache( ).             */
+struct jpl_eph_cache
+   {
+   uint32_t serial;          /* 'serial' of the ephemeris last used    */
+   uint32_t buffer_size;     /* number of doubles in each block buffer */
+   uint32_t use_count;
+   struct jpl_cache_block blocks[JPL_CACHE_N_BLOCKS];
+   double pvsun[9];
+   double pvsun_t;
+   struct interpolation_info iinfo;
+   };
+
 /* 2014 Mar 25:  notes about the file structure :
 
 Bytes 0- 83:  first line ("JPL Planetary Ephemeris DExxx/LExxx")
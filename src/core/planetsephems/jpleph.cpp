@@ -63,6 +63,9 @@ details of the implementation encapsulated.
 #include <stdint.h>
 
 #include "StelUtils.hpp"
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
 /**** include variable and type definitions, specific for this C version */
 
 #include "jpleph.h"
@@ -144,6 +147,67 @@ int DLL_FUNC jpl_pleph(void *ephem, const double et, const int ntarg,
                       const int ncent, double rrd[], const int calc_velocity)
 {
     struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
+    const int rval = jpl_pleph_cached(ephem, eph->default_cache, et, ntarg,
+                                      ncent, rrd, calc_velocity);
+
+    memcpy(eph->pvsun, eph->default_cache->pvsun, sizeof(eph->pvsun));
+    eph->pvsun_t = eph->default_cache->pvsun_t;
+    return(rval);
+}
+
+/* Set up the entries of 'list' needed for the body 'ntarg' (or 'ncent'),  */
+/* numbered as in jpl_pleph(),  from 1 to 13. */
+static void add_to_list(int list[14], const int body, const int list_val)
+{
+    const unsigned k = body - 1;
+
+    if(k <= 9) list[k] = list_val;   /* Major planets */
+    if(k == 9) list[2] = list_val;   /* for moon,  earth state is needed */
+    if(k == 2) list[9] = list_val;   /* for earth,  moon state is needed */
+    if(k == 12) list[2] = list_val;  /* EMBary state additionally */
+}
+
+/* Complete the barycentric states of the sun,  SSBary and EMBary,  and */
+/* turn the EMBary and geocentric moon given by jpl_state() into the    */
+/* earth and barycentric moon,  unless 'earth_moon' (moon from earth or */
+/* earth from moon) is set,  in which case the earth is put at zero.    */
+static void complete_states(const struct jpl_eph_data *eph,
+           const struct jpl_eph_cache *cache, const int list[14],
+           double pv[13][6], const int earth_moon)
+{
+    unsigned i;
+
+   /* Solar System barycentric Sun state goes to pv[10][] */
+   for(i = 0; i < 6; i++)
+      pv[10][i] = cache->pvsun[i];
+
+   /* Solar System Barycenter coordinates & velocities equal to zero */
+   for(i = 0; i < 6; i++)
+      pv[11][i] = 0.0;
+
+   /* Solar System barycentric EMBary state:  */
+   for(i = 0; i < 6; i++)
+      pv[12][i] = pv[2][i];
+
+   /* if moon from earth or earth from moon ..... */
+   if(earth_moon)
+      for(i = 0; i < 6; ++i) pv[2][i]=0.0;
+   else
+      {
+      if(list[2])           /* calculate earth state from EMBary */
+         for(i = 0; i < list[2] * 3u; ++i)
+            pv[2][i] -= pv[9][i]/(1.0+eph->emrat);
+
+      if(list[9]) /* calculate Solar System barycentric moon state */
+         for(i = 0; i < list[9] * 3u; ++i)
+            pv[9][i] += pv[2][i];
+      }
+}
+
+int DLL_FUNC jpl_pleph_cached(const void *ephem, void *cache, const double et,
+                 const int ntarg, const int ncent, double rrd[], const int calc_velocity)
+{
+    const struct jpl_eph_data *eph = (const struct jpl_eph_data *)ephem;
     double pv[13][6]={{0.}};/* pv is the position/velocity array
                              NUMBERED FROM ZERO: 0=Mercury,1=Venus,...
                              8=Pluto,9=Moon,10=Sun,11=SSBary,12=EMBary
@@ -189,7 +253,7 @@ int DLL_FUNC jpl_pleph(void *ephem, const double et, const int ntarg,
 	  //     which accesses it at byte offset 56.
 	  // I see it does explicitly NOT access list[14].
 	  // TODO: check again after next round of travis.
-          rval = jpl_state(ephem, et, list, pv, rrd, 0);
+          rval = jpl_state_cached(ephem, cache, et, list, pv, rrd, 0);
         }
         else          /*  quantity doesn't exist in the ephemeris file  */
           rval = JPL_EPH_QUANTITY_NOT_IN_EPHEMERIS;
@@ -202,51 +266,72 @@ int DLL_FUNC jpl_pleph(void *ephem, const double et, const int ntarg,
 
 /*  set up proper entries in 'list' array for state call     */
 
-    for(i = 0; i < 2; i++) /* list[] IS NUMBERED FROM ZERO ! */
-    {
-      const unsigned k = (i ? ncent : ntarg) - 1;
-
-      if(k <= 9) list[k] = list_val;   /* Major planets */
-      if(k == 9) list[2] = list_val;   /* for moon,  earth state is needed */
-      if(k == 2) list[9] = list_val;   /* for earth,  moon state is needed */
-      if(k == 12) list[2] = list_val;  /* EMBary state additionally */
-    }
+    add_to_list(list, ntarg, list_val);
+    add_to_list(list, ncent, list_val);
 
   /*   make call to state   */
-   rval = jpl_state(eph, et, list, pv, rrd, 1);
-   /* Solar System barycentric Sun state goes to pv[10][] */
-   if(ntarg == 11 || ncent == 11)
-      for(i = 0; i < 6; i++)
-         pv[10][i] = eph->pvsun[i];
+   rval = jpl_state_cached(ephem, cache, et, list, pv, rrd, 1);
+   complete_states(eph, (const struct jpl_eph_cache *)cache, list, pv,
+                   (ntarg*ncent) == 30 && (ntarg+ncent) == 13);
 
-   /* Solar System Barycenter coordinates & velocities equal to zero */
-   if(ntarg == 12 || ncent == 12)
-      for(i = 0; i < 6; i++)
-         pv[11][i] = 0.0;
+   for(i = 0; i < list_val * 3u; ++i)
+      rrd[i] = pv[ntarg-1][i] - pv[ncent-1][i];
 
-   /* Solar System barycentric EMBary state:  */
-   if(ntarg == 13 || ncent == 13)
-      for(i = 0; i < 6; i++)
-         pv[12][i] = pv[2][i];
+   return(rval);
+}
 
-   /* if moon from earth or earth from moon ..... */
-   if((ntarg*ncent) == 30 && (ntarg+ncent) == 13)
-      for(i = 0; i < 6; ++i) pv[2][i]=0.0;
-   else
-      {
-      if(list[2])           /* calculate earth state from EMBary */
-         for(i = 0; i < list[2] * 3u; ++i)
-            pv[2][i] -= pv[9][i]/(1.0+eph->emrat);
+int DLL_FUNC jpl_pleph_multi(const void *ephem, void *cache, const int n_et,
+                 const double et[], const int n_targ, const int ntarg[],
+                 const int ncent, double rrd[], const int calc_velocity)
+{
+    const struct jpl_eph_data *eph = (const struct jpl_eph_data *)ephem;
+    const int list_val = (calc_velocity ? 2 : 1);
+    int list[14];
+    int i, j;
+    unsigned k;
 
-      if(list[9]) /* calculate Solar System barycentric moon state */
-         for(i = 0; i < list[9] * 3u; ++i)
-            pv[9][i] += pv[2][i];
-      }
+    if(ncent > 13 || ncent < 1)
+      return(JPL_EPH_INVALID_INDEX);
+    for(k = 0; k < sizeof(list) / sizeof(list[0]); k++)
+      list[k] = 0;
+    add_to_list(list, ncent, list_val);
+    for(j = 0; j < n_targ; j++)
+    {
+      if(ntarg[j] > 13 || ntarg[j] < 1)
+        return(JPL_EPH_INVALID_INDEX);
+      add_to_list(list, ntarg[j], list_val);
+    }
 
-   for(i = 0; i < list_val * 3u; ++i)
-      rrd[i] = pv[ntarg-1][i] - pv[ncent-1][i];
+    for(i = 0; i < n_et; i++)
+    {
+      double pv[13][6]={{0.}}, moon_pv[13][6];
+      double *out = rrd + (size_t)i * n_targ * 6;
+      const int rval = jpl_state_cached(ephem, cache, et[i], list, pv, NULL, 1);
 
-   return(rval);
+      if(rval)
+        return(rval);
+      /* the moon from earth and earth from moon cases use the geocentric */
+      /* moon as is,  like jpl_pleph( ) does                              */
+      if(ncent == 3 || ncent == 10)
+      {
+        memcpy(moon_pv, pv, sizeof(pv));
+        complete_states(eph, (const struct jpl_eph_cache *)cache, list, moon_pv, 1);
+      }
+      complete_states(eph, (const struct jpl_eph_cache *)cache, list, pv, 0);
+
+      for(j = 0; j < n_targ; j++, out += 6)
+      {
+        const int earth_moon = ((ntarg[j]*ncent) == 30 && (ntarg[j]+ncent) == 13);
+        const double (*state)[6] = (earth_moon ? moon_pv : pv);
+
+        for(k = 0; k < 6; ++k)
+          out[k] = 0.0;
+        if(ntarg[j] != ncent)
+          for(k = 0; k < list_val * 3u; ++k)
+            out[k] = state[ntarg[j]-1][k] - state[ncent-1][k];
+      }
+    }
+    return(0);
 }
 
 /* Some notes about the information stored in 'iinfo':  the posn_coeff[]
@@ -581,13 +666,135 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
                           double pv[][6], double nut[4], const int bary)
 {
 	struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
+	const int rval = jpl_state_cached(ephem, eph->default_cache, et, list, pv, nut, bary);
+
+	memcpy(eph->pvsun, eph->default_cache->pvsun, sizeof(eph->pvsun));
+	eph->pvsun_t = eph->default_cache->pvsun_t;
+	return(rval);
+}
+
+void * DLL_FUNC jpl_alloc_cache(void)
+{
+	/* The cache is set up for a given ephemeris by reset_cache() on first use */
+	return(calloc(sizeof(struct jpl_eph_cache), 1));
+}
+
+void DLL_FUNC jpl_free_cache(void *cache_ptr)
+{
+	struct jpl_eph_cache *cache = (struct jpl_eph_cache *)cache_ptr;
+	unsigned i;
+
+	if(!cache)
+		return;
+	for(i = 0; i < JPL_CACHE_N_BLOCKS; i++)
+		free(cache->blocks[i].buffer);
+	free(cache);
+}
+
+static void reset_cache(struct jpl_eph_cache *cache, const struct jpl_eph_data *eph)
+{
+	unsigned i;
+
+	for(i = 0; i < JPL_CACHE_N_BLOCKS; i++)
+	{
+		struct jpl_cache_block *block = cache->blocks + i;
+
+		block->loc = (uint32_t)-1;
+		block->last_use = 0;
+		block->coeffs = NULL;
+		if(cache->buffer_size < eph->ncoeff)
+		{
+			free(block->buffer);
+			block->buffer = NULL;
+		}
+	}
+	if(cache->buffer_size < eph->ncoeff)
+		cache->buffer_size = eph->ncoeff;
+	cache->use_count = 0;
+	/* No valid epoch is out of the range of all ephemerides */
+	cache->pvsun_t = -HUGE_VAL;
+	cache->iinfo.posn_coeff[0] = 1.0;
+	/* Seed a bogus value here.  The first and subsequent calls to */
+	/* 'interp' will correct it to a value between -1 and +1.      */
+	cache->iinfo.posn_coeff[1] = -2.0;
+	cache->iinfo.vel_coeff[0] = 0.0;
+	cache->iinfo.vel_coeff[1] = 1.0;
+	cache->iinfo.n_posn_avail = cache->iinfo.n_vel_avail = 0;
+	cache->serial = eph->serial;
+}
+
+/* Get the coefficients of record 'nr' from the cache,  or else read them   */
+/* in place of the least recently used block.  When the file is mapped and  */
+/* in the byte order of the platform,  the coefficients are used in place.  */
+static int get_block(const struct jpl_eph_data *eph, struct jpl_eph_cache *cache,
+                     const uint32_t nr, const double **coeffs)
+{
+	struct jpl_cache_block *block = cache->blocks;
+	/* Read two blocks ahead to account for header: */
+	const int64_t offset = ((int64_t)nr + 2) * eph->recsize;
+	unsigned i;
+
+	cache->use_count++;
+	for(i = 0; i < JPL_CACHE_N_BLOCKS; i++)
+		if(cache->blocks[i].loc == nr)
+		{
+			cache->blocks[i].last_use = cache->use_count;
+			*coeffs = cache->blocks[i].coeffs;
+			return(0);
+		}
+
+	for(i = 1; i < JPL_CACHE_N_BLOCKS; i++)
+		if(cache->blocks[i].last_use < block->last_use)
+			block = cache->blocks + i;
+	block->loc = (uint32_t)-1;
+
+	if(eph->map && offset + eph->recsize > eph->map_size)
+		return(JPL_EPH_READ_ERROR);
+	if(eph->map && !eph->swap_bytes)
+		block->coeffs = (const double *)(eph->map + offset);
+	else
+	{
+		if(!block->buffer)
+		{
+			block->buffer = (double *)malloc(cache->buffer_size * sizeof(double));
+			if(!block->buffer)
+				return(JPL_EPH_READ_ERROR);
+		}
+		if(eph->map)
+			memcpy(block->buffer, eph->map + offset, eph->ncoeff * sizeof(double));
+		else
+		{
+			QMutexLocker lock(static_cast<QMutex *>(eph->file_lock));
+
+			if(FSeek(eph->ifile, offset, SEEK_SET))
+				return(JPL_EPH_FSEEK_ERROR);
+			if(fread(block->buffer, sizeof(double), (size_t)eph->ncoeff, eph->ifile)
+					!= (size_t)eph->ncoeff)
+				return(JPL_EPH_READ_ERROR);
+		}
+		if(eph->swap_bytes)
+			swap_64_bit_val(block->buffer, eph->ncoeff);
+		block->coeffs = block->buffer;
+	}
+	block->loc = nr;
+	block->last_use = cache->use_count;
+	*coeffs = block->coeffs;
+	return(0);
+}
+
+int DLL_FUNC jpl_state_cached(const void *ephem, void *cache_ptr, const double et,
+                 const int list[14], double pv[][6], double nut[4], const int bary)
+{
+	const struct jpl_eph_data *eph = (const struct jpl_eph_data *)ephem;
+	struct jpl_eph_cache *cache = (struct jpl_eph_cache *)cache_ptr;
 	unsigned i, j, n_intervals;
 	uint32_t nr;
-	double *buf = eph->cache;
+	const double *buf;
 	double t[2];
 	const double block_loc = (et - eph->ephem_start) / eph->ephem_step;
 	bool recompute_pvsun;
 	const double aufac = 1.0 / eph->au;
+	int rval;
 
 	/*   error return for epoch out of range  */
 	if(et < eph->ephem_start || et > eph->ephem_end)
@@ -603,30 +810,18 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 		nr--;
 	}
 
-	/*   read correct record if not in core (static vector buf[])   */
-	if(nr != eph->curr_cache_loc)
-	{
-		eph->curr_cache_loc = nr;
-		/* Read two blocks ahead to account for header: */
-		if(FSeek(eph->ifile, (nr + 2) * eph->recsize, SEEK_SET))
-		{
-			// GZ: Make sure we will try again on next call...
-			eph->curr_cache_loc=0;
-			return(JPL_EPH_FSEEK_ERROR);
-		}
-		if(fread(buf, sizeof(double), (size_t)eph->ncoeff, eph->ifile)
-				!= (size_t)eph->ncoeff)
-			return(JPL_EPH_READ_ERROR);
-
-		if(eph->swap_bytes)
-			swap_64_bit_val(buf, eph->ncoeff);
-	}
+	/*   read correct record if not in the cache   */
+	if(cache->serial != eph->serial)
+		reset_cache(cache, eph);
+	rval = get_block(eph, cache, nr, &buf);
+	if(rval)
+		return(rval);
 	t[1] = eph->ephem_step;
 
-	if(eph->pvsun_t != et)   /* If several calls are made for the same et, */
+	if(cache->pvsun_t != et)   /* If several calls are made for the same et, */
 	{                      /* don't recompute pvsun each time... only on */
 		recompute_pvsun = true;   /* the first run through.                     */
-		eph->pvsun_t = et;
+		cache->pvsun_t = et;
 	}
 	else
 		recompute_pvsun = false;
@@ -642,7 +837,7 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 		for(i = 0; i < 15; i++)
 		{
 			unsigned quantities;
-			uint32_t *iptr = &eph->ipt[i + 1][0];
+			const uint32_t *iptr;
 
 			if(i == 14)
 			{
@@ -656,15 +851,15 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 			}
 			if(n_intervals == iptr[2] && quantities)
 			{
-				double *dest = ((i == 10) ? eph->pvsun : pv[i]);
+				double *dest;
 
 				if(i < 10)
 					dest = pv[i];
 				else if(i == 14)
-					dest = eph->pvsun;
+					dest = cache->pvsun;
 				else
 					dest = nut;
-				interp(&eph->iinfo, &buf[iptr[0]-1], t, (int)iptr[1],
+				interp(&cache->iinfo, &buf[iptr[0]-1], t, (int)iptr[1],
 						dimension(i + 1),
 						n_intervals, quantities, dest);
 
@@ -676,11 +871,13 @@ int DLL_FUNC jpl_state(void *ephem, const double et, const int list[14],
 	if(!bary)                             /* gotta correct everybody for */
 		for(i = 0; i < 9; i++)            /* the solar system barycenter */
 			for(j = 0; j < (unsigned)list[i] * 3; j++)
-				pv[i][j] -= eph->pvsun[j];
+				pv[i][j] -= cache->pvsun[j];
 	return(0);
 }
 
 static int init_err_code = JPL_INIT_NOT_CALLED;
+/* Number of ephemerides initialized so far,  to tell them apart in caches */
+static uint32_t n_ephemerides = 0;
 
 int DLL_FUNC jpl_init_error_code(void)
 {
@@ -718,6 +915,34 @@ const char * jpl_init_error_message(void)
   }
 }
 
+bool jpl_check_result(const char *func, const int error_code, const double et, const int ntarg)
+{
+  switch(error_code)
+  {
+    case 0:
+      return true;
+    case JPL_EPH_OUTSIDE_RANGE:
+      qDebug() << func << ": JPL_EPH_OUTSIDE_RANGE at jde" << et << "for planet" << ntarg;
+      break;
+    case JPL_EPH_READ_ERROR:
+      qDebug() << func << ": JPL_EPH_READ_ERROR at jde" << et << "for planet" << ntarg;
+      break;
+    case JPL_EPH_QUANTITY_NOT_IN_EPHEMERIS:
+      qDebug() << func << ": JPL_EPH_QUANTITY_NOT_IN_EPHEMERIS at jde" << et << "for planet" << ntarg;
+      break;
+    case JPL_EPH_INVALID_INDEX:
+      qDebug() << func << ": JPL_EPH_INVALID_INDEX at jde" << et << "for planet" << ntarg;
+      break;
+    case JPL_EPH_FSEEK_ERROR:
+      qDebug() << func << ": JPL_EPH_FSEEK_ERROR at jde" << et << "for planet" << ntarg;
+      break;
+    default: // Should never happen...
+      qDebug() << func << ": unknown error" << error_code << "at jde" << et << "for planet" << ntarg;
+      break;
+  }
+  return false;
+}
+
    /* DE-430 has 572 constants.  That's more than the 400 constants */
    /* originally expected.  The remaining 172 are stored after the  */
    /* other header data :                                           */
@@ -757,6 +982,7 @@ void * DLL_FUNC jpl_init_ephemeris(const char *ephemeris_filename,
     struct jpl_eph_data temp_data;
 
     init_err_code = 0;
+    memset(&temp_data, 0, sizeof(temp_data));
     temp_data.ifile = ifile;
     if(!ifile)
       init_err_code = JPL_INIT_FILE_NOT_FOUND;
@@ -883,25 +1109,41 @@ void * DLL_FUNC jpl_init_ephemeris(const char *ephemeris_filename,
                /* we need is allocated in _one_ chunk,  then parceled out. */
                /* This looks a little weird,  but it simplifies error      */
                /* handling and cleanup.                                    */
-    rval = (struct jpl_eph_data *)calloc(sizeof(struct jpl_eph_data)
-                        + temp_data.recsize, 1);
-    if(!rval)
+    rval = (struct jpl_eph_data *)calloc(sizeof(struct jpl_eph_data), 1);
+    if(rval)
+    {
+      memcpy(rval, &temp_data, sizeof(struct jpl_eph_data));
+      rval->default_cache = (struct jpl_eph_cache *)jpl_alloc_cache();
+    }
+    if(!rval || !rval->default_cache)
     {
       init_err_code = JPL_INIT_MEMORY_FAILURE;
+      free(rval);
       fclose(ifile);
       return(NULL);
     }
-    memcpy(rval, &temp_data, sizeof(struct jpl_eph_data));
-    rval->iinfo.posn_coeff[0] = 1.0;
-            /* Seed a bogus value here.  The first and subsequent calls to */
-            /* 'interp' will correct it to a value between -1 and +1.      */
-    rval->iinfo.posn_coeff[1] = -2.0;
-    rval->iinfo.vel_coeff[0] = 0.0;
-    rval->iinfo.vel_coeff[1] = 1.0;
     rval->curr_cache_loc = (uint32_t)-1;
-    
-              /* The 'cache' data is right after the 'jpl_eph_data' struct: */
-    rval->cache = (double *)(rval + 1);
+    rval->serial = ++n_ephemerides;
+    rval->file_lock = new QMutex;
+
+               /* The coefficients are read from a map of the whole file,  */
+               /* so that concurrent readers don't have to share the file  */
+               /* position.  Without a map (e.g. DE431 on 32-bit systems), */
+               /* they are read with fread() under 'file_lock'.            */
+    QFile *map_file = new QFile(QFile::decodeName(ephemeris_filename));
+    if(map_file->open(QIODevice::ReadOnly))
+    {
+      rval->map_size = map_file->size();
+      rval->map = (const char *)map_file->map(0, rval->map_size);
+    }
+    if(rval->map)
+      rval->map_file = map_file;
+    else
+    {
+      qDebug() << "jpl_init_ephemeris(): cannot map" << map_file->fileName() << "in memory, reading it instead.";
+      delete map_file;
+    }
+
                /* If there are more than 400 constants,  the names of       */
                /* the extra constants are stored in what would normally     */
                /* be zero-padding after the header record.  However,        */
@@ -958,6 +1200,9 @@ void DLL_FUNC jpl_close_ephemeris(void *ephem)
 {
    struct jpl_eph_data *eph = (struct jpl_eph_data *)ephem;
 
+   jpl_free_cache(eph->default_cache);
+   delete static_cast<QFile *>(eph->map_file);
+   delete static_cast<QMutex *>(eph->file_lock);
    fclose(eph->ifile);
    free(ephem);
 }
@@ -973,6 +1218,8 @@ double DLL_FUNC jpl_get_constant(const int idx, void *ephem, char *constant_name
 	*constant_name = '\0';
 	if(idx >= 0 && idx < (int)eph->ncon)
 	{
+		QMutexLocker lock(static_cast<QMutex *>(eph->file_lock));
+
 		// GZ extended from const long to const long long
 		const long long seek_loc = (idx < 400 ? 84L * 3L + (long)idx * 6 :
 							START_400TH_CONSTANT_NAME + (idx - 400) * 6);
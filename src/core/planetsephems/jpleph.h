@@ -61,6 +61,28 @@ int DLL_FUNC make_sub_ephem( void *ephem, const char *sub_filename,
                               const double start_jd, const double end_jd);
 double DLL_FUNC jpl_get_constant( const int idx, void *ephem, char *constant_name);
 
+/* Reentrant variants, added for stellarium.  jpl_state() and jpl_pleph()
+   keep their interpolation state in the ephemeris itself,  so they must not
+   be called from several threads at once.  The _cached variants take that
+   state from a cache allocated by jpl_alloc_cache():  any number of threads
+   may read the same ephemeris concurrently,  each one with its own cache.
+   A cache may be used with any ephemeris;  it is reset when switching. */
+void * DLL_FUNC jpl_alloc_cache( void);
+void DLL_FUNC jpl_free_cache( void *cache);
+int DLL_FUNC jpl_state_cached( const void *ephem, void *cache, const double et,
+                 const int list[14], double pv[][6], double nut[4], const int bary);
+int DLL_FUNC jpl_pleph_cached( const void *ephem, void *cache, const double et,
+                 const int ntarg, const int ncent, double rrd[], const int calc_velocity);
+/* Positions (and velocities) of n_targ bodies relative to ncent at n_et
+   epochs,  each epoch interpolating its coefficient block once for all the
+   bodies.  rrd must hold n_et * n_targ * 6 doubles;  the state of target j
+   at epoch i starts at rrd[(i * n_targ + j) * 6].  ntarg and ncent are
+   numbered as in jpl_pleph(),  from 1 to 13.  Returns 0,  or the error of
+   the first epoch that failed (the following epochs are not computed). */
+int DLL_FUNC jpl_pleph_multi( const void *ephem, void *cache, const int n_et,
+                 const double et[], const int n_targ, const int ntarg[],
+                 const int ncent, double rrd[], const int calc_velocity);
+
 #ifdef __cplusplus
 }
 #endif
@@ -115,3 +137,6 @@ int DLL_FUNC jpl_init_error_code( void);
 #define CENTRAL_PLANET_ID   11  //ID of sun in JPL enumeration
 
 const char * jpl_init_error_message(void);
+/* Log the error returned by jpl_state( ),  jpl_pleph( ) or their variants,  if any,
+   for the target ntarg at et.  Returns whether there was no error. */
+bool jpl_check_result(const char *func, const int error_code, const double et, const int ntarg);
@@ -69,6 +69,30 @@ void GetL1OsculatingCoor(const double jd0,const double jd, const int body,double
   /* The oculating orbit of epoch jd0, evatuated at jd, is returned.
   */
 
+struct L1Context {
+  double t_0[4],t_1[4],t_2[4];
+  double elem_0[4*6];
+  double elem_1[4*6];
+  double elem_2[4*6];
+  double jd0[4];
+  double elem[4*6];
+};
+  /* Interpolation cache of the L1 elements, one for each satellite.
+     GetL1Coor() and GetL1OsculatingCoor() use a static context,
+     so they must only be called from one thread at a time.
+     Each thread computing positions concurrently must use its own context,
+     initialized by InitL1Context().
+  */
+
+void InitL1Context(struct L1Context *ctx);
+
+void GetL1CoorCtx(struct L1Context *ctx,double jd,int body,double *xyz);
+
+void GetL1OsculatingCoorCtx(struct L1Context *ctx,
+                            const double jd0,const double jd,
+                            const int body,double *xyz);
+  /* Same as above, using the given context. */
+
 
 #ifdef __cplusplus
 }
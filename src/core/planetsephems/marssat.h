@@ -70,6 +70,32 @@ void GetMarsSatOsculatingCoor(const double jd0, const double jd, const int body,
   /* The oculating orbit of epoch jd0, evatuated at jd, is returned.
   */
 
+struct MarsSatContext {
+  double t_0,t_1,t_2;
+  double elem_0[2*6];
+  double elem_1[2*6];
+  double elem_2[2*6];
+  double jd0;
+  double elem[2*6];
+  double to_vsop87[9];
+};
+  /* Interpolation cache of the elements of the mars satellites.
+     GetMarsSatCoor() and GetMarsSatOsculatingCoor() use a static context,
+     so they must only be called from one thread at a time.
+     Each thread computing positions concurrently must use its own context,
+     initialized by InitMarsSatContext().
+  */
+
+void InitMarsSatContext(struct MarsSatContext *ctx);
+
+void GetMarsSatCoorCtx(struct MarsSatContext *ctx,
+                       double jd,int body,double *xyz);
+
+void GetMarsSatOsculatingCoorCtx(struct MarsSatContext *ctx,
+                                 const double jd0, const double jd,
+                                 const int body,double *xyz);
+  /* Same as above, using the given context. */
+
 #ifdef __cplusplus
 }
 #endif
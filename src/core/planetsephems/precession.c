@@ -29,16 +29,7 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include <math.h>
 #include <assert.h>
 
-/* Interval threshold (days) for re-computing these values. with 1, compute only 1/day:  */
-#define PRECESSION_EPOCH_THRESHOLD 1.0
-/* Interval threshold (days) for re-computing nutation values. with 1/24, compute only every hour  */
-#define NUTATION_EPOCH_THRESHOLD (1./24.)
-
-/* cache results for retrieval if recomputation is not required */
-
-static double c_psi_A=0.0, c_omega_A=0.0, c_chi_A=0.0, /*c_p_A=0.0, */ c_epsilon_A=0.0,
-		c_Y_A=0.0, c_X_A=0.0, c_Q_A=0.0, c_P_A=0.0,
-		c_lastJDE=-1e100;
+/* The functions keep no state, so that they may be called from several threads at once. */
 
 static const double arcSec2Rad=M_PI*2.0/(360.0*3600.0);
 
@@ -111,155 +102,133 @@ static const double p_epsVals[10][5]=
 // 
 void getPrecessionAnglesVondrak(const double jde, double *epsilon_A, double *chi_A, double *omega_A, double *psi_A)
 {
-	if (fabs(jde-c_lastJDE) > PRECESSION_EPOCH_THRESHOLD)
+	double T=(jde-2451545.0)* (1.0/36525.0); // Julian centuries from J2000.0
+	assert(fabs(T)<=2000); // MAKES SURE YOU NEVER OVERSTRETCH THIS!
+	double T2pi= T*(2.0*M_PI); // Julian centuries from J2000.0, premultiplied by 2Pi
+	// these are actually small greek letters in the papers.
+	double Psi_A=0.0;
+	double Omega_A=0.0;
+	double Chi_A=0.0;
+	double Epsilon_A=0.0;
+	//double p_A=0.0; // currently unused. The data don't disturb.
+	int i;
+	for (i=0; i<18; ++i)
 	{
-		double T=(jde-2451545.0)* (1.0/36525.0); // Julian centuries from J2000.0
-		assert(fabs(T)<=2000); // MAKES SURE YOU NEVER OVERSTRETCH THIS!
-		double T2pi= T*(2.0*M_PI); // Julian centuries from J2000.0, premultiplied by 2Pi
-		// these are actually small greek letters in the papers.
-		double Psi_A=0.0;
-		double Omega_A=0.0;
-		double Chi_A=0.0;
-		double Epsilon_A=0.0;
-		//double p_A=0.0; // currently unused. The data don't disturb.
-		int i;
-		for (i=0; i<18; ++i)
-		{
-			double invP=precVals[i][0];
-			double sin2piT_P, cos2piT_P;
+		double invP=precVals[i][0];
+		double sin2piT_P, cos2piT_P;
 #ifdef _GNU_SOURCE
-			sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
+		sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
 #else
-			double phase=T2pi*invP;
-			sin2piT_P= sin(phase);
-			cos2piT_P= cos(phase);
+		double phase=T2pi*invP;
+		sin2piT_P= sin(phase);
+		cos2piT_P= cos(phase);
 #endif
-			Psi_A   += precVals[i][1]*cos2piT_P + precVals[i][4]*sin2piT_P;
-			Omega_A += precVals[i][2]*cos2piT_P + precVals[i][5]*sin2piT_P;
-			Chi_A   += precVals[i][3]*cos2piT_P + precVals[i][6]*sin2piT_P;
-		}
+		Psi_A   += precVals[i][1]*cos2piT_P + precVals[i][4]*sin2piT_P;
+		Omega_A += precVals[i][2]*cos2piT_P + precVals[i][5]*sin2piT_P;
+		Chi_A   += precVals[i][3]*cos2piT_P + precVals[i][6]*sin2piT_P;
+	}
 
-		for (i=0; i<10; ++i)
-		{
-			double invP=p_epsVals[i][0];
-			double sin2piT_P, cos2piT_P;
+	for (i=0; i<10; ++i)
+	{
+		double invP=p_epsVals[i][0];
+		double sin2piT_P, cos2piT_P;
 #ifdef _GNU_SOURCE
-			sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
+		sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
 #else
-			double phase=T2pi*invP;
-			sin2piT_P= sin(phase);
-			cos2piT_P= cos(phase);
+		double phase=T2pi*invP;
+		sin2piT_P= sin(phase);
+		cos2piT_P= cos(phase);
 #endif
-			//p_A       += p_epsVals[i][1]*cos2piT_P + p_epsVals[i][3]*sin2piT_P;
-			Epsilon_A += p_epsVals[i][2]*cos2piT_P + p_epsVals[i][4]*sin2piT_P;
-		}
-
-		Psi_A     += (( 289.e-9*T - 0.00740913)*T + 5042.7980307)*T +  8473.343527;
-		Omega_A   += (( 151.e-9*T + 0.00000146)*T -    0.4436568)*T + 84283.175915;
-		Chi_A     += (( -61.e-9*T + 0.00001472)*T +    0.0790159)*T -    19.657270;
-		//p_A       += ((271.e-9*T - 0.00710733)*T + 5043.0520035)*T +  8134.017132;
-		Epsilon_A += ((-110.e-9*T - 0.00004039)*T +    0.3624445)*T + 84028.206305;
-		c_psi_A     = arcSec2Rad*Psi_A;
-		c_omega_A   = arcSec2Rad*Omega_A;
-		c_chi_A     = arcSec2Rad*Chi_A;
-		// c_p_A     = arcSec2Rad*p_A;
-		c_epsilon_A = arcSec2Rad*Epsilon_A;
+		//p_A       += p_epsVals[i][1]*cos2piT_P + p_epsVals[i][3]*sin2piT_P;
+		Epsilon_A += p_epsVals[i][2]*cos2piT_P + p_epsVals[i][4]*sin2piT_P;
 	}
-	*psi_A     = c_psi_A;
-	*omega_A   = c_omega_A;
-	*chi_A     = c_chi_A;
-	*epsilon_A = c_epsilon_A;
+
+	Psi_A     += (( 289.e-9*T - 0.00740913)*T + 5042.7980307)*T +  8473.343527;
+	Omega_A   += (( 151.e-9*T + 0.00000146)*T -    0.4436568)*T + 84283.175915;
+	Chi_A     += (( -61.e-9*T + 0.00001472)*T +    0.0790159)*T -    19.657270;
+	//p_A       += ((271.e-9*T - 0.00710733)*T + 5043.0520035)*T +  8134.017132;
+	Epsilon_A += ((-110.e-9*T - 0.00004039)*T +    0.3624445)*T + 84028.206305;
+	*psi_A     = arcSec2Rad*Psi_A;
+	*omega_A   = arcSec2Rad*Omega_A;
+	*chi_A     = arcSec2Rad*Chi_A;
+	*epsilon_A = arcSec2Rad*Epsilon_A;
 }
 
 void getPrecessionAnglesVondrakPQXYe(const double jde, double *vP_A, double *vQ_A, double *vX_A, double *vY_A, double *vepsilon_A)
 {
-	if (fabs(jde-c_lastJDE) > PRECESSION_EPOCH_THRESHOLD)
+	double T=(jde-2451545.0)* (1.0/36525.0);
+	assert(fabs(T)<=2000); // MAKES SURE YOU NEVER OVERSTRETCH THIS!
+	double T2pi= T*(2.0*M_PI); // Julian centuries from J2000.0, premultiplied by 2Pi
+	// these are actually small greek letters in the papers.
+	double P_A=0.0;
+	double Q_A=0.0;
+	double X_A=0.0;
+	double Y_A=0.0;
+	double Epsilon_A=0.0;
+	int i;
+	for (i=0; i<8; ++i)
 	{
-		double T=(jde-2451545.0)* (1.0/36525.0);
-		assert(fabs(T)<=2000); // MAKES SURE YOU NEVER OVERSTRETCH THIS!
-		double T2pi= T*(2.0*M_PI); // Julian centuries from J2000.0, premultiplied by 2Pi
-		// these are actually small greek letters in the papers.
-		double P_A=0.0;
-		double Q_A=0.0;
-		double X_A=0.0;
-		double Y_A=0.0;
-		double Epsilon_A=0.0;
-		int i;
-		for (i=0; i<8; ++i)
-		{
-			double invP=PQvals[i][0];
-			double sin2piT_P, cos2piT_P;
+		double invP=PQvals[i][0];
+		double sin2piT_P, cos2piT_P;
 #ifdef _GNU_SOURCE
-			sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
+		sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
 #else
-			double phase=T2pi*invP;
-			sin2piT_P= sin(phase);
-			cos2piT_P= cos(phase);
+		double phase=T2pi*invP;
+		sin2piT_P= sin(phase);
+		cos2piT_P= cos(phase);
 #endif
-			P_A += PQvals[i][1]*cos2piT_P + PQvals[i][3]*sin2piT_P;
-			Q_A += PQvals[i][2]*cos2piT_P + PQvals[i][4]*sin2piT_P;
-		}
-		for (i=0; i<14; ++i)
-		{
-			double invP=XYvals[i][0];
-			double sin2piT_P, cos2piT_P;
+		P_A += PQvals[i][1]*cos2piT_P + PQvals[i][3]*sin2piT_P;
+		Q_A += PQvals[i][2]*cos2piT_P + PQvals[i][4]*sin2piT_P;
+	}
+	for (i=0; i<14; ++i)
+	{
+		double invP=XYvals[i][0];
+		double sin2piT_P, cos2piT_P;
 #ifdef _GNU_SOURCE
-			sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
+		sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
 #else
-			double phase=T2pi*invP;
-			sin2piT_P= sin(phase);
-			cos2piT_P= cos(phase);
+		double phase=T2pi*invP;
+		sin2piT_P= sin(phase);
+		cos2piT_P= cos(phase);
 #endif
-			X_A += XYvals[i][1]*cos2piT_P + XYvals[i][3]*sin2piT_P;
-			Y_A += XYvals[i][2]*cos2piT_P + XYvals[i][4]*sin2piT_P;
-		}
-		for (i=0; i<10; ++i)
-		{
-			double invP=p_epsVals[i][0];
-			double sin2piT_P, cos2piT_P;
+		X_A += XYvals[i][1]*cos2piT_P + XYvals[i][3]*sin2piT_P;
+		Y_A += XYvals[i][2]*cos2piT_P + XYvals[i][4]*sin2piT_P;
+	}
+	for (i=0; i<10; ++i)
+	{
+		double invP=p_epsVals[i][0];
+		double sin2piT_P, cos2piT_P;
 #ifdef _GNU_SOURCE
-			sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
+		sincos(T2pi*invP, &sin2piT_P, &cos2piT_P);
 #else
-			double phase=T2pi*invP;
-			sin2piT_P= sin(phase);
-			cos2piT_P= cos(phase);
+		double phase=T2pi*invP;
+		sin2piT_P= sin(phase);
+		cos2piT_P= cos(phase);
 #endif
-			//p_A       += p_epsVals[i][1]*cos2piT_P + p_epsVals[i][3]*sin2piT_P;
-			Epsilon_A += p_epsVals[i][2]*cos2piT_P + p_epsVals[i][4]*sin2piT_P;
-		}
-
-		// Now the polynomial terms in T. Horner's scheme is best again.
-		P_A       += (( 110.e-9*T - 0.00028913)*T -    0.1189000)*T +  5851.607687;
-		Q_A       += ((-437.e-9*T - 0.00000020)*T +    1.1689818)*T -  1600.886300;
-		X_A       += ((-152.e-9*T - 0.00037173)*T +    0.4252841)*T +  5453.282155;
-		Y_A       += ((+231.e-9*T - 0.00018725)*T -    0.7675452)*T - 73750.930350;
-		Epsilon_A += (( 110.e-9*T - 0.00004039)*T +    0.3624445)*T + 84028.206305;
-		c_P_A       = arcSec2Rad*P_A;
-		c_Q_A       = arcSec2Rad*Q_A;
-		c_X_A       = arcSec2Rad*X_A;
-		c_Y_A       = arcSec2Rad*Y_A;
-		c_epsilon_A = arcSec2Rad*Epsilon_A;
+		//p_A       += p_epsVals[i][1]*cos2piT_P + p_epsVals[i][3]*sin2piT_P;
+		Epsilon_A += p_epsVals[i][2]*cos2piT_P + p_epsVals[i][4]*sin2piT_P;
 	}
-	*vP_A       = c_P_A;
-	*vQ_A       = c_Q_A;
-	*vX_A       = c_X_A;
-	*vY_A       = c_Y_A;
-	*vepsilon_A = c_epsilon_A;
 
+	// Now the polynomial terms in T. Horner's scheme is best again.
+	P_A       += (( 110.e-9*T - 0.00028913)*T -    0.1189000)*T +  5851.607687;
+	Q_A       += ((-437.e-9*T - 0.00000020)*T +    1.1689818)*T -  1600.886300;
+	X_A       += ((-152.e-9*T - 0.00037173)*T +    0.4252841)*T +  5453.282155;
+	Y_A       += ((+231.e-9*T - 0.00018725)*T -    0.7675452)*T - 73750.930350;
+	Epsilon_A += (( 110.e-9*T - 0.00004039)*T +    0.3624445)*T + 84028.206305;
+	*vP_A       = arcSec2Rad*P_A;
+	*vQ_A       = arcSec2Rad*Q_A;
+	*vX_A       = arcSec2Rad*X_A;
+	*vY_A       = arcSec2Rad*Y_A;
+	*vepsilon_A = arcSec2Rad*Epsilon_A;
 }
 
-//! Just return (presumably precomputed) ecliptic obliquity.
+//! Return the ecliptic obliquity.
 double getPrecessionAngleVondrakEpsilon(const double jde)
 {
 	double epsilon_A, dummy_chi_A, dummy_omega_A, dummy_psi_A;
 	getPrecessionAnglesVondrak(jde, &epsilon_A, &dummy_chi_A, &dummy_omega_A, &dummy_psi_A);
 	return epsilon_A;
 }
-//! Just return (presumably precomputed) ecliptic obliquity.
-double getPrecessionAngleVondrakCurrentEpsilonA(void)
-{
-	return c_epsilon_A;
-}
 
 // ====================== NUTATION IAU-2000B below.
 
@@ -363,12 +332,6 @@ static const struct nut2000B nut2000Btable[78] = {
 { -2,  0,  2,  4,  2,     7.35,      -1214,       0,      518,     0,      5,     2},
 { -1,  0,  4,  0,  2,     9.06,       1146,       0,     -490,     0,     -3,    -1}};
 
-/* cache results for retrieval if recomputation is not required */
-static double c_deltaEps=0.0;
-static double c_deltaPsi=0.0;
-static double c_jdeLastNut=-1e-100;
-
-
 //! Compute and return nutation angles of the abridged IAU-2000B nutation.
 //! Ref: Dennis D. McCarthy and Brian J. Lizum: An Abridged Model of the Precession-Nutation of the Celestial Pole.
 //! Celestial Mechanics and Dynamical Astronomy 85: 37-49, 2003.
@@ -392,40 +355,34 @@ void getNutationAngles(const double JDE, double *deltaPsi, double *deltaEpsilon)
 			return;
 	}
 
-	if (fabs(JDE-c_jdeLastNut)>NUTATION_EPOCH_THRESHOLD)
+	double t=(JDE-2451545.0)/36525.0;
+	// F1 : l = mean anomaly of the Moon ['']
+	double     l  =  (485868.249036 + 1717915923.2178*t);//*arcSec2Rad;
+	// F2 : l' = mean anomaly of the Sun ['']
+	double     ls = (1287104.79305 + 129596581.0481*t);//*arcSec2Rad;
+	// F3 : F = L - Omega (L is the mean longitude of the Moon)
+	double      F = (335779.526232 + 1739527262.8478*t);//*arcSec2Rad;
+	// F4 : D = mean elongation of the Moon from the Sun
+	double      D =  (1072260.70369 + 1602961601.2090*t);//*arcSec2Rad;
+	// F5 : Omega = mean longitude of the ascending node of the lunar orbit
+	double Omega  = (450160.398036 - 6962890.5431*t);//*arcSec2Rad;
+
+	double deltaEpsSec=0.0, deltaPsiSec=0.0;
+	int i;
+	for (i=0; i<78; ++i)
 	{
-		c_jdeLastNut=JDE;
-		double t=(JDE-2451545.0)/36525.0;
-		// F1 : l = mean anomaly of the Moon ['']
-		double     l  =  (485868.249036 + 1717915923.2178*t);//*arcSec2Rad;
-		// F2 : l' = mean anomaly of the Sun ['']
-		double     ls = (1287104.79305 + 129596581.0481*t);//*arcSec2Rad;
-		// F3 : F = L - Omega (L is the mean longitude of the Moon)
-		double      F = (335779.526232 + 1739527262.8478*t);//*arcSec2Rad;
-		// F4 : D = mean elongation of the Moon from the Sun
-		double      D =  (1072260.70369 + 1602961601.2090*t);//*arcSec2Rad;
-		// F5 : Omega = mean longitude of the ascending node of the lunar orbit
-		double Omega  = (450160.398036 - 6962890.5431*t);//*arcSec2Rad;
-
-		double deltaEps=0.0, deltaPsi=0.0;
-		int i;
-		for (i=0; i<78; ++i)
-		{
-			const struct nut2000B *nut=&nut2000Btable[i];
-			double theta=nut->l_factor*l + nut->ls_factor*ls + nut->F_factor*F + nut->D_factor*D + nut->Omega_factor*Omega;
-			theta *=arcSec2Rad;
-			double sinTheta=sin(theta);
-			double cosTheta=cos(theta);
-			deltaPsi+=(nut->A + nut->Ap*t)*sinTheta + nut->App*cosTheta;
-			deltaEps+=(nut->B + nut->Bp*t)*cosTheta + nut->Bpp*sinTheta;
-		}
-		deltaPsi *= 1e-7; // convert from units of 0.1uas to arcsec. (The paper says mas, but this is an error!)
-		deltaEps *= 1e-7;
-		deltaPsi -= (0.29965*t + 0.0417750 + 0.0015835);
-		deltaEps -= (0.02524*t + 0.0068192 - 0.0016339);
-		c_deltaPsi = deltaPsi * arcSec2Rad;
-		c_deltaEps = deltaEps * arcSec2Rad;
+		const struct nut2000B *nut=&nut2000Btable[i];
+		double theta=nut->l_factor*l + nut->ls_factor*ls + nut->F_factor*F + nut->D_factor*D + nut->Omega_factor*Omega;
+		theta *=arcSec2Rad;
+		double sinTheta=sin(theta);
+		double cosTheta=cos(theta);
+		deltaPsiSec+=(nut->A + nut->Ap*t)*sinTheta + nut->App*cosTheta;
+		deltaEpsSec+=(nut->B + nut->Bp*t)*cosTheta + nut->Bpp*sinTheta;
 	}
+	deltaPsiSec *= 1e-7; // convert from units of 0.1uas to arcsec. (The paper says mas, but this is an error!)
+	deltaEpsSec *= 1e-7;
+	deltaPsiSec -= (0.29965*t + 0.0417750 + 0.0015835);
+	deltaEpsSec -= (0.02524*t + 0.0068192 - 0.0016339);
 	double limiter=1.0;
 	if (JDE<NUT_BEGIN)
 	{
@@ -436,6 +393,6 @@ void getNutationAngles(const double JDE, double *deltaPsi, double *deltaEpsilon)
 		limiter=1.-(JDE-NUT_END)/NUT_TRANSITION;
 	}
 
-	*deltaPsi=c_deltaPsi*limiter;
-	*deltaEpsilon=c_deltaEps*limiter;
+	*deltaPsi=deltaPsiSec*arcSec2Rad*limiter;
+	*deltaEpsilon=deltaEpsSec*arcSec2Rad*limiter;
 }
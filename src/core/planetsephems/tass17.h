@@ -69,6 +69,27 @@ extern "C" {
 void GetTass17Coor(double jd,int body,double *xyz);
 void GetTass17OsculatingCoor(const double jd0,const double jd, const int body,double *xyz);
 
+#define TASS17_DIM (8*6)
+
+struct Tass17Context {
+  double t_0,t_1,t_2;
+  double elem_0[TASS17_DIM];
+  double elem_1[TASS17_DIM];
+  double elem_2[TASS17_DIM];
+  double jd0;
+  double elem[TASS17_DIM];
+};
+  /* Interpolation cache of the TASS1.7 elements.
+     GetTass17Coor() and GetTass17OsculatingCoor() use a static context,
+     so they must only be called from one thread at a time.
+     Each thread computing positions concurrently must use its own context,
+     initialized by InitTass17Context().
+  */
+
+void InitTass17Context(struct Tass17Context *ctx);
+void GetTass17CoorCtx(struct Tass17Context *ctx,double jd,int body,double *xyz);
+void GetTass17OsculatingCoorCtx(struct Tass17Context *ctx,const double jd0,const double jd, const int body,double *xyz);
+
 #ifdef __cplusplus
 }
 #endif
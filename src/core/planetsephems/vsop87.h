@@ -63,6 +63,39 @@ void GetVsop87OsculatingCoor(const double jd0,const double jd, const int body,do
   /* The oculating orbit of epoch jd0, evaluated at jd, is returned.
   */
 
+#define VSOP87_DIM (8*6)
+
+struct Vsop87Context {
+  double t_0,t_1,t_2;
+  double elem_0[VSOP87_DIM];
+  double elem_1[VSOP87_DIM];
+  double elem_2[VSOP87_DIM];
+  double jd0;
+  double elem[VSOP87_DIM];
+};
+  /* Interpolation cache of the VSOP87 elements.
+     GetVsop87Coor() and GetVsop87OsculatingCoor() use a static context,
+     so they must only be called from one thread at a time.
+     Each thread computing positions concurrently must use its own context,
+     initialized by InitVsop87Context().
+  */
+
+void InitVsop87Context(struct Vsop87Context *ctx);
+
+void GetVsop87CoorCtx(struct Vsop87Context *ctx,
+                      double jd,int body,double *xyz);
+
+void GetVsop87OsculatingCoorCtx(struct Vsop87Context *ctx,
+                                const double jd0,const double jd,
+                                const int body,double *xyz);
+  /* Same as above, using the given context. */
+
+void GetVsop87CoorExact(double jd,int body,double *xyz);
+  /* Same as GetVsop87Coor(), computing the elements at jd instead of
+     interpolating them. Needs no context, but is slower when called
+     for close dates.
+  */
+
 #ifdef __cplusplus
 }
 #endif
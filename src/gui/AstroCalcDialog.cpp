@@ -26,8 +26,10 @@
 #include "StelTranslator.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StelFileMgr.hpp"
+#include "StelSkyDrawer.hpp"
 
 #include "SolarSystem.hpp"
+#include "SolarSystemEphemeris.hpp"
 #include "Planet.hpp"
 #include "NebulaMgr.hpp"
 #include "Nebula.hpp"
@@ -177,6 +179,8 @@ void AstroCalcDialog::setPlanetaryPositionsHeaderNames()
 void AstroCalcDialog::currentPlanetaryPositions()
 {
 	float ra, dec;
+	// Including the minor planets too faint to be drawn
+	solarSystem->computeCulledPositions();
 	QList<PlanetP> allPlanets = solarSystem->getAllPlanets();
 
 	initListPlanetaryPositions();
@@ -333,26 +337,41 @@ void AstroCalcDialog::generateEphemeris()
 			break;
 	}
 
-	StelObjectP obj = solarSystem->searchByName(currentPlanet);
+	PlanetP obj = solarSystem->searchByEnglishName(currentPlanet);
 	if (obj)
 	{
-		double currentJD = core->getJD(); // save current JD
 		double firstJD = StelUtils::qDateTimeToJd(ui->dateFromDateTimeEdit->dateTime());
 		firstJD = firstJD - StelUtils::getGMTShiftFromQT(firstJD)/24;
 		int elements = (int)((StelUtils::qDateTimeToJd(ui->dateToDateTimeEdit->dateTime()) - firstJD)/currentStep);
+		QVector<double> dates;
+		dates.reserve(elements);
+		for (int i=0; i<elements; i++)
+			dates.append(firstJD + i*currentStep);
+
+		// The positions are computed without changing the date of the core
+		const SolarSystemEphemeris ephemeris(core, core->getCurrentLocation());
+		QVector<SolarSystemEphemeris::Position> positions;
+		ephemeris.compute(obj, dates, positions);
+		const bool withExtinction = core->getSkyDrawer()->getFlagHasAtmosphere();
+
 		EphemerisListJ2000.clear();
-		EphemerisListJ2000.reserve(elements);
+		EphemerisListJ2000.reserve(positions.size());
 		EphemerisListDates.clear();
-		EphemerisListDates.reserve(elements);
-		for (int i=0; i<elements; i++)
+		EphemerisListDates.reserve(positions.size());
+		foreach (const SolarSystemEphemeris::Position& position, positions)
 		{
-			double JD = firstJD + i*currentStep;
-			core->setJD(JD);
-			core->update(0); // force update to get new coordinates			
-			Vec3d pos = obj->getJ2000EquatorialPos(core);
+			double JD = position.JD;
+			Vec3d pos = position.j2000EquatorialPos;
 			EphemerisListJ2000.append(pos);
 			EphemerisListDates.append(StelUtils::jdToQDateTime(JD + StelUtils::getGMTShiftFromQT(JD)/24).toString("yyyy-MM-dd"));
 			StelUtils::rectToSphe(&ra,&dec,pos);
+			float vMag = position.vMagnitude;
+			if (withExtinction)
+			{
+				Vec3d altAzPos = position.altAzPos;
+				altAzPos.normalize();
+				core->getSkyDrawer()->getExtinction().forward(altAzPos, &vMag);
+			}
 			ACTreeWidgetItem *treeItem = new ACTreeWidgetItem(ui->ephemerisTreeWidget);
 			// local date and time
 			treeItem->setText(EphemerisDate, StelUtils::jdToQDateTime(JD + StelUtils::getGMTShiftFromQT(JD)/24).toString("yyyy-MM-dd hh:mm:ss"));
@@ -361,10 +380,9 @@ void AstroCalcDialog::generateEphemeris()
 			treeItem->setTextAlignment(EphemerisRA, Qt::AlignRight);
 			treeItem->setText(EphemerisDec, StelUtils::radToDmsStr(dec, true));
 			treeItem->setTextAlignment(EphemerisDec, Qt::AlignRight);
-			treeItem->setText(EphemerisMagnitude, QString::number(obj->getVMagnitudeWithExtinction(core), 'f', 2));
+			treeItem->setText(EphemerisMagnitude, QString::number(vMag, 'f', 2));
 			treeItem->setTextAlignment(EphemerisMagnitude, Qt::AlignRight);
 		}
-		core->setJD(currentJD); // restore time
 	}
 
 	// adjust the column width
@@ -709,11 +727,13 @@ void AstroCalcDialog::calculatePhenomena()
 	PlanetP planet = solarSystem->searchByEnglishName(currentPlanet);
 	if (planet)
 	{
-		double currentJD = core->getJD(); // save current JD
+		// The positions are computed without changing the date of the core
+		const SolarSystemEphemeris ephemeris(core, core->getCurrentLocation());
 		double startJD = StelUtils::qDateTimeToJd(ui->phenomenFromDateEdit->dateTime());
 		double stopJD = StelUtils::qDateTimeToJd(ui->phenomenToDateEdit->dateTime());
 		startJD = startJD - StelUtils::getGMTShiftFromQT(startJD)/24;
 		stopJD = stopJD - StelUtils::getGMTShiftFromQT(stopJD)/24;
+		const double maxSeparation = separation*M_PI/180.;
 
 		if (obj2Type<9)
 		{
@@ -721,9 +741,9 @@ void AstroCalcDialog::calculatePhenomena()
 			foreach (PlanetP obj, objects)
 			{
 				// conjunction
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation, false), planet, obj, false);
+				fillPhenomenaTable(ephemeris.findClosestApproaches(planet, obj, startJD, stopJD, maxSeparation, false), planet, obj, false);
 				// opposition
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation, true), planet, obj, true);
+				fillPhenomenaTable(ephemeris.findClosestApproaches(planet, obj, startJD, stopJD, maxSeparation, true), planet, obj, true);
 			}
 		}
 		else
@@ -732,13 +752,9 @@ void AstroCalcDialog::calculatePhenomena()
 			foreach (NebulaP obj, dso)
 			{
 				// conjunction
-				fillPhenomenaTable(findClosestApproach(planet, obj, startJD, stopJD, separation), planet, obj);
+				fillPhenomenaTable(ephemeris.findClosestApproaches(planet, obj->getJ2000EquatorialPos(core), startJD, stopJD, maxSeparation), planet, obj);
 			}
 		}
-
-
-		core->setJD(currentJD); // restore time
-		core->update(0);
 	}
 
 	// adjust the column width
@@ -791,9 +807,6 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	QMap<double, double>::ConstIterator it;
 	for (it=list.constBegin(); it!=list.constEnd(); ++it)
 	{
-		core->setJD(it.key());
-		core->update(0);
-
 		QString phenomenType = q_("Conjunction");
 		double separation = it.value();
 		if (opposition)
@@ -812,142 +825,11 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	}
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, PlanetP &object2, double startJD, double stopJD, double maxSeparation, bool opposition)
-{
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/4.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object2->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus" || object2->getEnglishName()=="Uranus")
-		if (step0 > 3652.5)
-			step0 = 3652.5;
-	if (object1->getEnglishName()=="Jupiter" || object2->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn" || object2->getEnglishName()=="Saturn")
-		if (step0 > 365.25)
-			step0 = 365.f;
-	if (object1->getEnglishName()=="Mars" || object2->getEnglishName()=="Mars")
-		if (step0 > 10.f)
-			step0 = 10.f;
-	if (object1->getEnglishName()=="Venus" || object2->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury" || object2->getEnglishName()=="Mercury")
-		if (step0 > 5.f)
-			step0 = 5.f;
-	if (object1->getEnglishName()=="Moon" || object2->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2, opposition);
-	jd += step;
-	while(jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2, opposition);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2, opposition);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn, opposition))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, PlanetP object2, double JD, double step, int prevSign, bool opposition)
-{
-	int sgn;
-	double dist, prevDist;
-
-	if (out==NULL)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2, opposition);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2, opposition);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2, opposition);
-			if (out->second < findDistance(JD - 5.0, object1, object2, opposition))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, PlanetP object2, bool opposition)
-{
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	double angle = obj1.angle(obj2);
-	if (opposition)
-		angle = M_PI - angle;
-	return angle;
-}
-
 void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const PlanetP object1, const NebulaP object2)
 {
 	QMap<double, double>::ConstIterator it;
 	for (it=list.constBegin(); it!=list.constEnd(); ++it)
 	{
-		core->setJD(it.key());
-		core->update(0);
-
 		QString phenomenType = q_("Conjunction");
 		double separation = it.value();
 
@@ -964,131 +846,6 @@ void AstroCalcDialog::fillPhenomenaTable(const QMap<double, double> list, const
 	}
 }
 
-QMap<double, double> AstroCalcDialog::findClosestApproach(PlanetP &object1, NebulaP &object2, double startJD, double stopJD, double maxSeparation)
-{
-	double dist, prevDist, step, step0;
-	int sgn, prevSgn = 0;
-	QMap<double, double> separations;
-	QPair<double, double> extremum;
-
-	step0 = (stopJD - startJD)/4.0;
-	if (step0>24.8*365.25)
-		step0 = 24.8*365.25;
-
-	if (object1->getEnglishName()=="Neptune" || object1->getEnglishName()=="Uranus")
-		if (step0 > 3652.5)
-			step0 = 3652.5;
-	if (object1->getEnglishName()=="Jupiter" || object1->getEnglishName()=="Saturn")
-		if (step0 > 365.25)
-			step0 = 365.f;
-	if (object1->getEnglishName()=="Mars")
-		if (step0 > 10.f)
-			step0 = 10.f;
-	if (object1->getEnglishName()=="Venus" || object1->getEnglishName()=="Mercury")
-		if (step0 > 5.f)
-			step0 = 5.f;
-	if (object1->getEnglishName()=="Moon")
-		if (step0 > 0.25)
-			step0 = 0.25;
-
-	step = step0;
-	double jd = startJD;
-	prevDist = findDistance(jd, object1, object2);
-	jd += step;
-	while(jd <= stopJD)
-	{
-		dist = findDistance(jd, object1, object2);
-		sgn = StelUtils::sign(dist - prevDist);
-
-		double factor = qAbs((dist - prevDist)/dist);
-		if (factor>10.f)
-			step = step0 * factor/10.f;
-		else
-			step = step0;
-
-		if (sgn != prevSgn && prevSgn == -1)
-		{
-			if (step > step0)
-			{
-				jd -= step;
-				step = step0;
-				sgn = prevSgn;
-				while(jd <= stopJD)
-				{
-					dist = findDistance(jd, object1, object2);
-					sgn = StelUtils::sign(dist - prevDist);
-					if (sgn!=prevSgn)
-						break;
-
-					prevDist = dist;
-					prevSgn = sgn;
-					jd += step;
-				}
-			}
-
-			if (findPrecise(&extremum, object1, object2, jd, step, sgn))
-			{
-				double sep = extremum.second*180./M_PI;
-				if (sep<maxSeparation)
-					separations.insert(extremum.first, extremum.second);
-			}
-
-		}
-
-		prevDist = dist;
-		prevSgn = sgn;
-		jd += step;
-	}
-
-	return separations;
-}
-
-bool AstroCalcDialog::findPrecise(QPair<double, double> *out, PlanetP object1, NebulaP object2, double JD, double step, int prevSign)
-{
-	int sgn;
-	double dist, prevDist;
-
-	if (out==NULL)
-		return false;
-
-	prevDist = findDistance(JD, object1, object2);
-	step = -step/2.f;
-	prevSign = -prevSign;
-
-	while(true)
-	{
-		JD += step;
-		dist = findDistance(JD, object1, object2);
-
-		if (qAbs(step)< 1.f/1440.f)
-		{
-			out->first = JD - step/2.0;
-			out->second = findDistance(JD - step/2.0, object1, object2);
-			if (out->second < findDistance(JD - 5.0, object1, object2))
-				return true;
-			else
-				return false;
-		}
-		sgn = StelUtils::sign(dist - prevDist);
-		if (sgn!=prevSign)
-		{
-			step = -step/2.0;
-			sgn = -sgn;
-		}
-		prevDist = dist;
-		prevSign = sgn;
-	}
-}
-
-double AstroCalcDialog::findDistance(double JD, PlanetP object1, NebulaP object2)
-{
-	core->setJD(JD);
-	core->update(0);
-	Vec3d obj1 = object1->getJ2000EquatorialPos(core);
-	Vec3d obj2 = object2->getJ2000EquatorialPos(core);
-	return obj1.angle(obj2);
-}
-
 void AstroCalcDialog::changePage(QListWidgetItem *current, QListWidgetItem *previous)
 {
 	if (!current)
@@ -23,6 +23,7 @@
 #include "StelLogger.hpp"
 #include "StelFileMgr.hpp"
 #include "CLIProcessor.hpp"
+#include "CLIEphemeris.hpp"
 #include "StelIniParser.hpp"
 #include "StelUtils.hpp"
 #ifndef DISABLE_SCRIPTING
@@ -144,6 +145,14 @@ int main(int argc, char **argv)
 	QCoreApplication::addLibraryPath(appInfo.absolutePath());
 	#endif	
 
+	// The ephemeris batch mode needs no display, so that it also runs on servers without one
+	QStringList preArgList;
+	for (int i=0; i<argc; ++i)
+		preArgList << argv[i];
+	preArgList += QString(qgetenv("STEL_OPTS").constData()).split(" ");
+	if (CLIEphemeris::isRequested(preArgList) && qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
 	QGuiApplication::setDesktopSettingsAware(false);
 
 #ifndef USE_QUICKVIEW
@@ -163,12 +172,6 @@ int main(int argc, char **argv)
 	// Init the file manager
 	StelFileMgr::init();
 
-	QPixmap pixmap(StelFileMgr::findFile("data/splash.png"));
-	QSplashScreen splash(pixmap);
-	splash.show();
-	splash.showMessage(StelUtils::getApplicationVersion() , Qt::AlignLeft, Qt::white);
-	app.processEvents();
-
 	// Log command line arguments.
 	QString argStr;
 	QStringList argList;
@@ -184,6 +187,17 @@ int main(int argc, char **argv)
 		argList+= envStelOpts.split(" ");
 		argStr += " " + envStelOpts;
 	}
+	// No window at all for the batch modes
+	const bool ephemerisMode = CLIEphemeris::isRequested(argList);
+	QPixmap pixmap(StelFileMgr::findFile("data/splash.png"));
+	QSplashScreen splash(pixmap);
+	if (!ephemerisMode)
+	{
+		splash.show();
+		splash.showMessage(StelUtils::getApplicationVersion() , Qt::AlignLeft, Qt::white);
+		app.processEvents();
+	}
+
 	// Parse for first set of CLI arguments - stuff we want to process before other
 	// output, such as --help and --version
 	CLIProcessor::parseCLIArgsPreConfig(argList);
@@ -368,6 +382,18 @@ int main(int argc, char **argv)
 	CustomQTranslator trans;
 	app.installTranslator(&trans);
 
+	if (ephemerisMode)
+	{
+		const int status = CLIEphemeris::run(argList, confSettings);
+		delete confSettings;
+		StelLogger::deinit();
+		#ifdef Q_OS_WIN
+		if(timerGrain)
+			timeEndPeriod(timerGrain);
+		#endif //Q_OS_WIN
+		return status;
+	}
+
 	StelMainView mainWin;
 	mainWin.init(confSettings); // May exit(0) when OpenGL subsystem insufficient
 	splash.finish(&mainWin);
@@ -30,6 +30,7 @@
 #include "NebulaMgr.hpp"
 #include "Planet.hpp"
 #include "SolarSystem.hpp"
+#include "SolarSystemEphemeris.hpp"
 #include "StarMgr.hpp"
 #include "StelApp.hpp"
 #include "StelAudioMgr.hpp"
@@ -1069,6 +1070,60 @@ QVariantMap StelMainScriptAPI::getSelectedObjectInfo()
 	return map;
 }
 
+QVariantList StelMainScriptAPI::getEphemeris(const QString& name, double startJD, double endJD, double step)
+{
+	QVariantList list;
+	PlanetP planet = GETSTELMODULE(SolarSystem)->searchByEnglishName(name);
+	if (!planet)
+	{
+		debug("getEphemeris WARNING - object not found: " + name);
+		return list;
+	}
+	if (!(step>0.) || endJD<startJD)
+	{
+		debug("getEphemeris WARNING - invalid range of dates");
+		return list;
+	}
+
+	QVector<double> dates;
+	for (double JD=startJD; JD<=endJD; JD+=step)
+		dates.append(JD);
+	StelCore* core = StelApp::getInstance().getCore();
+	const SolarSystemEphemeris ephemeris(core, core->getCurrentLocation());
+	QVector<SolarSystemEphemeris::Position> positions;
+	if (!ephemeris.compute(planet, dates, positions))
+	{
+		debug("getEphemeris WARNING - cannot compute the positions of " + name);
+		return list;
+	}
+
+	float direction = 3.; // N is zero, E is 90 degrees
+	if (StelApp::getInstance().getFlagSouthAzimuthUsage())
+		direction = 2.;
+	foreach (const SolarSystemEphemeris::Position& position, positions)
+	{
+		QVariantMap map;
+		double ra, dec, alt, az;
+		map.insert("jd", position.JD);
+		StelUtils::rectToSphe(&ra, &dec, position.equinoxEquatorialPos);
+		map.insert("ra", ra*180./M_PI);
+		map.insert("dec", dec*180./M_PI);
+		StelUtils::rectToSphe(&ra, &dec, position.j2000EquatorialPos);
+		map.insert("raJ2000", ra*180./M_PI);
+		map.insert("decJ2000", dec*180./M_PI);
+		StelUtils::rectToSphe(&az, &alt, position.altAzPos);
+		az = direction*M_PI - az;
+		if (az > M_PI*2)
+			az -= M_PI*2;
+		map.insert("altitude", alt*180./M_PI);
+		map.insert("azimuth", az*180./M_PI);
+		map.insert("distance", position.distance);
+		map.insert("vmag", position.vMagnitude);
+		list.append(map);
+	}
+	return list;
+}
+
 
 void StelMainScriptAPI::clear(const QString& state)
 {
@@ -225,6 +225,23 @@ public slots:
 	//! - elongation-deg : elongation of object in decimal degrees (for Solar system objects only!)
 	QVariantMap getSelectedObjectInfo();
 
+	//! Compute the positions of a solar system object at a range of dates, for the current location,
+	//! without changing the simulation time.
+	//! @param name is the English name of the solar system object
+	//! @param startJD, endJD the range of dates (Julian Day, UT)
+	//! @param step the interval between the dates, in days
+	//! @return a list of maps, one for each date, empty if the object is not found. Keys:
+	//! - jd : date (Julian Day, UT)
+	//! - altitude : geometric altitude angle in decimal degrees
+	//! - azimuth : geometric azimuth angle in decimal degrees
+	//! - ra : right ascension angle (current date frame) in decimal degrees
+	//! - dec : declination angle in (current date frame) decimal degrees
+	//! - raJ2000 : right ascension angle (J2000 frame) in decimal degrees
+	//! - decJ2000 : declination angle in (J2000 frame) decimal degrees
+	//! - distance : distance to object in AU
+	//! - vmag : visual magnitude, without extinction
+	QVariantList getEphemeris(const QString& name, double startJD, double endJD, double step);
+
 	//! Clear the display options, setting a "standard" view.
 	//! Preset states:
 	//! - natural : azimuthal mount, atmosphere, landscape,
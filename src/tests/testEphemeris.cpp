@@ -23,10 +23,14 @@
 #include <QVariantList>
 #include <QString>
 #include <QtGlobal>
+#include <QVector>
+#include <QFile>
+#include <QTemporaryDir>
 
 #include "StelFileMgr.hpp"
 #include "EphemWrapper.hpp"
 #include "vsop87.h"
+#include "ChebyshevEphemeris.hpp"
 #include "de430.hpp"
 #include "de431.hpp"
 
@@ -1233,6 +1237,105 @@ void TestEphemeris::testNeptuneHeliocentricEphemerisVsop87()
 	}
 }
 
+void TestEphemeris::testVsop87Context()
+{
+	// Two contexts used alternately for distant dates must give the same positions
+	// as the default context used for one date after another.
+	Vsop87Context ctxA, ctxB;
+	InitVsop87Context(&ctxA);
+	InitVsop87Context(&ctxB);
+	const int planet_id = 3; // Mars
+	const double jdA = 2451545.0;
+	const double jdB = 2469807.5;
+	QVector<double> expectedA, expectedB;
+	double xyz[3];
+	for (int i=0; i<40; ++i)
+	{
+		GetVsop87Coor(jdA + 0.7*i, planet_id, xyz);
+		expectedA << xyz[0] << xyz[1] << xyz[2];
+	}
+	for (int i=0; i<40; ++i)
+	{
+		GetVsop87Coor(jdB + 0.7*i, planet_id, xyz);
+		expectedB << xyz[0] << xyz[1] << xyz[2];
+	}
+	for (int i=0; i<40; ++i)
+	{
+		GetVsop87CoorCtx(&ctxA, jdA + 0.7*i, planet_id, xyz);
+		QCOMPARE(xyz[0], expectedA.at(3*i));
+		QCOMPARE(xyz[1], expectedA.at(3*i+1));
+		QCOMPARE(xyz[2], expectedA.at(3*i+2));
+		GetVsop87CoorCtx(&ctxB, jdB + 0.7*i, planet_id, xyz);
+		QCOMPARE(xyz[0], expectedB.at(3*i));
+		QCOMPARE(xyz[1], expectedB.at(3*i+1));
+		QCOMPARE(xyz[2], expectedB.at(3*i+2));
+	}
+}
+
+static void vsop87Exact(double jde, int body, double xyz[3])
+{
+	GetVsop87CoorExact(jde, body, xyz);
+}
+
+// A theory which jumps at a date, where it cannot be fitted
+static void steppedTheory(double jde, int body, double xyz[3])
+{
+	Q_UNUSED(body);
+	xyz[0] = jde<2451600.3 ? 1. : 2.;
+	xyz[1] = xyz[2] = 0.;
+}
+
+void TestEphemeris::testVsop87Chebyshev()
+{
+	const double start = 2451545.0;
+	const double end = start + 730.;
+	const double tolerance = 1e-9;
+	ChebyshevEphemeris chebyshev("VSOP87/test", 8, start, end, tolerance);
+	QVERIFY(chebyshev.fit(vsop87Exact));
+	double xyz[3], exact[3];
+	for (int body=0; body<8; ++body)
+	{
+		QVERIFY(chebyshev.getSegmentCount(body)>0);
+		for (int i=0; i<=100; ++i)
+		{
+			const double jde = start + 7.3*i;
+			QVERIFY(chebyshev.compute(body, jde, xyz));
+			GetVsop87CoorExact(jde, body, exact);
+			for (int c=0; c<3; ++c)
+				QVERIFY2(qAbs(xyz[c]-exact[c]) <= 2*tolerance, QString("body=%1 jde=%2").arg(body).arg(jde, 0, 'f', 5).toUtf8());
+		}
+	}
+	QVERIFY(!chebyshev.compute(2, start-1., xyz));
+	QVERIFY(!chebyshev.compute(2, end+1., xyz));
+
+	// A saved fit is only loaded back with the same parameters
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path() + "/vsop87.cheb";
+	QVERIFY(chebyshev.save(fileName));
+	ChebyshevEphemeris loaded("VSOP87/test", 8, start, end, tolerance);
+	QVERIFY(loaded.load(fileName));
+	double loadedXyz[3];
+	QVERIFY(chebyshev.compute(4, start+100.5, xyz));
+	QVERIFY(loaded.compute(4, start+100.5, loadedXyz));
+	QCOMPARE(loadedXyz[0], xyz[0]);
+	QCOMPARE(loadedXyz[1], xyz[1]);
+	QCOMPARE(loadedXyz[2], xyz[2]);
+	ChebyshevEphemeris otherTolerance("VSOP87/test", 8, start, end, 1e-8);
+	QVERIFY(!otherTolerance.load(fileName));
+	ChebyshevEphemeris otherTheory("VSOP87/other", 8, start, end, tolerance);
+	QVERIFY(!otherTheory.load(fileName));
+
+	// The segment which cannot be fitted is not used, the others are
+	ChebyshevEphemeris stepped("Stepped/test", 1, start, end, tolerance);
+	QVERIFY(stepped.fit(steppedTheory));
+	QVERIFY(!stepped.compute(0, 2451600.3, xyz));
+	QVERIFY(stepped.compute(0, 2451590., xyz));
+	QCOMPARE(xyz[0], 1.);
+	QVERIFY(stepped.compute(0, 2451610., xyz));
+	QCOMPARE(xyz[0], 2.);
+}
+
 void TestEphemeris::testMercuryHeliocentricEphemerisDe430()
 {
 	if (de430FilePath.isEmpty())
@@ -1499,6 +1602,51 @@ void TestEphemeris::testNeptuneHeliocentricEphemerisDe430()
 	}
 }
 
+void TestEphemeris::testDe430Cache()
+{
+	if (de430FilePath.isEmpty())
+		QSKIP("DE430 file ephemeris does not exist");
+	InitDE430(QFile::encodeName(de430FilePath).constData());
+
+	// Dates alternating between distant coefficient blocks, read one by one with the shared
+	// state, with a cache per date range, and all at once. The results must be identical.
+	const int planets[3] = {3, 5, 10}; // Earth, Jupiter, Moon
+	QVector<double> dates;
+	for (int i=0; i<20; ++i)
+		dates << 2451545.0 + 0.37*i << 2469807.5 - 0.37*i;
+	QVector<double> expected, cached(3*dates.size()), multi(3*dates.size()*3);
+	double xyz[3];
+	for (int p=0; p<3; ++p)
+	{
+		for (int i=0; i<dates.size(); ++i)
+		{
+			QVERIFY(GetDe430Coor(dates.at(i), planets[p], xyz, CENTRAL_BODY_ID));
+			expected << xyz[0] << xyz[1] << xyz[2];
+		}
+	}
+	void* cacheA = jpl_alloc_cache();
+	void* cacheB = jpl_alloc_cache();
+	for (int p=0; p<3; ++p)
+	{
+		for (int i=0; i<dates.size(); ++i)
+			QVERIFY(GetDe430CoorCached(i%2 ? cacheB : cacheA, dates.at(i), planets[p], cached.data()+3*i, CENTRAL_BODY_ID));
+		for (int i=0; i<3*dates.size(); ++i)
+			QCOMPARE(cached.at(i), expected.at(3*dates.size()*p+i));
+	}
+	QVERIFY(GetDe430CoorMulti(cacheA, dates.size(), dates.constData(), 3, planets, multi.data(), CENTRAL_BODY_ID));
+	for (int i=0; i<dates.size(); ++i)
+	{
+		for (int p=0; p<3; ++p)
+		{
+			QCOMPARE(multi.at(3*(3*i+p)),   expected.at(3*(dates.size()*p+i)));
+			QCOMPARE(multi.at(3*(3*i+p)+1), expected.at(3*(dates.size()*p+i)+1));
+			QCOMPARE(multi.at(3*(3*i+p)+2), expected.at(3*(dates.size()*p+i)+2));
+		}
+	}
+	jpl_free_cache(cacheA);
+	jpl_free_cache(cacheB);
+}
+
 void TestEphemeris::testMercuryHeliocentricEphemerisDe431()
 {
 	if (de431FilePath.isEmpty())
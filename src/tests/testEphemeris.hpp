@@ -37,6 +37,8 @@ private slots:
 	void testSaturnHeliocentricEphemerisVsop87();
 	void testUranusHeliocentricEphemerisVsop87();
 	void testNeptuneHeliocentricEphemerisVsop87();
+	void testVsop87Context();
+	void testVsop87Chebyshev();
 	// JPL DE430
 	void testMercuryHeliocentricEphemerisDe430();
 	void testVenusHeliocentricEphemerisDe430();
@@ -45,6 +47,7 @@ private slots:
 	void testSaturnHeliocentricEphemerisDe430();
 	void testUranusHeliocentricEphemerisDe430();
 	void testNeptuneHeliocentricEphemerisDe430();
+	void testDe430Cache();
 	// JPL DE431
 	void testMercuryHeliocentricEphemerisDe431();
 	void testVenusHeliocentricEphemerisDe431();
@@ -43,3 +43,26 @@ void TestExtinction::testBase()
 	extCls.forward(vert, &mag);
 	QVERIFY(mag==2.25);
 }
+
+void TestExtinction::testTable()
+{
+	Extinction extCls;
+	extCls.setExtinctionCoefficient(0.2f);
+	ExtinctionTable table;
+	const Extinction::UndergroundExtinctionMode modes[] = {Extinction::UndergroundExtinctionZero,
+		Extinction::UndergroundExtinctionMax, Extinction::UndergroundExtinctionMirror};
+	for (int m=0; m<3; ++m)
+	{
+		extCls.setUndergroundExtinctionMode(modes[m]);
+		table.update(extCls);
+		for (int i=0; i<=2000; ++i)
+		{
+			const float sinAlt = -1.f + i*0.001f;
+			const Vec3f v(std::sqrt(1.f-sinAlt*sinAlt), 0.f, sinAlt);
+			float mag=0.f;
+			extCls.forward(v, &mag);
+			QVERIFY2(std::fabs(table.getMagShift(sinAlt)-mag)<0.005f,
+				 qPrintable(QString("mode %1 sin(alt) %2: %3 instead of %4").arg(m).arg(sinAlt).arg(table.getMagShift(sinAlt)).arg(mag)));
+		}
+	}
+}
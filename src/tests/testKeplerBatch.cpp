@@ -0,0 +1,222 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testKeplerBatch.hpp"
+#include "KeplerBatch.hpp"
+#include "Orbit.hpp"
+
+#include <QVector>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestKeplerBatch)
+
+#define NB_BODIES 10000
+
+namespace
+{
+	const double dateJDE = 2457600.5;
+
+	struct Elements
+	{
+		double q, e, i, Omega, w, t0, n;
+	};
+
+	// Minor planets between 1.5 and 5 AU, with all the eccentricities of elliptical orbits
+	QVector<Elements> randomElements(int count)
+	{
+		qsrand(42);
+		QVector<Elements> elements(count);
+		for (int k=0;k<count;++k)
+		{
+			Elements& el = elements[k];
+			el.q = 1.5+3.5*(double)qrand()/RAND_MAX;
+			el.e = 0.999*(double)qrand()/RAND_MAX;
+			el.i = M_PI*(double)qrand()/RAND_MAX;
+			el.Omega = 2.*M_PI*(double)qrand()/RAND_MAX;
+			el.w = 2.*M_PI*(double)qrand()/RAND_MAX;
+			el.t0 = 2451545.0+10000.*(double)qrand()/RAND_MAX;
+			const double a = el.q/(1.-el.e);
+			el.n = 0.01720209895/(a*std::sqrt(a));
+		}
+		return elements;
+	}
+
+	double distance(const double* a, const double* b)
+	{
+		return std::sqrt((a[0]-b[0])*(a[0]-b[0]) + (a[1]-b[1])*(a[1]-b[1]) + (a[2]-b[2])*(a[2]-b[2]));
+	}
+
+	// One row for each implementation supported by the CPU
+	void addImplementationRows()
+	{
+		QTest::addColumn<int>("implementation");
+		for (int impl=KeplerBatch::Scalar; impl<=KeplerBatch::getBestImplementation(); ++impl)
+			QTest::newRow(KeplerBatch::implementationName((KeplerBatch::Implementation)impl)) << impl;
+	}
+}
+
+void TestKeplerBatch::cleanup()
+{
+	KeplerBatch::setImplementation(KeplerBatch::getBestImplementation());
+}
+
+void TestKeplerBatch::testCometOrbit_data()
+{
+	addImplementationRows();
+}
+
+void TestKeplerBatch::testCometOrbit()
+{
+	QFETCH(int, implementation);
+	KeplerBatch::setImplementation((KeplerBatch::Implementation)implementation);
+	QCOMPARE((int)KeplerBatch::getImplementation(), implementation);
+	const QVector<Elements> elements = randomElements(NB_BODIES);
+	KeplerBatch batch;
+	foreach (const Elements& el, elements)
+		batch.addCometOrbit(el.q, el.e, el.i, el.Omega, el.w, el.t0, el.n, 0.1, 0.2, 0.3);
+	QCOMPARE(batch.size(), NB_BODIES);
+	batch.compute(dateJDE);
+	for (int k=0;k<NB_BODIES;++k)
+	{
+		const Elements& el = elements.at(k);
+		CometOrbit orbit(el.q, el.e, el.i, el.Omega, el.w, el.t0, 0., el.n, 0.1, 0.2, 0.3);
+		double xyz[3];
+		orbit.positionAtTimevInVSOP87Coordinates(dateJDE, xyz, false);
+		const double a = el.q/(1.-el.e);
+		QVERIFY2(distance(xyz, batch.getPosition(k))<=1e-12*a, qPrintable(QString("body %1, e=%2").arg(k).arg(el.e)));
+	}
+}
+
+void TestKeplerBatch::testEllipticalOrbit()
+{
+	const QVector<Elements> elements = randomElements(NB_BODIES);
+	KeplerBatch batch;
+	foreach (const Elements& el, elements)
+		batch.addEllipticalOrbit(el.q, el.e, el.i, el.Omega, el.w, 1., 2.*M_PI/el.n, el.t0, 0.1, 0.2, 0.3);
+	batch.compute(dateJDE);
+	for (int k=0;k<NB_BODIES;++k)
+	{
+		const Elements& el = elements.at(k);
+		EllipticalOrbit orbit(el.q, el.e, el.i, el.Omega, el.w, 1., 2.*M_PI/el.n, el.t0, 0.1, 0.2, 0.3);
+		double xyz[3];
+		orbit.positionAtTimevInVSOP87Coordinates(dateJDE, xyz);
+		const double a = el.q/(1.-el.e);
+		// EllipticalOrbit stops its iterations earlier (see KeplerBatch)
+		const double tolerance = el.e<0.2 ? std::pow(el.e, 6)+1e-13 : 1e-9;
+		QVERIFY2(distance(xyz, batch.getPosition(k))<=tolerance*a, qPrintable(QString("body %1, e=%2").arg(k).arg(el.e)));
+	}
+}
+
+void TestKeplerBatch::testImplementationsMatch()
+{
+	// Not a multiple of the vector widths, so that the padding is used
+	const QVector<Elements> elements = randomElements(NB_BODIES+3);
+	KeplerBatch batch;
+	foreach (const Elements& el, elements)
+		batch.addCometOrbit(el.q, el.e, el.i, el.Omega, el.w, el.t0, el.n, 0.1, 0.2, 0.3);
+	// Dates over several periods, for all the quadrants of the anomalies
+	QVector<double> dates(batch.size());
+	for (int k=0;k<dates.size();++k)
+		dates[k] = dateJDE+3.7*k;
+	KeplerBatch::setImplementation(KeplerBatch::Scalar);
+	QVector<double> scalar(3*batch.size());
+	batch.computePositions(0, batch.size(), dates.constData(), scalar.data());
+	for (int impl=KeplerBatch::SSE2; impl<=KeplerBatch::getBestImplementation(); ++impl)
+	{
+		KeplerBatch::setImplementation((KeplerBatch::Implementation)impl);
+		QVector<double> xyz(3*batch.size());
+		batch.computePositions(0, batch.size(), dates.constData(), xyz.data());
+		for (int k=0;k<batch.size();++k)
+		{
+			const double a = elements.at(k).q/(1.-elements.at(k).e);
+			QVERIFY2(distance(xyz.constData()+3*k, scalar.constData()+3*k)<=1e-12*a,
+				 qPrintable(QString("%1, body %2").arg(KeplerBatch::implementationName((KeplerBatch::Implementation)impl)).arg(k)));
+		}
+	}
+}
+
+void TestKeplerBatch::testKeptPositions()
+{
+	const QVector<Elements> elements = randomElements(100);
+	KeplerBatch batch;
+	QVector<KeplerBatch::Member*> members;
+	foreach (const Elements& el, elements)
+		members.append(batch.addCometOrbit(el.q, el.e, el.i, el.Omega, el.w, el.t0, el.n, 0., 0., 0.));
+	QVector<double> dates(batch.size());
+	for (int k=0;k<dates.size();++k)
+		dates[k] = dateJDE-0.01*k;
+	batch.compute(dateJDE);
+	batch.compute(dates.constData());
+
+	// The positions of both compute() are found, the others are computed alone
+	const double testDates[3] = {dateJDE, dateJDE-0.5, 0.};
+	for (int k=0;k<members.size();++k)
+	{
+		for (int d=0;d<3;++d)
+		{
+			const double jde = d==2 ? dates.at(k) : testDates[d];
+			double kept[3], alone[3];
+			KeplerBatch::posFunc(jde, kept, members.at(k));
+			KeplerBatch::samplingPosFunc(jde, alone, members.at(k));
+			// Solved in a block, Kepler's equation may take one more iteration than alone
+			QVERIFY(distance(kept, alone)<=1e-12*elements.at(k).q/(1.-elements.at(k).e));
+		}
+	}
+}
+
+void TestKeplerBatch::testSkipped()
+{
+	const QVector<Elements> elements = randomElements(100);
+	KeplerBatch batch;
+	QVector<KeplerBatch::Member*> members;
+	foreach (const Elements& el, elements)
+		members.append(batch.addCometOrbit(el.q, el.e, el.i, el.Omega, el.w, el.t0, el.n, 0., 0., 0.));
+	for (int k=0;k<members.size();k+=3)
+		batch.setSkipped(k, true);
+	batch.compute(dateJDE);
+
+	// The skipped bodies are still computed alone by posFunc()
+	for (int k=0;k<members.size();++k)
+	{
+		QCOMPARE(batch.isSkipped(k), k%3==0);
+		double kept[3], alone[3];
+		KeplerBatch::posFunc(dateJDE, kept, members.at(k));
+		KeplerBatch::samplingPosFunc(dateJDE, alone, members.at(k));
+		QVERIFY(distance(kept, alone)<=1e-12*elements.at(k).q/(1.-elements.at(k).e));
+	}
+}
+
+void TestKeplerBatch::benchmarkCompute_data()
+{
+	addImplementationRows();
+}
+
+void TestKeplerBatch::benchmarkCompute()
+{
+	QFETCH(int, implementation);
+	KeplerBatch::setImplementation((KeplerBatch::Implementation)implementation);
+	const QVector<Elements> elements = randomElements(NB_BODIES);
+	KeplerBatch batch;
+	foreach (const Elements& el, elements)
+		batch.addCometOrbit(el.q, el.e, el.i, el.Omega, el.w, el.t0, el.n, 0., 0., 0.);
+	QBENCHMARK {
+		batch.compute(dateJDE);
+	}
+}
@@ -0,0 +1,193 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testMinimumSearch.hpp"
+#include "MinimumSearch.hpp"
+#include "EphemWrapper.hpp"
+#include "StelUtils.hpp"
+#include "VecMath.hpp"
+
+#include <QScopedPointer>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestMinimumSearch)
+
+namespace
+{
+	const double startJD = 2451545.0;
+	const double lunarMonth = 29.530589;
+	const double year = 365.25;
+
+	//! A separation like the one of the Moon and a planet: one minimum each month, modulated over the year
+	struct MonthlySeparation
+	{
+		typedef double result_type;
+		MonthlySeparation() : calls(0) {}
+		double operator()(double JD)
+		{
+			++calls;
+			const double t = JD-startJD;
+			return 1.-std::cos(2.*M_PI*t/lunarMonth) + 0.5*(1.+std::sin(2.*M_PI*t/year));
+		}
+		int calls;
+	};
+
+	typedef void (*PosFunc)(double, double*, void*);
+
+	//! The separation of two bodies seen from the center of the Earth, computed as by
+	//! SolarSystemEphemeris::findClosestApproaches(): each copy has its own EphemContext,
+	//! and the bodies are placed where their light left them.
+	struct PlanetSeparation
+	{
+		typedef double result_type;
+
+		PlanetSeparation(PosFunc body1, PosFunc body2) : body1(body1), body2(body2), context(new EphemContext) {}
+		PlanetSeparation(const PlanetSeparation& other) : body1(other.body1), body2(other.body2), context(new EphemContext) {}
+
+		double operator()(double JDE) const
+		{
+			Vec3d earthPos;
+			get_earth_helio_coordsv(JDE, earthPos, context.data());
+			return direction(body1, JDE, earthPos).angle(direction(body2, JDE, earthPos));
+		}
+		Vec3d direction(PosFunc body, double JDE, const Vec3d& earthPos) const
+		{
+			Vec3d pos;
+			body(JDE, pos, context.data());
+			body(JDE - (pos-earthPos).length() * (AU / (SPEED_OF_LIGHT * 86400)), pos, context.data());
+			return pos-earthPos;
+		}
+
+		PosFunc body1;
+		PosFunc body2;
+		QScopedPointer<EphemContext> context;
+
+	private:
+		PlanetSeparation& operator=(const PlanetSeparation&);
+	};
+
+	//! The angle between two directions crossing each other, minimal and not derivable at JD
+	struct Crossing
+	{
+		typedef double result_type;
+		Crossing(double JD) : JD(JD) {}
+		double operator()(double date) const {return std::fabs(0.01*(date-JD)) + 1e-4*std::fabs(std::sin(date));}
+		double JD;
+	};
+}
+
+void TestMinimumSearch::testRefine()
+{
+	// Smooth minimum: the parabolic steps converge in a few evaluations
+	MonthlySeparation smooth;
+	double value;
+	const double b = startJD+lunarMonth-0.3;
+	double date = MinimumSearch::refine(smooth, startJD+lunarMonth-1., b, startJD+lunarMonth+1., smooth(b), 1e-6, &value);
+	QVERIFY2(std::fabs(date-(startJD+lunarMonth))<0.3, qPrintable(QString("date %1").arg(date-startJD, 0, 'f', 6)));
+	QVERIFY(value<=smooth(date-1e-4) && value<=smooth(date+1e-4));
+	QVERIFY(smooth.calls<40);
+
+	// Sharp minimum, as for a close conjunction: golden sections still reach the tolerance
+	const double crossingJD = startJD+12.345678;
+	Crossing crossing(crossingJD);
+	date = MinimumSearch::refine(crossing, startJD+11., startJD+12., startJD+13., crossing(startJD+12.), 1e-6, &value);
+	QVERIFY2(std::fabs(date-crossingJD)<1e-5, qPrintable(QString("date %1").arg(date-crossingJD)));
+	QVERIFY(value<=crossing(crossingJD)+1e-7);
+}
+
+void TestMinimumSearch::testFindMinima()
+{
+	MonthlySeparation separation;
+	const QMap<double, double> minima = MinimumSearch::findMinima(separation, startJD, startJD+10.*year, 1., 10., 1e-6);
+	// One minimum each month, apart from the month cut at the end of the range
+	const int months = (int)(10.*year/lunarMonth);
+	QVERIFY2(minima.size()==months || minima.size()==months-1, qPrintable(QString("%1 minima").arg(minima.size())));
+	double previous = 0.;
+	for (QMap<double, double>::ConstIterator it=minima.constBegin(); it!=minima.constEnd(); ++it)
+	{
+		if (previous>0.)
+			QVERIFY(std::fabs(it.key()-previous-lunarMonth)<1.);
+		previous = it.key();
+	}
+}
+
+void TestMinimumSearch::testMaxValue()
+{
+	MonthlySeparation separation;
+	const QMap<double, double> all = MinimumSearch::findMinima(separation, startJD, startJD+year, 1., 10., 1e-6);
+	const QMap<double, double> close = MinimumSearch::findMinima(separation, startJD, startJD+year, 1., 0.5, 1e-6);
+	QVERIFY(!close.isEmpty());
+	QVERIFY(close.size()<all.size());
+	for (QMap<double, double>::ConstIterator it=close.constBegin(); it!=close.constEnd(); ++it)
+		QVERIFY(it.value()<=0.5);
+}
+
+void TestMinimumSearch::testParallelMatchesSerial()
+{
+	MonthlySeparation separation;
+	const QMap<double, double> serial = MinimumSearch::findMinima(separation, startJD, startJD+20.*year, 0.25, 10., 1e-6, false);
+	const QMap<double, double> parallel = MinimumSearch::findMinima(separation, startJD, startJD+20.*year, 0.25, 10., 1e-6, true);
+	// Exact comparison: each minimum is refined by the same evaluations in both cases
+	QCOMPARE(parallel, serial);
+}
+
+void TestMinimumSearch::testGreatConjunction()
+{
+	// Jupiter and Saturn on 2020 December 21, 6 arcminutes apart, scanned as findClosestApproaches() does for them
+	const PlanetSeparation separation(&get_jupiter_helio_coordsv, &get_saturn_helio_coordsv);
+	const QMap<double, double> minima = MinimumSearch::findMinima(separation, 2459100.5, 2459300.5, 2., 1.*M_PI/180., 1./86400.);
+	QCOMPARE(minima.size(), 1);
+	const double JDE = minima.firstKey();
+	QVERIFY2(std::fabs(JDE-2459205.2)<0.3, qPrintable(QString("JDE %1").arg(JDE, 0, 'f', 4)));
+	const double arcMinutes = minima.first()*180./M_PI*60.;
+	QVERIFY2(arcMinutes>5.5 && arcMinutes<7., qPrintable(QString("%1 arcminutes").arg(arcMinutes)));
+}
+
+void TestMinimumSearch::benchmarkClosestApproaches_data()
+{
+	QTest::addColumn<bool>("parallel");
+	QTest::newRow("serial") << false;
+	QTest::newRow("parallel") << true;
+}
+
+void TestMinimumSearch::benchmarkClosestApproaches()
+{
+	// The conjunctions closer than 10 degrees of each pair of the Sun and the major planets during 10 years,
+	// with the scan steps of SolarSystemEphemeris::getScanStep()
+	QFETCH(bool, parallel);
+	const PosFunc bodies[] = {&get_sun_helio_coordsv, &get_mercury_helio_coordsv, &get_venus_helio_coordsv, &get_mars_helio_coordsv,
+				  &get_jupiter_helio_coordsv, &get_saturn_helio_coordsv, &get_uranus_helio_coordsv, &get_neptune_helio_coordsv};
+	const double steps[] = {1., 1., 1., 1., 2., 2., 2., 2.};
+	const int count = sizeof(bodies)/sizeof(bodies[0]);
+	int conjunctions = 0;
+	QBENCHMARK {
+		conjunctions = 0;
+		for (int i=0; i<count; ++i)
+		{
+			for (int j=i+1; j<count; ++j)
+			{
+				const PlanetSeparation separation(bodies[i], bodies[j]);
+				conjunctions += MinimumSearch::findMinima(separation, startJD, startJD+10.*year, qMin(steps[i], steps[j]),
+									  10.*M_PI/180., 1./86400., parallel).size();
+			}
+		}
+	}
+	QVERIFY(conjunctions>0);
+}
@@ -0,0 +1,212 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testOrbitSampler.hpp"
+#include "OrbitSampler.hpp"
+
+#include <QFuture>
+#include <QtConcurrent>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestOrbitSampler)
+
+namespace
+{
+	const double pericenterJDE = 2451545.0;
+
+	//! A Keplerian ellipse in the XY plane, with its pericenter on the X axis at pericenterJDE.
+	struct Ellipse
+	{
+		double a;
+		double e;
+
+		double period() const {return 365.25*a*std::sqrt(a);}
+		Vec3d position(double jde) const
+		{
+			double M = std::fmod(2.*M_PI*(jde-pericenterJDE)/period(), 2.*M_PI);
+			if (M<0.)
+				M += 2.*M_PI;
+			// Newton's method, started from pi for the high eccentricities
+			double E = e>0.8 ? M_PI : M;
+			for (int i=0; i<100; ++i)
+			{
+				const double delta = (E-e*std::sin(E)-M)/(1.-e*std::cos(E));
+				E -= delta;
+				if (std::fabs(delta)<1e-15)
+					break;
+			}
+			return Vec3d(a*(std::cos(E)-e), a*std::sqrt(1.-e*e)*std::sin(E), 0.);
+		}
+	};
+
+	void ellipsePosFunc(double jde, double xyz[3], void* userData)
+	{
+		const Vec3d pos = static_cast<const Ellipse*>(userData)->position(jde);
+		xyz[0] = pos[0];
+		xyz[1] = pos[1];
+		xyz[2] = pos[2];
+	}
+
+	//! Osculating elements which are the ones of the ellipse at any epoch, and count the calls with another epoch than the expected one.
+	struct OsculatingEllipse
+	{
+		Ellipse ellipse;
+		double epoch;
+		int otherEpochs;
+	};
+
+	void osculatingEllipseFunc(double jde0, double jde, double xyz[3], void* userData)
+	{
+		OsculatingEllipse* osculating = static_cast<OsculatingEllipse*>(userData);
+		if (jde0!=osculating->epoch)
+			++osculating->otherEpochs;
+		ellipsePosFunc(jde, xyz, &osculating->ellipse);
+	}
+
+	const Vec3d observerPos(0., 0., 3.);
+}
+
+void TestOrbitSampler::testInitialIntervals()
+{
+	// The dates of the initial intervals are kept, uniformly spaced and one of them at the middle date
+	Ellipse ellipse = {1., 0.7};
+	const OrbitSampler sampler(&ellipsePosFunc, NULL, &ellipse);
+	const double span = ellipse.period();
+	const OrbitSampler::Samples samples = sampler.sample(pericenterJDE, span, observerPos, 1e-4);
+	QCOMPARE(samples.dateJDE, pericenterJDE);
+	QCOMPARE(samples.tolerance, 1e-4);
+	QVERIFY(samples.observerPos==observerPos);
+	QCOMPARE(samples.points.first().jde, pericenterJDE-0.5*span);
+	QCOMPARE(samples.points.last().jde, pericenterJDE+0.5*span);
+	const double step = span/OrbitSampler::InitialIntervals;
+	int found = 0;
+	for (int i=0; i<samples.points.size(); ++i)
+	{
+		const double k = (samples.points.at(i).jde-(pericenterJDE-0.5*span))/step;
+		if (std::fabs(k-qRound(k))<1e-9)
+			++found;
+		if (i>0)
+			QVERIFY(samples.points.at(i).jde>samples.points.at(i-1).jde);
+	}
+	QCOMPARE(found, OrbitSampler::InitialIntervals+1);
+	bool hasMiddle = false;
+	foreach (const OrbitSample& s, samples.points)
+		hasMiddle = hasMiddle || s.jde==pericenterJDE;
+	QVERIFY(hasMiddle);
+}
+
+void TestOrbitSampler::testTolerance()
+{
+	// No chord of the line deviates from the orbit by more than the tolerance, as seen by the observer
+	Ellipse ellipse = {1., 0.7};
+	const OrbitSampler sampler(&ellipsePosFunc, NULL, &ellipse);
+	const double tolerance = 1e-4;
+	const OrbitSampler::Samples samples = sampler.sample(pericenterJDE, ellipse.period(), observerPos, tolerance);
+	for (int i=1; i<samples.points.size(); ++i)
+	{
+		const OrbitSample& a = samples.points.at(i-1);
+		const OrbitSample& b = samples.points.at(i);
+		const Vec3d chordMiddle = (a.pos+b.pos)*0.5;
+		const double deviation = (ellipse.position(0.5*(a.jde+b.jde))-chordMiddle).length()/(chordMiddle-observerPos).length();
+		QVERIFY2(deviation<=tolerance, qPrintable(QString("JDE %1: %2 rad").arg(a.jde, 0, 'f', 4).arg(deviation)));
+	}
+}
+
+void TestOrbitSampler::testPericenterDensity()
+{
+	// Over a period centered on the pericenter, the quarters of the period around the pericenter and around the
+	// apocenter: the body moves about 6 times faster at the pericenter of this orbit
+	Ellipse ellipse = {1., 0.7};
+	const OrbitSampler sampler(&ellipsePosFunc, NULL, &ellipse);
+	const double period = ellipse.period();
+	const OrbitSampler::Samples samples = sampler.sample(pericenterJDE, period, observerPos, 1e-4);
+	int nearPericenter = 0;
+	int nearApocenter = 0;
+	foreach (const OrbitSample& s, samples.points)
+	{
+		const double dt = std::fabs(s.jde-pericenterJDE);
+		if (dt<period/8.)
+			++nearPericenter;
+		else if (dt>3.*period/8.)
+			++nearApocenter;
+	}
+	QVERIFY2(nearPericenter>2*nearApocenter, qPrintable(QString("%1 samples near the pericenter, %2 near the apocenter").arg(nearPericenter).arg(nearApocenter)));
+
+	// The sampling does not go as deep as it can
+	QVERIFY(samples.points.size()<OrbitSampler::InitialIntervals*(1<<(OrbitSampler::MaxDepth+1))/4);
+}
+
+void TestOrbitSampler::testMaxDepth()
+{
+	// A nearly parabolic orbit, whose pericenter is too sharp for the line to follow it: its intervals are
+	// halved MaxDepth times and the last ones are split by their middle
+	Ellipse ellipse = {1., 0.99};
+	const OrbitSampler sampler(&ellipsePosFunc, NULL, &ellipse);
+	const double span = ellipse.period();
+	const double shortest = span/OrbitSampler::InitialIntervals/(1<<(OrbitSampler::MaxDepth+1));
+	OrbitSampler::Samples samples = sampler.sample(pericenterJDE, span, Vec3d(0., 2., 0.), 1e-5);
+	double minInterval = span;
+	for (int i=1; i<samples.points.size(); ++i)
+		minInterval = qMin(minInterval, samples.points.at(i).jde-samples.points.at(i-1).jde);
+	QVERIFY2(std::fabs(minInterval-shortest)<1e-6, qPrintable(QString("%1 days instead of %2").arg(minInterval).arg(shortest)));
+
+	// Without any tolerance, all the intervals are halved until the maximum depth
+	samples = sampler.sample(pericenterJDE, span, Vec3d(0., 2., 0.), 0.);
+	QCOMPARE(samples.points.size(), OrbitSampler::InitialIntervals*(1<<(OrbitSampler::MaxDepth+1))+1);
+}
+
+void TestOrbitSampler::testOsculatingEpoch()
+{
+	// With osculating elements, all the positions use the elements of the middle date
+	const double dateJDE = pericenterJDE+100.;
+	OsculatingEllipse osculating;
+	osculating.ellipse.a = 1.;
+	osculating.ellipse.e = 0.7;
+	osculating.epoch = dateJDE;
+	osculating.otherEpochs = 0;
+	const OrbitSampler withElements(&ellipsePosFunc, &osculatingEllipseFunc, &osculating);
+	const OrbitSampler::Samples samples = withElements.sample(dateJDE, osculating.ellipse.period(), observerPos, 1e-4);
+	QCOMPARE(osculating.otherEpochs, 0);
+
+	const OrbitSampler withoutElements(&ellipsePosFunc, NULL, &osculating.ellipse);
+	const OrbitSampler::Samples expected = withoutElements.sample(dateJDE, osculating.ellipse.period(), observerPos, 1e-4);
+	QCOMPARE(samples.points.size(), expected.points.size());
+	for (int i=0; i<samples.points.size(); ++i)
+		QVERIFY(samples.points.at(i).pos==expected.points.at(i).pos);
+}
+
+void TestOrbitSampler::testWorkerThread()
+{
+	// As Planet::updateOrbitSamples(), the line sampled in a worker thread is the one sampled in the main thread
+	Ellipse ellipse = {1., 0.7};
+	const OrbitSampler sampler(&ellipsePosFunc, NULL, &ellipse);
+	const OrbitSampler::Samples expected = sampler.sample(pericenterJDE, ellipse.period(), observerPos, 1e-4);
+	QFuture<OrbitSampler::Samples> job = QtConcurrent::run(sampler, &OrbitSampler::sample, pericenterJDE, ellipse.period(), observerPos, 1e-4);
+	const OrbitSampler::Samples samples = job.result();
+	QVERIFY(job.isFinished());
+	QCOMPARE(samples.dateJDE, expected.dateJDE);
+	QCOMPARE(samples.points.size(), expected.points.size());
+	for (int i=0; i<samples.points.size(); ++i)
+	{
+		QCOMPARE(samples.points.at(i).jde, expected.points.at(i).jde);
+		QVERIFY(samples.points.at(i).pos==expected.points.at(i).pos);
+	}
+}
@@ -0,0 +1,291 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testPlanetFamilies.hpp"
+#include "EphemWrapper.hpp"
+#include "Orbit.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestPlanetFamilies)
+
+// About as many bodies as a full MPCORB extract of bright minor planets
+#define NB_MINOR_PLANETS 10000
+
+namespace
+{
+	const double startJDE = 2457600.5;
+	const double deltaT = 68.4/86400.;
+
+	// As cometOrbitPosFunc() in SolarSystem.cpp
+	void cometOrbitPosFunc(double jd, double xyz[3], void* userDataPtr)
+	{
+		static_cast<CometOrbit*>(userDataPtr)->positionAtTimevInVSOP87Coordinates(jd, xyz);
+	}
+
+	// As SolarSystem::FamilyPositions
+	struct ComputeFamily
+	{
+		typedef void result_type;
+		double dateJDE;
+		Vec3d observerPos;
+		void operator()(const PlanetFamilies<TestBody>::Family& family) const
+		{
+			PlanetFamilies<TestBody>::computePositions(family, dateJDE, dateJDE-deltaT, observerPos, true);
+		}
+	};
+}
+
+TestBody* TestPlanetFamilies::addBody(const QString& name, TestBody::PosFunc func, TestBody* parent)
+{
+	TestBody* b = new TestBody;
+	b->name = name;
+	b->coordFunc = func;
+	b->parent = parent;
+	bodies.append(b);
+	return b;
+}
+
+void TestPlanetFamilies::initTestCase()
+{
+	sun = addBody("Sun", &get_sun_helio_coordsv, NULL);
+
+	// The families of the major bodies, as loaded from ssystem.ini, each one with its own context
+	QVector<PlanetFamilies<TestBody>::Family> majorFamilies;
+	PlanetFamilies<TestBody>::Family family;
+	family << addBody("Mercury", &get_mercury_helio_coordsv, sun);
+	majorFamilies << family;
+	family.clear();
+	family << addBody("Venus", &get_venus_helio_coordsv, sun);
+	majorFamilies << family;
+	family.clear();
+	TestBody* earth = addBody("Earth", &get_earth_helio_coordsv, sun);
+	family << earth << addBody("Moon", &get_lunar_parent_coordsv, earth);
+	majorFamilies << family;
+	family.clear();
+	TestBody* mars = addBody("Mars", &get_mars_helio_coordsv, sun);
+	family << mars << addBody("Phobos", &get_phobos_parent_coordsv, mars) << addBody("Deimos", &get_deimos_parent_coordsv, mars);
+	majorFamilies << family;
+	family.clear();
+	TestBody* jupiter = addBody("Jupiter", &get_jupiter_helio_coordsv, sun);
+	family << jupiter << addBody("Io", &get_io_parent_coordsv, jupiter) << addBody("Europa", &get_europa_parent_coordsv, jupiter)
+	       << addBody("Ganymede", &get_ganymede_parent_coordsv, jupiter) << addBody("Callisto", &get_callisto_parent_coordsv, jupiter);
+	majorFamilies << family;
+	family.clear();
+	TestBody* saturn = addBody("Saturn", &get_saturn_helio_coordsv, sun);
+	family << saturn << addBody("Mimas", &get_mimas_parent_coordsv, saturn) << addBody("Enceladus", &get_enceladus_parent_coordsv, saturn)
+	       << addBody("Tethys", &get_tethys_parent_coordsv, saturn) << addBody("Dione", &get_dione_parent_coordsv, saturn)
+	       << addBody("Rhea", &get_rhea_parent_coordsv, saturn) << addBody("Titan", &get_titan_parent_coordsv, saturn)
+	       << addBody("Hyperion", &get_hyperion_parent_coordsv, saturn) << addBody("Iapetus", &get_iapetus_parent_coordsv, saturn);
+	majorFamilies << family;
+	family.clear();
+	TestBody* uranus = addBody("Uranus", &get_uranus_helio_coordsv, sun);
+	family << uranus << addBody("Miranda", &get_miranda_parent_coordsv, uranus) << addBody("Ariel", &get_ariel_parent_coordsv, uranus)
+	       << addBody("Umbriel", &get_umbriel_parent_coordsv, uranus) << addBody("Titania", &get_titania_parent_coordsv, uranus)
+	       << addBody("Oberon", &get_oberon_parent_coordsv, uranus);
+	majorFamilies << family;
+	family.clear();
+	family << addBody("Neptune", &get_neptune_helio_coordsv, sun);
+	majorFamilies << family;
+	family.clear();
+	family << addBody("Pluto", &get_pluto_helio_coordsv, sun);
+	majorFamilies << family;
+	foreach (const PlanetFamilies<TestBody>::Family& f, majorFamilies)
+		families.append(f);
+
+	// Minor planets between 1.5 and 5 AU, alone in their family
+	qsrand(42);
+	for (int i=0;i<NB_MINOR_PLANETS;++i)
+	{
+		const double random = (double)qrand()/RAND_MAX;
+		const double q = 1.5+3.5*random;
+		const double e = 0.3*random;
+		const double a = q/(1.-e);
+		TestBody* b = addBody(QString("Minor planet %1").arg(i), &cometOrbitPosFunc, sun);
+		b->orbit = new CometOrbit(q, e, 0.3*random, 6.*random, 4.*random, 2451545.0+1000.*random, 0., 0.01720209895/(a*std::sqrt(a)), 0., 0., 0.);
+		b->userData = b->orbit;
+		family.clear();
+		family << b;
+		families.append(family);
+	}
+}
+
+void TestPlanetFamilies::cleanupTestCase()
+{
+	foreach (TestBody* b, bodies)
+	{
+		delete b->orbit;
+		delete b;
+	}
+	qDeleteAll(contexts);
+}
+
+const TestBody* TestPlanetFamilies::findBody(const QString& name) const
+{
+	foreach (const TestBody* b, bodies)
+	{
+		if (b->name==name)
+			return b;
+	}
+	return NULL;
+}
+
+// Give new contexts to the families of the major bodies, or the static caches when useContexts is false,
+// and forget the positions already computed.
+void TestPlanetFamilies::resetBodies(bool useContexts)
+{
+	qDeleteAll(contexts);
+	contexts.clear();
+	for (int f=0;f<families.size();++f)
+	{
+		const PlanetFamilies<TestBody>::Family& family = families.at(f);
+		if (family.first()->orbit)
+			continue;
+		EphemContext* context = NULL;
+		if (useContexts)
+		{
+			context = new EphemContext;
+			contexts.append(context);
+		}
+		foreach (TestBody* b, family)
+			b->userData = context;
+	}
+	foreach (TestBody* b, bodies)
+	{
+		b->lastJDE = -1e100;
+		b->eclipticPos.set(0., 0., 0.);
+	}
+}
+
+// As SolarSystem::computePositions(), seen from the Earth
+void TestPlanetFamilies::computePositions(double dateJDE, bool parallel)
+{
+	PlanetFamilies<TestBody>::Family sunFamily;
+	sunFamily << sun;
+	PlanetFamilies<TestBody>::computePositions(sunFamily, dateJDE, dateJDE-deltaT, Vec3d(0.), true);
+	ComputeFamily func;
+	func.dateJDE = dateJDE;
+	get_earth_helio_coordsv(dateJDE, func.observerPos, NULL);
+	families.forEach(func, parallel);
+}
+
+void TestPlanetFamilies::testFamilies()
+{
+	QCOMPARE(families.size(), 9+NB_MINOR_PLANETS);
+	QCOMPARE(families.getBodyCount(), bodies.size()-1);
+	for (int f=0;f<families.size();++f)
+	{
+		const PlanetFamilies<TestBody>::Family& family = families.at(f);
+		QVERIFY(family.first()->parent==sun);
+		for (int i=1;i<family.size();++i)
+			QVERIFY(family.indexOf(family.at(i)->parent)<i);
+	}
+}
+
+void TestPlanetFamilies::testParallelMatchesSerial()
+{
+	// Several dates, so that the interpolation caches of the contexts are used
+	QVector<Vec3d> serial;
+	resetBodies(true);
+	for (int d=0;d<5;++d)
+	{
+		computePositions(startJDE+0.3*d, false);
+		foreach (const TestBody* b, bodies)
+			serial << b->getHeliocentricEclipticPos() << Vec3d(b->transJD, b->transJDE, 0.);
+	}
+
+	resetBodies(true);
+	int i = 0;
+	for (int d=0;d<5;++d)
+	{
+		computePositions(startJDE+0.3*d, true);
+		foreach (const TestBody* b, bodies)
+		{
+			// Exact comparison: the results must be bit identical
+			QVERIFY2(b->getHeliocentricEclipticPos()==serial.at(i++), qPrintable(b->name));
+			QVERIFY2(Vec3d(b->transJD, b->transJDE, 0.)==serial.at(i++), qPrintable(b->name));
+		}
+	}
+}
+
+void TestPlanetFamilies::testMatchesDefaultCaches()
+{
+	// The contexts of the families give the positions the static caches of the theories give
+	resetBodies(false);
+	computePositions(startJDE, false);
+	QVector<Vec3d> positions;
+	foreach (const TestBody* b, bodies)
+		positions << b->getHeliocentricEclipticPos();
+
+	resetBodies(true);
+	computePositions(startJDE, true);
+	for (int i=0;i<bodies.size();++i)
+	{
+		const double difference = (bodies.at(i)->getHeliocentricEclipticPos()-positions.at(i)).length();
+		QVERIFY2(difference<1e-8, qPrintable(QString("%1: %2 AU").arg(bodies.at(i)->name).arg(difference)));
+	}
+}
+
+void TestPlanetFamilies::testPositions()
+{
+	resetBodies(true);
+	computePositions(startJDE, true);
+	Vec3d earthPos;
+	get_earth_helio_coordsv(startJDE, earthPos, NULL);
+
+	// Each satellite is placed relative to its own parent
+	const double earthDistance = findBody("Earth")->getHeliocentricEclipticPos().length();
+	QVERIFY(earthDistance>0.98 && earthDistance<1.02);
+	const double moonDistance = (findBody("Moon")->getHeliocentricEclipticPos()-findBody("Earth")->getHeliocentricEclipticPos()).length();
+	QVERIFY(moonDistance>0.0023 && moonDistance<0.0028);
+	const double ioDistance = (findBody("Io")->getHeliocentricEclipticPos()-findBody("Jupiter")->getHeliocentricEclipticPos()).length();
+	QVERIFY(ioDistance>0.0027 && ioDistance<0.0030);
+	const double titanDistance = (findBody("Titan")->getHeliocentricEclipticPos()-findBody("Saturn")->getHeliocentricEclipticPos()).length();
+	QVERIFY(titanDistance>0.0078 && titanDistance<0.0085);
+
+	// The bodies are computed at the date their light left them
+	foreach (const TestBody* b, bodies)
+	{
+		if (b==sun)
+			continue;
+		const double lightTime = (b->getHeliocentricEclipticPos()-earthPos).length() * (AU / (SPEED_OF_LIGHT * 86400));
+		QVERIFY2(std::fabs(startJDE-lightTime-b->transJDE)<1e-6, qPrintable(b->name));
+		QVERIFY2(std::fabs(startJDE-deltaT-lightTime-b->transJD)<1e-6, qPrintable(b->name));
+	}
+}
+
+void TestPlanetFamilies::benchmarkComputePositions_data()
+{
+	QTest::addColumn<bool>("parallel");
+	QTest::newRow("serial") << false;
+	QTest::newRow("parallel") << true;
+}
+
+void TestPlanetFamilies::benchmarkComputePositions()
+{
+	QFETCH(bool, parallel);
+	resetBodies(true);
+	double dateJDE = startJDE;
+	QBENCHMARK {
+		// A new date each time, as when the time runs
+		dateJDE += 1./1440.;
+		computePositions(dateJDE, parallel);
+	}
+}
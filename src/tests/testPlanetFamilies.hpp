@@ -0,0 +1,95 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _TESTPLANETFAMILIES_HPP_
+#define _TESTPLANETFAMILIES_HPP_
+
+#include <QObject>
+#include <QTest>
+#include <QVector>
+
+#include "PlanetFamilies.hpp"
+#include "VecMath.hpp"
+
+class CometOrbit;
+struct EphemContext;
+
+//! A body with the interface PlanetFamilies::computePositions() uses, computed as Planet does:
+//! its position function gives its position relative to its parent, and is called with the
+//! EphemContext of its family or with its orbit.
+struct TestBody
+{
+	typedef void (*PosFunc)(double, double*, void*);
+
+	TestBody() : name(), coordFunc(NULL), userData(NULL), orbit(NULL), parent(NULL), lastJDE(-1e100), transJD(0.), transJDE(0.) {}
+
+	void computePositionWithoutOrbits(double dateJDE)
+	{
+		if (dateJDE!=lastJDE)
+		{
+			coordFunc(dateJDE, eclipticPos, userData);
+			lastJDE = dateJDE;
+		}
+	}
+	void computePosition(double dateJDE)
+	{
+		// As Planet::computePosition(), the Sun is not updated
+		if (parent && parent->parent)
+			parent->computePositionWithoutOrbits(dateJDE);
+		computePositionWithoutOrbits(dateJDE);
+	}
+	Vec3d getHeliocentricEclipticPos() const {return parent ? parent->getHeliocentricEclipticPos()+eclipticPos : Vec3d(0.);}
+	void computeTransMatrix(double JD, double JDE) {transJD = JD; transJDE = JDE;}
+
+	QString name;
+	PosFunc coordFunc;
+	void* userData;
+	CometOrbit* orbit;
+	TestBody* parent;
+	Vec3d eclipticPos;
+	double lastJDE;
+	double transJD;
+	double transJDE;
+};
+
+class TestPlanetFamilies : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testFamilies();
+	void testParallelMatchesSerial();
+	void testMatchesDefaultCaches();
+	void testPositions();
+	void benchmarkComputePositions_data();
+	void benchmarkComputePositions();
+	void cleanupTestCase();
+private:
+	TestBody* addBody(const QString& name, TestBody::PosFunc func, TestBody* parent);
+	void resetBodies(bool useContexts);
+	void computePositions(double dateJDE, bool parallel);
+	const TestBody* findBody(const QString& name) const;
+	TestBody* sun;
+	QVector<TestBody*> bodies;
+	QVector<EphemContext*> contexts;
+	PlanetFamilies<TestBody> families;
+};
+
+#endif // _TESTPLANETFAMILIES_HPP_
@@ -0,0 +1,79 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testPlanetMeshCache.hpp"
+#include "PlanetMeshCache.hpp"
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestPlanetMeshCache)
+
+void TestPlanetMeshCache::testSphere()
+{
+	PlanetMeshCache cache;
+	const PlanetMeshCache::Mesh* mesh = cache.sphere(20, 0.9f);
+	QVERIFY(mesh!=NULL);
+	QCOMPARE(cache.getMisses(), (qint64)1);
+	QCOMPARE(mesh->vertexArr.size(), 20*21*2*3);
+	QCOMPARE(mesh->texCoordArr.size(), 20*21*2*2);
+	QCOMPARE(mesh->indiceArr.size(), 20*20*6);
+	// All the vertices are on the spheroid
+	for (int i=0;i<mesh->vertexArr.size();i+=3)
+	{
+		const float x = mesh->vertexArr.at(i);
+		const float y = mesh->vertexArr.at(i+1);
+		const float z = mesh->vertexArr.at(i+2)/0.9f;
+		QVERIFY(std::fabs(x*x+y*y+z*z-1.f)<1e-5f);
+	}
+
+	// Same mesh for the same facets and close shapes, others are generated
+	QCOMPARE(cache.sphere(20, 0.90001f), mesh);
+	QCOMPARE(cache.getHits(), (qint64)1);
+	QVERIFY(cache.sphere(21, 0.9f)!=mesh);
+	QVERIFY(cache.sphere(20, 0.95f)!=mesh);
+	QCOMPARE(cache.getMisses(), (qint64)3);
+	QVERIFY(cache.memoryUsage()>0);
+}
+
+void TestPlanetMeshCache::testRing()
+{
+	PlanetMeshCache cache;
+	const PlanetMeshCache::Mesh* ring = cache.ring(128, 0.5f);
+	QCOMPARE(ring->vertexArr.size(), 33*129*3);
+	for (int i=0;i<ring->vertexArr.size();i+=3)
+	{
+		const float r = std::sqrt(ring->vertexArr.at(i)*ring->vertexArr.at(i) + ring->vertexArr.at(i+1)*ring->vertexArr.at(i+1));
+		QVERIFY(r>=0.5f-1e-5f && r<=1.f+1e-5f);
+	}
+	// Rings and spheres are not mixed up
+	QVERIFY(cache.sphere(128, 0.5f)!=ring);
+	QCOMPARE(cache.getMisses(), (qint64)2);
+}
+
+void TestPlanetMeshCache::testBudget()
+{
+	PlanetMeshCache cache(1024*1024);
+	for (int facets=10;facets<=100;++facets)
+		QVERIFY(cache.sphere(facets, 1.f)!=NULL);
+	QVERIFY(cache.memoryUsage()<=1024*1024);
+	// The last mesh is still there
+	const qint64 hits = cache.getHits();
+	cache.sphere(100, 1.f);
+	QCOMPARE(cache.getHits(), hits+1);
+}
@@ -0,0 +1,83 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testPlanetSkyIndex.hpp"
+#include "PlanetSkyIndex.hpp"
+
+#include <QSet>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestPlanetSkyIndex)
+
+namespace
+{
+	Vec3d randomDirection()
+	{
+		const double z = 2.*qrand()/RAND_MAX-1.;
+		const double ra = 2.*M_PI*qrand()/RAND_MAX;
+		const double r = std::sqrt(1.-z*z);
+		return Vec3d(r*std::cos(ra), r*std::sin(ra), z);
+	}
+}
+
+void TestPlanetSkyIndex::testFindAround()
+{
+	qsrand(42);
+	QVector<Vec3d> directions;
+	PlanetSkyIndex index;
+	for (int k=0;k<20000;++k)
+	{
+		directions.append(randomDirection());
+		index.insert(directions.last(), 0.f, k);
+	}
+	// The poles, where all the cells of right ascension meet
+	directions << Vec3d(0., 0., 1.) << Vec3d(0., 0., -1.);
+	index.insert(directions.at(20000), 0.f, 20000);
+	index.insert(directions.at(20001), 0.f, 20001);
+	index.build();
+	QCOMPARE(index.size(), directions.size());
+
+	// The same bodies as by looking at all of them
+	const double radii[4] = {0.0001, 0.01, 0.1, 1.};
+	for (int t=0;t<200;++t)
+	{
+		Vec3d center = t<2 ? Vec3d(0., 0.01, t==0 ? 1. : -1.) : randomDirection();
+		center.normalize();
+		for (int r=0;r<4;++r)
+		{
+			QVector<PlanetSkyIndex::Entry> found;
+			index.findAround(center, radii[r], found);
+			QSet<int> foundIds;
+			foreach (const PlanetSkyIndex::Entry& entry, found)
+				foundIds.insert(entry.id);
+			QCOMPARE(foundIds.size(), found.size());
+			const double cosRadius = std::cos(radii[r]);
+			for (int k=0;k<directions.size();++k)
+			{
+				const double c = directions.at(k)*center;
+				// Allow for rounding at the limit
+				if (c>cosRadius+1e-12)
+					QVERIFY2(foundIds.contains(k), qPrintable(QString("test %1, radius %2, body %3").arg(t).arg(radii[r]).arg(k)));
+				else if (c<cosRadius-1e-9)
+					QVERIFY2(!foundIds.contains(k), qPrintable(QString("test %1, radius %2, body %3").arg(t).arg(radii[r]).arg(k)));
+			}
+		}
+	}
+}
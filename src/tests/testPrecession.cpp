@@ -23,14 +23,51 @@
 #include <QtTest>
 
 #include "tests/testPrecession.hpp"
+#include "sidereal_time.h"
 #include "StelUtils.hpp"
 #include "VecMath.hpp"
 
+#include <QtConcurrent>
+
 QTEST_GUILESS_MAIN(TestPrecession)
 
 static const double arcSec2Rad=M_PI*2.0/(360.0*3600.0);
 static const double eps0=84381.406*arcSec2Rad;
 
+namespace
+{
+	//! Everything computed for one date, as Planet::computeRotLocalToParent() and Planet::getSiderealTime() do for the Earth
+	struct DateAngles
+	{
+		typedef void result_type;
+		double jde;
+		double epsilon_A, chi_A, omega_A, psi_A;
+		double deltaPsi, deltaEpsilon;
+		double siderealTime;
+
+		void compute()
+		{
+			getPrecessionAnglesVondrak(jde, &epsilon_A, &chi_A, &omega_A, &psi_A);
+			getNutationAngles(jde, &deltaPsi, &deltaEpsilon);
+			siderealTime=get_apparent_sidereal_time(jde-68.4/86400., jde);
+		}
+		bool operator==(const DateAngles& other) const
+		{
+			return jde==other.jde && epsilon_A==other.epsilon_A && chi_A==other.chi_A && omega_A==other.omega_A && psi_A==other.psi_A
+			    && deltaPsi==other.deltaPsi && deltaEpsilon==other.deltaEpsilon && siderealTime==other.siderealTime;
+		}
+	};
+
+	struct ComputeAngles
+	{
+		typedef void result_type;
+		void operator()(DateAngles& angles) const
+		{
+			angles.compute();
+		}
+	};
+}
+
 void TestPrecession::initTestCase()
 {
 }
@@ -56,8 +93,7 @@ void TestPrecession::testPrecessionAnglesVondrak()
 
 	// get angles for Capitaine parameterisation
 	getPrecessionAnglesVondrak(JulianDay, &epsilon_A, &chi_A, &omega_A, &psi_A);
-	// Get reference angles. We have to call this twice with different dates to avoid returning the cached (zero) angles.
-	getPrecessionAnglesVondrakPQXYe(-1234.567, &P_A, &Q_A, &X_A, &Y_A, &epsilon_A);
+	// get reference angles
 	getPrecessionAnglesVondrakPQXYe(JulianDay, &P_A, &Q_A, &X_A, &Y_A, &epsilon_A);
 	Z=sqrt(qMax(1.0-P_A*P_A-Q_A*Q_A, 0.0));
 	W=X_A*X_A+Y_A*Y_A;
@@ -119,3 +155,40 @@ void TestPrecession::testPrecessionAnglesVondrak()
 
 	//TODO: Add more dates and verify this angle difference is limited to what we can see in Fig.12
 }
+
+void TestPrecession::testNoCachedAngles()
+{
+	// Dates closer than a day, or than an hour for the nutation, must not give the angles of the previous call
+	DateAngles first, second, again;
+	first.jde=2457600.5;
+	second.jde=first.jde+0.01;
+	again.jde=first.jde;
+	first.compute();
+	second.compute();
+	again.compute();
+	QVERIFY(second.psi_A!=first.psi_A);
+	QVERIFY(second.epsilon_A!=first.epsilon_A);
+	QVERIFY(second.deltaPsi!=first.deltaPsi);
+	QVERIFY(again==first);
+	QCOMPARE(getPrecessionAngleVondrakEpsilon(second.jde), second.epsilon_A);
+}
+
+void TestPrecession::testParallelMatchesSerial()
+{
+	// As when the ephemerides are computed by several threads while the main thread draws the sky
+	QVector<DateAngles> serial;
+	for (int i=0; i<20000; ++i)
+	{
+		DateAngles angles;
+		angles.jde=2268932.5+(i%2 ? 18.3*i : 0.37*i);
+		angles.compute();
+		serial << angles;
+	}
+
+	QVector<DateAngles> parallel=serial;
+	for (int i=0; i<parallel.size(); ++i)
+		parallel[i].epsilon_A=parallel[i].chi_A=parallel[i].omega_A=parallel[i].psi_A=parallel[i].deltaPsi=parallel[i].deltaEpsilon=parallel[i].siderealTime=0.;
+	QtConcurrent::blockingMap(parallel, ComputeAngles());
+	for (int i=0; i<serial.size(); ++i)
+		QVERIFY2(parallel.at(i)==serial.at(i), qPrintable(QString("JDE %1").arg(serial.at(i).jde, 0, 'f', 5)));
+}
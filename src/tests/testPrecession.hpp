@@ -30,6 +30,8 @@ class TestPrecession : public QObject
 private slots:
 	void initTestCase();	
 	void testPrecessionAnglesVondrak(); 
+	void testNoCachedAngles();
+	void testParallelMatchesSerial();
 };
 
 #endif // _TESTPRECESSION_HPP_
@@ -0,0 +1,432 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testSolarSystemEphemeris.hpp"
+#include "SolarSystemEphemeris.hpp"
+#include "SolarSystem.hpp"
+#include "Planet.hpp"
+#include "StelApp.hpp"
+#include "StelCore.hpp"
+#include "StelFileMgr.hpp"
+#include "StelIniParser.hpp"
+#include "StelModuleMgr.hpp"
+#include "StelTranslator.hpp"
+#include "StelUtils.hpp"
+#include "EphemWrapper.hpp"
+
+#include <QApplication>
+#include <QDir>
+#include <QSettings>
+
+#include <clocale>
+#include <cmath>
+
+// As for the --ephemeris option, the application needs no display
+int main(int argc, char *argv[])
+{
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	QApplication app(argc, argv);
+	TestSolarSystemEphemeris test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+namespace
+{
+	// 2017-01-01 0h UT, far from the eclipses of the Sun
+	const double startJD = 2457754.5;
+
+	// Heliocentric ecliptic positions, in AU, for the magnitudes computed from fixed positions
+	const Vec3d earthPos(-0.18, 0.97, 0.);
+
+	Vec3d planetPos(const QString& englishName)
+	{
+		if (englishName=="Mercury")
+			return Vec3d(0.31, 0.25, 0.03);
+		if (englishName=="Venus")
+			return Vec3d(-0.52, 0.48, 0.02);
+		if (englishName=="Mars")
+			return Vec3d(1.21, -0.93, -0.05);
+		if (englishName=="Jupiter")
+			return Vec3d(-5.17, 1.04, 0.11);
+		if (englishName=="Saturn")
+			return Vec3d(1.52, -9.93, 0.12);
+		if (englishName=="Uranus")
+			return Vec3d(18.04, 7.23, -0.21);
+		if (englishName=="Neptune")
+			return Vec3d(28.11, -9.12, -0.46);
+		return Vec3d(10.37, -31.82, 1.53);	// Pluto
+	}
+
+	// The magnitude of a planet seen from the Earth, as Planet::getVMagnitude() computed it from the
+	// positions of StelCore before Planet::computeVMagnitude() was split out of it.
+	// @return false if the planet and the algorithm have no empirical formula
+	bool empiricalMagnitude(const QString& englishName, Planet::ApparentMagnitudeAlgorithm algorithm, const Vec3d& observerHelioPos,
+				const Vec3d& planetHelioPos, const Vec3d& earthHelioPos, double jde, double* mag)
+	{
+		const double observerRq = observerHelioPos.lengthSquared();
+		const double planetRq = planetHelioPos.lengthSquared();
+		const double observerPlanetRq = (observerHelioPos - planetHelioPos).lengthSquared();
+		const double cos_chi = (observerPlanetRq + planetRq - observerRq)/(2.0*std::sqrt(observerPlanetRq*planetRq));
+		const double phaseDeg = std::acos(cos_chi)*180./M_PI;
+		const double d = 5. * log10(std::sqrt(observerPlanetRq*planetRq));
+
+		// Saturnicentric latitude of the Earth, for the rings (Meeus, Astr.Alg.1992)
+		const double T=(jde-2451545.0)/36525.0;
+		const double i=((0.000004*T-0.012998)*T+28.075216)*M_PI/180.0;
+		const double Omega=((0.000412*T+1.394681)*T+169.508470)*M_PI/180.0;
+		const Vec3d saturnEarth=planetHelioPos - earthHelioPos;
+		const double lambda=atan2(saturnEarth[1], saturnEarth[0]);
+		const double beta=atan2(saturnEarth[2], std::sqrt(saturnEarth[0]*saturnEarth[0]+saturnEarth[1]*saturnEarth[1]));
+		const double sinB=sin(i)*cos(beta)*sin(lambda-Omega)-cos(i)*sin(beta);
+
+		switch (algorithm)
+		{
+			case Planet::Planesas:
+			{
+				double f1 = phaseDeg/100.;
+				if (englishName=="Mercury")
+				{
+					if ( phaseDeg > 150. ) f1 = 1.5;
+					*mag = -0.36 + d + 3.8*f1 - 2.73*f1*f1 + 2*f1*f1*f1;
+				}
+				else if (englishName=="Venus")
+					*mag = -4.29 + d + 0.09*f1 + 2.39*f1*f1 - 0.65*f1*f1*f1;
+				else if (englishName=="Mars")
+					*mag = -1.52 + d + 0.016*phaseDeg;
+				else if (englishName=="Jupiter")
+					*mag = -9.25 + d + 0.005*phaseDeg;
+				else if (englishName=="Saturn")
+					*mag = -8.88 + d + 0.044*phaseDeg - 2.6*sinB + 1.25*sinB*sinB;
+				else if (englishName=="Uranus")
+					*mag = -7.19 + d + 0.0028*phaseDeg;
+				else if (englishName=="Neptune")
+					*mag = -6.87 + d;
+				else if (englishName=="Pluto")
+					*mag = -1.01 + d + 0.041*phaseDeg;
+				else
+					return false;
+				return true;
+			}
+			case Planet::Mueller:
+			{
+				if (englishName=="Mercury")
+				{
+					double ph50=phaseDeg-50.0;
+					*mag = 1.16 + d + 0.02838*ph50 + 0.0001023*ph50*ph50;
+				}
+				else if (englishName=="Venus")
+					*mag = -4.0 + d + 0.01322*phaseDeg + 0.0000004247*phaseDeg*phaseDeg*phaseDeg;
+				else if (englishName=="Mars")
+					*mag = -1.3 + d + 0.01486*phaseDeg;
+				else if (englishName=="Jupiter")
+					*mag = -8.93 + d;
+				else if (englishName=="Saturn")
+					*mag = -8.68 + d + 0.044*phaseDeg - 2.6*fabs(sinB) + 1.25*sinB*sinB;
+				else if (englishName=="Uranus")
+					*mag = -6.85 + d;
+				else if (englishName=="Neptune")
+					*mag = -7.05 + d;
+				else if (englishName=="Pluto")
+					*mag = -1.0 + d;
+				else
+					return false;
+				return true;
+			}
+			case Planet::Harris:
+			case Planet::UndefinedAlgorithm:
+			{
+				if (englishName=="Mercury")
+					*mag = 0.42 + d + .038*phaseDeg - 0.000273*phaseDeg*phaseDeg + 0.000002*phaseDeg*phaseDeg*phaseDeg;
+				else if (englishName=="Venus")
+					*mag = -4.40 + d + 0.0009*phaseDeg + 0.000239*phaseDeg*phaseDeg - 0.00000065*phaseDeg*phaseDeg*phaseDeg;
+				else if (englishName=="Mars")
+					*mag = -1.52 + d + 0.016*phaseDeg;
+				else if (englishName=="Jupiter")
+					*mag = -9.40 + d + 0.005*phaseDeg;
+				else if (englishName=="Saturn")
+					*mag = -8.88 + d + 0.044*phaseDeg - 2.6*fabs(sinB) + 1.25*sinB*sinB;
+				else if (englishName=="Uranus")
+					*mag = -7.19 + d;
+				else if (englishName=="Neptune")
+					*mag = -6.87 + d;
+				else if (englishName=="Pluto")
+					*mag = -1.00 + d;
+				else
+					return false;
+				return true;
+			}
+			case Planet::Generic:
+				break;
+		}
+		return false;
+	}
+
+	QString difference(const QString& name, double date, double diff)
+	{
+		return QString("%1 at %2: %3").arg(name).arg(date, 0, 'f', 5).arg(diff);
+	}
+}
+
+void TestSolarSystemEphemeris::initTestCase()
+{
+	conf = NULL;
+	app = NULL;
+	// As main(), with the data of the source tree and a temporary user directory
+	setlocale(LC_NUMERIC, "C");
+	QVERIFY(userDir.isValid());
+	QVERIFY(QDir::setCurrent(STELLARIUM_SOURCE_DIR));
+	StelFileMgr::init();
+	StelFileMgr::setUserDir(userDir.path());
+	StelTranslator::init(StelFileMgr::getInstallationDir() + "/data/iso639-1.utf8");
+
+	// No location looked up from the IP address
+	conf = new QSettings(userDir.path() + "/config.ini", StelIniFormat);
+	conf->setValue("init_location/location", "Paris, France");
+	app = new StelApp();
+	app->initHeadless(conf);
+	core = app->getCore();
+	ssystem = GETSTELMODULE(SolarSystem);
+	QVERIFY(ssystem);
+	QCOMPARE(core->getCurrentLocation().planetName, QString("Earth"));
+	core->setTimeRate(0.);
+}
+
+void TestSolarSystemEphemeris::cleanupTestCase()
+{
+	delete app;
+	delete conf;
+}
+
+void TestSolarSystemEphemeris::testPositionsMatch_data()
+{
+	QTest::addColumn<QString>("name");
+	QTest::newRow("VSOP87") << QString("Mars");
+	QTest::newRow("ELP82B") << QString("Moon");
+	QTest::newRow("L1") << QString("Io");
+	QTest::newRow("Kepler orbit") << QString("Ceres");
+	QTest::newRow("Comet orbit") << QString("1P/Halley");
+}
+
+// Planet::computeEclipticPosAt() with its own caches against Planet::computePosition(), which StelCore uses
+void TestSolarSystemEphemeris::testPositionsMatch()
+{
+	QFETCH(QString, name);
+	const PlanetP planet = ssystem->searchByEnglishName(name);
+	QVERIFY2(planet, qPrintable(name));
+
+	EphemContext context;
+	// Dates far enough apart that computePosition() computes each one
+	for (int i=0; i<5; ++i)
+	{
+		const double JDE = startJD + 41.7*i;
+		planet->computePosition(JDE);
+		double xyz[3];
+		QVERIFY(planet->computeEclipticPosAt(JDE, xyz, &context));
+		const double diff = (planet->getEclipticPos() - Vec3d(xyz[0], xyz[1], xyz[2])).length();
+		QVERIFY2(diff<1e-8, qPrintable(difference(name, JDE, diff) + " AU"));
+
+		Vec3d helioPos;
+		QVERIFY(SolarSystemEphemeris::computeHeliocentricEclipticPos(planet.data(), JDE, helioPos, &context));
+		const double helioDiff = (planet->getHeliocentricEclipticPos() - helioPos).length();
+		QVERIFY2(helioDiff<1e-8, qPrintable(difference(name, JDE, helioDiff) + " AU"));
+	}
+}
+
+void TestSolarSystemEphemeris::testRotationsMatch_data()
+{
+	QTest::addColumn<QString>("name");
+	QTest::newRow("Earth") << QString("Earth");
+	QTest::newRow("Moon") << QString("Moon");
+	QTest::newRow("Mars") << QString("Mars");
+	QTest::newRow("Jupiter") << QString("Jupiter");
+	QTest::newRow("Io") << QString("Io");
+}
+
+// Planet::computeRotLocalToParent() of a body and its parents against the matrices computeTransMatrix() sets
+void TestSolarSystemEphemeris::testRotationsMatch()
+{
+	QFETCH(QString, name);
+	const PlanetP planet = ssystem->searchByEnglishName(name);
+	QVERIFY2(planet, qPrintable(name));
+
+	for (int i=0; i<3; ++i)
+	{
+		const double JD = startJD + 1000.3*i;
+		const double JDE = JD + core->computeDeltaT(JD)/86400.;
+		Mat4d rot = Mat4d::identity();
+		for (Planet* p=planet.data(); p->getParent(); p=p->getParent().data())
+		{
+			p->computeTransMatrix(JD, JDE);
+			rot = p->computeRotLocalToParent(JDE) * rot;
+		}
+		Mat4d expected = planet->getRotEquatorialToVsop87();
+		for (int j=0; j<16; ++j)
+			QVERIFY2(std::fabs(rot[j]-expected[j])<1e-14, qPrintable(difference(name, JD, rot[j]-expected[j])));
+	}
+}
+
+// Planet::computeVMagnitude() against the arithmetic of Planet::getVMagnitude() before it
+void TestSolarSystemEphemeris::testSunMagnitude()
+{
+	const PlanetP sun = ssystem->getSun();
+	QVERIFY(sun);
+	Planet::MagnitudeContext context;
+	context.observerHelioPos = earthPos;
+	context.planetHelioPos.set(0., 0., 0.);
+	context.parentHelioPos.set(0., 0., 0.);
+	context.earthHelioPos = earthPos;
+	context.JDE = startJD;
+	context.fromEarth = true;
+	context.algorithm = Planet::Harris;
+
+	// The last factor is below the smallest visible part of the Sun
+	const double eclipseFactors[] = {1., 0.4, 1e-6};
+	for (int i=0; i<3; ++i)
+	{
+		context.eclipseFactor = eclipseFactors[i];
+		const double distParsec = std::sqrt(earthPos.lengthSquared())*AU/PARSEC;
+		const double expected = 4.83 + 5.*(std::log10(distParsec)-1.) - 2.5*(std::log10(qMax(eclipseFactors[i], 0.000128)));
+		const double diff = sun->computeVMagnitude(context) - expected;
+		QVERIFY2(std::fabs(diff)<1e-4, qPrintable(QString("eclipse factor %1: %2 mag").arg(eclipseFactors[i]).arg(diff)));
+	}
+}
+
+void TestSolarSystemEphemeris::testPlanetMagnitudes_data()
+{
+	QTest::addColumn<QString>("name");
+	QTest::addColumn<int>("algorithm");
+	const QStringList names = QStringList() << "Mercury" << "Venus" << "Mars" << "Jupiter" << "Saturn" << "Uranus" << "Neptune" << "Pluto";
+	foreach (const QString& name, names)
+	{
+		QTest::newRow(qPrintable(name + ", Planesas")) << name << (int)Planet::Planesas;
+		QTest::newRow(qPrintable(name + ", Mueller")) << name << (int)Planet::Mueller;
+		QTest::newRow(qPrintable(name + ", Harris")) << name << (int)Planet::Harris;
+	}
+}
+
+void TestSolarSystemEphemeris::testPlanetMagnitudes()
+{
+	QFETCH(QString, name);
+	QFETCH(int, algorithm);
+	const PlanetP planet = ssystem->searchByEnglishName(name);
+	QVERIFY2(planet, qPrintable(name));
+
+	Planet::MagnitudeContext context;
+	// A topocentric observer, away from the center of the Earth
+	context.observerHelioPos = earthPos + Vec3d(0., 0., 4.26e-5);
+	context.planetHelioPos = planetPos(name);
+	context.parentHelioPos.set(0., 0., 0.);
+	context.earthHelioPos = earthPos;
+	context.JDE = startJD;
+	context.fromEarth = true;
+	context.algorithm = (Planet::ApparentMagnitudeAlgorithm)algorithm;
+	context.eclipseFactor = 1.;
+
+	double expected;
+	QVERIFY(empiricalMagnitude(name, context.algorithm, context.observerHelioPos, context.planetHelioPos, context.earthHelioPos, context.JDE, &expected));
+	const double diff = planet->computeVMagnitude(context) - expected;
+	QVERIFY2(std::fabs(diff)<1e-4, qPrintable(QString("%1 mag").arg(diff)));
+}
+
+// The Moon inside the umbra of the Earth, as the old arithmetic darkens it
+void TestSolarSystemEphemeris::testMoonInUmbra()
+{
+	const PlanetP moon = ssystem->getMoon();
+	QVERIFY(moon);
+	Vec3d antisolar = earthPos;
+	antisolar.normalize();
+
+	Planet::MagnitudeContext context;
+	context.observerHelioPos = earthPos + Vec3d(0., 0., 4.26e-5);
+	context.planetHelioPos = earthPos + antisolar*0.00257;
+	context.parentHelioPos = earthPos;
+	context.earthHelioPos = earthPos;
+	context.JDE = startJD;
+	context.fromEarth = true;
+	context.algorithm = Planet::Harris;
+	context.eclipseFactor = 1.;
+	const double eclipsed = moon->computeVMagnitude(context);
+
+	// The same Moon, with the Earth farther from the Sun so that it casts no shadow on it
+	context.parentHelioPos = earthPos + antisolar*0.00514;
+	const double full = moon->computeVMagnitude(context);
+
+	const double diff = (eclipsed-full) + 2.5*std::log10(2.718e-5);
+	QVERIFY2(std::fabs(diff)<1e-3, qPrintable(QString("%1 mag").arg(diff)));
+}
+
+void TestSolarSystemEphemeris::testEphemerisMatchesCore_data()
+{
+	QTest::addColumn<QString>("name");
+	QTest::addColumn<bool>("lightTravelTime");
+	const QStringList names = QStringList() << "Sun" << "Mercury" << "Venus" << "Moon" << "Mars" << "Jupiter" << "Saturn"
+						<< "Io" << "Ceres" << QString("1P/Halley");
+	foreach (const QString& name, names)
+	{
+		QTest::newRow(qPrintable(name)) << name << false;
+		QTest::newRow(qPrintable(name + ", light time")) << name << true;
+	}
+}
+
+// SolarSystemEphemeris::compute() against the positions and magnitudes of StelCore at the same dates
+void TestSolarSystemEphemeris::testEphemerisMatchesCore()
+{
+	QFETCH(QString, name);
+	QFETCH(bool, lightTravelTime);
+	const PlanetP planet = ssystem->searchByEnglishName(name);
+	QVERIFY2(planet, qPrintable(name));
+
+	ssystem->setFlagLightTravelTime(lightTravelTime);
+	const SolarSystemEphemeris ephemeris(core, core->getCurrentLocation());
+	QVERIFY(ephemeris.isValid());
+	// With the light time, StelCore leaves the Earth at the date the light left the Moon, computed
+	// after it in the family of the Earth: about 40 km from where the ephemeris has it.
+	const double tolerance = lightTravelTime ? 5e-7 : 1e-8;	// AU
+
+	EphemContext context;
+	for (int i=0; i<4; ++i)
+	{
+		const double JD = startJD + 3.27*i;
+		// StelCore finds the light time from the position of the observer at the previous update:
+		// a first update without it computes all the bodies at the date.
+		ssystem->setFlagLightTravelTime(false);
+		core->setJD(JD);
+		core->update(0.);
+		ssystem->setFlagLightTravelTime(lightTravelTime);
+		core->update(0.);
+		ssystem->computeCulledPositions();
+
+		SolarSystemEphemeris::Position pos;
+		QVERIFY(ephemeris.compute(planet, JD, pos, &context));
+		QVERIFY2(std::fabs(pos.JDE-core->getJDE())<1e-9, qPrintable(difference(name, JD, pos.JDE-core->getJDE()) + " d"));
+
+		const Vec3d j2000Pos = planet->getJ2000EquatorialPos(core);
+		const double j2000Diff = (pos.j2000EquatorialPos-j2000Pos).length();
+		QVERIFY2(j2000Diff<tolerance, qPrintable(difference(name, JD, j2000Diff) + " AU, J2000"));
+		const double equinoxDiff = (pos.equinoxEquatorialPos-planet->getEquinoxEquatorialPos(core)).length();
+		QVERIFY2(equinoxDiff<tolerance, qPrintable(difference(name, JD, equinoxDiff) + " AU, of date"));
+		const double altAzDiff = (pos.altAzPos-planet->getAltAzPosGeometric(core)).length();
+		QVERIFY2(altAzDiff<tolerance, qPrintable(difference(name, JD, altAzDiff) + " AU, horizontal"));
+		const double distanceDiff = pos.distance-j2000Pos.length();
+		QVERIFY2(std::fabs(distanceDiff)<tolerance, qPrintable(difference(name, JD, distanceDiff) + " AU, distance"));
+		const double magnitudeDiff = pos.vMagnitude-planet->getVMagnitude(core);
+		QVERIFY2(std::fabs(magnitudeDiff)<1e-3, qPrintable(difference(name, JD, magnitudeDiff) + " mag"));
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTSOLARSYSTEMEPHEMERIS_HPP_
+#define _TESTSOLARSYSTEMEPHEMERIS_HPP_
+
+#include <QObject>
+#include <QTest>
+#include <QTemporaryDir>
+
+class QSettings;
+class StelApp;
+class StelCore;
+class SolarSystem;
+
+//! Compare SolarSystemEphemeris, and the methods of Planet it uses, with the positions and
+//! magnitudes StelCore computes when its date is set. The application is started without
+//! a window, as for the --ephemeris option, from the data files of the source tree.
+class TestSolarSystemEphemeris : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void testPositionsMatch_data();
+	void testPositionsMatch();
+	void testRotationsMatch_data();
+	void testRotationsMatch();
+	void testSunMagnitude();
+	void testPlanetMagnitudes_data();
+	void testPlanetMagnitudes();
+	void testMoonInUmbra();
+	void testEphemerisMatchesCore_data();
+	void testEphemerisMatchesCore();
+
+private:
+	QTemporaryDir userDir;
+	QSettings* conf;
+	StelApp* app;
+	StelCore* core;
+	SolarSystem* ssystem;
+};
+
+#endif // _TESTSOLARSYSTEMEPHEMERIS_HPP_
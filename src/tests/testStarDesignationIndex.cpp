@@ -0,0 +1,143 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStarDesignationIndex.hpp"
+#include "StarDesignationIndex.hpp"
+
+QTEST_GUILESS_MAIN(TestStarDesignationIndex)
+
+#define MASK(c) (1u<<StarDesignationIndex::c)
+
+void TestStarDesignationIndex::testFind()
+{
+	StarDesignationIndex index;
+	index.insert(StarDesignationIndex::CommonName, "Sirius", 32349);
+	index.insert(StarDesignationIndex::SciName, "alpha CMa", 32349);
+	index.insert(StarDesignationIndex::GcvsName, "alf CMa", 32349);
+	index.insert(StarDesignationIndex::CommonName, "Vega", 91262);
+	index.insert(StarDesignationIndex::WdsName, "WDS J06451-1643", 32349);
+	index.build();
+
+	QCOMPARE(index.size(), 5);
+	QCOMPARE(index.find("SIRIUS", MASK(CommonName)), 32349);
+	QCOMPARE(index.find("VEGA", MASK(CommonName) | MASK(SciName)), 91262);
+	QCOMPARE(index.find("ALPHA CMA", MASK(SciName)), 32349);
+	QCOMPARE(index.find("WDS J06451-1643", MASK(WdsName)), 32349);
+	// Catalogs not in the mask are ignored
+	QCOMPARE(index.find("SIRIUS", MASK(CommonNameI18n)), 0);
+	QCOMPARE(index.find("ALF CMA", MASK(SciName)), 0);
+	// Keys must be normalized
+	QCOMPARE(index.find("Sirius", MASK(CommonName)), 0);
+	QCOMPARE(index.find(StarDesignationIndex::normalize("Sirius"), MASK(CommonName)), 32349);
+	QCOMPARE(index.find("", MASK(CommonName)), 0);
+	QCOMPARE(index.find("SIRIUSB", MASK(CommonName)), 0);
+}
+
+void TestStarDesignationIndex::testDuplicates()
+{
+	StarDesignationIndex index;
+	// The same designation in two catalogs: the first catalog of the mask wins
+	index.insert(StarDesignationIndex::SciName, "Polaris", 2);
+	index.insert(StarDesignationIndex::CommonName, "Polaris", 1);
+	// The same designation twice in a catalog: the last insertion wins
+	index.insert(StarDesignationIndex::CommonName, "Castor", 10);
+	index.insert(StarDesignationIndex::CommonName, "castor", 11);
+	index.insert(StarDesignationIndex::CommonName, "CASTOR", 12);
+	index.build();
+
+	QCOMPARE(index.size(), 3);
+	QCOMPARE(index.find("POLARIS", MASK(CommonName) | MASK(SciName)), 1);
+	QCOMPARE(index.find("POLARIS", MASK(SciName)), 2);
+	QCOMPARE(index.find("CASTOR", MASK(CommonName)), 12);
+
+	// Building again after more insertions keeps the previous entries
+	index.insert(StarDesignationIndex::CommonName, "Castor", 13);
+	index.insert(StarDesignationIndex::CommonName, "Pollux", 14);
+	index.build();
+	QCOMPARE(index.size(), 4);
+	QCOMPARE(index.find("CASTOR", MASK(CommonName)), 13);
+	QCOMPARE(index.find("POLLUX", MASK(CommonName)), 14);
+	QCOMPARE(index.find("POLARIS", MASK(SciName)), 2);
+}
+
+void TestStarDesignationIndex::testPrefix()
+{
+	StarDesignationIndex index;
+	index.insert(StarDesignationIndex::CommonName, "Alnitak", 26727);
+	index.insert(StarDesignationIndex::CommonName, "Alnilam", 26311);
+	index.insert(StarDesignationIndex::CommonName, "Altair", 97649);
+	index.insert(StarDesignationIndex::GcvsName, "ALN", 1);
+	index.insert(StarDesignationIndex::CommonName, "Betelgeuse", 27989);
+	index.build();
+
+	QVector<int> found = index.findPrefix("ALNI", MASK(CommonName));
+	QCOMPARE(found.size(), 2);
+	QCOMPARE(index.key(found.at(0)).toString(), QString("ALNILAM"));
+	QCOMPARE(index.hip(found.at(1)), 26727);
+
+	found = index.findPrefix("ALN", MASK(CommonName) | MASK(GcvsName));
+	QCOMPARE(found.size(), 3);
+	QCOMPARE(index.catalog(found.at(0)), StarDesignationIndex::GcvsName);
+
+	QVERIFY(index.findPrefix("ALX", MASK(CommonName)).isEmpty());
+	QCOMPARE(index.findPrefix("", MASK(CommonName)).size(), 4);
+	QCOMPARE(index.key(index.lowerBound("B")).toString(), QString("BETELGEUSE"));
+	QCOMPARE(index.lowerBound("C"), index.size());
+}
+
+void TestStarDesignationIndex::testNumbers()
+{
+	StarDesignationIndex index;
+	index.insert(StarDesignationIndex::SaoNumber, 128522, 1);
+	index.insert(StarDesignationIndex::SaoNumber, 165988, 2);
+	index.insert(StarDesignationIndex::HdNumber, 224700, 1);
+	// Out of order and duplicated numbers
+	index.insert(StarDesignationIndex::SaoNumber, 100, 3);
+	index.insert(StarDesignationIndex::SaoNumber, 165988, 4);
+	index.build();
+
+	QCOMPARE(index.find(StarDesignationIndex::SaoNumber, 128522), 1);
+	QCOMPARE(index.find(StarDesignationIndex::SaoNumber, 165988), 4);
+	QCOMPARE(index.find(StarDesignationIndex::SaoNumber, 100), 3);
+	QCOMPARE(index.find(StarDesignationIndex::SaoNumber, 224700), 0);
+	QCOMPARE(index.find(StarDesignationIndex::HdNumber, 224700), 1);
+	QCOMPARE(index.find(StarDesignationIndex::HdNumber, 128522), 0);
+}
+
+void TestStarDesignationIndex::testClear()
+{
+	StarDesignationIndex index;
+	index.insert(StarDesignationIndex::CommonName, "Deneb", 102098);
+	index.insert(StarDesignationIndex::CommonNameI18n, "Deneb", 102098);
+	index.insert(StarDesignationIndex::SciName, "alpha Cyg", 102098);
+	index.insert(StarDesignationIndex::HdNumber, 197345, 102098);
+	index.build();
+
+	index.clear(StarDesignationIndex::CommonNameI18n);
+	index.insert(StarDesignationIndex::CommonNameI18n, "Denebe", 102098);
+	index.clear(StarDesignationIndex::HdNumber);
+	index.build();
+
+	QCOMPARE(index.size(), 3);
+	QCOMPARE(index.find("DENEB", MASK(CommonNameI18n)), 0);
+	QCOMPARE(index.find("DENEBE", MASK(CommonNameI18n)), 102098);
+	QCOMPARE(index.find("DENEB", MASK(CommonName)), 102098);
+	QCOMPARE(index.find("ALPHA CYG", MASK(SciName)), 102098);
+	QCOMPARE(index.find(StarDesignationIndex::HdNumber, 197345), 0);
+}
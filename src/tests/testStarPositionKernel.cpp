@@ -0,0 +1,160 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStarPositionKernel.hpp"
+
+#include <cstring>
+
+QTEST_GUILESS_MAIN(TestStarPositionKernel)
+
+#define NB_STARS (STAR_BLOCK_SIZE*200+17)
+
+void TestStarPositionKernel::initTestCase()
+{
+	// A zone of about 2 degrees around an arbitrary direction, with the axes
+	// scaled the same way as ZoneArray::scaleAxis() does for Star2.
+	zone.center = Vec3f(0.3f, 0.5f, 0.8f);
+	zone.center.normalize();
+	zone.axis0 = Vec3f(0.f, 0.f, 1.f) ^ zone.center;
+	zone.axis0.normalize();
+	zone.axis1 = zone.center ^ zone.axis0;
+	const float scale = 0.035f / Star2::MaxPosVal;
+	zone.axis0 *= scale;
+	zone.axis1 *= scale;
+	movementFactor = 1e-4f;
+
+	// Random packed records are valid Star2 data.
+	qsrand(42);
+	stars.resize(NB_STARS);
+	QVector<quint8> raw(NB_STARS*sizeof(Star2));
+	for (int i=0;i<raw.size();++i)
+		raw[i] = qrand() & 0xFF;
+	std::memcpy(stars.data(), raw.constData(), raw.size());
+
+	// Two caps cutting through the zone so that about half the stars are visible.
+	caps.append(SphericalCap(Vec3d(zone.center[0], zone.center[1], zone.center[2]), 0.9999));
+	Vec3d n(zone.axis0[0], zone.axis0[1], zone.axis0[2]);
+	n.normalize();
+	caps.append(SphericalCap(n, 0.));
+}
+
+void TestStarPositionKernel::cleanupTestCase()
+{
+	StarPositionKernel::setImplementation(StarPositionKernel::getBestImplementation());
+}
+
+void TestStarPositionKernel::testImplementations()
+{
+	const StarKernelCaps kernelCaps(caps);
+	StarBlock block;
+	StarBlockPositions pos;
+	const StarPositionKernel::Implementation impls[] = {StarPositionKernel::Scalar, StarPositionKernel::SSE2, StarPositionKernel::AVX2};
+	for (unsigned int k=0;k<sizeof(impls)/sizeof(impls[0]);++k)
+	{
+		StarPositionKernel::setImplementation(impls[k]);
+		int nbVisible = 0;
+		int nbMismatch = 0;
+		for (int b=0;b<NB_STARS;b+=STAR_BLOCK_SIZE)
+		{
+			const int n = qMin(STAR_BLOCK_SIZE, NB_STARS-b);
+			block.unpack(stars.constData()+b, n);
+			StarPositionKernel::compute(&zone, movementFactor, block, kernelCaps, pos);
+			// Padding stars are never visible
+			QVERIFY(n==STAR_BLOCK_SIZE || (pos.visible>>n)==0);
+			for (int i=0;i<n;++i)
+			{
+				Vec3f v;
+				stars[b+i].getJ2000Pos(&zone, movementFactor, v);
+				v.normalize();
+				bool isVisible = true;
+				foreach (const SphericalCap& cap, caps)
+				{
+					if (!cap.contains(v))
+						isVisible = false;
+				}
+				// Stars right on a cap border may be classified differently due to rounding
+				if (isVisible!=pos.isVisible(i))
+					++nbMismatch;
+				nbVisible += isVisible;
+				QVERIFY2((pos.getPos(i)-v).length()<1e-6f, StarPositionKernel::implementationName(StarPositionKernel::getImplementation()));
+			}
+		}
+		QVERIFY(nbVisible>0 && nbVisible<NB_STARS);
+		QVERIFY(nbMismatch<=NB_STARS/1000);
+	}
+}
+
+// The loop used by SpecialZoneArray::draw() before the kernel was introduced.
+void TestStarPositionKernel::benchmarkScalarLoop()
+{
+	int nbVisible = 0;
+	QBENCHMARK {
+		nbVisible = 0;
+		Vec3f vf;
+		for (const Star2* s=stars.constBegin();s<stars.constEnd();++s)
+		{
+			s->getJ2000Pos(&zone, movementFactor, vf);
+			vf.normalize();
+			bool isVisible = true;
+			foreach (const SphericalCap& cap, caps)
+			{
+				if (!cap.contains(vf))
+				{
+					isVisible = false;
+					continue;
+				}
+			}
+			if (!isVisible)
+				continue;
+			++nbVisible;
+		}
+	}
+	QVERIFY(nbVisible>0);
+}
+
+void TestStarPositionKernel::benchmarkKernel_data()
+{
+	QTest::addColumn<int>("implementation");
+	QTest::newRow("Scalar") << (int)StarPositionKernel::Scalar;
+	if (StarPositionKernel::getBestImplementation()>=StarPositionKernel::SSE2)
+		QTest::newRow("SSE2") << (int)StarPositionKernel::SSE2;
+	if (StarPositionKernel::getBestImplementation()>=StarPositionKernel::AVX2)
+		QTest::newRow("AVX2") << (int)StarPositionKernel::AVX2;
+}
+
+void TestStarPositionKernel::benchmarkKernel()
+{
+	QFETCH(int, implementation);
+	StarPositionKernel::setImplementation((StarPositionKernel::Implementation)implementation);
+	const StarKernelCaps kernelCaps(caps);
+	StarBlock block;
+	StarBlockPositions pos;
+	int nbVisible = 0;
+	QBENCHMARK {
+		nbVisible = 0;
+		for (int b=0;b<NB_STARS;b+=STAR_BLOCK_SIZE)
+		{
+			block.unpack(stars.constData()+b, qMin(STAR_BLOCK_SIZE, NB_STARS-b));
+			StarPositionKernel::compute(&zone, movementFactor, block, kernelCaps, pos);
+			for (quint64 m=pos.visible;m;m&=m-1)
+				++nbVisible;
+		}
+	}
+	QVERIFY(nbVisible>0);
+}
@@ -0,0 +1,47 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TESTSTARPOSITIONKERNEL_HPP_
+#define _TESTSTARPOSITIONKERNEL_HPP_
+
+#include <QObject>
+#include <QTest>
+#include <QVector>
+
+#include "StarPositionKernel.hpp"
+#include "StelSphereGeometry.hpp"
+
+class TestStarPositionKernel : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testImplementations();
+	void benchmarkScalarLoop();
+	void benchmarkKernel_data();
+	void benchmarkKernel();
+	void cleanupTestCase();
+private:
+	QVector<Star2> stars;
+	ZoneData zone;
+	QVector<SphericalCap> caps;
+	float movementFactor;
+};
+
+#endif // _TESTSTARPOSITIONKERNEL_HPP_
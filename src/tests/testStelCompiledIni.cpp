@@ -0,0 +1,116 @@
+/*
+ * Stellarium
+ * Copyright (C) 2016 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelCompiledIni.hpp"
+#include "StelCompiledIni.hpp"
+#include "StelIniParser.hpp"
+
+#include <QFile>
+
+QTEST_GUILESS_MAIN(TestStelCompiledIni)
+
+namespace
+{
+	const char* iniContent =
+		"version = 1\n"
+		"[sun]\n"
+		"name = Sun\n"
+		"parent = none\n"
+		"radius = 696000  # km\n"
+		"color = 1., 1., 1.\n"
+		"[ceres]\n"
+		"name = Céres\n"
+		"parent = Sun\n"
+		"orbit_Eccentricity = 0.0758\n"
+		"color = 1., 1., 1.\n";
+}
+
+void TestStelCompiledIni::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	iniPath = dir.path() + "/ssystem.ini";
+	cachePath = dir.path() + "/cache/ssystem.bin";
+}
+
+void TestStelCompiledIni::writeIni(const QByteArray& content)
+{
+	QFile file(iniPath);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	QCOMPARE(file.write(content), (qint64)content.size());
+}
+
+void TestStelCompiledIni::testSameAsQSettings()
+{
+	writeIni(iniContent);
+	QSettings settings(iniPath, StelIniFormat);
+	StelCompiledIni ini(iniPath, QString());
+	QCOMPARE(ini.status(), QSettings::NoError);
+	QCOMPARE(ini.childGroups(), settings.childGroups());
+	foreach (const QString& key, settings.allKeys())
+		QCOMPARE(ini.value(key), settings.value(key));
+	QCOMPARE(ini.value("ceres/name").toString(), QString::fromUtf8("Céres"));
+	QCOMPARE(ini.value("ceres/radius", 470).toInt(), 470);
+	QCOMPARE(ini.value("pluto/name", "none").toString(), QString("none"));
+}
+
+void TestStelCompiledIni::testCache()
+{
+	writeIni(iniContent);
+	QFile::remove(cachePath);
+	{
+		StelCompiledIni ini(iniPath, cachePath);
+		QVERIFY(!ini.isLoadedFromCache());
+		QVERIFY(QFile::exists(cachePath));
+	}
+	StelCompiledIni ini(iniPath, cachePath);
+	QVERIFY(ini.isLoadedFromCache());
+	QCOMPARE(ini.childGroups(), QStringList() << "ceres" << "sun");
+	QCOMPARE(ini.value("version").toString(), QString("1"));
+	QCOMPARE(ini.value("sun/radius").toDouble(), 696000.);
+	QCOMPARE(ini.value("ceres/orbit_Eccentricity").toDouble(), 0.0758);
+}
+
+void TestStelCompiledIni::testStaleCache()
+{
+	writeIni(iniContent);
+	{
+		StelCompiledIni ini(iniPath, cachePath);
+	}
+	writeIni(QByteArray(iniContent).replace("0.0758", "0.0760"));
+	StelCompiledIni ini(iniPath, cachePath);
+	QVERIFY(!ini.isLoadedFromCache());
+	QCOMPARE(ini.value("ceres/orbit_Eccentricity").toDouble(), 0.0760);
+}
+
+void TestStelCompiledIni::testInvalidCache()
+{
+	writeIni(iniContent);
+	{
+		StelCompiledIni ini(iniPath, cachePath);
+	}
+	QFile cache(cachePath);
+	QVERIFY(cache.open(QIODevice::ReadWrite));
+	QVERIFY(cache.resize(cache.size()-3));
+	cache.close();
+	StelCompiledIni ini(iniPath, cachePath);
+	QVERIFY(!ini.isLoadedFromCache());
+	QCOMPARE(ini.value("sun/name").toString(), QString("Sun"));
+	StelCompiledIni rewritten(iniPath, cachePath);
+	QVERIFY(rewritten.isLoadedFromCache());
+}